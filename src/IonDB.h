@@ -29,8 +29,10 @@
 #include "cpp_wrapper/FlatFile.h"
 #include "cpp_wrapper/OpenAddressFileHash.h"
 #include "cpp_wrapper/OpenAddressHash.h"
+#include "cpp_wrapper/GroupHash.h"
 #include "cpp_wrapper/BppTree.h"
 #include "cpp_wrapper/SkipList.h"
+#include "cpp_wrapper/ConcurrentSkipList.h"
 
 #include "serial/serial_c_iface.h"
 
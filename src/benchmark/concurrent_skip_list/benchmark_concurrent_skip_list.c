@@ -0,0 +1,196 @@
+/******************************************************************************/
+/**
+@file
+@brief		Measures how the concurrent skiplist scales with the number of
+			threads using it.
+@details	Each run preloads the list, then has every thread carry out a
+			fixed number of random operations on it, and reports the
+			operations per second across all threads, for a read only
+			workload and for one that also inserts and deletes.
+
+			Usage: benchmark_concurrent_skip_list [max threads] [operations
+			per thread]. The thread count doubles from one up to the maximum,
+			which defaults to twice the number of processors online.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#if !defined(_POSIX_C_SOURCE)
+/* clock_gettime() and sysconf() are POSIX, and hidden by -std=c99 */
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "../../dictionary/concurrent_skip_list/concurrent_skip_list.h"
+
+#define CSL_BENCH_KEYS				(1 << 16)
+#define CSL_BENCH_OPERATIONS		200000
+#define CSL_BENCH_MAX_HEIGHT		12
+
+/**
+@brief		What one benchmark thread does.
+*/
+typedef struct {
+	ion_concurrent_skiplist_t	*skiplist;
+	unsigned int				seed;
+	int							operations;
+	int							write_percent;
+} csl_bench_thread_t;
+
+/**
+@brief		A small generator of pseudo random numbers, kept per thread so
+			that the threads do not contend on it.
+*/
+static unsigned int
+csl_bench_random(
+	unsigned int *state
+) {
+	*state	^= *state << 13;
+	*state	^= *state >> 17;
+	*state	^= *state << 5;
+	return *state;
+}
+
+static void *
+csl_bench_thread(
+	void *argument
+) {
+	csl_bench_thread_t	*work = argument;
+	int					i;
+	int					key;
+	int					value;
+	int					choice;
+
+	for (i = 0; i < work->operations; i++) {
+		key		= (int) (csl_bench_random(&work->seed) % CSL_BENCH_KEYS);
+		choice	= (int) (csl_bench_random(&work->seed) % 100);
+
+		if (choice >= work->write_percent) {
+			csl_query(work->skiplist, &key, &value);
+		}
+		else if (choice % 2) {
+			value = i;
+			csl_insert(work->skiplist, &key, &value);
+		}
+		else {
+			csl_delete(work->skiplist, &key);
+		}
+	}
+
+	return NULL;
+}
+
+static double
+csl_bench_now(
+	void
+) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+/**
+@brief		Runs one workload with @p thread_count threads.
+
+@return		The operations per second across all threads.
+*/
+static double
+csl_bench_run(
+	int thread_count,
+	int operations,
+	int write_percent
+) {
+	ion_concurrent_skiplist_t	skiplist;
+	pthread_t					*threads	= malloc(sizeof(pthread_t) * thread_count);
+	csl_bench_thread_t			*work		= malloc(sizeof(csl_bench_thread_t) * thread_count);
+	double						start;
+	double						elapsed;
+	int							i;
+
+	skiplist.super.compare = dictionary_compare_signed_value;
+	csl_initialize(&skiplist, key_type_numeric_signed, sizeof(int), sizeof(int), CSL_BENCH_MAX_HEIGHT);
+
+	/* Half the keys are in the list to begin with, which the mixed workload keeps roughly so. */
+	for (i = 0; i < CSL_BENCH_KEYS; i += 2) {
+		csl_insert(&skiplist, &i, &i);
+	}
+
+	for (i = 0; i < thread_count; i++) {
+		work[i].skiplist		= &skiplist;
+		work[i].seed			= 2463534242U + (unsigned int) i * 7919U;
+		work[i].operations		= operations;
+		work[i].write_percent	= write_percent;
+	}
+
+	start = csl_bench_now();
+
+	for (i = 0; i < thread_count; i++) {
+		pthread_create(&threads[i], NULL, csl_bench_thread, &work[i]);
+	}
+
+	for (i = 0; i < thread_count; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	elapsed = csl_bench_now() - start;
+
+	csl_destroy(&skiplist);
+	free(threads);
+	free(work);
+
+	return (double) thread_count * operations / elapsed;
+}
+
+int
+main(
+	int		argc,
+	char	**argv
+) {
+	static const int	write_percents[] = { 0, 20 };
+	long				processors	= sysconf(_SC_NPROCESSORS_ONLN);
+	int					max_threads = (argc > 1) ? atoi(argv[1]) : (int) (processors > 0 ? processors * 2 : 2);
+	int					operations	= (argc > 2) ? atoi(argv[2]) : CSL_BENCH_OPERATIONS;
+	int					threads;
+	int					w;
+
+	if (max_threads > ION_CSL_MAX_THREADS) {
+		max_threads = ION_CSL_MAX_THREADS;
+	}
+
+	printf("%ld processors online, %d operations per thread over %d keys\n", processors, operations, CSL_BENCH_KEYS);
+
+	for (w = 0; w < (int) (sizeof(write_percents) / sizeof(write_percents[0])); w++) {
+		double single = 0;
+
+		printf("\n%d%% inserts and deletes\n%8s %14s %8s\n", write_percents[w], "threads", "ops/s", "speedup");
+
+		for (threads = 1; threads <= max_threads; threads *= 2) {
+			double rate = csl_bench_run(threads, operations, write_percents[w]);
+
+			if (1 == threads) {
+				single = rate;
+			}
+
+			printf("%8d %14.0f %7.2fx\n", threads, rate, rate / single);
+		}
+	}
+
+	return 0;
+}
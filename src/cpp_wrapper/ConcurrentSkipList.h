@@ -0,0 +1,44 @@
+/******************************************************************************/
+/**
+@file
+@brief		The C++ implementation of a concurrent skiplist based dictionary.
+*/
+/******************************************************************************/
+
+#ifndef PROJECT_CONCURRENTSKIPLIST_H
+#define PROJECT_CONCURRENTSKIPLIST_H
+
+#include "Dictionary.h"
+#include "../key_value/kv_system.h"
+#include "../dictionary/concurrent_skip_list/concurrent_skip_list_handler.h"
+
+template<typename K, typename V>
+class ConcurrentSkipList:public Dictionary<K, V> {
+public:
+/**
+@brief		Registers a specific concurrent skiplist dictionary instance.
+
+@details	Registers functions for dictionary.
+
+@param		type_key
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param	  value_size
+				The size of the values to be stored in the dictionary.
+@param	  dictionary_size
+				The maximum height of the skiplist.
+*/
+ConcurrentSkipList(
+	ion_key_type_t			type_key,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	ion_dictionary_size_t	dictionary_size
+) {
+	csldict_init(&this->handler);
+
+	this->initializeDictionary(type_key, key_size, value_size, dictionary_size);
+}
+};
+
+#endif /* PROJECT_CONCURRENTSKIPLIST_H */
@@ -72,6 +72,33 @@ insert(
 	return status;
 }
 
+/**
+@brief		Insert many key-value pairs at once.
+
+@param		keys
+				The keys to insert.
+@param		values
+				The value to store under each key.
+@param		statuses
+				The status of each pair's insertion.
+@param		num_records
+				How many pairs to insert.
+@returns	A status whose count is the number of pairs inserted.
+*/
+ion_status_t
+insertBatch(
+	K				*keys,
+	V				*values,
+	ion_status_t	*statuses,
+	int				num_records
+) {
+	ion_status_t status = dictionary_insert_batch(&dict, keys, values, statuses, num_records);
+
+	this->last_status = status;
+
+	return status;
+}
+
 V
 get(
 	K key
@@ -84,6 +111,32 @@ get(
 	return *((V *) ion_value);
 }
 
+/**
+@brief		Retrieve the values for many keys at once.
+@param		keys
+				The keys to look up.
+@param		values
+				Where to store the value found for each key.
+@param		statuses
+				The status of each key's lookup.
+@param		num_keys
+				How many keys to look up.
+@return		A status whose count is the number of keys found.
+*/
+ion_status_t
+multiGet(
+	K				*keys,
+	V				*values,
+	ion_status_t	*statuses,
+	int				num_keys
+) {
+	ion_status_t status = dictionary_multi_get(&dict, keys, values, statuses, num_keys);
+
+	this->last_status = status;
+
+	return status;
+}
+
 /**
 @brief		Delete a value given a key.
 
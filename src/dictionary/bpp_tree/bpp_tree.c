@@ -20,9 +20,11 @@
  *	each 3/4 full.  On deletion, if 3 nodes are 1/2 full, they are
  *	joined to create 2 nodes 3/4 full.
  *
- *	A LRR (least-recently-read) buffering scheme for nodes is used to
+ *	A LRU (least-recently-used) buffering scheme for nodes is used to
  *	simplify storage management, and, assuming some locality of reference,
- *	improve performance.
+ *	improve performance.  The number of buffers is chosen when the tree
+ *	is opened, and buffers are found by hashing their disk address, so
+ *	a large pool costs no more per lookup than a small one.
  *
  *	To simplify matters, both internal nodes and leafs contain the
  *	same fields.
@@ -35,11 +37,12 @@
 #define bAdr(p)		*(ion_bpp_address_t *) (p)
 #define eAdr(p)		*(ion_bpp_external_address_t *) (p)
 
-/* based on k = &[key,rec,childGE] */
+/* based on k = &[key,rec,value,childGE] */
 #define childLT(k)	bAdr((char *) k - sizeof(ion_bpp_address_t))
 #define key(k)		(k)
 #define rec(k)		eAdr((char *) (k) + h->keySize)
-#define childGE(k)	bAdr((char *) (k) + h->keySize + sizeof(ion_bpp_external_address_t))
+#define val(k)		((char *) (k) + h->keySize + sizeof(ion_bpp_external_address_t))
+#define childGE(k)	bAdr(val(k) + h->valueSize)
 
 /* based on b = &ion_bpp_buffer_t */
 #define leaf(b)		b->p->leaf
@@ -68,7 +71,7 @@ typedef struct {
 	ion_bpp_address_t	prev;			/* prev node in sequence (leaf) */
 	ion_bpp_address_t	next;			/* next node in sequence (leaf) */
 	ion_bpp_address_t	childLT;		/* child LT first key */
-	/* ct occurrences of [key,rec,childGE] */
+	/* ct occurrences of [key,rec,value,childGE] */
 	ion_bpp_key_t		fkey;			/* first occurrence */
 } ion_bpp_node_t;
 
@@ -76,6 +79,7 @@ typedef struct ion_bpp_buffer_tag {
 	/* location of node */
 	struct ion_bpp_buffer_tag	*next;	/* next */
 	struct ion_bpp_buffer_tag	*prev;	/* previous */
+	struct ion_bpp_buffer_tag	*hnext;	/* next in hash chain */
 	ion_bpp_address_t			adr;	/* on disk */
 	ion_bpp_node_t				*p;	/* in memory */
 	ion_bpp_bool_t				valid;		/* true if buffer contents valid */
@@ -86,11 +90,16 @@ typedef struct ion_bpp_buffer_tag {
 typedef struct ion_bpp_h_node_tag {
 	ion_file_handle_t		fp;		/* idx file */
 	int						keySize;/* key length */
+	int						valueSize;	/* inline value length */
 	ion_bpp_bool_t			dupKeys;/* true if duplicate keys */
 	int						sectorSize;	/* block size for idx records */
 	ion_bpp_comparison_t	comp;			/* pointer to compare routine */
 	ion_bpp_buffer_t		root;			/* root of b-tree, room for 3 sets */
 	ion_bpp_buffer_t		bufList;		/* head of buf list */
+	ion_bpp_buffer_t		**bufHash;		/* buffers hashed by adr */
+	unsigned int			hashMask;	/* number of hash chains - 1 */
+	long					nHits;	/* reads found in buffers */
+	long					nMisses;/* reads that went to disk */
 	void					*malloc1;	/* malloc'd resources */
 	void					*malloc2;	/* malloc'd resources */
 	ion_bpp_buffer_t		gbuf;			/* gather buffer, room for 3 sets */
@@ -99,19 +108,77 @@ typedef struct ion_bpp_h_node_tag {
 	unsigned int			maxCt;	/* minimum # keys in node */
 	int						ks;	/* sizeof key entry */
 	ion_bpp_address_t		nextFreeAdr;/* next free b-tree record address */
+	ion_file_offset_t		base;	/* file offset of node address 0 */
 } ion_bpp_h_node_t;
 
+/*
+ * Files start with a header, padded to one sector so that nodes stay
+ * sector aligned.  Files written before the header existed begin with
+ * the root node, whose first word never has its upper 16 bits set.
+*/
+#define ION_BPP_MAGIC 0x42505431L	/* "BPT1" */
+
+typedef struct {
+	uint32_t	magic;			/* ION_BPP_MAGIC */
+	uint32_t	sectorSize;		/* node size the file was created with */
+	uint32_t	valueSize;		/* inline value length the file was created with */
+} ion_bpp_header_t;
+
 #define error(rc) lineError(__LINE__, rc)
 
+int maxHeight;
+int nNodesIns;
+int nNodesDel;
+int nKeysIns;
+int nKeysDel;
+int nDiskReads;
+int nDiskWrites;
+int bErrLineNo;
+
+/* statistics are shared by every tree, which may be in use by different threads */
+#if ION_THREAD_SAFE
+#define statAdd(stat, n) __atomic_add_fetch(&(stat), (n), __ATOMIC_RELAXED)
+#else
+#define statAdd(stat, n) ((stat) += (n))
+#endif
+
+static void
+statMax(
+	int *stat,
+	int value
+) {
+#if ION_THREAD_SAFE
+	int old = __atomic_load_n(stat, __ATOMIC_RELAXED);
+
+	while (value > old && !__atomic_compare_exchange_n(stat, &old, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+
+#else
+
+	if (value > *stat) {
+		*stat = value;
+	}
+
+#endif
+}
+
 static ion_bpp_err_t
 lineError(
 	int				lineno,
 	ion_bpp_err_t	rc
 ) {
 	if ((rc == bErrIO) || (rc == bErrMemory)) {
+#if ION_THREAD_SAFE
+		int none = 0;
+
+		/* only the first error is kept */
+		__atomic_compare_exchange_n(&bErrLineNo, &none, lineno, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+#else
+
 		if (!bErrLineNo) {
 			bErrLineNo = lineno;
 		}
+
+#endif
 	}
 
 	return rc;
@@ -145,7 +212,7 @@ flush(
 		len *= 3;	/* root */
 	}
 
-	err = ion_fwrite_at(h->fp, buf->adr, len, (ion_byte_t *) buf->p);
+	err = ion_fwrite_at(h->fp, h->base + buf->adr, len, (ion_byte_t *) buf->p);
 
 	if (err_ok != err) {
 		return error(bErrIO);
@@ -192,7 +259,7 @@ flush(
 #endif
 
 	buf->modified = boolean_false;
-	nDiskWrites++;
+	statAdd(nDiskWrites, 1);
 	return bErrOk;
 }
 
@@ -225,6 +292,31 @@ flushAll(
 	return bErrOk;
 }
 
+#define hashAdr(adr) (((adr) / h->sectorSize) & h->hashMask)
+
+static void
+unhashBuf(
+	ion_bpp_handle_t	handle,
+	ion_bpp_buffer_t	*buf
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_buffer_t	**link;
+
+	/* unlink buf from its hash chain */
+	link = &h->bufHash[hashAdr(buf->adr)];
+
+	while (*link != NULL) {
+		if (*link == buf) {
+			*link = buf->hnext;
+			break;
+		}
+
+		link = &(*link)->hnext;
+	}
+
+	buf->hnext = NULL;
+}
+
 static ion_bpp_err_t
 assignBuf(
 	ion_bpp_handle_t	handle,
@@ -242,31 +334,30 @@ assignBuf(
 	}
 
 	/* search for buf with matching adr */
-	buf = h->bufList.next;
-
-	while (buf->next != &h->bufList) {
-		if (buf->valid && (buf->adr == adr)) {
-			break;
-		}
+	buf = h->bufHash[hashAdr(adr)];
 
-		buf = buf->next;
+	while ((buf != NULL) && (buf->adr != adr)) {
+		buf = buf->hnext;
 	}
 
-	/* either buf points to a match, or it's last one in list (LRR) */
-	if (buf->valid) {
-		if (buf->adr != adr) {
-			if (buf->modified) {
-				if ((rc = flush(handle, buf)) != 0) {
-					return rc;
-				}
+	if (buf == NULL) {
+		/* no match, reuse last one in list (LRU) */
+		buf = h->bufList.prev;
+
+		if (buf->valid && buf->modified) {
+			if ((rc = flush(handle, buf)) != 0) {
+				return rc;
 			}
+		}
 
-			buf->adr	= adr;
-			buf->valid	= boolean_false;
+		if (buf->adr != 0) {
+			unhashBuf(handle, buf);
 		}
-	}
-	else {
-		buf->adr = adr;
+
+		buf->adr					= adr;
+		buf->valid					= boolean_false;
+		buf->hnext					= h->bufHash[hashAdr(adr)];
+		h->bufHash[hashAdr(adr)]	= buf;
 	}
 
 	/* remove from current position and place at front of list */
@@ -306,14 +397,17 @@ readDisk(
 		return rc;
 	}
 
-	if (!buf->valid) {
+	if (buf->valid) {
+		h->nHits++;
+	}
+	else {
 		len = h->sectorSize;
 
 		if (adr == 0) {
 			len *= 3;	/* root */
 		}
 
-		ion_err_t err = ion_fread_at(h->fp, adr, len, (ion_byte_t *) buf->p);
+		ion_err_t err = ion_fread_at(h->fp, h->base + adr, len, (ion_byte_t *) buf->p);
 
 		if (err_ok != err) {
 			return error(bErrIO);
@@ -321,7 +415,7 @@ readDisk(
 
 		buf->modified	= boolean_false;
 		buf->valid		= boolean_true;
-		nDiskReads++;
+		statAdd(nDiskReads, 1);
 
 #if 0
 		len = 1;
@@ -362,9 +456,7 @@ readDisk(
 
 #endif
 
-		buf->modified	= boolean_false;
-		buf->valid		= boolean_true;
-		nDiskReads++;
+		h->nMisses++;
 	}
 
 	*b = buf;
@@ -602,7 +694,7 @@ scatter(
 			}
 
 			iu++;
-			nNodesIns++;
+			statAdd(nNodesIns, 1);
 		}
 		else if ((iu > 1) && (ct < (k0Min + (iu - 1) * knMin))) {
 			/* del a buffer */
@@ -614,7 +706,7 @@ scatter(
 			}
 
 			next(tmp[iu - 1]) = next(tmp[iu]);
-			nNodesDel++;
+			statAdd(nNodesDel, 1);
 		}
 		else {
 			break;
@@ -851,23 +943,46 @@ bOpen(
 	ion_bpp_h_node_t	*h;
 	ion_bpp_err_t		rc;			/* return code */
 	int					bufCt;	/* number of tmp buffers */
+	unsigned int		hashCt;	/* number of hash chains */
 	ion_bpp_buffer_t	*buf;				/* buffer */
 	int					maxCt;	/* maximum number of keys in a node */
 	ion_bpp_buffer_t	*root;
 	int					i;
 	ion_bpp_node_t		*p;
+	ion_bpp_header_t	hdr;			/* file header */
+	ion_bpp_bool_t		exists;			/* true if opening an existing file */
+	ion_file_handle_t	fp;				/* idx file */
+	ion_file_offset_t	base;			/* file offset of the root */
+
+	/* an existing file overrides the requested sector and value sizes */
+	exists	= ion_fexists(info.iName);
+	base	= 0;
+
+	if (exists) {
+		fp				= ion_fopen(info.iName);
+		info.valueSize	= 0;
+
+		if ((err_ok == ion_fread_at(fp, 0, sizeof(hdr), (ion_byte_t *) &hdr)) && (ION_BPP_MAGIC == hdr.magic)) {
+			info.sectorSize = hdr.sectorSize;
+			info.valueSize	= hdr.valueSize;
+			base			= hdr.sectorSize;
+		}
+
+		ion_fclose(fp);
+	}
 
-	if ((info.sectorSize < sizeof(ion_bpp_h_node_t)) || (0 != info.sectorSize % 4)) {
+	if ((info.sectorSize < sizeof(ion_bpp_node_t)) || (0 != info.sectorSize % 4) || (info.valueSize < 0)) {
 		return bErrSectorSize;
 	}
 
 	/* determine sizes and offsets */
-	/* leaf/n, prev, next, [childLT,key,rec]... childGE */
+	/* leaf/n, prev, next, [childLT,key,rec,value]... childGE */
 	/* ensure that there are at least 3 children/parent for gather/scatter */
 	maxCt	= info.sectorSize - (sizeof(ion_bpp_node_t) - sizeof(ion_bpp_key_t));
-	maxCt	/= sizeof(ion_bpp_address_t) + info.keySize + sizeof(ion_bpp_external_address_t);
+	maxCt	/= sizeof(ion_bpp_address_t) + info.keySize + sizeof(ion_bpp_external_address_t) + info.valueSize;
 
-	if (maxCt < 6) {
+	/* gbuf gathers up to 3 full nodes, and ct is only 15 bits */
+	if ((maxCt < 6) || (3 * maxCt + 2 > 0x7FFF)) {
 		return bErrSectorSize;
 	}
 
@@ -877,12 +992,14 @@ bOpen(
 	}
 
 	h->keySize		= info.keySize;
+	h->valueSize	= info.valueSize;
 	h->dupKeys		= info.dupKeys;
 	h->sectorSize	= info.sectorSize;
 	h->comp			= info.comp;
+	h->base			= base;
 
-	/* childLT, key, rec */
-	h->ks			= sizeof(ion_bpp_address_t) + h->keySize + sizeof(ion_bpp_external_address_t);
+	/* childLT, key, rec, value */
+	h->ks			= sizeof(ion_bpp_address_t) + h->keySize + sizeof(ion_bpp_external_address_t) + h->valueSize;
 	h->maxCt		= maxCt;
 
 	/* Allocate buflist.
@@ -891,13 +1008,35 @@ bOpen(
 	 *  - 1 parent buf
 	 *  - 1 next sequential link
 	 *  - 1 lastGE
+	 * Any buffers beyond that simply cache nodes.
 	*/
-	bufCt			= 7;
+	bufCt = info.bufCt;
+
+	if (bufCt == 0) {
+		bufCt = ION_BPP_BUFFER_COUNT;
+	}
+
+	if (bufCt < ION_BPP_MIN_BUFFERS) {
+		bufCt = ION_BPP_MIN_BUFFERS;
+	}
 
 	if ((h->malloc1 = calloc(bufCt, sizeof(ion_bpp_buffer_t))) == NULL) {
 		return error(bErrMemory);
 	}
 
+	/* one hash chain per buffer, rounded up to a power of 2 */
+	hashCt = 1;
+
+	while (hashCt < (unsigned int) bufCt) {
+		hashCt <<= 1;
+	}
+
+	if ((h->bufHash = calloc(hashCt, sizeof(ion_bpp_buffer_t *))) == NULL) {
+		return error(bErrMemory);
+	}
+
+	h->hashMask = hashCt - 1;
+
 	buf = h->malloc1;
 
 	/*
@@ -945,9 +1084,9 @@ bOpen(
 	h->curKey				= NULL;
 
 	/* initialize root */
-	if (ion_fexists(info.iName)) {
+	if (exists) {
 		/* open an existing database */
-		h->fp = ion_fopen(info.iName);
+		h->fp = info.mapped ? ion_fopen_mapped(info.iName) : ion_fopen(info.iName);
 
 		if ((rc = readDisk(h, 0, &root)) != 0) {
 			return rc;
@@ -960,14 +1099,29 @@ bOpen(
 		if ((h->nextFreeAdr = ion_ftell(h->fp)) == -1) {
 			return error(bErrIO);
 		}
+
+		h->nextFreeAdr -= h->base;
 	}
 
 	/*TODO make this cleaner **/
 #if defined(ARDUINO)
-	else if (NULL != (h->fp = ion_fopen(info.iName)).file) {
+	else if (NULL != (h->fp = info.mapped ? ion_fopen_mapped(info.iName) : ion_fopen(info.iName)).file) {
 #else
-	else if (NULL != (h->fp = ion_fopen(info.iName))) {
+	else if (NULL != (h->fp = info.mapped ? ion_fopen_mapped(info.iName) : ion_fopen(info.iName))) {
 #endif
+		/* write header, padded to a sector using the (zeroed) gather buffer */
+		hdr.magic		= ION_BPP_MAGIC;
+		hdr.sectorSize	= h->sectorSize;
+		hdr.valueSize	= h->valueSize;
+		h->base			= h->sectorSize;
+		memcpy(h->gbuf.p, &hdr, sizeof(hdr));
+
+		if (err_ok != ion_fwrite_at(h->fp, 0, h->sectorSize, (ion_byte_t *) h->gbuf.p)) {
+			return error(bErrIO);
+		}
+
+		memset(h->gbuf.p, 0, sizeof(hdr));
+
 		/* initialize root */
 		memset(root->p, 0, 3 * h->sectorSize);
 		leaf(root)		= 1;
@@ -1016,10 +1170,72 @@ bClose(
 		free(h->malloc1);
 	}
 
+	if (h->bufHash) {
+		free(h->bufHash);
+	}
+
 	free(h);
 	return bErrOk;
 }
 
+ion_bpp_err_t
+bFlush(
+	ion_bpp_handle_t	handle,
+	ion_bpp_bool_t		sync
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_err_t		rc;
+
+	if ((rc = flushAll(handle)) != bErrOk) {
+		return rc;
+	}
+
+	if (err_ok != (sync ? ion_fsync(h->fp) : ion_fflush(h->fp))) {
+		return error(bErrIO);
+	}
+
+	return bErrOk;
+}
+
+ion_bpp_err_t
+bCacheStats(
+	ion_bpp_handle_t	handle,
+	long				*hits,
+	long				*misses
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	*hits	= h->nHits;
+	*misses = h->nMisses;
+	return bErrOk;
+}
+
+ion_bpp_err_t
+bValueSize(
+	ion_bpp_handle_t	handle,
+	int					*valueSize
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	*valueSize = h->valueSize;
+	return bErrOk;
+}
+
+ion_bpp_err_t
+bCurrentValue(
+	ion_bpp_handle_t	handle,
+	void				*value
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	if (h->curKey == NULL) {
+		return bErrKeyNotFound;
+	}
+
+	memcpy(value, val(h->curKey), h->valueSize);
+	return bErrOk;
+}
+
 ion_bpp_err_t
 bFindKey(
 	ion_bpp_handle_t			handle,
@@ -1117,7 +1333,8 @@ ion_bpp_err_t
 bInsertKey(
 	ion_bpp_handle_t			handle,
 	void						*key,
-	ion_bpp_external_address_t	rec
+	ion_bpp_external_address_t	rec,
+	void						*value
 ) {
 	int					rc;		/* return code */
 	ion_bpp_key_t		*mkey;			/* match key */
@@ -1158,9 +1375,7 @@ bInsertKey(
 		if (leaf(buf)) {
 			/* in leaf, and there' room guaranteed */
 
-			if (height > maxHeight) {
-				maxHeight = height;
-			}
+			statMax(&maxHeight, height);
 
 			/* set mkey to point to insertion point */
 			switch (search(handle, buf, key, rec, &mkey, MODE_MATCH)) {
@@ -1200,6 +1415,10 @@ bInsertKey(
 			childGE(mkey)	= 0;
 			ct(buf)++;
 
+			if (h->valueSize) {
+				memcpy(val(mkey), value, h->valueSize);
+			}
+
 			if ((rc = writeDisk(buf)) != 0) {
 				return rc;
 			}
@@ -1213,8 +1432,7 @@ bInsertKey(
 					return rc;
 				}
 
-				/* tkey = fkey(tbuf) + lastGEkey; */
-				tkey		= fkey(tbuf);
+				tkey		= fkey(tbuf) + lastGEkey;
 				memcpy(key(tkey), key, h->keySize);
 				rec(tkey)	= rec;
 
@@ -1223,7 +1441,7 @@ bInsertKey(
 				}
 			}
 
-			nKeysIns++;
+			statAdd(nKeysIns, 1);
 			break;
 		}
 		else {
@@ -1291,11 +1509,309 @@ bInsertKey(
 	return bErrOk;
 }
 
+/* one level of a tree being built by bBulkLoad */
+typedef struct {
+	ion_bpp_buffer_t	buf;		/* node being filled */
+	ion_bpp_key_t		*low;	/* lowest [key,rec] under node being filled */
+	long				nNodes;	/* number of nodes on this level */
+	long				node;	/* index of node being filled */
+	long				base;	/* entries placed in every node */
+	long				extra;	/* number of nodes given one more entry */
+	long				have;	/* entries placed in node being filled */
+} ion_bpp_bulk_level_t;
+
+/* more levels than any key count that fits in a long can need */
+#define ION_BPP_MAX_LEVELS 32
+
+static long
+bulkNodes(
+	long	n,
+	long	want,
+	long	least
+) {
+	long nodes;
+
+	/*
+	 * input:
+	 *   n					  entries to spread over a level
+	 *   want				   entries per node at the requested fill
+	 *   least				  fewest entries a node may hold
+	 * returns:
+	 *   number of nodes, so that spreading n evenly gives each node
+	 *   between least and want entries; when n is too small for that,
+	 *   fewer nodes are used, which never puts more than 1.5 * least
+	 *   entries in a node
+	*/
+	nodes = (n + want - 1) / want;
+
+	if (nodes > n / least) {
+		nodes = n / least;
+	}
+
+	if (nodes < 1) {
+		nodes = 1;
+	}
+
+	return nodes;
+}
+
+static ion_bpp_err_t
+bulkAdd(
+	ion_bpp_handle_t		handle,
+	ion_bpp_bulk_level_t	*lv,
+	int						level,
+	int						top,
+	ion_bpp_address_t		leafAdr,
+	ion_bpp_key_t			*entry,
+	ion_bpp_address_t		child
+) {
+	ion_bpp_h_node_t		*h = handle;
+	ion_bpp_bulk_level_t	*l;
+	ion_bpp_buffer_t		*buf;
+	ion_bpp_key_t			*k;
+	ion_bpp_err_t			rc;			/* return code */
+	long					want;
+
+	/*
+	 * input:
+	 *   lv					 levels of tree being built
+	 *   level				  level to add to, 0 for leaves
+	 *   top					level held in root
+	 *   leafAdr				address of first leaf
+	 *   entry				  [key,rec,value] to add
+	 *   child				  node whose lowest key is entry (internal only)
+	*/
+	l	= &lv[level];
+	buf = &l->buf;
+
+	if (l->have == 0) {
+		memcpy(l->low, entry, h->keySize + sizeof(ion_bpp_external_address_t));
+	}
+
+	if (level == 0) {
+		k				= fkey(buf) + ks(ct(buf));
+		memcpy(k, entry, h->keySize + sizeof(ion_bpp_external_address_t) + h->valueSize);
+		childGE(k)		= 0;
+		ct(buf)++;
+	}
+	else if (l->have == 0) {
+		/* first child goes LT, its key is already held by an ancestor */
+		childLT(fkey(buf)) = child;
+	}
+	else {
+		k				= fkey(buf) + ks(ct(buf));
+		memcpy(k, entry, h->keySize + sizeof(ion_bpp_external_address_t));
+		childGE(k)		= child;
+		ct(buf)++;
+	}
+
+	l->have++;
+
+	want = l->base;
+
+	if (l->node < l->extra) {
+		want++;
+	}
+
+	if ((level == top) || (l->have < want)) {
+		return bErrOk;
+	}
+
+	/* node is complete, write it and pass its lowest key to its parent */
+	if (level == 0) {
+		buf->adr	= leafAdr + l->node * h->sectorSize;
+		leaf(buf)	= 1;
+		prev(buf)	= (l->node == 0) ? 0 : buf->adr - h->sectorSize;
+		next(buf)	= (l->node == l->nNodes - 1) ? 0 : buf->adr + h->sectorSize;
+	}
+	else {
+		buf->adr = allocAdr(handle);
+	}
+
+	if (err_ok != ion_fwrite_at(h->fp, h->base + buf->adr, h->sectorSize, (ion_byte_t *) buf->p)) {
+		return error(bErrIO);
+	}
+
+	statAdd(nDiskWrites, 1);
+	statAdd(nNodesIns, 1);
+
+	if ((rc = bulkAdd(handle, lv, level + 1, top, leafAdr, l->low, buf->adr)) != 0) {
+		return rc;
+	}
+
+	memset(buf->p, 0, h->sectorSize);
+	l->node++;
+	l->have = 0;
+	return bErrOk;
+}
+
+ion_bpp_err_t
+bBulkLoad(
+	ion_bpp_handle_t		handle,
+	long					nKeys,
+	int						fillPercent,
+	ion_bpp_bulk_source_t	source,
+	void					*state
+) {
+	ion_bpp_bulk_level_t	lv[ION_BPP_MAX_LEVELS];
+	ion_bpp_buffer_t		*root;
+	ion_bpp_key_t			*entry;		/* [key,rec] from source */
+	ion_bpp_key_t			*last;		/* previous entry */
+	char					*mem;
+	ion_bpp_address_t		leafAdr;	/* address of first leaf */
+	ion_bpp_err_t			rc;			/* return code */
+	long					n;
+	long					want;
+	long					least;
+	long					most;
+	long					i;
+	int						top;		/* level held in root */
+	int						cc;
+
+	ion_bpp_h_node_t *h = handle;
+
+	root = &h->root;
+
+	if (!leaf(root) || (ct(root) != 0)) {
+		return bErrNotEmpty;
+	}
+
+	if (nKeys <= 0) {
+		return bErrOk;
+	}
+
+	if (fillPercent < 1) {
+		fillPercent = 1;
+	}
+
+	if (fillPercent > 100) {
+		fillPercent = 100;
+	}
+
+	/* size each level, from the leaves up, until one fits in the root */
+	memset(lv, 0, sizeof(lv));
+	n	= nKeys;
+	top = 0;
+
+	while (1) {
+		if (top == 0) {
+			/* keys per leaf */
+			if (n <= 3 * h->maxCt) {
+				break;
+			}
+
+			want	= h->maxCt * fillPercent / 100;
+			least	= h->maxCt / 2;
+			most	= h->maxCt;
+		}
+		else {
+			/* children per internal node */
+			if (n - 1 <= 3 * h->maxCt) {
+				break;
+			}
+
+			want	= h->maxCt * fillPercent / 100 + 1;
+			least	= h->maxCt / 2 + 1;
+			most	= h->maxCt + 1;
+		}
+
+		if (want < least) {
+			want = least;
+		}
+
+		if (want > most) {
+			want = most;
+		}
+
+		if (top == ION_BPP_MAX_LEVELS - 1) {
+			return bErrSectorSize;
+		}
+
+		lv[top].nNodes	= bulkNodes(n, want, least);
+		lv[top].base	= n / lv[top].nNodes;
+		lv[top].extra	= n % lv[top].nNodes;
+		n				= lv[top].nNodes;
+		top++;
+	}
+
+	lv[top].nNodes	= 1;
+	lv[top].base	= n;
+
+	/* node buffers for levels below root, plus low keys, entry and last */
+	if ((mem = calloc(1, top * h->sectorSize + (top + 3) * h->ks)) == NULL) {
+		return error(bErrMemory);
+	}
+
+	for (i = 0; i < top; i++) {
+		lv[i].buf.p = (ion_bpp_node_t *) (mem + i * h->sectorSize);
+	}
+
+	for (i = 0; i <= top; i++) {
+		lv[i].low = mem + top * h->sectorSize + i * h->ks;
+	}
+
+	entry		= mem + top * h->sectorSize + (top + 1) * h->ks;
+	last		= entry + h->ks;
+
+	memset(root->p, 0, 3 * h->sectorSize);
+	lv[top].buf.p	= root->p;
+
+	/* leaves are written to consecutive sectors */
+	leafAdr			= h->nextFreeAdr;
+
+	if (top > 0) {
+		h->nextFreeAdr += lv[0].nNodes * h->sectorSize;
+	}
+
+	rc = bErrOk;
+
+	for (i = 0; i < nKeys; i++) {
+		if ((rc = source(state, key(entry), &rec(entry), val(entry))) != 0) {
+			break;
+		}
+
+		if (i > 0) {
+			cc = h->comp(key(entry), key(last), (ion_key_size_t) (h->keySize));
+
+			if ((cc < 0) || ((cc == 0) && (!h->dupKeys || (rec(entry) <= rec(last))))) {
+				rc = bErrKeyOrder;
+				break;
+			}
+		}
+
+		memcpy(last, entry, h->keySize + sizeof(ion_bpp_external_address_t));
+
+		if ((rc = bulkAdd(handle, lv, 0, top, leafAdr, entry, 0)) != 0) {
+			break;
+		}
+	}
+
+	free(mem);
+
+	if (rc != bErrOk) {
+		/* nothing references the nodes written so far */
+		memset(root->p, 0, 3 * h->sectorSize);
+		leaf(root) = 1;
+		return rc;
+	}
+
+	leaf(root)	= (top == 0);
+	h->curBuf	= NULL;
+	h->curKey	= NULL;
+
+	statMax(&maxHeight, top);
+
+	statAdd(nKeysIns, nKeys);
+
+	return writeDisk(root);
+}
+
 ion_bpp_err_t
 bUpdateKey(
 	ion_bpp_handle_t			handle,
 	void						*key,
-	ion_bpp_external_address_t	rec
+	ion_bpp_external_address_t	rec,
+	void						*value
 ) {
 	int					rc;		/* return code */
 	ion_bpp_key_t		*mkey;	/* match key */
@@ -1328,9 +1844,7 @@ bUpdateKey(
 		if (leaf(buf)) {
 			/* in leaf, and there' room guaranteed */
 
-			if (height > maxHeight) {
-				maxHeight = height;
-			}
+			statMax(&maxHeight, height);
 
 			/* set mkey to point to update point */
 			switch (search(handle, buf, key, rec, &mkey, MODE_MATCH)) {
@@ -1348,6 +1862,15 @@ bUpdateKey(
 
 			/* update key */
 			rec(mkey) = rec;
+
+			if (h->valueSize) {
+				memcpy(val(mkey), value, h->valueSize);
+			}
+
+			if ((rc = writeDisk(buf)) != 0) {
+				return rc;
+			}
+
 			break;
 		}
 		else {
@@ -1470,7 +1993,7 @@ bDeleteKey(
 				}
 			}
 
-			nKeysDel++;
+			statAdd(nKeysDel, 1);
 			break;
 		}
 		else {
@@ -1490,7 +2013,9 @@ bDeleteKey(
 			}
 
 			/* check for room to delete */
-			if (ct(cbuf) == h->maxCt / 2) {
+			/* (below half is possible: with an even maxCt, scatter can */
+			/* leave an internal node at exactly half, ready to lose a key) */
+			if (ct(cbuf) <= h->maxCt / 2) {
 				/* gather 3 bufs and scatter */
 				if ((rc = gather(handle, buf, &mkey, tmp)) != 0) {
 					return rc;
@@ -1500,7 +2025,7 @@ bDeleteKey(
 				if ((buf == root) && (ct(root) == 2) && (ct(gbuf) < (3 * (3 * h->maxCt)) / 4)) {
 					/* collapse tree by one level */
 					scatterRoot(handle);
-					nNodesDel += 3;
+					statAdd(nNodesDel, 3);
 					continue;
 				}
 
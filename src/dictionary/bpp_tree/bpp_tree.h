@@ -20,6 +20,22 @@ extern "C" {
 typedef long	ion_bpp_external_address_t;		/* record address for external record */
 typedef long	ion_bpp_address_t;		/* record address for btree node */
 
+/* minimum number of node buffers, see bOpen() */
+#define ION_BPP_MIN_BUFFERS 7
+
+/* number of node buffers used when bOpen() is given none */
+#if !defined(ION_BPP_BUFFER_COUNT)
+#if defined(ARDUINO)
+#define ION_BPP_BUFFER_COUNT ION_BPP_MIN_BUFFERS
+#else
+#define ION_BPP_BUFFER_COUNT 64
+#endif
+#endif
+
+/* node size used when a dictionary does not ask for one, and the largest it may ask for */
+#define ION_BPP_DEFAULT_SECTOR_SIZE 256
+#define ION_BPP_MAX_SECTOR_SIZE		65536
+
 #define ION_CC_EQ	0
 #define ION_CC_GT	1
 #define ION_CC_LT	-1
@@ -41,27 +57,35 @@ typedef char (*ion_bpp_comparison_t)(
  * implementation independent *
  ******************************/
 
-/* statistics */
-int maxHeight;	/* maximum height attained */
-int nNodesIns;	/* number of nodes inserted */
-int nNodesDel;	/* number of nodes deleted */
-int nKeysIns;	/* number of keys inserted */
-int nKeysDel;	/* number of keys deleted */
-int nDiskReads;	/* number of disk reads */
-int nDiskWrites;/* number of disk writes */
+/* statistics, summed over all trees; updated atomically when ION_THREAD_SAFE */
+extern int	maxHeight;	/* maximum height attained */
+extern int	nNodesIns;	/* number of nodes inserted */
+extern int	nNodesDel;	/* number of nodes deleted */
+extern int	nKeysIns;	/* number of keys inserted */
+extern int	nKeysDel;	/* number of keys deleted */
+extern int	nDiskReads;	/* number of disk reads */
+extern int	nDiskWrites;/* number of disk writes */
 
-/* line number for last IO or memory error */
-int bErrLineNo;
+/* line number for first IO or memory error */
+extern int bErrLineNo;
 
 typedef ion_boolean_e ion_bpp_bool_t;
 
 /* typedef enum {false, true} bool; */
 typedef enum ION_BPP_ERR {
-	bErrOk, bErrKeyNotFound, bErrDupKeys, bErrSectorSize, bErrFileNotOpen, bErrFileExists, bErrIO, bErrMemory
+	bErrOk, bErrKeyNotFound, bErrDupKeys, bErrSectorSize, bErrFileNotOpen, bErrFileExists, bErrIO, bErrMemory, bErrNotEmpty, bErrKeyOrder
 } ion_bpp_err_t;
 
 typedef void *ion_bpp_handle_t;
 
+/* supplies the next key, record address and inline value to bBulkLoad() */
+typedef ion_bpp_err_t (*ion_bpp_bulk_source_t)(
+	void						*state,
+	void						*key,
+	ion_bpp_external_address_t	*rec,
+	void						*value
+);
+
 typedef struct {
 	/* info for bOpen() */
 	char					*iName;	/* name of index file */
@@ -69,6 +93,9 @@ typedef struct {
 	ion_bpp_bool_t			dupKeys;		/* true if duplicate keys allowed */
 	size_t					sectorSize;	/* size of sector on disk */
 	ion_bpp_comparison_t	comp;			/* pointer to compare function */
+	int						bufCt;	/* number of node buffers, 0 for default */
+	int						valueSize;	/* length of value kept with each key, 0 for none */
+	ion_bpp_bool_t			mapped;	/* true to access the file through a memory mapping */
 } ion_bpp_open_t;
 
 /***********************
@@ -88,8 +115,15 @@ bOpen(
  * returns:
  *   bErrOk				 open was successful
  *   bErrMemory			 insufficient memory
- *   bErrSectorSize		 sector size too small or not 0 mod 4
+ *   bErrSectorSize		 sector size too small, too large or not 0 mod 4
  *   bErrFileNotOpen		unable to open index file
+ * notes:
+ *   bufCt is raised to ION_BPP_MIN_BUFFERS if smaller, and set to
+ *   ION_BPP_BUFFER_COUNT if 0.
+ *   New files record sectorSize and valueSize in a one sector header.
+ *   When opening a file that has one, the recorded sizes are used
+ *   instead of those in info; files without one use info.sectorSize
+ *   and no inline values.
 */
 
 ion_bpp_err_t
@@ -104,11 +138,28 @@ bClose(
  *   bErrOk				 file closed, resources deleted
 */
 
+ion_bpp_err_t
+bFlush(
+	ion_bpp_handle_t	handle,
+	ion_bpp_bool_t		sync
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   sync				 true to also wait until the file is on the
+ *						 storage device
+ * returns:
+ *   bErrOk				 modified buffers written
+ *   bErrIO				 file write error
+*/
+
 ion_bpp_err_t
 bInsertKey(
 	ion_bpp_handle_t			handle,
 	void						*key,
-	ion_bpp_external_address_t	rec
+	ion_bpp_external_address_t	rec,
+	void						*value
 );
 
 /*
@@ -116,6 +167,7 @@ bInsertKey(
  *   handle				 handle returned by bOpen
  *   key					key to insert
  *   rec					record address
+ *   value				  valueSize bytes stored with the key, unused if 0
  * returns:
  *   bErrOk				 operation successful
  *   bErrDupKeys			duplicate keys (and info.dupKeys = false)
@@ -127,11 +179,42 @@ bInsertKey(
  *   nodes to generate a "unique" key.
 */
 
+ion_bpp_err_t
+bBulkLoad(
+	ion_bpp_handle_t		handle,
+	long					nKeys,
+	int						fillPercent,
+	ion_bpp_bulk_source_t	source,
+	void					*state
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   nKeys				  number of keys source will supply
+ *   fillPercent			how full to pack each node, 1 to 100
+ *   source				 called nKeys times for the next key, record and value
+ *   state				  passed through to source
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrNotEmpty		   tree already holds keys
+ *   bErrKeyOrder		   keys not ascending (strictly, if dupKeys is false)
+ * notes:
+ *   Builds the tree bottom up: leaves are written once, in key order,
+ *   to consecutive sectors, and each interior level is built as the
+ *   level below it completes.  Nodes are never filled below half, so
+ *   the result can be updated with bInsertKey and bDeleteKey as usual.
+ *   With dupKeys true, equal keys must be ordered by record address.
+ *   The root is only written once every key has been placed, so a
+ *   failed load leaves the tree empty.
+*/
+
 ion_bpp_err_t
 bUpdateKey(
 	ion_bpp_handle_t			handle,
 	void						*key,
-	ion_bpp_external_address_t	rec
+	ion_bpp_external_address_t	rec,
+	void						*value
 );
 
 /*
@@ -139,6 +222,7 @@ bUpdateKey(
  *   handle				 handle returned by bOpen
  *   key					key to update
  *   rec					record address
+ *   value				  valueSize bytes stored with the key, unused if 0
  * returns:
  *   bErrOk				 operation successful
  *   bErrDupKeys			duplicate keys (and info.dupKeys = false)
@@ -264,6 +348,57 @@ bFindNextKey(
  *   bErrKeyNotFound		key not found
 */
 
+ion_bpp_err_t
+bCacheStats(
+	ion_bpp_handle_t	handle,
+	long				*hits,
+	long				*misses
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * output:
+ *   hits				   node reads satisfied by the buffer pool
+ *   misses				 node reads that went to disk
+ * returns:
+ *   bErrOk				 operation successful
+*/
+
+ion_bpp_err_t
+bValueSize(
+	ion_bpp_handle_t	handle,
+	int					*valueSize
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * output:
+ *   valueSize			  bytes of value stored with each key, 0 for none
+ * returns:
+ *   bErrOk				 operation successful
+*/
+
+ion_bpp_err_t
+bCurrentValue(
+	ion_bpp_handle_t	handle,
+	void				*value
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * output:
+ *   value				  value stored with the key last found
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrKeyNotFound		no current key
+ * notes:
+ *   The current key is set by bFindKey, bFindFirstKey, bFindLastKey,
+ *   bFindNextKey, bFindPrevKey and bFindFirstGreaterOrEqual.
+*/
+
 #if defined(__cplusplus)
 }
 #endif
@@ -20,8 +20,17 @@ bpptree_get_value_filename(
 @brief		Creates an instance of a dictionary.
 
 @details	Creates as instance of a dictionary given a @p key_size and
-			@p value_size, in bytes. The @p dictionary_size parameter is
-			not used for this implementation, as there is no size bound.
+			@p value_size, in bytes. There is no size bound, so
+			@p dictionary_size instead chooses the node size in bytes.
+			Powers of two from @ref ION_BPP_DEFAULT_SECTOR_SIZE to
+			@ref ION_BPP_MAX_SECTOR_SIZE are accepted, anything else
+			gives the default. An existing tree keeps the node size it
+			was created with.
+
+			Values of up to @ref ION_BPP_INLINE_VALUE_SIZE bytes are kept
+			in the tree next to their key, so a lookup reads no more than
+			the path to the leaf. The value file then only holds the
+			chains of keys that have been inserted more than once.
 @param		id
 				ID of a dictionary that's given to us.
 @param		key_type
@@ -31,7 +40,7 @@ bpptree_get_value_filename(
 @param		value_size
 				The size of the value in bytes.
 @param		dictionary_size
-				The size of the hashmap in discrete units
+				The node size in bytes.
 @param		compare
 				Function pointer for the comparison function for the dictionary.
 @param		handler
@@ -39,10 +48,13 @@ bpptree_get_value_filename(
 @param		dictionary
 				 The pointer declared by the caller that will reference
 				 the instance of the dictionary created.
+@param		mapped
+				Whether the tree and value files are accessed through
+				memory mappings rather than stdio streams.
 @return		The status of the creation of the dictionary.
 */
-ion_err_t
-bpptree_create_dictionary(
+static ion_err_t
+bpptree_create(
 	ion_dictionary_id_t			id,
 	ion_key_type_t				key_type,
 	ion_key_size_t				key_size,
@@ -50,10 +62,9 @@ bpptree_create_dictionary(
 	ion_dictionary_size_t		dictionary_size,
 	ion_dictionary_compare_t	compare,
 	ion_dictionary_handler_t	*handler,
-	ion_dictionary_t			*dictionary
+	ion_dictionary_t			*dictionary,
+	ion_boolean_t				mapped
 ) {
-	UNUSED(dictionary_size);
-
 	/* TODO: Uncomment this when IINQ has been merged into development */
 /*	if (key_size != sizeof(int)) {
 		return err_invalid_initial_size;
@@ -71,34 +82,52 @@ bpptree_create_dictionary(
 	char value_filename[20];
 
 	bpptree_get_value_filename(id, value_filename);
-	bpptree->values.file_handle = ion_fopen(value_filename);
+	bpptree->values.file_handle = mapped ? ion_fopen_mapped(value_filename) : ion_fopen(value_filename);
 
 	bpptree->values.next_empty	= ION_FILE_NULL;
 
 	/* FIXME: read this from a property bag. */
 
 	/* FIXME: VARIABLE NAMES! */
-	char addr_filename[ION_MAX_FILENAME_LENGTH];
-
-	int actual_filename_length = dictionary_get_filename(id, "bpt", addr_filename);
+	int actual_filename_length = dictionary_get_filename(id, "bpt", bpptree->filename);
 
 	if (actual_filename_length >= ION_MAX_FILENAME_LENGTH) {
 		return err_dictionary_initialization_failed;
 	}
 
-	info.iName		= addr_filename;
+	info.iName		= bpptree->filename;
 	info.keySize	= key_size;
 	info.dupKeys	= boolean_false;
-	/* FIXME: HOW DO WE SET BLOCK SIZE? */
-	info.sectorSize = 256;
+	info.sectorSize = ION_BPP_DEFAULT_SECTOR_SIZE;
+
+	if ((dictionary_size > ION_BPP_DEFAULT_SECTOR_SIZE) && (dictionary_size <= ION_BPP_MAX_SECTOR_SIZE) && (0 == (dictionary_size & (dictionary_size - 1)))) {
+		info.sectorSize = dictionary_size;
+	}
+
 	info.comp		= compare;
+	info.bufCt		= ION_BPP_BUFFER_COUNT;
+	info.valueSize	= (value_size <= ION_BPP_INLINE_VALUE_SIZE) ? value_size : 0;
+	info.mapped		= mapped;
 
 	ion_bpp_err_t bErr = bOpen(info, &(bpptree->tree));
 
+	if ((bErrSectorSize == bErr) && (0 != info.valueSize)) {
+		/* nodes are too small to hold the values as well */
+		info.valueSize	= 0;
+		bErr			= bOpen(info, &(bpptree->tree));
+	}
+
 	if (bErrOk != bErr) {
 		return err_dictionary_initialization_failed;
 	}
 
+	bpptree->info = info;
+
+	int inline_size;
+
+	bValueSize(bpptree->tree, &inline_size);
+	bpptree->inline_values = (0 != inline_size) && (value_size == inline_size);
+
 	dictionary->instance					= (ion_dictionary_parent_t *) bpptree;
 	dictionary->instance->compare			= compare;
 	dictionary->instance->key_type			= key_type;
@@ -110,6 +139,83 @@ bpptree_create_dictionary(
 	return err_ok;
 }
 
+ion_err_t
+bpptree_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	return bpptree_create(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary, boolean_false);
+}
+
+/**
+@brief		Creates an instance of a dictionary whose files are accessed
+			through memory mappings.
+@see		bpptree_create_dictionary
+*/
+ion_err_t
+bpptree_create_mapped_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	return bpptree_create(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary, boolean_true);
+}
+
+ion_err_t
+bpptree_cache_stats(
+	ion_dictionary_t	*dictionary,
+	long				*hits,
+	long				*misses
+) {
+	ion_bpptree_t *bpptree = (ion_bpptree_t *) dictionary->instance;
+
+	if (bErrOk != bCacheStats(bpptree->tree, hits, misses)) {
+		return err_illegal_state;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+bpptree_set_buffer_count(
+	ion_dictionary_t	*dictionary,
+	int					buffer_count
+) {
+	ion_bpptree_t	*bpptree	= (ion_bpptree_t *) dictionary->instance;
+	int				old_count	= bpptree->info.bufCt;
+
+	/* Closing writes out the modified nodes */
+	if (bErrOk != bClose(bpptree->tree)) {
+		return err_file_write_error;
+	}
+
+	bpptree->tree			= NULL;
+	bpptree->info.bufCt		= buffer_count;
+
+	if (bErrOk == bOpen(bpptree->info, &(bpptree->tree))) {
+		return err_ok;
+	}
+
+	bpptree->info.bufCt = old_count;
+
+	if (bErrOk != bOpen(bpptree->info, &(bpptree->tree))) {
+		return err_dictionary_initialization_failed;
+	}
+
+	return err_out_of_memory;
+}
+
 /**
 @brief		Inserts a @p key and @p value into the dictionary.
 
@@ -139,16 +245,34 @@ bpptree_insert(
 
 	if (bErrKeyNotFound == bErr) {
 		offset = ION_FILE_NULL;
+
+		if (bpptree->inline_values) {
+			if (bErrOk != bInsertKey(bpptree->tree, key, ION_BPP_VALUE_INLINE, value)) {
+				return ION_STATUS_ERROR(err_unable_to_insert);
+			}
+
+			return ION_STATUS_OK(1);
+		}
+	}
+	else if (ION_BPP_VALUE_INLINE == offset) {
+		/* a second value for the key starts a chain with the inline one */
+		ion_byte_t inline_value[ION_BPP_INLINE_VALUE_SIZE];
+
+		bCurrentValue(bpptree->tree, inline_value);
+
+		if (err_ok != lfb_put(&(bpptree->values), inline_value, bpptree->super.record.value_size, ION_FILE_NULL, &offset)) {
+			return ION_STATUS_ERROR(err_unable_to_insert);
+		}
 	}
 
 	err = lfb_put(&(bpptree->values), (ion_byte_t *) value, bpptree->super.record.value_size, offset, &offset);
 
 	if (err_ok == err) {
 		if (bErrKeyNotFound == bErr) {
-			bErr = bInsertKey(bpptree->tree, key, offset);
+			bErr = bInsertKey(bpptree->tree, key, offset, value);
 		}
 		else {
-			bErr = bUpdateKey(bpptree->tree, key, offset);
+			bErr = bUpdateKey(bpptree->tree, key, offset, value);
 		}
 
 		if (bErrOk != bErr) {
@@ -163,6 +287,134 @@ bpptree_insert(
 	}
 }
 
+/**
+@brief		Where @ref bpptree_bulk_source is in the caller's sorted records.
+*/
+typedef struct {
+	ion_bpptree_t		*bpptree;	/**< Tree being loaded. */
+	ion_byte_t			*keys;		/**< Sorted keys, packed back to back. */
+	ion_byte_t			*values;	/**< Values, in the same order as @p keys. */
+	int					num_records;/**< Number of records in @p keys. */
+	int					next_record;/**< Index of the next record to hand out. */
+	ion_file_offset_t	end;		/**< End of the value file. */
+} ion_bpp_bulk_state_t;
+
+/**
+@brief		Supplies the next distinct key to @ref bBulkLoad.
+
+@details	A key with a single record has its value kept in the tree if
+			the dictionary keeps values inline. Otherwise the values of
+			every record with that key are appended to the value file,
+			linked together as @ref bpptree_insert would link them, and
+			the key is handed back with the offset of the last value.
+
+@param		state
+				The @ref ion_bpp_bulk_state_t of the load.
+@param		key
+				Where to write the key.
+@param		rec
+				Where to write the offset of the key's values.
+@param		value
+				Where to write the value if it is kept inline.
+@return		The status of the value writes.
+*/
+static ion_bpp_err_t
+bpptree_bulk_source(
+	void						*state,
+	void						*key,
+	ion_bpp_external_address_t	*rec,
+	void						*value
+) {
+	ion_bpp_bulk_state_t	*bulk		= (ion_bpp_bulk_state_t *) state;
+	ion_bpptree_t			*bpptree	= bulk->bpptree;
+	ion_key_size_t			key_size	= bpptree->super.record.key_size;
+	ion_value_size_t		value_size	= bpptree->super.record.value_size;
+	ion_byte_t				*first_key	= bulk->keys + bulk->next_record * key_size;
+	ion_file_offset_t		offset		= ION_FILE_NULL;
+
+	memcpy(key, first_key, key_size);
+
+	if (bpptree->inline_values && ((bulk->next_record + 1 == bulk->num_records) || (0 != bpptree->super.compare(first_key + key_size, first_key, key_size)))) {
+		memcpy(value, bulk->values + bulk->next_record * value_size, value_size);
+		*rec = ION_BPP_VALUE_INLINE;
+		bulk->next_record++;
+		return bErrOk;
+	}
+
+	do {
+		if (err_ok != lfb_append(&(bpptree->values), bulk->values + bulk->next_record * value_size, value_size, offset, &bulk->end)) {
+			return bErrIO;
+		}
+
+		offset = bulk->end - (ion_file_offset_t) (sizeof(ion_file_offset_t) + value_size);
+		bulk->next_record++;
+	} while ((bulk->next_record < bulk->num_records) && (0 == bpptree->super.compare(bulk->keys + bulk->next_record * key_size, first_key, key_size)));
+
+	*rec = offset;
+
+	return bErrOk;
+}
+
+ion_status_t
+bpptree_bulk_load(
+	ion_dictionary_t	*dictionary,
+	ion_byte_t			*keys,
+	ion_byte_t			*values,
+	int					num_records,
+	int					fill_percent
+) {
+	ion_bpptree_t			*bpptree;
+	ion_bpp_bulk_state_t	bulk;
+	ion_key_size_t			key_size;
+	ion_bpp_err_t			bErr;
+	long					num_keys;
+	int						i;
+
+	bpptree		= (ion_bpptree_t *) dictionary->instance;
+	key_size	= bpptree->super.record.key_size;
+
+	/* count the distinct keys, each record's value goes under one of them */
+	num_keys	= 0;
+
+	for (i = 0; i < num_records; i++) {
+		char cc = (0 == i) ? ION_IS_GREATER : bpptree->super.compare(keys + i * key_size, keys + (i - 1) * key_size, key_size);
+
+		if (ION_IS_LESS == cc) {
+			return ION_STATUS_ERROR(err_sorted_order_violation);
+		}
+
+		if (ION_IS_EQUAL != cc) {
+			num_keys++;
+		}
+	}
+
+	bulk.bpptree		= bpptree;
+	bulk.keys			= keys;
+	bulk.values			= values;
+	bulk.num_records	= num_records;
+	bulk.next_record	= 0;
+	bulk.end			= ION_FILE_NULL;
+
+	bErr				= bBulkLoad(bpptree->tree, num_keys, fill_percent, bpptree_bulk_source, &bulk);
+
+	switch (bErr) {
+		case bErrOk:
+			return ION_STATUS_OK(num_records);
+
+		case bErrNotEmpty:
+			return ION_STATUS_ERROR(err_illegal_state);
+
+		case bErrKeyOrder:
+			return ION_STATUS_ERROR(err_sorted_order_violation);
+
+		case bErrMemory:
+			return ION_STATUS_ERROR(err_out_of_memory);
+
+		default:
+			return ION_STATUS_ERROR(err_file_write_error);
+	}
+}
+
 /**
 @brief	  Queries a dictionary instance for the given @p key and returns
 			the associated @p value.
@@ -207,6 +459,11 @@ bpptree_query(
 		return ION_STATUS_ERROR(err_item_not_found);
 	}
 
+	if (ION_BPP_VALUE_INLINE == offset) {
+		bCurrentValue(bpptree->tree, value);
+		return ION_STATUS_OK(1);
+	}
+
 	err = lfb_get(&(bpptree->values), offset, bpptree->super.record.value_size, (ion_byte_t *) value, &next);
 
 	if (err_ok == err) {
@@ -216,6 +473,181 @@ bpptree_query(
 	return ION_STATUS_ERROR(err);
 }
 
+/**
+@brief		Orders a batch by the value file offset of each record.
+*/
+static int
+bpptree_compare_offset_order(
+	void	*context,
+	int		a,
+	int		b
+) {
+	ion_file_offset_t *offsets = (ion_file_offset_t *) context;
+
+	return (offsets[a] > offsets[b]) - (offsets[a] < offsets[b]);
+}
+
+/**
+@brief		Queries a dictionary instance for many keys at once.
+
+@details	Keys are looked up in ascending order, so that neighbouring
+			keys find the leaves and their parents already in the buffer
+			pool. Values kept in the tree are copied out as each key is
+			found. The rest are then read from the value file in file
+			order.
+
+@param		dictionary
+				The instance of the dictionary to query.
+@param		keys
+				@p num_keys keys, packed back to back.
+@param		values
+				Room for @p num_keys values, packed back to back.
+@param		statuses
+				The status of each key's lookup.
+@param		num_keys
+				The number of keys.
+@return		The combined status of the lookups.
+*/
+ion_status_t
+bpptree_multi_get(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_keys
+) {
+	ion_bpptree_t		*bpptree;
+	ion_key_size_t		key_size;
+	ion_value_size_t	value_size;
+	ion_file_offset_t	*offsets;
+	ion_file_offset_t	next;
+	int					*order;
+	ion_err_t			err;
+	int					i;
+	int					j;
+
+	bpptree		= (ion_bpptree_t *) dictionary->instance;
+	key_size	= bpptree->super.record.key_size;
+	value_size	= bpptree->super.record.value_size;
+
+	order		= malloc(num_keys * sizeof(int));
+	offsets		= malloc(num_keys * sizeof(ion_file_offset_t));
+
+	if ((NULL == order) || (NULL == offsets)) {
+		free(order);
+		free(offsets);
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	err = dictionary_sort_keys(dictionary->instance, keys, num_keys, order);
+
+	for (i = 0; (err_ok == err) && (i < num_keys); i++) {
+		j			= order[i];
+		offsets[j]	= ION_FILE_NULL;
+
+		if (bErrOk != bFindKey(bpptree->tree, (ion_byte_t *) keys + j * key_size, &next)) {
+			statuses[j] = ION_STATUS_ERROR(err_item_not_found);
+			continue;
+		}
+
+		statuses[j] = ION_STATUS_OK(1);
+
+		if (ION_BPP_VALUE_INLINE == next) {
+			bCurrentValue(bpptree->tree, (ion_byte_t *) values + j * value_size);
+		}
+		else {
+			offsets[j] = next;
+		}
+	}
+
+	if (err_ok == err) {
+		err = dictionary_sort_order(order, num_keys, bpptree_compare_offset_order, offsets);
+	}
+
+	for (i = 0; (err_ok == err) && (i < num_keys); i++) {
+		j = order[i];
+
+		if (ION_FILE_NULL == offsets[j]) {
+			continue;
+		}
+
+		if (err_ok != lfb_get(&(bpptree->values), offsets[j], value_size, (ion_byte_t *) values + j * value_size, &next)) {
+			statuses[j] = ION_STATUS_ERROR(err_file_read_error);
+		}
+	}
+
+	free(order);
+	free(offsets);
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	return dictionary_batch_status(statuses, num_keys);
+}
+
+/**
+@brief		Inserts many records at once.
+
+@details	Records are inserted in ascending key order, so that each leaf
+			is changed by every record that lands in it while it is still
+			in the buffer pool, and is written out once when it is evicted
+			rather than once per record. Records with equal keys keep their
+			batch order.
+
+@param		dictionary
+				The instance of the dictionary to insert into.
+@param		keys
+				@p num_records keys, packed back to back.
+@param		values
+				@p num_records values, packed back to back.
+@param		statuses
+				The status of each record's insert.
+@param		num_records
+				The number of records.
+@return		The combined status of the inserts.
+*/
+ion_status_t
+bpptree_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_records
+) {
+	ion_key_size_t		key_size;
+	ion_value_size_t	value_size;
+	int					*order;
+	ion_err_t			err;
+	int					i;
+	int					j;
+
+	key_size	= dictionary->instance->record.key_size;
+	value_size	= dictionary->instance->record.value_size;
+
+	order		= malloc(num_records * sizeof(int));
+
+	if (NULL == order) {
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	err = dictionary_sort_keys(dictionary->instance, keys, num_records, order);
+
+	if (err_ok != err) {
+		free(order);
+		return ION_STATUS_ERROR(err);
+	}
+
+	for (i = 0; i < num_records; i++) {
+		j			= order[i];
+		statuses[j] = bpptree_insert(dictionary, (ion_byte_t *) keys + j * key_size, (ion_byte_t *) values + j * value_size);
+	}
+
+	free(order);
+
+	return dictionary_batch_status(statuses, num_records);
+}
+
 /**
 @brief		Deletes the @p key and assoicated value from the dictionary
 			instance.
@@ -242,11 +674,15 @@ bpptree_delete(
 
 	bErr	= bDeleteKey(bpptree->tree, key, &offset);
 
-	if (bErrKeyNotFound != bErr) {
-		status.error = lfb_delete_all(&(bpptree->values), offset, &(status.count));
+	if (bErrKeyNotFound == bErr) {
+		status.error = err_item_not_found;
+	}
+	else if (ION_BPP_VALUE_INLINE == offset) {
+		status.error	= err_ok;
+		status.count	= 1;
 	}
 	else {
-		status.error = err_item_not_found;
+		status.error = lfb_delete_all(&(bpptree->values), offset, &(status.count));
 	}
 
 	return status;
@@ -273,6 +709,31 @@ bpptree_close_dictionary(
 	return err_ok;
 }
 
+/**
+@brief		Writes out the modified nodes of the tree, and what is buffered
+			for its files.
+
+@param	  dictionary
+				The instance of the dictionary to flush.
+@param	  sync
+				Whether to also wait until the files are on the storage
+				device.
+@return		The status of the flush.
+*/
+ion_err_t
+bpptree_flush_dictionary(
+	ion_dictionary_t	*dictionary,
+	ion_boolean_t		sync
+) {
+	ion_bpptree_t *bpptree = (ion_bpptree_t *) dictionary->instance;
+
+	if (bErrOk != bFlush(bpptree->tree, sync)) {
+		return err_file_write_error;
+	}
+
+	return sync ? ion_fsync(bpptree->values.file_handle) : ion_fflush(bpptree->values.file_handle);
+}
+
 /**
 @brief	  Deletes an instance of the dictionary and associated data.
 
@@ -338,11 +799,18 @@ bpptree_update(
 
 	bErr	= bFindKey(bpptree->tree, key, &offset);
 
-	if (bErrKeyNotFound != bErr) {
-		lfb_update_all(&(bpptree->values), offset, bpptree->super.record.value_size, (ion_byte_t *) value, &count);
+	if (bErrKeyNotFound == bErr) {
+		return bpptree_insert(dictionary, key, value);
+	}
+	else if (ION_BPP_VALUE_INLINE == offset) {
+		if (bErrOk != bUpdateKey(bpptree->tree, key, offset, value)) {
+			return ION_STATUS_ERROR(err_file_write_error);
+		}
+
+		count = 1;
 	}
 	else {
-		return bpptree_insert(dictionary, key, value);
+		lfb_update_all(&(bpptree->values), offset, bpptree->super.record.value_size, (ion_byte_t *) value, &count);
 	}
 
 	return ION_STATUS_OK(count);
@@ -434,7 +902,14 @@ bpptree_next(
 		memcpy(record->key, bCursor->cur_key, cursor->dictionary->instance->record.key_size);
 
 		/* Get value */
-		lfb_get(&(bpptree->values), bCursor->offset, cursor->dictionary->instance->record.value_size, record->value, &bCursor->offset);
+		if (ION_BPP_VALUE_INLINE == bCursor->offset) {
+			bCurrentValue(bpptree->tree, record->value);
+			bCursor->offset = ION_FILE_NULL;
+		}
+		else {
+			lfb_get(&(bpptree->values), bCursor->offset, cursor->dictionary->instance->record.value_size, record->value, &bCursor->offset);
+		}
+
 		return cursor->status;
 	}
 
@@ -636,6 +1111,16 @@ bpptree_open_dictionary(
 	return bpptree_create_dictionary(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, compare, handler, dictionary);
 }
 
+ion_err_t
+bpptree_open_mapped_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	return bpptree_create_mapped_dictionary(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, compare, handler, dictionary);
+}
+
 void
 bpptree_init(
 	ion_dictionary_handler_t *handler
@@ -648,5 +1133,18 @@ bpptree_init(
 	handler->remove				= bpptree_delete;
 	handler->delete_dictionary	= bpptree_delete_dictionary;
 	handler->open_dictionary	= bpptree_open_dictionary;
+	handler->concurrency		= ion_concurrency_serial;
 	handler->close_dictionary	= bpptree_close_dictionary;
+	handler->multi_get			= bpptree_multi_get;
+	handler->insert_batch		= bpptree_insert_batch;
+	handler->flush_dictionary	= bpptree_flush_dictionary;
+}
+
+void
+bpptree_mapped_init(
+	ion_dictionary_handler_t *handler
+) {
+	bpptree_init(handler);
+	handler->create_dictionary	= bpptree_create_mapped_dictionary;
+	handler->open_dictionary	= bpptree_open_mapped_dictionary;
 }
@@ -19,10 +19,26 @@ extern "C" {
 #include "../../file/linked_file_bag.h"
 #include "bpp_tree.h"
 
+/**
+@brief		Largest value, in bytes, that is kept in the tree itself rather
+			than in the value file.
+*/
+#if !defined(ION_BPP_INLINE_VALUE_SIZE)
+#define ION_BPP_INLINE_VALUE_SIZE 16
+#endif
+
+/**
+@brief		Record address of a key whose only value is kept in the tree.
+*/
+#define ION_BPP_VALUE_INLINE -2
+
 typedef struct bplusplustree {
 	ion_dictionary_parent_t super;
 	ion_bpp_handle_t		tree;
 	ion_lfb_t				values;
+	ion_boolean_t			inline_values;	/**< True if a key's first value is kept in the tree. */
+	ion_bpp_open_t			info;	/**< How the tree was opened, so it can be reopened with another number of node buffers. */
+	char					filename[ION_MAX_FILENAME_LENGTH];	/**< The name of the tree file, which @p info refers to. */
 } ion_bpptree_t;
 
 typedef struct {
@@ -46,6 +62,108 @@ bpptree_init(
 	ion_dictionary_handler_t *handler
 );
 
+/**
+@brief		Registers the handler for trees whose index and value files are
+			accessed through memory mappings instead of stdio streams.
+
+@details	The file formats are unchanged, so a tree may be reopened with
+			either handler.
+
+@param	  handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+bpptree_mapped_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Gives how many node reads of a B+ tree dictionary were found in
+			its node buffers, and how many went to its file.
+
+@details	The counts start over when the dictionary is opened, and
+			when its number of buffers is changed with
+			@ref bpptree_set_buffer_count. Either includes the read of the
+			root made while opening the tree.
+
+@param		dictionary
+				The B+ tree dictionary instance to read the counts of.
+@param[out]	hits
+				The node reads found in the buffers.
+@param[out]	misses
+				The node reads that went to the file.
+@return		The status of reading the counts.
+*/
+ion_err_t
+bpptree_cache_stats(
+	ion_dictionary_t	*dictionary,
+	long				*hits,
+	long				*misses
+);
+
+/**
+@brief		Changes the number of node buffers of an open B+ tree
+			dictionary.
+
+@details	A dictionary is opened with @ref ION_BPP_BUFFER_COUNT buffers.
+			Its modified nodes are written out, and the tree is reopened
+			with @p buffer_count buffers, so the size can be picked from the
+			counts given by @ref bpptree_cache_stats once the dictionary has
+			been used for a while. The counts start over.
+
+@param		dictionary
+				The B+ tree dictionary instance to resize the buffers of.
+@param		buffer_count
+				The number of node buffers, or 0 for
+				@ref ION_BPP_BUFFER_COUNT. It is raised to
+				@ref ION_BPP_MIN_BUFFERS if smaller.
+@return		The status of resizing the buffers. If the tree cannot be
+			reopened with the new number, it is reopened with the old one
+			and @ref err_out_of_memory is given.
+*/
+ion_err_t
+bpptree_set_buffer_count(
+	ion_dictionary_t	*dictionary,
+	int					buffer_count
+);
+
+/**
+@brief		Loads an empty B+ tree dictionary from records sorted by key.
+
+@details	Builds the tree from the leaves up instead of inserting keys one
+			at a time, and appends the values to the value file in order.
+			Records with equal keys are kept as duplicates, exactly as if
+			they had been inserted in the given order.
+
+@param		dictionary
+				The B+ tree dictionary instance to load. It must be empty.
+@param		keys
+				@p num_records keys, packed back to back and sorted in
+				ascending order by the dictionary's comparison function.
+@param		values
+				@p num_records values, packed back to back, in the same
+				order as @p keys.
+@param		num_records
+				The number of records to load.
+@param		fill_percent
+				How full to pack each node, from 1 to 100. Nodes are never
+				packed below half full. Lower values leave room for later
+				inserts, 100 gives the smallest and shallowest tree.
+@return		The status of the load. The count is the number of records
+			loaded. The error is @ref err_sorted_order_violation if the
+			keys are out of order, and @ref err_illegal_state if the
+			dictionary is not empty.
+*/
+ion_status_t
+bpptree_bulk_load(
+	ion_dictionary_t	*dictionary,
+	ion_byte_t			*keys,
+	ion_byte_t			*values,
+	int					num_records,
+	int					fill_percent
+);
+
 #if defined(__cplusplus)
 }
 #endif
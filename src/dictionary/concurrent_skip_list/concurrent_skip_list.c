@@ -0,0 +1,655 @@
+/******************************************************************************/
+/**
+@file
+@brief		A skiplist that many threads may read and write at once.
+@details	Nodes are linked in at each level with compare-and-swap. A node
+			is deleted by setting the lowest bit of each of its links, top
+			down, after which no thread will link anything after it and any
+			search that passes it unlinks it. Searches for reading only step
+			over deleted nodes, so they never write or restart.
+
+			Memory is reclaimed by epochs. Each operation announces the
+			global epoch in a slot of its own while it runs, and the global
+			epoch only moves on once every announced epoch has caught up with
+			it. What is unlinked in one epoch is therefore unreachable to all
+			operations two epochs on, and is freed then.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#include "concurrent_skip_list.h"
+
+#define CSL_MARKED(link)	(0 != ((link) & (uintptr_t) 1))
+#define CSL_NODE(link)		((ion_csl_node_t *) ((link) & ~(uintptr_t) 1))
+#define CSL_LINK(node)		((uintptr_t) (node))
+#define CSL_LOAD(pointer)	__atomic_load_n(pointer, __ATOMIC_ACQUIRE)
+
+/**
+@brief		Swaps @p link from @p expected to @p desired, if it still holds
+			@p expected.
+*/
+static ion_boolean_t
+csl_swap_link(
+	uintptr_t	*link,
+	uintptr_t	expected,
+	uintptr_t	desired
+) {
+	return __atomic_compare_exchange_n(link, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/**
+@brief		Adds a chain of retired memory to the memory waiting to be
+			freed.
+*/
+static void
+csl_push_retired(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_csl_retired_t			*first,
+	ion_csl_retired_t			*last
+) {
+	ion_csl_retired_t *head = __atomic_load_n(&skiplist->retired, __ATOMIC_RELAXED);
+
+	do {
+		last->next = head;
+	} while (!__atomic_compare_exchange_n(&skiplist->retired, &head, first, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+@brief		Moves the global epoch on if every thread has caught up with it,
+			and frees the retired memory old enough to be unreachable.
+*/
+static void
+csl_reclaim(
+	ion_concurrent_skiplist_t *skiplist
+) {
+	unsigned long		epoch	= __atomic_load_n(&skiplist->epoch, __ATOMIC_SEQ_CST);
+	ion_csl_retired_t	*keep	= NULL;
+	ion_csl_retired_t	*last	= NULL;
+	ion_csl_retired_t	*retired;
+	int					i;
+
+	for (i = 0; i < ION_CSL_MAX_THREADS; i++) {
+		unsigned long announced = __atomic_load_n(&skiplist->slots[i].epoch, __ATOMIC_SEQ_CST);
+
+		if ((0 != announced) && (epoch != announced)) {
+			break;
+		}
+	}
+
+	if (ION_CSL_MAX_THREADS == i) {
+		__atomic_compare_exchange_n(&skiplist->epoch, &epoch, epoch + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+		epoch = __atomic_load_n(&skiplist->epoch, __ATOMIC_SEQ_CST);
+	}
+
+	/* Whoever takes the retired memory owns it, so it can be walked without interference. */
+	retired = __atomic_exchange_n(&skiplist->retired, NULL, __ATOMIC_ACQ_REL);
+
+	while (NULL != retired) {
+		ion_csl_retired_t *next = retired->next;
+
+		if (retired->epoch + 2 <= epoch) {
+			free(retired);
+		}
+		else {
+			if (NULL == keep) {
+				last = retired;
+			}
+
+			retired->next	= keep;
+			keep			= retired;
+		}
+
+		retired = next;
+	}
+
+	if (NULL != keep) {
+		csl_push_retired(skiplist, keep, last);
+	}
+}
+
+/**
+@brief		Hands memory that has been unlinked over to be freed once no
+			thread can still be reading it.
+*/
+static void
+csl_retire(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_csl_retired_t			*retired
+) {
+	retired->epoch = __atomic_load_n(&skiplist->epoch, __ATOMIC_SEQ_CST);
+	csl_push_retired(skiplist, retired, retired);
+
+	if (0 == __atomic_add_fetch(&skiplist->retire_count, 1, __ATOMIC_RELAXED) % ION_CSL_RECLAIM_INTERVAL) {
+		csl_reclaim(skiplist);
+	}
+}
+
+/**
+@brief		Drops one reference to a node, retiring it and its value once
+			both the inserter and the deleter are done with it.
+*/
+static void
+csl_release(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_csl_node_t				*node
+) {
+	ion_csl_retired_t *value;
+
+	if (0 != __atomic_sub_fetch(&node->references, 1, __ATOMIC_ACQ_REL)) {
+		return;
+	}
+
+	value = __atomic_exchange_n(&node->value, NULL, __ATOMIC_ACQ_REL);
+
+	if (NULL != value) {
+		csl_retire(skiplist, value);
+	}
+
+	csl_retire(skiplist, &node->retired);
+}
+
+/**
+@brief		Allocates a value block holding a copy of @p value.
+*/
+static ion_csl_retired_t *
+csl_new_value(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_value_t					value
+) {
+	ion_csl_retired_t *block = malloc(sizeof(ion_csl_retired_t) + skiplist->super.record.value_size);
+
+	if (NULL != block) {
+		memcpy(block + 1, value, skiplist->super.record.value_size);
+	}
+
+	return block;
+}
+
+/**
+@brief		Picks the height index of a new node, going up a level with a
+			probability of one in four.
+*/
+static int
+csl_random_level(
+	ion_concurrent_skiplist_t *skiplist
+) {
+	uint32_t	bits	= __atomic_add_fetch(&skiplist->level_seed, 1, __ATOMIC_RELAXED);
+	int			level	= 0;
+
+	/* Mixed so that consecutive counts give unrelated bits. */
+	bits	*= (uint32_t) 0x9E3779B1UL;
+	bits	^= bits >> 16;
+	bits	*= (uint32_t) 0x85EBCA6BUL;
+	bits	^= bits >> 13;
+	bits	*= (uint32_t) 0xC2B2AE35UL;
+	bits	^= bits >> 16;
+
+	while ((level < skiplist->head->height) && (0 == (bits & 3))) {
+		level++;
+		bits >>= 2;
+	}
+
+	return level;
+}
+
+/**
+@brief		Finds, at each level, the last node before @p key and the first
+			node not before it, unlinking deleted nodes on the way.
+
+@return		Whether @p key is in the list, as the first node of @p succs.
+*/
+static ion_boolean_t
+csl_search(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_csl_node_t				**preds,
+	ion_csl_node_t				**succs
+) {
+	ion_key_size_t	key_size = skiplist->super.record.key_size;
+	ion_csl_node_t	*pred;
+	ion_csl_node_t	*curr = NULL;
+	uintptr_t		succ;
+	int				level;
+
+retry:
+	pred = skiplist->head;
+
+	for (level = skiplist->head->height; level >= 0; level--) {
+		curr = CSL_NODE(CSL_LOAD(&pred->next[level]));
+
+		while (NULL != curr) {
+			succ = CSL_LOAD(&curr->next[level]);
+
+			while (CSL_MARKED(succ)) {
+				/* The node is being deleted, so unlink it on the way past. */
+				if (!csl_swap_link(&pred->next[level], CSL_LINK(curr), succ & ~(uintptr_t) 1)) {
+					goto retry;
+				}
+
+				curr = CSL_NODE(succ);
+
+				if (NULL == curr) {
+					break;
+				}
+
+				succ = CSL_LOAD(&curr->next[level]);
+			}
+
+			if ((NULL == curr) || (skiplist->super.compare(CSL_NODE_KEY(curr), key, key_size) >= 0)) {
+				break;
+			}
+
+			pred	= curr;
+			curr	= CSL_NODE(succ);
+		}
+
+		preds[level]	= pred;
+		succs[level]	= curr;
+	}
+
+	return (NULL != curr) && (0 == skiplist->super.compare(CSL_NODE_KEY(curr), key, key_size));
+}
+
+int
+csl_enter(
+	ion_concurrent_skiplist_t *skiplist
+) {
+	unsigned int	slot = __atomic_fetch_add(&skiplist->next_slot, 1, __ATOMIC_RELAXED) % ION_CSL_MAX_THREADS;
+	unsigned long	epoch;
+	unsigned long	current;
+
+	for (;; slot = (slot + 1) % ION_CSL_MAX_THREADS) {
+		unsigned long free_slot = 0;
+
+		epoch = __atomic_load_n(&skiplist->epoch, __ATOMIC_SEQ_CST);
+
+		if (__atomic_compare_exchange_n(&skiplist->slots[slot].epoch, &free_slot, epoch, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+			break;
+		}
+	}
+
+	/* The epoch may have moved on before the slot was taken, which would hold up the next move. */
+	while (epoch != (current = __atomic_load_n(&skiplist->epoch, __ATOMIC_SEQ_CST))) {
+		__atomic_store_n(&skiplist->slots[slot].epoch, current, __ATOMIC_SEQ_CST);
+		epoch = current;
+	}
+
+	return (int) slot;
+}
+
+void
+csl_leave(
+	ion_concurrent_skiplist_t	*skiplist,
+	int							slot
+) {
+	__atomic_store_n(&skiplist->slots[slot].epoch, 0, __ATOMIC_RELEASE);
+}
+
+ion_err_t
+csl_initialize(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	int							maxheight
+) {
+	int i;
+
+	if (maxheight < 1) {
+		maxheight = 1;
+	}
+	else if (maxheight > ION_CSL_MAX_HEIGHT) {
+		maxheight = ION_CSL_MAX_HEIGHT;
+	}
+
+	skiplist->super.key_type			= key_type;
+	skiplist->super.record.key_size		= key_size;
+	skiplist->super.record.value_size	= value_size;
+
+	memset(skiplist->slots, 0, sizeof(skiplist->slots));
+	skiplist->epoch						= 1;
+	skiplist->retired					= NULL;
+	skiplist->retire_count				= 0;
+	skiplist->next_slot					= 0;
+	skiplist->level_seed				= 0;
+
+	skiplist->head						= malloc(sizeof(ion_csl_node_t) + sizeof(uintptr_t) * maxheight);
+
+	if (NULL == skiplist->head) {
+		return err_out_of_memory;
+	}
+
+	skiplist->head->value		= NULL;
+	skiplist->head->references	= 1;
+	skiplist->head->height		= maxheight - 1;
+
+	for (i = 0; i < maxheight; i++) {
+		skiplist->head->next[i] = CSL_LINK(NULL);
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+csl_destroy(
+	ion_concurrent_skiplist_t *skiplist
+) {
+	ion_csl_node_t		*node;
+	ion_csl_retired_t	*retired;
+
+	if (NULL == skiplist->head) {
+		return err_ok;
+	}
+
+	/* Deleted nodes are unlinked before their deletes return, so what is left linked is live. */
+	node = CSL_NODE(skiplist->head->next[0]);
+
+	while (NULL != node) {
+		ion_csl_node_t *next = CSL_NODE(node->next[0]);
+
+		free(node->value);
+		free(node);
+		node = next;
+	}
+
+	free(skiplist->head);
+	skiplist->head = NULL;
+
+	while (NULL != skiplist->retired) {
+		retired				= skiplist->retired;
+		skiplist->retired	= retired->next;
+		free(retired);
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Inserts a node for @p key, from within an epoch.
+*/
+static ion_status_t
+csl_insert_node(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+) {
+	ion_csl_node_t	*preds[ION_CSL_MAX_HEIGHT];
+	ion_csl_node_t	*succs[ION_CSL_MAX_HEIGHT];
+	ion_csl_node_t	*node;
+	int				height = csl_random_level(skiplist);
+	int				level;
+
+	node = malloc(sizeof(ion_csl_node_t) + sizeof(uintptr_t) * (height + 1) + skiplist->super.record.key_size);
+
+	if (NULL == node) {
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	node->value = csl_new_value(skiplist, value);
+
+	if (NULL == node->value) {
+		free(node);
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	node->references	= 2;
+	node->height		= height;
+	memcpy(CSL_NODE_KEY(node), key, skiplist->super.record.key_size);
+
+	do {
+		if (csl_search(skiplist, key, preds, succs)) {
+			free(node->value);
+			free(node);
+			return ION_STATUS_ERROR(err_duplicate_key);
+		}
+
+		for (level = 0; level <= height; level++) {
+			node->next[level] = CSL_LINK(succs[level]);
+		}
+	} while (!csl_swap_link(&preds[0]->next[0], CSL_LINK(succs[0]), CSL_LINK(node)));
+
+	/* The node is in the list once linked at the bottom; the levels above only speed up searches. */
+	for (level = 1; level <= height; level++) {
+		for (;;) {
+			uintptr_t link = CSL_LOAD(&node->next[level]);
+
+			/* Stop once a delete has started, so that nothing is linked to the node after it is unlinked. */
+			if (CSL_MARKED(link) || ((link != CSL_LINK(succs[level])) && !csl_swap_link(&node->next[level], link, CSL_LINK(succs[level])))) {
+				level = height;
+				break;
+			}
+
+			if (csl_swap_link(&preds[level]->next[level], CSL_LINK(succs[level]), CSL_LINK(node))) {
+				break;
+			}
+
+			csl_search(skiplist, key, preds, succs);
+
+			if (succs[0] != node) {
+				level = height;
+				break;
+			}
+		}
+	}
+
+	/* A delete that ran alongside may have unlinked the node before it was linked above. */
+	if (CSL_MARKED(CSL_LOAD(&node->next[0]))) {
+		csl_search(skiplist, key, preds, succs);
+	}
+
+	csl_release(skiplist, node);
+
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+csl_insert(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+) {
+	int				slot	= csl_enter(skiplist);
+	ion_status_t	status	= csl_insert_node(skiplist, key, value);
+
+	csl_leave(skiplist, slot);
+
+	return status;
+}
+
+ion_csl_node_t *
+csl_find_node(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key
+) {
+	ion_key_size_t	key_size	= skiplist->super.record.key_size;
+	ion_csl_node_t	*pred		= skiplist->head;
+	ion_csl_node_t	*curr		= NULL;
+	uintptr_t		succ;
+	int				level;
+
+	for (level = skiplist->head->height; level >= 0; level--) {
+		curr = CSL_NODE(CSL_LOAD(&pred->next[level]));
+
+		while (NULL != curr) {
+			succ = CSL_LOAD(&curr->next[level]);
+
+			/* Deleted nodes are stepped over rather than unlinked, so that reading never writes. */
+			if (CSL_MARKED(succ)) {
+				curr = CSL_NODE(succ);
+				continue;
+			}
+
+			if ((NULL == key) || (skiplist->super.compare(CSL_NODE_KEY(curr), key, key_size) >= 0)) {
+				break;
+			}
+
+			pred	= curr;
+			curr	= CSL_NODE(succ);
+		}
+	}
+
+	return curr;
+}
+
+ion_csl_node_t *
+csl_next_node(
+	ion_csl_node_t *node
+) {
+	uintptr_t link = CSL_LOAD(&node->next[0]);
+
+	for (node = CSL_NODE(link); NULL != node; node = CSL_NODE(link)) {
+		link = CSL_LOAD(&node->next[0]);
+
+		if (!CSL_MARKED(link)) {
+			break;
+		}
+	}
+
+	return node;
+}
+
+ion_boolean_t
+csl_read_value(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_csl_node_t				*node,
+	ion_value_t					value
+) {
+	ion_csl_retired_t *block = __atomic_load_n(&node->value, __ATOMIC_ACQUIRE);
+
+	if (NULL == block) {
+		return boolean_false;
+	}
+
+	/* A value block is never written once published, so the copy can not be torn. */
+	memcpy(value, block + 1, skiplist->super.record.value_size);
+
+	return boolean_true;
+}
+
+ion_status_t
+csl_query(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+) {
+	int				slot	= csl_enter(skiplist);
+	ion_csl_node_t	*node	= csl_find_node(skiplist, key);
+	ion_status_t	status	= ION_STATUS_ERROR(err_item_not_found);
+
+	if ((NULL != node) && (0 == skiplist->super.compare(CSL_NODE_KEY(node), key, skiplist->super.record.key_size)) && csl_read_value(skiplist, node, value)) {
+		status = ION_STATUS_OK(1);
+	}
+
+	csl_leave(skiplist, slot);
+
+	return status;
+}
+
+ion_status_t
+csl_update(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+) {
+	ion_csl_node_t		*preds[ION_CSL_MAX_HEIGHT];
+	ion_csl_node_t		*succs[ION_CSL_MAX_HEIGHT];
+	ion_csl_retired_t	*block;
+	ion_csl_retired_t	*old;
+	ion_status_t		status;
+	ion_boolean_t		swapped;
+	int					slot = csl_enter(skiplist);
+
+	for (;;) {
+		if (!csl_search(skiplist, key, preds, succs)) {
+			status = csl_insert_node(skiplist, key, value);
+
+			/* Someone else inserted the key first, which is now there to update. */
+			if (err_duplicate_key == status.error) {
+				continue;
+			}
+
+			break;
+		}
+
+		block = csl_new_value(skiplist, value);
+
+		if (NULL == block) {
+			status = ION_STATUS_ERROR(err_out_of_memory);
+			break;
+		}
+
+		old		= __atomic_load_n(&succs[0]->value, __ATOMIC_ACQUIRE);
+		swapped = boolean_false;
+
+		/* Once the node is being deleted its value can no longer be seen, so the key is looked for again. */
+		while (!swapped && (NULL != old) && !CSL_MARKED(CSL_LOAD(&succs[0]->next[0]))) {
+			swapped = __atomic_compare_exchange_n(&succs[0]->value, &old, block, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+		}
+
+		if (swapped) {
+			csl_retire(skiplist, old);
+			status = ION_STATUS_OK(1);
+			break;
+		}
+
+		free(block);
+	}
+
+	csl_leave(skiplist, slot);
+
+	return status;
+}
+
+ion_status_t
+csl_delete(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key
+) {
+	ion_csl_node_t	*preds[ION_CSL_MAX_HEIGHT];
+	ion_csl_node_t	*succs[ION_CSL_MAX_HEIGHT];
+	ion_csl_node_t	*node;
+	ion_status_t	status = ION_STATUS_ERROR(err_item_not_found);
+	uintptr_t		link;
+	int				level;
+	int				slot = csl_enter(skiplist);
+
+	if (csl_search(skiplist, key, preds, succs)) {
+		node = succs[0];
+
+		for (level = node->height; level >= 1; level--) {
+			link = CSL_LOAD(&node->next[level]);
+
+			while (!CSL_MARKED(link) && !__atomic_compare_exchange_n(&node->next[level], &link, link | 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {}
+		}
+
+		/* Whoever marks the bottom level deletes the node. */
+		link = CSL_LOAD(&node->next[0]);
+
+		while (!CSL_MARKED(link)) {
+			if (__atomic_compare_exchange_n(&node->next[0], &link, link | 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+				csl_search(skiplist, key, preds, succs);
+				csl_release(skiplist, node);
+				status = ION_STATUS_OK(1);
+				break;
+			}
+		}
+	}
+
+	csl_leave(skiplist, slot);
+
+	return status;
+}
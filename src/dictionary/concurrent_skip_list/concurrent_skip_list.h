@@ -0,0 +1,248 @@
+/******************************************************************************/
+/**
+@file
+@brief		A skiplist that many threads may read and write at once.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#if !defined(CONCURRENT_SKIP_LIST_H_)
+#define CONCURRENT_SKIP_LIST_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "concurrent_skip_list_types.h"
+
+/**
+@brief		The key of a node.
+*/
+#define CSL_NODE_KEY(node) ((ion_key_t) &(node)->next[(node)->height + 1])
+
+/**
+@brief		Initializes a concurrent skiplist.
+
+@details	Creating and destroying the list are the only operations that
+			may not run alongside others.
+
+@param		skiplist
+				Pointer to the skiplist instance to initialize.
+@param		key_type
+				Type of key used in this instance of a skiplist.
+@param		key_size
+				Size of key in bytes.
+@param		value_size
+				Size of value in bytes.
+@param		maxheight
+				Maximum number of levels the skiplist will have, at most
+				@ref ION_CSL_MAX_HEIGHT.
+@return		Status of initialization.
+*/
+ion_err_t
+csl_initialize(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	int							maxheight
+);
+
+/**
+@brief		Destroys the skiplist and frees its nodes.
+
+@param		skiplist
+				The skiplist to destroy. No other thread may be using it.
+@return		Status of destruction.
+*/
+ion_err_t
+csl_destroy(
+	ion_concurrent_skiplist_t *skiplist
+);
+
+/**
+@brief		Inserts a @p key and @p value into the skiplist.
+
+@details	Lock-free: a thread only retries when another thread changed
+			the same links in the meantime, so some thread always makes
+			progress.
+
+@param		skiplist
+				The skiplist in which to insert.
+@param		key
+				The key to insert.
+@param		value
+				The value to insert.
+@return		Status of insertion. Inserting a key already in the skiplist
+			fails with @ref err_duplicate_key.
+*/
+ion_status_t
+csl_insert(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+);
+
+/**
+@brief		Looks up @p key and copies its value into @p value.
+
+@details	Wait-free apart from taking an epoch slot: the search neither
+			writes to the list nor restarts, stepping over nodes being
+			deleted instead of unlinking them.
+
+@param		skiplist
+				The skiplist to search.
+@param		key
+				The key to search for.
+@param		value
+				Memory allocated by the caller to hold the value.
+@return		Status of the query.
+*/
+ion_status_t
+csl_query(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+);
+
+/**
+@brief		Replaces the value of @p key, inserting it if it is not in the
+			skiplist.
+
+@details	Readers see either the old value or the new one, never a mix.
+
+@param		skiplist
+				The skiplist to update.
+@param		key
+				The key to update.
+@param		value
+				The new value.
+@return		Status of the update.
+*/
+ion_status_t
+csl_update(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key,
+	ion_value_t					value
+);
+
+/**
+@brief		Deletes @p key and its value from the skiplist.
+
+@details	Lock-free. The node is marked deleted at each level first, which
+			removes it from the list as far as other threads are concerned,
+			and then unlinked.
+
+@param		skiplist
+				The skiplist to delete from.
+@param		key
+				The key to delete.
+@return		Status of the deletion.
+*/
+ion_status_t
+csl_delete(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key
+);
+
+/**
+@brief		Announces that the calling thread is about to read the
+			skiplist, so that nothing it reads is freed until
+			@ref csl_leave.
+
+@param		skiplist
+				The skiplist to read.
+@return		The epoch slot taken, to pass to @ref csl_leave.
+*/
+int
+csl_enter(
+	ion_concurrent_skiplist_t *skiplist
+);
+
+/**
+@brief		Gives back the epoch slot taken by @ref csl_enter.
+
+@param		skiplist
+				The skiplist that was read.
+@param		slot
+				The slot taken.
+*/
+void
+csl_leave(
+	ion_concurrent_skiplist_t	*skiplist,
+	int							slot
+);
+
+/**
+@brief		Finds the first node not being deleted whose key is not less
+			than @p key.
+
+@details	Must be called between @ref csl_enter and @ref csl_leave, which
+			keeps the node returned from being freed.
+
+@param		skiplist
+				The skiplist to search.
+@param		key
+				The key to search for, or @c NULL for the first node.
+@return		The node, or @c NULL if there is none.
+*/
+ion_csl_node_t *
+csl_find_node(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_key_t					key
+);
+
+/**
+@brief		Finds the node not being deleted that follows @p node.
+
+@details	Must be called between @ref csl_enter and @ref csl_leave.
+
+@param		node
+				The node to move on from.
+@return		The next node, or @c NULL if there is none.
+*/
+ion_csl_node_t *
+csl_next_node(
+	ion_csl_node_t *node
+);
+
+/**
+@brief		Copies the value of a node.
+
+@details	Must be called between @ref csl_enter and @ref csl_leave.
+
+@param		skiplist
+				The skiplist holding the node.
+@param		node
+				The node to read.
+@param		value
+				Memory allocated by the caller to hold the value.
+@return		Whether the node still had a value, which it does not once it
+			has been deleted.
+*/
+ion_boolean_t
+csl_read_value(
+	ion_concurrent_skiplist_t	*skiplist,
+	ion_csl_node_t				*node,
+	ion_value_t					value
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CONCURRENT_SKIP_LIST_H_ */
@@ -0,0 +1,343 @@
+/******************************************************************************/
+/**
+@file
+@brief		Handler liaison between dictionary API and concurrent skiplist
+			implementation.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#include "concurrent_skip_list_handler.h"
+
+ion_status_t
+csldict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return csl_query((ion_concurrent_skiplist_t *) dictionary->instance, key, value);
+}
+
+/**
+@brief	  Next function queries and retrieves the next key/value pair that
+			satisfies the predicate of the cursor.
+
+@param	  cursor
+				The cursor used to iterate over results.
+@param	  record
+				A record pointer that is allocated by the caller in which the
+				cursor will fill with the next key/value result. The assumption
+				is that the caller will also free this memory.
+@return	 Status of cursor.
+*/
+static ion_cursor_status_t
+csldict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_csldict_cursor_t		*csl_cursor = (ion_csldict_cursor_t *) cursor;
+	ion_concurrent_skiplist_t	*skiplist	= (ion_concurrent_skiplist_t *) cursor->dictionary->instance;
+
+	if ((cursor->status == cs_cursor_uninitialized) || (cursor->status == cs_end_of_results)) {
+		return cursor->status;
+	}
+	else if ((cursor->status == cs_cursor_initialized) || (cursor->status == cs_cursor_active)) {
+		/* A node deleted since it was reached no longer has a value to give, and is passed over. */
+		while (NULL != csl_cursor->current && test_predicate(cursor, CSL_NODE_KEY(csl_cursor->current)) && !csl_read_value(skiplist, csl_cursor->current, record->value)) {
+			csl_cursor->current = csl_next_node(csl_cursor->current);
+		}
+
+		if ((NULL == csl_cursor->current) || !test_predicate(cursor, CSL_NODE_KEY(csl_cursor->current))) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+
+		cursor->status = cs_cursor_active;
+
+		memcpy(record->key, CSL_NODE_KEY(csl_cursor->current), skiplist->super.record.key_size);
+
+		/* Keys are unique, so an equality match has no more results */
+		if (predicate_equality == cursor->predicate->type) {
+			csl_cursor->current = NULL;
+		}
+		else {
+			csl_cursor->current = csl_next_node(csl_cursor->current);
+		}
+
+		return cursor->status;
+	}
+
+	return cs_invalid_cursor;
+}
+
+/**
+@brief			Closes a concurrent skiplist instance of a dictionary.
+
+@param			dictionary
+					A pointer to the specific dictionary instance to be closed.
+
+@return			The status of closing the dictionary.
+ */
+static ion_err_t
+csldict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	UNUSED(dictionary);
+	return err_not_implemented;
+}
+
+/**
+@brief	  Destroys the cursor, giving back its epoch slot.
+
+@param	  cursor
+				Pointer to a pointer of a cursor.
+*/
+static void
+csldict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	ion_csldict_cursor_t *csl_cursor = (ion_csldict_cursor_t *) (*cursor);
+
+	if (-1 != csl_cursor->slot) {
+		csl_leave((ion_concurrent_skiplist_t *) (*cursor)->dictionary->instance, csl_cursor->slot);
+	}
+
+	(*cursor)->predicate->destroy(&(*cursor)->predicate);
+	free(*cursor);
+	*cursor = NULL;
+}
+
+ion_err_t
+csldict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_concurrent_skiplist_t	*skiplist	= (ion_concurrent_skiplist_t *) dictionary->instance;
+	ion_key_size_t				key_size	= skiplist->super.record.key_size;
+	ion_csldict_cursor_t		*csl_cursor;
+	ion_key_t					start_key	= NULL;
+
+	*cursor = malloc(sizeof(ion_csldict_cursor_t));
+
+	if (NULL == *cursor) {
+		return err_out_of_memory;
+	}
+
+	csl_cursor				= (ion_csldict_cursor_t *) (*cursor);
+	csl_cursor->current		= NULL;
+	csl_cursor->slot		= -1;
+
+	(*cursor)->dictionary	= dictionary;
+	(*cursor)->status		= cs_cursor_uninitialized;
+
+	(*cursor)->destroy		= csldict_destroy_cursor;
+	(*cursor)->next			= csldict_next;
+
+	(*cursor)->predicate	= malloc(sizeof(ion_predicate_t));
+
+	if (NULL == (*cursor)->predicate) {
+		free(*cursor);
+		return err_out_of_memory;
+	}
+
+	(*cursor)->predicate->type		= predicate->type;
+	(*cursor)->predicate->destroy	= predicate->destroy;
+
+	switch (predicate->type) {
+		case predicate_equality: {
+			(*cursor)->predicate->statement.equality.equality_value = malloc(key_size);
+
+			if (NULL == (*cursor)->predicate->statement.equality.equality_value) {
+				free((*cursor)->predicate);
+				free(*cursor);
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.equality.equality_value, predicate->statement.equality.equality_value, key_size);
+			start_key = (*cursor)->predicate->statement.equality.equality_value;
+			break;
+		}
+
+		case predicate_range: {
+			(*cursor)->predicate->statement.range.lower_bound = malloc(key_size);
+
+			if (NULL == (*cursor)->predicate->statement.range.lower_bound) {
+				free((*cursor)->predicate);
+				free(*cursor);
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
+
+			(*cursor)->predicate->statement.range.upper_bound = malloc(key_size);
+
+			if (NULL == (*cursor)->predicate->statement.range.upper_bound) {
+				free((*cursor)->predicate->statement.range.lower_bound);
+				free((*cursor)->predicate);
+				free(*cursor);
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
+			start_key = (*cursor)->predicate->statement.range.lower_bound;
+			break;
+		}
+
+		case predicate_all_records: {
+			break;
+		}
+
+		case predicate_predicate: {
+			/* TODO not implemented */
+			return err_ok;
+		}
+
+		default: {
+			free((*cursor)->predicate);
+			free(*cursor);
+			*cursor = NULL;
+			return err_invalid_predicate;
+		}
+	}
+
+	/* The slot is held until the cursor is destroyed, so that the node it is on stays allocated. */
+	csl_cursor->slot	= csl_enter(skiplist);
+	csl_cursor->current = csl_find_node(skiplist, start_key);
+	(*cursor)->status	= ((NULL == csl_cursor->current) || !test_predicate(*cursor, CSL_NODE_KEY(csl_cursor->current))) ? cs_end_of_results : cs_cursor_initialized;
+
+	return err_ok;
+}
+
+/**
+@brief			Opens a specific concurrent skiplist instance of a dictionary.
+
+@param			handler
+					A pointer to the handler for the specific dictionary being opened.
+@param			dictionary
+					The pointer declared by the caller that will reference
+					the instance of the dictionary opened.
+@param			config
+					The configuration info of the specific dictionary to be opened.
+@param			compare
+					Function pointer for the comparison function for the dictionary.
+
+@return			The status of opening the dictionary.
+ */
+static ion_err_t
+csldict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	UNUSED(handler);
+	UNUSED(dictionary);
+	UNUSED(config);
+	UNUSED(compare);
+	return err_not_implemented;
+}
+
+void
+csldict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= csldict_insert;
+	handler->get				= csldict_query;
+	handler->create_dictionary	= csldict_create_dictionary;
+	handler->remove				= csldict_delete;
+	handler->delete_dictionary	= csldict_delete_dictionary;
+	handler->update				= csldict_update;
+	handler->find				= csldict_find;
+	handler->close_dictionary	= csldict_close_dictionary;
+	handler->multi_get			= NULL;
+	handler->insert_batch		= NULL;
+	handler->open_dictionary	= csldict_open_dictionary;
+	handler->flush_dictionary	= NULL;
+	handler->concurrency		= ion_concurrency_internal;
+}
+
+ion_status_t
+csldict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return csl_insert((ion_concurrent_skiplist_t *) dictionary->instance, key, value);
+}
+
+ion_err_t
+csldict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	UNUSED(id);
+
+	dictionary->instance = malloc(sizeof(ion_concurrent_skiplist_t));
+
+	if (NULL == dictionary->instance) {
+		return err_out_of_memory;
+	}
+
+	dictionary->instance->compare = compare;
+
+	ion_err_t result = csl_initialize((ion_concurrent_skiplist_t *) dictionary->instance, key_type, key_size, value_size, dictionary_size);
+
+	if (err_ok != result) {
+		free(dictionary->instance);
+		dictionary->instance = NULL;
+		return result;
+	}
+
+	dictionary->handler = handler;
+
+	return err_ok;
+}
+
+ion_status_t
+csldict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	return csl_delete((ion_concurrent_skiplist_t *) dictionary->instance, key);
+}
+
+ion_err_t
+csldict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t result = csl_destroy((ion_concurrent_skiplist_t *) dictionary->instance);
+
+	free(dictionary->instance);
+	dictionary->instance = NULL;
+	return result;
+}
+
+ion_status_t
+csldict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return csl_update((ion_concurrent_skiplist_t *) dictionary->instance, key, value);
+}
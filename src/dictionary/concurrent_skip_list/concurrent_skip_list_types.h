@@ -0,0 +1,140 @@
+/******************************************************************************/
+/**
+@file
+@brief		Contains all types local to the concurrent skiplist.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#if !defined(CONCURRENT_SKIP_LIST_TYPES_H_)
+#define CONCURRENT_SKIP_LIST_TYPES_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+
+#include "../../key_value/kv_system.h"
+
+/**
+@brief		The most levels a concurrent skiplist can have.
+*/
+#if !defined(ION_CSL_MAX_HEIGHT)
+#define ION_CSL_MAX_HEIGHT 24
+#endif
+
+/**
+@brief		The most operations and cursors that can be in progress on one
+			concurrent skiplist at once, each of which holds an epoch slot.
+*/
+#if !defined(ION_CSL_MAX_THREADS)
+#define ION_CSL_MAX_THREADS 64
+#endif
+
+/**
+@brief		The number of retired nodes and values between attempts to free
+			those no thread can still be reading.
+*/
+#if !defined(ION_CSL_RECLAIM_INTERVAL)
+#define ION_CSL_RECLAIM_INTERVAL 64
+#endif
+
+/**
+@brief		The size of a cache line, which each epoch slot is padded to so
+			that threads do not write to each other's lines.
+*/
+#if !defined(ION_CSL_CACHE_LINE_SIZE)
+#define ION_CSL_CACHE_LINE_SIZE 64
+#endif
+
+/**
+@brief		Memory unlinked from a concurrent skiplist, waiting until no
+			thread can still be reading it.
+*/
+typedef struct csl_retired {
+	struct csl_retired	*next;	/**< The memory retired before this */
+	unsigned long		epoch;	/**< The epoch it was retired in */
+} ion_csl_retired_t;
+
+/**
+@brief		A node of a concurrent skiplist.
+
+@details	A node is allocated in one block, in which its tower of @p next
+			links is followed by its key. The lowest bit of a link marks the
+			node holding it as deleted at that level, so a node can not be
+			linked past once it is being deleted. The value is kept in a
+			block of its own behind @p value, so that it can be replaced by
+			swapping a pointer while readers copy the old one.
+*/
+typedef struct csl_node {
+	ion_csl_retired_t	retired;	/**< Links the node once it is retired */
+	ion_csl_retired_t	*value;		/**< The value, which follows this header, or
+										 @c NULL once the node is retired */
+	int					references;	/**< The inserter and the deleter each hold one
+										 until they are done with the node */
+	int					height;		/**< Height index of the node (counts
+										 from 0) */
+	uintptr_t			next[];		/**< The next node at each level, and
+										 whether this node is deleted there */
+} ion_csl_node_t;
+
+/**
+@brief		The epoch a thread announced, alone on its cache line.
+*/
+typedef struct {
+	unsigned long	epoch;	/**< The announced epoch, or 0 if the slot is free */
+	char			padding[ION_CSL_CACHE_LINE_SIZE - sizeof(unsigned long)];
+} ion_csl_slot_t;
+
+/**
+@brief		Struct of the concurrent skiplist.
+
+@details	Readers, inserters and deleters of different threads may all
+			use it at once. Each does so in an epoch it announces in a slot,
+			and memory unlinked in one epoch is only freed two epochs later,
+			by when no thread can still be reading it.
+*/
+typedef struct concurrent_skiplist {
+	ion_dictionary_parent_t super;		/**< Parent structure holding dictionary level
+										information */
+	ion_csl_node_t			*head;		/**< Entry point into the skiplist. Does not
+										hold any key/value information */
+	ion_csl_slot_t			slots[ION_CSL_MAX_THREADS];	/**< The epochs of the
+															 threads in the list */
+	unsigned long			epoch;		/**< The global epoch, from 1 */
+	ion_csl_retired_t		*retired;	/**< Memory waiting to be freed */
+	unsigned int			retire_count;	/**< Memory retired so far */
+	unsigned int			next_slot;	/**< Where to look for a free slot next */
+	unsigned int			level_seed;	/**< Counts the levels picked, to pick the
+										next one from */
+} ion_concurrent_skiplist_t;
+
+typedef struct
+	csldict_cursor {
+	ion_dict_cursor_t	super;			/**< Supertype of cursor */
+	ion_csl_node_t		*current;		/**< Next node to visit */
+	int					slot;			/**< The epoch slot the cursor holds, which
+											 keeps @p current from being freed */
+} ion_csldict_cursor_t;
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CONCURRENT_SKIP_LIST_TYPES_H_ */
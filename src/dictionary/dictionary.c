@@ -23,6 +23,26 @@
 
 #include "dictionary.h"
 #include "flat_file/flat_file_dictionary_handler.h"
+#include "../file/ion_wal.h"
+
+#if ION_THREAD_SAFE
+#include <sched.h>
+#endif
+
+/**
+@brief		The number of times a latch is tried before the waiting thread
+			yields the processor.
+*/
+#define ION_LATCH_SPINS 64
+
+/**
+@brief		The types of the records in the log of a durable dictionary.
+*/
+enum ION_DICTIONARY_WAL_RECORD {
+	ion_dictionary_wal_insert = 1,	/**< A key and value inserted. */
+	ion_dictionary_wal_update,	/**< A key and the value it was updated to. */
+	ion_dictionary_wal_delete	/**< A key deleted. */
+};
 
 int
 dictionary_get_filename(
@@ -89,23 +109,1013 @@ dictionary_switch_compare(
 			break;
 		}
 
-		case key_type_char_array: {
-			compare = dictionary_compare_char_array;
+		case key_type_char_array: {
+			compare = dictionary_compare_char_array;
+			break;
+		}
+
+		case key_type_null_terminated_string: {
+			compare = dictionary_compare_null_terminated_string;
+			break;
+		}
+
+		default: {
+			/* do something - you must bind the correct comparison function */
+			break;
+		}
+	}
+
+	return compare;
+}
+
+#define ION_XXHASH_PRIME_1	((uint32_t) 0x9E3779B1UL)
+#define ION_XXHASH_PRIME_2	((uint32_t) 0x85EBCA77UL)
+#define ION_XXHASH_PRIME_3	((uint32_t) 0xC2B2AE3DUL)
+#define ION_XXHASH_PRIME_4	((uint32_t) 0x27D4EB2FUL)
+#define ION_XXHASH_PRIME_5	((uint32_t) 0x165667B1UL)
+
+#define ION_WYHASH_SECRET_0 0x2D358DCCAA6C78A5ULL
+#define ION_WYHASH_SECRET_1 0x8BB84B93962EACC9ULL
+
+#define ION_ROTL32(x, r)	(((x) << (r)) | ((x) >> (32 - (r))))
+
+/**
+@brief		Reads four bytes as a little endian integer.
+*/
+static uint32_t
+dictionary_read32(
+	const ion_byte_t *bytes
+) {
+	return (uint32_t) bytes[0] | ((uint32_t) bytes[1] << 8) | ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+}
+
+/**
+@brief		Reads eight bytes as a little endian integer.
+*/
+static uint64_t
+dictionary_read64(
+	const ion_byte_t *bytes
+) {
+	return (uint64_t) dictionary_read32(bytes) | ((uint64_t) dictionary_read32(bytes + 4) << 32);
+}
+
+/**
+@brief		Returns the length of a string key, up to its terminator.
+*/
+static ion_key_size_t
+dictionary_string_length(
+	ion_key_t		key,
+	ion_key_size_t	key_size
+) {
+	ion_key_size_t length = 0;
+
+	while ((length < key_size) && ('\0' != ((char *) key)[length])) {
+		length++;
+	}
+
+	return length;
+}
+
+/**
+@brief		Mixes one lane of input into an xxHash32 accumulator.
+*/
+static uint32_t
+dictionary_xxhash_round(
+	uint32_t	accumulator,
+	uint32_t	input
+) {
+	accumulator += input * ION_XXHASH_PRIME_2;
+	accumulator	= ION_ROTL32(accumulator, 13);
+	return accumulator * ION_XXHASH_PRIME_1;
+}
+
+/**
+@brief		Folds the last few bytes into an xxHash32 state and avalanches it.
+*/
+static uint32_t
+dictionary_xxhash_finish(
+	const ion_byte_t	*bytes,
+	int					length,
+	uint32_t			hash
+) {
+	for (; length >= 4; length -= 4, bytes += 4) {
+		hash	+= dictionary_read32(bytes) * ION_XXHASH_PRIME_3;
+		hash	= ION_ROTL32(hash, 17) * ION_XXHASH_PRIME_4;
+	}
+
+	for (; length > 0; length--, bytes++) {
+		hash	+= *bytes * ION_XXHASH_PRIME_5;
+		hash	= ION_ROTL32(hash, 11) * ION_XXHASH_PRIME_1;
+	}
+
+	hash	^= hash >> 15;
+	hash	*= ION_XXHASH_PRIME_2;
+	hash	^= hash >> 13;
+	hash	*= ION_XXHASH_PRIME_3;
+	hash	^= hash >> 16;
+
+	return hash;
+}
+
+/**
+@brief		xxHash32, with a seed of zero, of @p length bytes.
+*/
+static uint32_t
+dictionary_xxhash_bytes(
+	const ion_byte_t	*bytes,
+	int					length
+) {
+	const ion_byte_t	*end = bytes + length;
+	uint32_t			hash;
+
+	if (length >= 16) {
+		uint32_t	v1	= ION_XXHASH_PRIME_1 + ION_XXHASH_PRIME_2;
+		uint32_t	v2	= ION_XXHASH_PRIME_2;
+		uint32_t	v3	= 0;
+		uint32_t	v4	= 0 - ION_XXHASH_PRIME_1;
+
+		for (; end - bytes >= 16; bytes += 16) {
+			v1	= dictionary_xxhash_round(v1, dictionary_read32(bytes));
+			v2	= dictionary_xxhash_round(v2, dictionary_read32(bytes + 4));
+			v3	= dictionary_xxhash_round(v3, dictionary_read32(bytes + 8));
+			v4	= dictionary_xxhash_round(v4, dictionary_read32(bytes + 12));
+		}
+
+		hash = ION_ROTL32(v1, 1) + ION_ROTL32(v2, 7) + ION_ROTL32(v3, 12) + ION_ROTL32(v4, 18);
+	}
+	else {
+		hash = ION_XXHASH_PRIME_5;
+	}
+
+	hash += (uint32_t) length;
+
+	return dictionary_xxhash_finish(bytes, (int) (end - bytes), hash);
+}
+
+uint32_t
+dictionary_hash_xxhash(
+	ion_key_t		key,
+	ion_key_size_t	key_size
+) {
+	return dictionary_xxhash_bytes(key, key_size);
+}
+
+/**
+@brief		xxHash32 of a four byte numeric key, unrolled for its size.
+*/
+static uint32_t
+dictionary_hash_xxhash_32bit(
+	ion_key_t		key,
+	ion_key_size_t	key_size
+) {
+	uint32_t hash = ION_XXHASH_PRIME_5 + 4;
+
+	UNUSED(key_size);
+
+	hash	+= dictionary_read32(key) * ION_XXHASH_PRIME_3;
+	hash	= ION_ROTL32(hash, 17) * ION_XXHASH_PRIME_4;
+
+	return dictionary_xxhash_finish(NULL, 0, hash);
+}
+
+/**
+@brief		xxHash32 of a string key, up to its terminator.
+*/
+static uint32_t
+dictionary_hash_xxhash_string(
+	ion_key_t		key,
+	ion_key_size_t	key_size
+) {
+	return dictionary_xxhash_bytes(key, dictionary_string_length(key, key_size));
+}
+
+/**
+@brief		Multiplies @p a and @p b to 128 bits, leaving the high and low
+			halves in them.
+@details	Built from 32 bit multiplies, so it needs no 128 bit type.
+*/
+static void
+dictionary_wyhash_multiply(
+	uint64_t	*a,
+	uint64_t	*b
+) {
+	uint64_t	hh	= (*a >> 32) * (*b >> 32);
+	uint64_t	hl	= (*a >> 32) * (uint32_t) *b;
+	uint64_t	lh	= (uint64_t) (uint32_t) *a * (*b >> 32);
+	uint64_t	ll	= (uint64_t) (uint32_t) *a * (uint32_t) *b;
+
+	*a	= ((hl >> 32) | (hl << 32)) ^ hh;
+	*b	= ((lh >> 32) | (lh << 32)) ^ ll;
+}
+
+/**
+@brief		Multiplies @p a and @p b and folds the product to 64 bits.
+*/
+static uint64_t
+dictionary_wyhash_mix(
+	uint64_t	a,
+	uint64_t	b
+) {
+	dictionary_wyhash_multiply(&a, &b);
+	return a ^ b;
+}
+
+/**
+@brief		Finishes a wyhash of @p length bytes from its last two words,
+			folding it to 32 bits.
+*/
+static uint32_t
+dictionary_wyhash_finish(
+	uint64_t	a,
+	uint64_t	b,
+	uint64_t	seed,
+	int			length
+) {
+	uint64_t hash;
+
+	a	^= ION_WYHASH_SECRET_1;
+	b	^= seed;
+	dictionary_wyhash_multiply(&a, &b);
+	hash = dictionary_wyhash_mix(a ^ ION_WYHASH_SECRET_0 ^ (uint64_t) length, b ^ ION_WYHASH_SECRET_1);
+
+	return (uint32_t) (hash ^ (hash >> 32));
+}
+
+/**
+@brief		wyhash, with a seed of zero, of @p length bytes.
+*/
+static uint32_t
+dictionary_wyhash_bytes(
+	const ion_byte_t	*bytes,
+	int					length
+) {
+	uint64_t	seed = dictionary_wyhash_mix(ION_WYHASH_SECRET_0, ION_WYHASH_SECRET_1);
+	uint64_t	a;
+	uint64_t	b;
+
+	if (length <= 16) {
+		if (length >= 4) {
+			int offset = (length >> 3) << 2;
+
+			a	= ((uint64_t) dictionary_read32(bytes) << 32) | dictionary_read32(bytes + offset);
+			b	= ((uint64_t) dictionary_read32(bytes + length - 4) << 32) | dictionary_read32(bytes + length - 4 - offset);
+		}
+		else if (length > 0) {
+			a	= ((uint64_t) bytes[0] << 16) | ((uint64_t) bytes[length >> 1] << 8) | bytes[length - 1];
+			b	= 0;
+		}
+		else {
+			a	= 0;
+			b	= 0;
+		}
+	}
+	else {
+		int remaining = length;
+
+		for (; remaining > 16; remaining -= 16, bytes += 16) {
+			seed = dictionary_wyhash_mix(dictionary_read64(bytes) ^ ION_WYHASH_SECRET_1, dictionary_read64(bytes + 8) ^ seed);
+		}
+
+		a	= dictionary_read64(bytes + remaining - 16);
+		b	= dictionary_read64(bytes + remaining - 8);
+	}
+
+	return dictionary_wyhash_finish(a, b, seed, length);
+}
+
+uint32_t
+dictionary_hash_wyhash(
+	ion_key_t		key,
+	ion_key_size_t	key_size
+) {
+	return dictionary_wyhash_bytes(key, key_size);
+}
+
+/**
+@brief		wyhash of an eight byte numeric key, unrolled for its size.
+*/
+static uint32_t
+dictionary_hash_wyhash_64bit(
+	ion_key_t		key,
+	ion_key_size_t	key_size
+) {
+	uint64_t	low		= dictionary_read32(key);
+	uint64_t	high	= dictionary_read32((ion_byte_t *) key + 4);
+
+	UNUSED(key_size);
+
+	return dictionary_wyhash_finish((low << 32) | high, (high << 32) | low, dictionary_wyhash_mix(ION_WYHASH_SECRET_0, ION_WYHASH_SECRET_1), 8);
+}
+
+/**
+@brief		wyhash of a string key, up to its terminator.
+*/
+static uint32_t
+dictionary_hash_wyhash_string(
+	ion_key_t		key,
+	ion_key_size_t	key_size
+) {
+	return dictionary_wyhash_bytes(key, dictionary_string_length(key, key_size));
+}
+
+ion_dictionary_hash_t
+dictionary_switch_hash(
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_hash_function_t hash_function
+) {
+	ion_boolean_t is_string = (key_type_char_array == key_type) || (key_type_null_terminated_string == key_type);
+
+	switch (hash_function) {
+		case hash_function_xxhash: {
+			if (is_string) {
+				return dictionary_hash_xxhash_string;
+			}
+
+			return (4 == key_size) ? dictionary_hash_xxhash_32bit : dictionary_hash_xxhash;
+		}
+
+		case hash_function_wyhash: {
+			if (is_string) {
+				return dictionary_hash_wyhash_string;
+			}
+
+			return (8 == key_size) ? dictionary_hash_wyhash_64bit : dictionary_hash_wyhash;
+		}
+
+		default: {
+			/* The legacy hash, which existing files were built with */
+			return NULL;
+		}
+	}
+}
+
+/**
+@brief		Latches a dictionary for a call into its handler, as the
+			handler's concurrency asks.
+@param		dictionary
+				The dictionary to latch.
+@param		reading
+				Whether the call is a get, which may share the latch.
+*/
+static void
+dictionary_enter(
+	ion_dictionary_t	*dictionary,
+	ion_boolean_t		reading
+) {
+	if (ion_concurrency_internal == dictionary->handler->concurrency) {
+		return;
+	}
+
+	if (reading && (ion_concurrency_shared_get == dictionary->handler->concurrency)) {
+		dictionary_latch_acquire_shared(&dictionary->instance->latch);
+	}
+	else {
+		dictionary_latch_acquire_exclusive(&dictionary->instance->latch);
+	}
+}
+
+/**
+@brief		Releases the latch taken by @ref dictionary_enter.
+*/
+static void
+dictionary_leave(
+	ion_dictionary_t	*dictionary,
+	ion_boolean_t		reading
+) {
+	if (ion_concurrency_internal == dictionary->handler->concurrency) {
+		return;
+	}
+
+	if (reading && (ion_concurrency_shared_get == dictionary->handler->concurrency)) {
+		dictionary_latch_release_shared(&dictionary->instance->latch);
+	}
+	else {
+		dictionary_latch_release_exclusive(&dictionary->instance->latch);
+	}
+}
+
+/**
+@brief		Waits for the calls in progress on a dictionary to finish, before
+			it is closed or deleted.
+*/
+static void
+dictionary_drain(
+	ion_dictionary_t *dictionary
+) {
+	dictionary_enter(dictionary, boolean_false);
+	dictionary_leave(dictionary, boolean_false);
+
+#if ION_THREAD_SAFE
+
+	/* Writes are committed after the latch is released */
+	while (0 != __atomic_load_n(&dictionary->instance->committing, __ATOMIC_ACQUIRE)) {
+		sched_yield();
+	}
+
+#endif
+}
+
+/**
+@brief		Appends a write that was made to a durable dictionary to its log.
+@details	The caller holds the dictionary latch, so that writes are logged
+			in the order they were made. Failed writes are not logged.
+@param		dictionary
+				The dictionary written to.
+@param		type
+				The type of the write.
+@param		key
+				The key written.
+@param		value
+				The value written, or @c NULL for a delete.
+@param		status
+				The status of the write, which a failure to log it is put in.
+@param		lsn
+				Set to the LSN of the record, if it is logged.
+*/
+static void
+dictionary_wal_log(
+	ion_dictionary_t	*dictionary,
+	ion_byte_t			type,
+	ion_key_t			key,
+	ion_value_t			value,
+	ion_status_t		*status,
+	ion_wal_lsn_t		*lsn
+) {
+	ion_dictionary_parent_t *instance = dictionary->instance;
+	ion_err_t				error;
+
+	if ((NULL == instance->wal) || (err_ok != status->error)) {
+		return;
+	}
+
+	error = ion_wal_append(instance->wal, type, key, instance->record.key_size, value, (NULL == value) ? 0 : instance->record.value_size, lsn);
+
+	if (err_ok != error) {
+		status->error = error;
+	}
+}
+
+/**
+@brief		Makes what has been written to a durable dictionary durable in
+			its files, and drops its log.
+@details	The caller holds the dictionary latch alone.
+*/
+static ion_err_t
+dictionary_wal_checkpoint(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t error = dictionary->handler->flush_dictionary(dictionary, boolean_true);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	return ion_wal_checkpoint(dictionary->instance->wal);
+}
+
+/**
+@brief		Releases the latch taken by @ref dictionary_enter for a write,
+			and commits the write if it was logged.
+@details	The dictionary's buffers are written out before the latch is
+			released, so that its files hold whole writes should the process
+			stop. The log is committed after, so that threads writing
+			meanwhile can share its synchronization.
+@param		dictionary
+				The dictionary written to.
+@param		status
+				The status of the write.
+@param		lsn
+				The LSN of the last record logged for the write, or 0 if
+				nothing was logged.
+@return		The status of the write, with any failure to commit it.
+*/
+static ion_status_t
+dictionary_leave_write(
+	ion_dictionary_t	*dictionary,
+	ion_status_t		status,
+	ion_wal_lsn_t		lsn
+) {
+	ion_dictionary_parent_t *instance = dictionary->instance;
+	ion_err_t				error;
+
+	if (0 == lsn) {
+		dictionary_leave(dictionary, boolean_false);
+		return status;
+	}
+
+	error = dictionary->handler->flush_dictionary(dictionary, boolean_false);
+
+#if ION_THREAD_SAFE
+	__atomic_add_fetch(&instance->committing, 1, __ATOMIC_RELAXED);
+#else
+	instance->committing++;
+#endif
+
+	dictionary_leave(dictionary, boolean_false);
+
+	if (err_ok == error) {
+		error = ion_wal_commit(instance->wal, lsn);
+	}
+
+	if ((err_ok == error) && (ion_wal_size(instance->wal) >= ION_WAL_CHECKPOINT_SIZE)) {
+		dictionary_enter(dictionary, boolean_false);
+
+		/* Another thread may have taken the checkpoint while this one waited */
+		if (ion_wal_size(instance->wal) >= ION_WAL_CHECKPOINT_SIZE) {
+			error = dictionary_wal_checkpoint(dictionary);
+		}
+
+		dictionary_leave(dictionary, boolean_false);
+	}
+
+#if ION_THREAD_SAFE
+	__atomic_sub_fetch(&instance->committing, 1, __ATOMIC_RELEASE);
+#else
+	instance->committing--;
+#endif
+
+	if ((err_ok != error) && (err_ok == status.error)) {
+		status.error = error;
+	}
+
+	return status;
+}
+
+/**
+@brief		Records of one kind noted while reading back the log of a
+			dictionary, each after the ordinal of its record in the log.
+*/
+typedef struct {
+	ion_byte_t		*entries;		/**< The noted records. Sorted by what was
+										 noted before the writes are redone. */
+	unsigned int	entry_size;		/**< Bytes of an entry. */
+	unsigned int	num_entries;	/**< Entries in @p entries. */
+	unsigned int	capacity;		/**< Entries @p entries has room for. */
+} ion_dictionary_wal_notes_t;
+
+/**
+@brief		What the replay of a dictionary's log keeps track of.
+*/
+typedef struct {
+	ion_dictionary_t			*dictionary;	/**< The dictionary being redone. */
+	ion_dictionary_wal_notes_t	touches;		/**< The key of each update and
+													 delete. */
+	ion_dictionary_wal_notes_t	inserts;		/**< The key and value of each
+													 insert. */
+	uint32_t					ordinal;		/**< Records read so far. */
+} ion_dictionary_wal_replay_t;
+
+/**
+@brief		Adds the first @p notes->entry_size bytes of a record, less those
+			of its ordinal, to @p notes.
+*/
+static ion_err_t
+dictionary_wal_note(
+	ion_dictionary_wal_notes_t	*notes,
+	uint32_t					ordinal,
+	ion_byte_t					*payload
+) {
+	unsigned int	capacity;
+	ion_byte_t		*entries;
+
+	if (notes->num_entries == notes->capacity) {
+		capacity	= (0 == notes->capacity) ? 32 : notes->capacity * 2;
+		entries		= realloc(notes->entries, (size_t) capacity * notes->entry_size);
+
+		if (NULL == entries) {
+			return err_out_of_memory;
+		}
+
+		notes->entries	= entries;
+		notes->capacity = capacity;
+	}
+
+	memcpy(notes->entries + notes->num_entries * notes->entry_size, &ordinal, sizeof(ordinal));
+	memcpy(notes->entries + notes->num_entries * notes->entry_size + sizeof(ordinal), payload, notes->entry_size - sizeof(ordinal));
+	notes->num_entries++;
+
+	return err_ok;
+}
+
+/**
+@brief		Notes the key of each update and delete, and the key and value of
+			each insert, read back from the log of a dictionary.
+*/
+static ion_err_t
+dictionary_wal_note_write(
+	void			*context,
+	ion_byte_t		type,
+	ion_byte_t		*payload,
+	unsigned int	size
+) {
+	ion_dictionary_wal_replay_t *replay = context;
+
+	UNUSED(size);
+
+	replay->ordinal++;
+
+	if (ion_dictionary_wal_insert == type) {
+		return dictionary_wal_note(&replay->inserts, replay->ordinal, payload);
+	}
+
+	if ((ion_dictionary_wal_update == type) || (ion_dictionary_wal_delete == type)) {
+		return dictionary_wal_note(&replay->touches, replay->ordinal, payload);
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Compares what two entries of @p notes hold, by key and then, for
+			inserts, by the bytes of the value.
+*/
+static int
+dictionary_wal_compare_notes(
+	ion_dictionary_wal_replay_t *replay,
+	ion_dictionary_wal_notes_t	*notes,
+	ion_byte_t					*first,
+	ion_byte_t					*second
+) {
+	ion_key_size_t	key_size	= replay->dictionary->instance->record.key_size;
+	int				order		= replay->dictionary->instance->compare(first, second, key_size);
+
+	if ((0 != order) || (notes != &replay->inserts)) {
+		return order;
+	}
+
+	return memcmp(first + key_size, second + key_size, replay->dictionary->instance->record.value_size);
+}
+
+/**
+@brief		Sorts the entries of @p notes by what they hold.
+@details	The sort is a stable merge sort, so the entries of the same key,
+			or key and value, stay in the order of their records.
+*/
+static ion_err_t
+dictionary_wal_sort_notes(
+	ion_dictionary_wal_replay_t *replay,
+	ion_dictionary_wal_notes_t	*notes
+) {
+	unsigned int	entry_size	= notes->entry_size;
+	unsigned int	n			= notes->num_entries;
+	ion_byte_t		*from		= notes->entries;
+	ion_byte_t		*to;
+	ion_byte_t		*swap;
+	unsigned int	width;
+	unsigned int	left;
+	unsigned int	mid;
+	unsigned int	end;
+	unsigned int	i;
+	unsigned int	j;
+	unsigned int	k;
+
+	if (n < 2) {
+		return err_ok;
+	}
+
+	to = malloc((size_t) n * entry_size);
+
+	if (NULL == to) {
+		return err_out_of_memory;
+	}
+
+	for (width = 1; width < n; width *= 2) {
+		for (left = 0; left < n; left += 2 * width) {
+			mid = (left + width < n) ? left + width : n;
+			end = (left + 2 * width < n) ? left + 2 * width : n;
+			i	= left;
+			j	= mid;
+
+			for (k = left; k < end; k++) {
+				if ((i < mid) && ((j >= end) || (dictionary_wal_compare_notes(replay, notes, from + i * entry_size + sizeof(uint32_t), from + j * entry_size + sizeof(uint32_t)) <= 0))) {
+					memcpy(to + k * entry_size, from + i++ * entry_size, entry_size);
+				}
+				else {
+					memcpy(to + k * entry_size, from + j++ * entry_size, entry_size);
+				}
+			}
+		}
+
+		swap	= from;
+		from	= to;
+		to		= swap;
+	}
+
+	notes->entries = from;
+	free(to);
+
+	return err_ok;
+}
+
+/**
+@brief		Finds the entries of @p notes that hold what @p payload starts
+			with.
+@param[out]	first
+				The first of the entries.
+@return		The number of entries, which follow each other in the order of
+			their records.
+*/
+static unsigned int
+dictionary_wal_find_notes(
+	ion_dictionary_wal_replay_t *replay,
+	ion_dictionary_wal_notes_t	*notes,
+	ion_byte_t					*payload,
+	unsigned int				*first
+) {
+	unsigned int	low;
+	unsigned int	high;
+	unsigned int	mid;
+
+	/* The first entry not before the payload */
+	low		= 0;
+	high	= notes->num_entries;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+
+		if (dictionary_wal_compare_notes(replay, notes, notes->entries + mid * notes->entry_size + sizeof(uint32_t), payload) < 0) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	*first	= low;
+
+	/* The first entry past it */
+	high	= notes->num_entries;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+
+		if (dictionary_wal_compare_notes(replay, notes, notes->entries + mid * notes->entry_size + sizeof(uint32_t), payload) <= 0) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	return low - *first;
+}
+
+/**
+@brief		Counts the entries among the @p count from @p first of @p notes
+			whose records are numbered @p ordinal or less.
+*/
+static unsigned int
+dictionary_wal_count_notes(
+	ion_dictionary_wal_notes_t	*notes,
+	unsigned int				first,
+	unsigned int				count,
+	uint32_t					ordinal
+) {
+	unsigned int	low		= 0;
+	unsigned int	high	= count;
+	unsigned int	mid;
+	uint32_t		noted;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		memcpy(&noted, notes->entries + (first + mid) * notes->entry_size, sizeof(noted));
+
+		if (noted <= ordinal) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+/**
+@brief		Counts the records of a dictionary with a key and value, up to
+			@p limit of them.
+*/
+static unsigned int
+dictionary_wal_count_records(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value,
+	unsigned int		limit
+) {
+	ion_value_size_t	value_size	= dictionary->instance->record.value_size;
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor		= NULL;
+	ion_record_t		record;
+	unsigned int		count		= 0;
+
+	dictionary_build_predicate(&predicate, predicate_equality, key);
+
+	if (err_ok != dictionary->handler->find(dictionary, &predicate, &cursor)) {
+		return 0;
+	}
+
+	record.key		= alloca(dictionary->instance->record.key_size);
+	record.value	= alloca(value_size);
+
+	while ((count < limit) && (cs_cursor_active == cursor->next(cursor, &record))) {
+		if (0 == memcmp(record.value, value, value_size)) {
+			count++;
+		}
+	}
+
+	cursor->destroy(&cursor);
+
+	return count;
+}
+
+/**
+@brief		Redoes a write read back from the log of a dictionary.
+@details	The write may have reached the dictionary's files already, so it
+			is redone in a way that leaves the same result either way. An
+			insert of a key that a later record updates or deletes is not
+			redone, since that record sets what the key holds, and in a
+			dictionary with duplicate keys the insert could not otherwise be
+			told apart from the records it became.
+
+			Otherwise an insert is redone unless the dictionary already holds
+			as many records with its key and value as the log inserted since
+			the last update or delete of the key, up to and including this
+			insert. Records with the same key and value that the dictionary
+			held before the log's checkpoint are counted among those, so
+			their copies inserted since may be lost if the data file itself
+			was rolled back.
+*/
+static ion_err_t
+dictionary_wal_apply(
+	void			*context,
+	ion_byte_t		type,
+	ion_byte_t		*payload,
+	unsigned int	size
+) {
+	ion_dictionary_wal_replay_t *replay		= context;
+	ion_dictionary_t			*dictionary = replay->dictionary;
+	ion_key_size_t				key_size	= dictionary->instance->record.key_size;
+	ion_byte_t					*value		= payload + key_size;
+	ion_status_t				status;
+
+	replay->ordinal++;
+
+	if (size != (unsigned int) (key_size + ((ion_dictionary_wal_delete == type) ? 0 : dictionary->instance->record.value_size))) {
+		return err_file_read_error;
+	}
+
+	switch (type) {
+		case ion_dictionary_wal_insert: {
+			unsigned int	first;
+			unsigned int	count	= dictionary_wal_find_notes(replay, &replay->touches, payload, &first);
+			unsigned int	before	= dictionary_wal_count_notes(&replay->touches, first, count, replay->ordinal);
+			uint32_t		touched = 0;
+			unsigned int	inserted;
+
+			if (before < count) {
+				return err_ok;
+			}
+
+			if (before > 0) {
+				memcpy(&touched, replay->touches.entries + (first + before - 1) * replay->touches.entry_size, sizeof(touched));
+			}
+
+			/* The inserts of this key and value since the key was last touched, this one included */
+			count		= dictionary_wal_find_notes(replay, &replay->inserts, payload, &first);
+			inserted	= dictionary_wal_count_notes(&replay->inserts, first, count, replay->ordinal) - dictionary_wal_count_notes(&replay->inserts, first, count, touched);
+
+			if (dictionary_wal_count_records(dictionary, payload, value, inserted) >= inserted) {
+				return err_ok;
+			}
+
+			status = dictionary->handler->insert(dictionary, payload, value);
+
+			/* The key was given another value by a later write, which is redone after */
+			if (err_duplicate_key == status.error) {
+				return err_ok;
+			}
+
+			break;
+		}
+
+		case ion_dictionary_wal_update: {
+			status = dictionary->handler->update(dictionary, payload, value);
 			break;
 		}
 
-		case key_type_null_terminated_string: {
-			compare = dictionary_compare_null_terminated_string;
+		case ion_dictionary_wal_delete: {
+			status = dictionary->handler->remove(dictionary, payload);
+
+			if (err_item_not_found == status.error) {
+				return err_ok;
+			}
+
 			break;
 		}
 
 		default: {
-			/* do something - you must bind the correct comparison function */
-			break;
+			return err_file_read_error;
 		}
 	}
 
-	return compare;
+	return status.error;
+}
+
+/**
+@brief		Opens the log of a dictionary, redoes the writes in it, and keeps
+			logging to it.
+*/
+static ion_err_t
+dictionary_wal_open(
+	ion_dictionary_t *dictionary
+) {
+	char						filename[ION_MAX_FILENAME_LENGTH];
+	ion_wal_t					*wal;
+	ion_err_t					error;
+	ion_dictionary_wal_replay_t replay;
+
+	dictionary_get_filename(dictionary->instance->id, "wal", filename);
+
+	memset(&replay, 0, sizeof(replay));
+	replay.dictionary			= dictionary;
+	replay.touches.entry_size	= sizeof(uint32_t) + dictionary->instance->record.key_size;
+	replay.inserts.entry_size	= sizeof(uint32_t) + dictionary->instance->record.key_size + dictionary->instance->record.value_size;
+
+	wal = malloc(sizeof(ion_wal_t));
+
+	if (NULL == wal) {
+		return err_out_of_memory;
+	}
+
+	error = ion_wal_open(wal, filename);
+
+	if (err_ok != error) {
+		free(wal);
+		return error;
+	}
+
+	/* The log is read twice, first for which records each write must be weighed against */
+	error = ion_wal_replay(wal, dictionary_wal_note_write, &replay);
+
+	if (err_ok == error) {
+		error = dictionary_wal_sort_notes(&replay, &replay.touches);
+	}
+
+	if (err_ok == error) {
+		error = dictionary_wal_sort_notes(&replay, &replay.inserts);
+	}
+
+	if (err_ok == error) {
+		replay.ordinal	= 0;
+		error			= ion_wal_replay(wal, dictionary_wal_apply, &replay);
+	}
+
+	free(replay.touches.entries);
+	free(replay.inserts.entries);
+
+	if (err_ok == error) {
+		dictionary->instance->wal	= wal;
+		error						= dictionary_wal_checkpoint(dictionary);
+	}
+
+	if (err_ok != error) {
+		ion_wal_close(wal);
+		free(wal);
+		dictionary->instance->wal = NULL;
+	}
+
+	return error;
+}
+
+/**
+@brief		Closes the log of a durable dictionary, after taking a checkpoint
+			if asked to.
+*/
+static ion_err_t
+dictionary_wal_close(
+	ion_dictionary_t	*dictionary,
+	ion_boolean_t		checkpoint
+) {
+	ion_wal_t	*wal	= dictionary->instance->wal;
+	ion_err_t	error	= err_ok;
+
+	if (NULL == wal) {
+		return err_ok;
+	}
+
+	if (checkpoint) {
+		error = dictionary_wal_checkpoint(dictionary);
+	}
+
+	if ((err_ok != ion_wal_close(wal)) && (err_ok == error)) {
+		error = err_file_close_error;
+	}
+
+	free(wal);
+	dictionary->instance->wal = NULL;
+
+	return error;
 }
 
 ion_err_t
@@ -117,15 +1127,46 @@ dictionary_create(
 	ion_key_size_t				key_size,
 	ion_value_size_t			value_size,
 	ion_dictionary_size_t		dictionary_size
+) {
+	return dictionary_create_hashed(handler, dictionary, id, key_type, key_size, value_size, dictionary_size, hash_function_default);
+}
+
+ion_err_t
+dictionary_create_hashed(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_hash_function_t			hash_function
 ) {
 	ion_err_t					err;
 	ion_dictionary_compare_t	compare = dictionary_switch_compare(key_type);
 
-	err = handler->create_dictionary(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary);
+	/* Record the family actually used, so the master table never stores the default */
+	dictionary->hash_function	= (hash_function_default == hash_function) ? hash_function_modulo : hash_function;
+
+	err							= handler->create_dictionary(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary);
 
 	if (err_ok == err) {
-		dictionary->instance->id	= id;
-		dictionary->status			= ion_dictionary_status_ok;
+		dictionary->instance->id			= id;
+		dictionary->instance->wal			= NULL;
+		dictionary->instance->committing	= 0;
+		dictionary->status					= ion_dictionary_status_ok;
+		dictionary_latch_init(&dictionary->instance->latch);
+
+		if (NULL != handler->flush_dictionary) {
+			char filename[ION_MAX_FILENAME_LENGTH];
+
+			/* A log left by an earlier dictionary with this ID must not be redone over this one */
+			dictionary_get_filename(id, "wal", filename);
+
+			if (ion_fexists(filename)) {
+				ion_fremove(filename);
+			}
+		}
 	}
 	else {
 		dictionary->status = ion_dictionary_status_error;
@@ -140,7 +1181,14 @@ dictionary_insert(
 	ion_key_t			key,
 	ion_value_t			value
 ) {
-	return dictionary->handler->insert(dictionary, key, value);
+	ion_status_t	status;
+	ion_wal_lsn_t	lsn = 0;
+
+	dictionary_enter(dictionary, boolean_false);
+	status = dictionary->handler->insert(dictionary, key, value);
+	dictionary_wal_log(dictionary, ion_dictionary_wal_insert, key, value, &status, &lsn);
+
+	return dictionary_leave_write(dictionary, status, lsn);
 }
 
 ion_status_t
@@ -149,7 +1197,222 @@ dictionary_get(
 	ion_key_t			key,
 	ion_value_t			value
 ) {
-	return dictionary->handler->get(dictionary, key, value);
+	ion_status_t status;
+
+	dictionary_enter(dictionary, boolean_true);
+	status = dictionary->handler->get(dictionary, key, value);
+	dictionary_leave(dictionary, boolean_true);
+
+	return status;
+}
+
+ion_status_t
+dictionary_multi_get(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_keys
+) {
+	ion_key_size_t		key_size	= dictionary->instance->record.key_size;
+	ion_value_size_t	value_size	= dictionary->instance->record.value_size;
+	int					i;
+
+	if (0 >= num_keys) {
+		return ION_STATUS_OK(0);
+	}
+
+	dictionary_enter(dictionary, boolean_true);
+
+	if (NULL != dictionary->handler->multi_get) {
+		ion_status_t status = dictionary->handler->multi_get(dictionary, keys, values, statuses, num_keys);
+
+		dictionary_leave(dictionary, boolean_true);
+		return status;
+	}
+
+	for (i = 0; i < num_keys; i++) {
+		statuses[i] = dictionary->handler->get(dictionary, (ion_byte_t *) keys + i * key_size, (ion_byte_t *) values + i * value_size);
+	}
+
+	dictionary_leave(dictionary, boolean_true);
+
+	return dictionary_batch_status(statuses, num_keys);
+}
+
+ion_status_t
+dictionary_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_records
+) {
+	ion_key_size_t		key_size	= dictionary->instance->record.key_size;
+	ion_value_size_t	value_size	= dictionary->instance->record.value_size;
+	ion_status_t		status;
+	ion_wal_lsn_t		lsn			= 0;
+	int					i;
+
+	if (0 >= num_records) {
+		return ION_STATUS_OK(0);
+	}
+
+	dictionary_enter(dictionary, boolean_false);
+
+	if (NULL != dictionary->handler->insert_batch) {
+		/* So that records a failed batch did not get to are not logged */
+		for (i = 0; (NULL != dictionary->instance->wal) && (i < num_records); i++) {
+			statuses[i] = ION_STATUS_INITIALIZE;
+		}
+
+		status = dictionary->handler->insert_batch(dictionary, keys, values, statuses, num_records);
+	}
+	else {
+		for (i = 0; i < num_records; i++) {
+			statuses[i] = dictionary->handler->insert(dictionary, (ion_byte_t *) keys + i * key_size, (ion_byte_t *) values + i * value_size);
+		}
+
+		status = dictionary_batch_status(statuses, num_records);
+	}
+
+	/* The whole batch is committed at once */
+	for (i = 0; (NULL != dictionary->instance->wal) && (i < num_records); i++) {
+		dictionary_wal_log(dictionary, ion_dictionary_wal_insert, (ion_byte_t *) keys + i * key_size, (ion_byte_t *) values + i * value_size, &statuses[i], &lsn);
+
+		if ((err_ok != statuses[i].error) && (err_ok == status.error)) {
+			status.error = statuses[i].error;
+		}
+	}
+
+	return dictionary_leave_write(dictionary, status, lsn);
+}
+
+/**
+@brief		Merges two sorted runs of positions.
+*/
+static void
+dictionary_merge_order(
+	int						*order,
+	int						*scratch,
+	int						num,
+	ion_dictionary_order_t	compare,
+	void					*context
+) {
+	int half;
+	int i;
+	int j;
+	int k;
+
+	if (num < 2) {
+		return;
+	}
+
+	half = num / 2;
+	dictionary_merge_order(order, scratch, half, compare, context);
+	dictionary_merge_order(order + half, scratch, num - half, compare, context);
+
+	memcpy(scratch, order, half * sizeof(int));
+
+	i	= 0;
+	j	= half;
+	k	= 0;
+
+	while (i < half) {
+		if ((j < num) && (compare(context, order[j], scratch[i]) < 0)) {
+			order[k++] = order[j++];
+		}
+		else {
+			order[k++] = scratch[i++];
+		}
+	}
+}
+
+ion_err_t
+dictionary_sort_order(
+	int						*order,
+	int						num,
+	ion_dictionary_order_t	compare,
+	void					*context
+) {
+	int *scratch;
+	int i;
+
+	for (i = 0; i < num; i++) {
+		order[i] = i;
+	}
+
+	if (num < 2) {
+		return err_ok;
+	}
+
+	scratch = malloc((num / 2) * sizeof(int));
+
+	if (NULL == scratch) {
+		return err_out_of_memory;
+	}
+
+	dictionary_merge_order(order, scratch, num, compare, context);
+	free(scratch);
+
+	return err_ok;
+}
+
+/**
+@brief		The keys being ordered by @ref dictionary_sort_keys.
+*/
+typedef struct {
+	ion_dictionary_parent_t *instance;	/**< Dictionary to compare keys with. */
+	ion_byte_t				*keys;	/**< Keys, packed back to back. */
+} ion_dictionary_key_order_t;
+
+/**
+@brief		Compares two keys of a batch by position.
+*/
+static int
+dictionary_compare_key_order(
+	void	*context,
+	int		a,
+	int		b
+) {
+	ion_dictionary_key_order_t	*batch		= context;
+	ion_key_size_t				key_size	= batch->instance->record.key_size;
+
+	return batch->instance->compare(batch->keys + a * key_size, batch->keys + b * key_size, key_size);
+}
+
+ion_err_t
+dictionary_sort_keys(
+	ion_dictionary_parent_t *instance,
+	ion_key_t				keys,
+	int						num,
+	int						*order
+) {
+	ion_dictionary_key_order_t batch;
+
+	batch.instance		= instance;
+	batch.keys			= keys;
+
+	return dictionary_sort_order(order, num, dictionary_compare_key_order, &batch);
+}
+
+ion_status_t
+dictionary_batch_status(
+	ion_status_t	*statuses,
+	int				num
+) {
+	ion_status_t	status = ION_STATUS_OK(0);
+	int				i;
+
+	for (i = 0; i < num; i++) {
+		status.count += statuses[i].count;
+
+		if ((err_ok == status.error) && (err_ok != statuses[i].error) && (err_item_not_found != statuses[i].error)) {
+			status.error = statuses[i].error;
+		}
+	}
+
+	return status;
 }
 
 ion_status_t
@@ -158,14 +1421,54 @@ dictionary_update(
 	ion_key_t			key,
 	ion_value_t			value
 ) {
-	return dictionary->handler->update(dictionary, key, value);
+	ion_status_t	status;
+	ion_wal_lsn_t	lsn = 0;
+
+	dictionary_enter(dictionary, boolean_false);
+	status = dictionary->handler->update(dictionary, key, value);
+	dictionary_wal_log(dictionary, ion_dictionary_wal_update, key, value, &status, &lsn);
+
+	return dictionary_leave_write(dictionary, status, lsn);
 }
 
 ion_err_t
 dictionary_delete_dictionary(
 	ion_dictionary_t *dictionary
 ) {
-	return dictionary->handler->delete_dictionary(dictionary);
+	char		filename[ION_MAX_FILENAME_LENGTH];
+	ion_boolean_t durable;
+	ion_err_t	error;
+
+	dictionary_drain(dictionary);
+
+	durable = NULL != dictionary->instance->wal;
+	dictionary_get_filename(dictionary->instance->id, "wal", filename);
+	dictionary_wal_close(dictionary, boolean_false);
+
+	error = dictionary->handler->delete_dictionary(dictionary);
+
+	if (durable) {
+		ion_fremove(filename);
+	}
+
+	return error;
+}
+
+ion_err_t
+dictionary_make_durable(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t error;
+
+	if (NULL == dictionary->handler->flush_dictionary) {
+		return err_not_implemented;
+	}
+
+	dictionary_enter(dictionary, boolean_false);
+	error = (NULL == dictionary->instance->wal) ? dictionary_wal_open(dictionary) : err_ok;
+	dictionary_leave(dictionary, boolean_false);
+
+	return error;
 }
 
 ion_status_t
@@ -173,7 +1476,14 @@ dictionary_delete(
 	ion_dictionary_t	*dictionary,
 	ion_key_t			key
 ) {
-	return dictionary->handler->remove(dictionary, key);
+	ion_status_t	status;
+	ion_wal_lsn_t	lsn = 0;
+
+	dictionary_enter(dictionary, boolean_false);
+	status = dictionary->handler->remove(dictionary, key);
+	dictionary_wal_log(dictionary, ion_dictionary_wal_delete, key, NULL, &status, &lsn);
+
+	return dictionary_leave_write(dictionary, status, lsn);
 }
 
 char
@@ -266,6 +1576,8 @@ dictionary_open(
 ) {
 	ion_dictionary_compare_t compare	= dictionary_switch_compare(config->type);
 
+	dictionary->hash_function			= (hash_function_default == config->hash_function) ? hash_function_modulo : config->hash_function;
+
 	ion_err_t error						= handler->open_dictionary(handler, dictionary, config, compare);
 
 	if (err_not_implemented == error) {
@@ -298,7 +1610,7 @@ dictionary_open(
 		record.key		= alloca(config->key_size);
 		record.value	= alloca(config->value_size);
 
-		err				= dictionary_create(handler, dictionary, config->id, config->type, config->key_size, config->value_size, config->dictionary_size);
+		err				= dictionary_create_hashed(handler, dictionary, config->id, config->type, config->key_size, config->value_size, config->dictionary_size, dictionary->hash_function);
 
 		if (err_ok != err) {
 			return err;
@@ -333,8 +1645,19 @@ dictionary_open(
 	}
 
 	if (err_ok == error) {
-		dictionary->status			= ion_dictionary_status_ok;
-		dictionary->instance->id	= config->id;
+		char filename[ION_MAX_FILENAME_LENGTH];
+
+		dictionary->status					= ion_dictionary_status_ok;
+		dictionary->instance->id			= config->id;
+		dictionary->instance->wal			= NULL;
+		dictionary->instance->committing	= 0;
+		dictionary_latch_init(&dictionary->instance->latch);
+
+		dictionary_get_filename(config->id, "wal", filename);
+
+		if ((NULL != handler->flush_dictionary) && ion_fexists(filename)) {
+			error = dictionary_wal_open(dictionary);
+		}
 	}
 	else {
 		dictionary->status = ion_dictionary_status_error;
@@ -351,7 +1674,15 @@ dictionary_close(
 		return err_ok;
 	}
 
-	ion_err_t error = dictionary->handler->close_dictionary(dictionary);
+	dictionary_drain(dictionary);
+
+	ion_err_t error = dictionary_wal_close(dictionary, boolean_true);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	error = dictionary->handler->close_dictionary(dictionary);
 
 	if (err_not_implemented == error) {
 		ion_predicate_t		predicate;
@@ -532,13 +1863,42 @@ dictionary_build_predicate(
 	return err_ok;
 }
 
+/**
+@brief		Takes the next step of a cursor under its dictionary's latch.
+*/
+static ion_cursor_status_t
+dictionary_cursor_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_cursor_status_t status;
+
+	dictionary_enter(cursor->dictionary, boolean_false);
+	status = cursor->handler_next(cursor, record);
+	dictionary_leave(cursor->dictionary, boolean_false);
+
+	return status;
+}
+
 ion_err_t
 dictionary_find(
 	ion_dictionary_t	*dictionary,
 	ion_predicate_t		*predicate,
 	ion_dict_cursor_t	**cursor
 ) {
-	return dictionary->handler->find(dictionary, predicate, cursor);
+	ion_err_t error;
+
+	dictionary_enter(dictionary, boolean_false);
+	error = dictionary->handler->find(dictionary, predicate, cursor);
+	dictionary_leave(dictionary, boolean_false);
+
+	/* Latch each step of the cursor too, unless the handler needs no latching. */
+	if ((err_ok == error) && (NULL != *cursor) && (ion_concurrency_internal != dictionary->handler->concurrency)) {
+		(*cursor)->handler_next = (*cursor)->next;
+		(*cursor)->next			= dictionary_cursor_next;
+	}
+
+	return error;
 }
 
 ion_boolean_t
@@ -581,3 +1941,99 @@ test_predicate(
 
 	return result;
 }
+
+void
+dictionary_latch_init(
+	ion_latch_t *latch
+) {
+	latch->state	= 0;
+	latch->writers	= 0;
+}
+
+#if ION_THREAD_SAFE
+
+/**
+@brief		Waits a little before a latch is tried again, giving up the
+			processor once the wait has gone on for a while.
+*/
+static void
+dictionary_latch_backoff(
+	int *spins
+) {
+	if (++(*spins) >= ION_LATCH_SPINS) {
+		sched_yield();
+		*spins = 0;
+	}
+}
+
+#endif
+
+void
+dictionary_latch_acquire_shared(
+	ion_latch_t *latch
+) {
+#if ION_THREAD_SAFE
+	int spins = 0;
+	int state;
+
+	for (;; dictionary_latch_backoff(&spins)) {
+		/* A waiting writer goes first, so that a steady stream of readers can not keep it out. */
+		if (0 != __atomic_load_n(&latch->writers, __ATOMIC_ACQUIRE)) {
+			continue;
+		}
+
+		state = __atomic_load_n(&latch->state, __ATOMIC_RELAXED);
+
+		if ((state >= 0) && __atomic_compare_exchange_n(&latch->state, &state, state + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			return;
+		}
+	}
+#else
+	UNUSED(latch);
+#endif
+}
+
+void
+dictionary_latch_release_shared(
+	ion_latch_t *latch
+) {
+#if ION_THREAD_SAFE
+	__atomic_sub_fetch(&latch->state, 1, __ATOMIC_RELEASE);
+#else
+	UNUSED(latch);
+#endif
+}
+
+void
+dictionary_latch_acquire_exclusive(
+	ion_latch_t *latch
+) {
+#if ION_THREAD_SAFE
+	int spins = 0;
+	int state;
+
+	__atomic_add_fetch(&latch->writers, 1, __ATOMIC_ACQUIRE);
+
+	for (;; dictionary_latch_backoff(&spins)) {
+		state = 0;
+
+		if (__atomic_compare_exchange_n(&latch->state, &state, -1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			return;
+		}
+	}
+#else
+	UNUSED(latch);
+#endif
+}
+
+void
+dictionary_latch_release_exclusive(
+	ion_latch_t *latch
+) {
+#if ION_THREAD_SAFE
+	__atomic_store_n(&latch->state, 0, __ATOMIC_RELEASE);
+	__atomic_sub_fetch(&latch->writers, 1, __ATOMIC_RELEASE);
+#else
+	UNUSED(latch);
+#endif
+}
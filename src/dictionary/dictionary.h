@@ -85,6 +85,31 @@ dictionary_create(
 	ion_dictionary_size_t		dictionary_size
 );
 
+/**
+@brief		Creates as instance of a specific type of dictionary, placing
+			keys with the given hash function family.
+@details	Takes the same parameters as @ref dictionary_create. Hash based
+			implementations place keys with @p hash_function, and the
+			master table records it so that the dictionary is reopened with
+			the same family. Other implementations ignore it.
+@param		hash_function
+				The hash function family to use, or
+				@ref hash_function_default for the legacy hash that
+				@ref dictionary_create uses.
+@return		A status describing the result of dictionary creation.
+*/
+ion_err_t
+dictionary_create_hashed(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_hash_function_t			hash_function
+);
+
 /**
 @brief		Insert a value into a dictionary.
 
@@ -121,6 +146,135 @@ dictionary_get(
 	ion_value_t			value
 );
 
+/**
+@brief		Retrieve the values for many keys at once.
+
+@details	Equivalent to calling @ref dictionary_get for each key, but
+			implementations may reorder the lookups so that each page or
+			bucket is read once. Dictionaries without a batched get fall
+			back to one lookup per key.
+
+@param		dictionary
+				A pointer to the dictionary to search.
+@param		keys
+				@p num_keys keys, packed back to back.
+@param		values
+				Room for @p num_keys values, packed back to back. The value
+				for each key found is written at the key's position.
+@param		statuses
+				@p num_keys statuses, each set as @ref dictionary_get would
+				set it for the key at the same position.
+@param		num_keys
+				The number of keys to look up.
+@return		A status whose count is the number of keys found. The error
+			is @ref err_ok unless a lookup failed for a reason other than
+			the key not being present.
+*/
+ion_status_t
+dictionary_multi_get(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_keys
+);
+
+/**
+@brief		Insert many records at once.
+
+@details	Equivalent to calling @ref dictionary_insert for each record in
+			batch order, but implementations may gather the writes so that
+			each page or bucket touched by the batch is written once.
+			Dictionaries without a batched insert fall back to one insert
+			per record.
+
+@param		dictionary
+				A pointer to the dictionary to insert into.
+@param		keys
+				@p num_records keys, packed back to back.
+@param		values
+				@p num_records values, packed back to back.
+@param		statuses
+				@p num_records statuses, each set as @ref dictionary_insert
+				would set it for the record at the same position.
+@param		num_records
+				The number of records to insert.
+@return		A status whose count is the number of records inserted. The
+			error is the first error reported for any record.
+*/
+ion_status_t
+dictionary_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_records
+);
+
+/**
+@brief		Sorts the positions of a batch of records.
+
+@details	Writes the positions 0 to @p num - 1 to @p order, sorted with
+			@p compare. The sort is stable, so records that compare equal
+			keep their batch order. Used by batched operations to visit
+			records in key, bucket or file order.
+
+@param		order
+				Room for @p num positions.
+@param		num
+				The number of records in the batch.
+@param		compare
+				Compares two positions.
+@param		context
+				Passed through to @p compare.
+@return		@ref err_out_of_memory if scratch space could not be
+			allocated, @ref err_ok otherwise.
+*/
+ion_err_t
+dictionary_sort_order(
+	int						*order,
+	int						num,
+	ion_dictionary_order_t	compare,
+	void					*context
+);
+
+/**
+@brief		Sorts the positions of a batch of keys by key.
+
+@param		instance
+				The dictionary instance whose comparison function orders the keys.
+@param		keys
+				@p num keys, packed back to back.
+@param		num
+				The number of keys.
+@param		order
+				Room for @p num positions, written in ascending key order.
+@return		The status of @ref dictionary_sort_order.
+*/
+ion_err_t
+dictionary_sort_keys(
+	ion_dictionary_parent_t *instance,
+	ion_key_t				keys,
+	int						num,
+	int						*order
+);
+
+/**
+@brief		Combines the statuses of a batch into one status.
+
+@param		statuses
+				The status of each record in the batch.
+@param		num
+				The number of records in the batch.
+@return		A status whose count is the total of the counts, and whose
+			error is the first error other than @ref err_item_not_found.
+*/
+ion_status_t
+dictionary_batch_status(
+	ion_status_t	*statuses,
+	int				num
+);
+
 /**
 @brief		Delete a value given a key.
 @param		dictionary
@@ -155,6 +309,9 @@ dictionary_update(
 /**
 @brief	  Destroys dictionary
 
+@details	Waits for calls already made into the dictionary to finish. No
+			thread may start a new one.
+
 @param	  dictionary
 				The dictionary instance to destroy.
 @return		The status of the total destruction of the dictionary.
@@ -222,8 +379,63 @@ dictionary_compare_signed_value(
 	ion_key_size_t	key_size
 );
 
+/**
+@brief		Hashes a key with xxHash32.
+@param		key
+				The key to hash.
+@param		key_size
+				The length of the key in bytes.
+@return		The 32 bit hash of the key.
+*/
+uint32_t
+dictionary_hash_xxhash(
+	ion_key_t		key,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Hashes a key with wyhash, folding the result to 32 bits.
+@param		key
+				The key to hash.
+@param		key_size
+				The length of the key in bytes.
+@return		The 32 bit hash of the key.
+*/
+uint32_t
+dictionary_hash_wyhash(
+	ion_key_t		key,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Picks the hash function to use for keys of the given type and
+			size.
+@details	Numeric keys of four and eight bytes get hashes specialized for
+			their size. String keys are hashed only up to their terminator,
+			since they are compared that way. Every function returned is
+			consistent with the comparison function of @p key_type.
+@param		key_type
+				The type of the key.
+@param		key_size
+				The size of the key in bytes.
+@param		hash_function
+				The hash function family to pick from.
+@return		The hash function, or @c NULL for @ref hash_function_modulo
+			and @ref hash_function_default, which hash based
+			implementations provide themselves.
+*/
+ion_dictionary_hash_t
+dictionary_switch_hash(
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_hash_function_t hash_function
+);
+
 /**
 @brief		Opens a dictionary, given the desired config.
+@details	If the dictionary was made durable with
+			@ref dictionary_make_durable, the writes in its log that may not
+			have reached its files are redone first, and it stays durable.
 @param		handler
 				A pointer to the dictionary handler object to be used.
 @param		dictionary
@@ -240,8 +452,42 @@ dictionary_open(
 	ion_dictionary_config_info_t	*config
 );
 
+/**
+@brief		Makes every write to a dictionary durable once the call making
+			it returns.
+@details	Writes are added to a write-ahead log kept beside the
+			dictionary's files, which is synchronized when each write is
+			committed; writes committed by several threads at once share a
+			synchronization, and a batch of inserts is committed once. The
+			dictionary's own files are only synchronized at checkpoints, taken
+			when the log reaches @ref ION_WAL_CHECKPOINT_SIZE and when the
+			dictionary is closed.
+
+			The log lasts until the dictionary is deleted, and
+			@ref dictionary_open redoes the writes logged since the last
+			checkpoint. An insert is not redone if the record is already
+			there, or if a later update or delete of its key is in the log,
+			as that write is redone after and sets what the key holds. A
+			redone insert of a key that is already there with another value
+			is dropped for the same reason. This relies on the dictionary's
+			files holding whole writes, which they are flushed to hold after
+			each one. The log holds writes, not the pages they changed, so a
+			write torn by the system stopping while its pages were flushed,
+			such as a B+ tree split over several nodes, is not repaired.
+@param		dictionary
+				A pointer to the dictionary object to make durable.
+@returns	An error describing the result of the call, which is
+			@ref err_not_implemented for dictionaries kept in memory.
+*/
+ion_err_t
+dictionary_make_durable(
+	ion_dictionary_t *dictionary
+);
+
 /**
 @brief		Closes a dictionary.
+@details	Waits for calls already made into the dictionary to finish. No
+			thread may start a new one.
 @param		dictionary
 				A pointer to the dictionary object to be closed.
 @returns	An error describing the result of open operation.
@@ -281,6 +527,12 @@ dictionary_build_predicate(
 @details	This function will allocate and initialize the cursor.
 			This means that it must freed once we are done. This function
 			sets up a cursor for traversal.
+
+			Each step of the cursor is latched like any other call into the
+			dictionary, but nothing is held between steps. Writing to the
+			dictionary, from any thread, while a cursor is open on it leaves
+			the cursor undefined, unless the implementation synchronizes
+			itself.
 @param		dictionary
 				A pointer to the dictionary object to be created.
 @param		predicate
@@ -319,6 +571,60 @@ test_predicate(
 	ion_key_t			key
 );
 
+/**
+@brief		Initializes a latch, which starts out free.
+@param		latch
+				The latch to initialize.
+*/
+void
+dictionary_latch_init(
+	ion_latch_t *latch
+);
+
+/**
+@brief		Acquires a latch alongside other readers, waiting for any writer
+			to release it first.
+@param		latch
+				The latch to acquire.
+*/
+void
+dictionary_latch_acquire_shared(
+	ion_latch_t *latch
+);
+
+/**
+@brief		Releases a latch acquired by
+			@ref dictionary_latch_acquire_shared.
+@param		latch
+				The latch to release.
+*/
+void
+dictionary_latch_release_shared(
+	ion_latch_t *latch
+);
+
+/**
+@brief		Acquires a latch alone, waiting for all other holders to release
+			it first.
+@param		latch
+				The latch to acquire.
+*/
+void
+dictionary_latch_acquire_exclusive(
+	ion_latch_t *latch
+);
+
+/**
+@brief		Releases a latch acquired by
+			@ref dictionary_latch_acquire_exclusive.
+@param		latch
+				The latch to release.
+*/
+void
+dictionary_latch_release_exclusive(
+	ion_latch_t *latch
+);
+
 #if defined(__cplusplus)
 }
 #endif
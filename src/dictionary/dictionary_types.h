@@ -45,6 +45,28 @@ typedef unsigned int ion_dictionary_id_t;
 */
 typedef ion_byte_t ion_dict_use_t;
 
+/**
+@brief		The families of key hash functions available to hash based
+			dictionaries.
+@details	The specific function used within a family is picked by key type
+			and key size. See @ref dictionary_switch_hash.
+*/
+enum ION_HASH_FUNCTION {
+	hash_function_default = 0,	/**< The legacy hash, the same as
+									 @ref hash_function_modulo. */
+	hash_function_modulo,	/**< The key, read as an int, modulo the map
+								 size. */
+	hash_function_xxhash,	/**< xxHash32. Opt-in. */
+	hash_function_wyhash	/**< wyhash, folded to 32 bits. Opt-in. */
+};
+
+/**
+@brief		A type for the hash function family used by a dictionary.
+@details	This allows us to control the size of the type stored in the
+			master table, rather than depending on the enum.
+*/
+typedef ion_byte_t ion_hash_function_t;
+
 /**
 @brief		Struct containing details for opening a dictionary previously
 			created.
@@ -62,6 +84,9 @@ typedef struct {
 													 parameter. Dependent on
 													 the dictionary
 													 implementation used. */
+	ion_hash_function_t		hash_function;		/**< The hash function family
+													 used to place keys. Ignore
+													 if N/A. */
 } ion_dictionary_config_info_t;
 
 /**
@@ -93,12 +118,34 @@ typedef char (*ion_dictionary_compare_t)(
 */
 typedef struct dictionary_cursor ion_dict_cursor_t;
 
+/**
+@brief		Function pointer type for key hash functions.
+*/
+typedef uint32_t (*ion_dictionary_hash_t)(
+	ion_key_t,
+	ion_key_size_t
+);
+
 /**
 @brief		The dictionary predicate type.
 @see		predicate
 */
 typedef struct predicate ion_predicate_t;
 
+/**
+@brief		Function pointer type used to sort records by their position in
+			a batch.
+@details	Returns a negative number, zero or a positive number as the record
+			at index @p a should come before, with, or after the record at
+			index @p b.
+@see		dictionary_sort_order
+*/
+typedef int (*ion_dictionary_order_t)(
+	void *,
+	int,
+	int
+);
+
 /**
 @brief		The dictionary predicate statement type.
 @see		predicate_statement
@@ -158,6 +205,40 @@ enum ION_CURSOR_STATUS {
 */
 typedef char ion_cursor_status_t;
 
+/**
+@brief		A latch that any number of readers, or a single writer, may hold.
+@details	Threads waiting for the latch spin for a while and then yield
+			the processor. A waiting writer keeps new readers out, so that
+			it can not be starved by them. The latch is not reentrant.
+*/
+typedef struct {
+	int state;		/**< The number of readers holding the latch, or -1 while
+						 a writer holds it. */
+	int writers;	/**< The number of writers holding or waiting for the
+						 latch. */
+} ion_latch_t;
+
+/**
+@brief		How calls to a dictionary implementation may overlap, which
+			decides how the dictionary layer latches them.
+*/
+enum ION_CONCURRENCY {
+	/**> Every call is made alone. */
+	ion_concurrency_serial,
+	/**> Gets only read the dictionary, and may be made at once, while any
+		 other call is made alone. */
+	ion_concurrency_shared_get,
+	/**> The implementation synchronizes its own calls, which the dictionary
+		 layer does not latch. */
+	ion_concurrency_internal,
+};
+
+/**
+@brief		A short value describing how calls to a dictionary
+			implementation may overlap.
+*/
+typedef char ion_concurrency_t;
+
 /**
 @brief		A dictionary_handler is responsible for dealing with the specific
 			interface for an underlying dictionary, but is decoupled from a
@@ -219,6 +300,33 @@ struct dictionary_handler {
 		ion_dictionary_t *
 	);
 	/**< A pointer to the dictionaries close function */
+	ion_status_t (*multi_get)(
+		ion_dictionary_t *,
+		ion_key_t,
+		ion_value_t,
+		ion_status_t *,
+		int
+	);
+	/**< A pointer to the dictionaries batched get function, or NULL if
+		 keys are to be looked up one at a time. */
+	ion_status_t (*insert_batch)(
+		ion_dictionary_t *,
+		ion_key_t,
+		ion_value_t,
+		ion_status_t *,
+		int
+	);
+	/**< A pointer to the dictionaries batched insert function, or NULL if
+		 records are to be inserted one at a time. */
+	ion_err_t (*flush_dictionary)(
+		ion_dictionary_t *,
+		ion_boolean_t
+	);
+	/**< A pointer to the dictionaries function that writes what it buffers
+		 to its files, and synchronizes them if asked to, or NULL if it
+		 keeps nothing in files. */
+	ion_concurrency_t concurrency;
+	/**< How calls to the dictionary may overlap. */
 };
 
 /**
@@ -252,6 +360,11 @@ struct dictionary {
 											 dictionary (but we don't
 											 know type). */
 	ion_dictionary_handler_t	*handler;	/**< Handler for the specific type. */
+	ion_hash_function_t			hash_function;	/**< Hash function family
+												 used by hash based
+												 implementations. Set by
+												 @ref dictionary_create_hashed
+												 and @ref dictionary_open. */
 };
 
 /**
@@ -263,6 +376,14 @@ struct dictionary_parent {
 	ion_dictionary_compare_t	compare;/**< Comparison function for
 											  instance of map. */
 	ion_dictionary_id_t			id;		/**< ID of dictionary instance. */
+	ion_latch_t					latch;	/**< Latches calls into the
+											 dictionary, as its handler's
+											 concurrency asks. */
+	struct wal					*wal;	/**< The write-ahead log of a durable
+											 dictionary, or NULL. */
+	int							committing;	/**< Logged writes still being
+												 committed, which closing
+												 the dictionary waits for. */
 };
 
 /**
@@ -382,6 +503,13 @@ struct dictionary_cursor {
 	);
 	/**< A pointer to the next function,
 		 which sets ion_cursor_status_t). */
+	ion_cursor_status_t (*handler_next)(
+		ion_dict_cursor_t *,
+		ion_record_t *record
+	);
+	/**< The handler's own next function,
+		 which @ref dictionary_find latches
+		 @p next around. */
 	void (*destroy)(
 		ion_dict_cursor_t **
 	);
@@ -23,6 +23,719 @@
 
 #include "flat_file.h"
 
+/**
+@brief		Records the key of the row written at @p location in the fence index,
+			if the row starts a block.
+@details	The index grows as rows are appended. Should it fail to grow, it is
+			dropped, and lookups go back to reading a row per probe.
+@param[in]	flat_file
+				Which flat file instance to update the index of.
+@param[in]	location
+				Which row index was written.
+@param[in]	key
+				The key written there.
+*/
+static void
+flat_file_fence_set(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		location,
+	ion_key_t		key
+) {
+	ion_key_size_t	key_size = flat_file->super.record.key_size;
+	ion_fpos_t		block;
+
+	if ((NULL == flat_file->fences) || (0 != location % flat_file->num_buffered)) {
+		return;
+	}
+
+	block = location / flat_file->num_buffered;
+
+	if (block >= flat_file->fence_capacity) {
+		ion_fpos_t	capacity = flat_file->fence_capacity * 2;
+		ion_byte_t	*fences;
+
+		while (capacity <= block) {
+			capacity *= 2;
+		}
+
+		fences = realloc(flat_file->fences, capacity * key_size);
+
+		if (NULL == fences) {
+			free(flat_file->fences);
+			flat_file->fences = NULL;
+			return;
+		}
+
+		flat_file->fences			= fences;
+		flat_file->fence_capacity	= capacity;
+	}
+
+	memcpy(flat_file->fences + block * key_size, key, key_size);
+
+	if (block >= flat_file->num_fences) {
+		flat_file->num_fences = block + 1;
+	}
+}
+
+/**
+@brief		Drops the fences of blocks that no longer hold any rows, after the
+			eof position has moved back.
+*/
+static void
+flat_file_fence_truncate(
+	ion_flat_file_t *flat_file
+) {
+	ion_fpos_t num_rows = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+
+	flat_file->num_fences = (num_rows + flat_file->num_buffered - 1) / flat_file->num_buffered;
+}
+
+/**
+@brief		Builds the fence index of an opened data file, by reading the key of
+			the first row of each block.
+@details	If there is not enough memory for the index, the flat file goes
+			without one.
+@param[in]	flat_file
+				Which flat file instance to build the index of.
+@return		Resulting status of the file operations.
+*/
+static ion_err_t
+flat_file_fence_build(
+	ion_flat_file_t *flat_file
+) {
+	ion_key_size_t	key_size	= flat_file->super.record.key_size;
+	ion_fpos_t		num_rows	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_fpos_t		num_blocks	= (num_rows + flat_file->num_buffered - 1) / flat_file->num_buffered;
+	ion_fpos_t		block;
+	ion_err_t		err;
+
+	flat_file->num_fences		= 0;
+	flat_file->fence_capacity	= num_blocks > 0 ? num_blocks : 1;
+	flat_file->fences			= malloc(flat_file->fence_capacity * key_size);
+
+	if (NULL == flat_file->fences) {
+		return err_ok;
+	}
+
+	for (block = 0; block < num_blocks; block++) {
+		ion_fpos_t offset = flat_file->start_of_data + block * flat_file->num_buffered * flat_file->row_size + sizeof(ion_flat_file_row_status_t);
+
+		err = ion_fread_at(flat_file->data_file, offset, key_size, flat_file->fences + block * key_size);
+
+		if (err_ok != err) {
+			free(flat_file->fences);
+			flat_file->fences = NULL;
+			return err;
+		}
+	}
+
+	flat_file->num_fences = num_blocks;
+
+	return err_ok;
+}
+
+/**
+@brief		Reads the block of rows starting at row @p location into the region
+			buffer, unless it is already loaded there.
+@param[in]	flat_file
+				Which flat file instance to read from.
+@param[in]	location
+				Which row index the block starts at.
+@return		Resulting status of the file operations.
+*/
+static ion_err_t
+flat_file_load_block(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		location
+) {
+	ion_fpos_t	num_rows	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	size_t		num_to_read = (num_rows - location) > flat_file->num_buffered ? (size_t) flat_file->num_buffered : (size_t) (num_rows - location);
+
+	if ((flat_file->current_loaded_region == location) && (flat_file->num_in_buffer == num_to_read)) {
+		return err_ok;
+	}
+
+	if (err_ok != ion_fseek(flat_file->data_file, flat_file->start_of_data + location * flat_file->row_size, ION_FILE_START)) {
+		return err_file_bad_seek;
+	}
+
+	if (err_ok != ion_fread(flat_file->data_file, flat_file->row_size * num_to_read, flat_file->buffer)) {
+		flat_file->current_loaded_region = -1;
+		return err_file_incomplete_read;
+	}
+
+	flat_file->current_loaded_region	= location;
+	flat_file->num_in_buffer			= num_to_read;
+
+	return err_ok;
+}
+
+/**
+@brief		Writes out the first @p num_rows rows held in the region buffer.
+@param[in]	flat_file
+				Which flat file instance to write to.
+@param[in]	location
+				Which row index the first buffered row is written to.
+@param[in]	num_rows
+				How many rows to write.
+@return		Resulting status of the file operations.
+*/
+static ion_err_t
+flat_file_write_buffer(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		location,
+	size_t			num_rows
+) {
+	if (err_ok != ion_fseek(flat_file->data_file, flat_file->start_of_data + location * flat_file->row_size, ION_FILE_START)) {
+		return err_file_bad_seek;
+	}
+
+	if (err_ok != ion_fwrite(flat_file->data_file, flat_file->row_size * num_rows, flat_file->buffer)) {
+		return err_file_incomplete_write;
+	}
+
+	/* A write holds at most a block's worth of rows, so at most one of them starts a block */
+	ion_fpos_t block_start = (location + flat_file->num_buffered - 1) / flat_file->num_buffered * flat_file->num_buffered;
+
+	if (block_start < location + (ion_fpos_t) num_rows) {
+		flat_file_fence_set(flat_file, block_start, flat_file->buffer + (block_start - location) * flat_file->row_size + sizeof(ion_flat_file_row_status_t));
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Predicate for rows that hold a record or a tombstone.
+@see		ion_flat_file_predicate_t
+*/
+static ion_boolean_t
+flat_file_predicate_written(
+	ion_flat_file_t		*flat_file,
+	ion_flat_file_row_t *row,
+	va_list				*args
+) {
+	UNUSED(flat_file);
+	UNUSED(args);
+
+	return ION_FLAT_FILE_STATUS_EMPTY != row->row_status;
+}
+
+/**
+@brief		Adds a run starting at row @p location to the end of the run list.
+*/
+static ion_err_t
+flat_file_run_add(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		location
+) {
+	if (flat_file->num_runs == flat_file->run_capacity) {
+		ion_fpos_t *runs = realloc(flat_file->runs, flat_file->run_capacity * 2 * sizeof(ion_fpos_t));
+
+		if (NULL == runs) {
+			return err_out_of_memory;
+		}
+
+		flat_file->runs			= runs;
+		flat_file->run_capacity *= 2;
+	}
+
+	flat_file->runs[flat_file->num_runs++] = location;
+
+	return err_ok;
+}
+
+/**
+@brief		Gives the row index one past the end of a run.
+*/
+static ion_fpos_t
+flat_file_run_end(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		run
+) {
+	if (run + 1 < flat_file->num_runs) {
+		return flat_file->runs[run + 1];
+	}
+
+	return (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+}
+
+/**
+@brief		Gives the tier of a run. A run of up to @ref ION_FLAT_FILE_TIER_FANOUT times as many rows
+			as the memtable holds is in tier 0, and each tier after that holds runs that many times
+			larger.
+*/
+static int
+flat_file_run_tier(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		run
+) {
+	ion_fpos_t	blocks	= (flat_file_run_end(flat_file, run) - flat_file->runs[run]) / flat_file->num_buffered;
+	int			tier	= 0;
+
+	while (blocks >= ION_FLAT_FILE_TIER_FANOUT) {
+		blocks /= ION_FLAT_FILE_TIER_FANOUT;
+		tier++;
+	}
+
+	return tier;
+}
+
+/**
+@brief		One of the runs being merged by @ref flat_file_merge_runs.
+*/
+typedef struct {
+	/**> The next row of the run to read. */
+	ion_fpos_t	next;
+	/**> One past the last row of the run. */
+	ion_fpos_t	end;
+	/**> Rows read from the run. */
+	ion_byte_t	*rows;
+	/**> Number of rows in @p rows. */
+	size_t		count;
+	/**> The next row in @p rows to merge. */
+	size_t		position;
+} ion_flat_file_merge_input_t;
+
+/**
+@brief		Gives the next row of a run being merged, reading more of the run if needed.
+@return		The row, or @p NULL at the end of the run or on an error, which is written to @p err.
+*/
+static ion_byte_t *
+flat_file_merge_peek(
+	ion_flat_file_t				*flat_file,
+	ion_flat_file_merge_input_t *input,
+	size_t						chunk,
+	ion_err_t					*err
+) {
+	if ((input->position == input->count) && (input->next < input->end)) {
+		input->count	= (input->end - input->next) > (ion_fpos_t) chunk ? chunk : (size_t) (input->end - input->next);
+		input->position = 0;
+		*err			= ion_fread_at(flat_file->data_file, flat_file->start_of_data + input->next * flat_file->row_size, input->count * flat_file->row_size, input->rows);
+		input->next		+= input->count;
+
+		if (err_ok != *err) {
+			input->count = 0;
+			return NULL;
+		}
+	}
+
+	return input->position < input->count ? input->rows + input->position * flat_file->row_size : NULL;
+}
+
+/**
+@brief		Merges the runs from run @p first to the newest into one run, in the place of the runs.
+@details	The rows with each key are gathered oldest first, and those before the last tombstone
+			among them are dropped, as it hides them. The tombstone itself is kept unless the merge
+			starts at the oldest run, where there is nothing left for it to hide. The merged run is
+			written to a separate file first, then copied over the runs it replaces, and the rows
+			left past it are cleared so that they are not found when the data file is opened again.
+@param[in]	flat_file
+				Which flat file instance to merge the runs of.
+@param[in]	first
+				Index of the oldest run to merge.
+@return		Resulting status of the merge.
+*/
+static ion_err_t
+flat_file_merge_runs(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		first
+) {
+	ion_key_size_t				key_size		= flat_file->super.record.key_size;
+	size_t						row_size		= flat_file->row_size;
+	ion_fpos_t					num_rows		= (flat_file->eof_position - flat_file->start_of_data) / row_size;
+	ion_fpos_t					num_inputs		= flat_file->num_runs - first;
+	size_t						chunk			= flat_file->num_buffered / num_inputs > 0 ? flat_file->num_buffered / num_inputs : 1;
+	ion_fpos_t					destination		= flat_file->runs[first];
+	ion_byte_t					*key			= alloca(key_size);
+	ion_byte_t					*group			= NULL;
+	size_t						group_size		= 0;
+	size_t						group_capacity	= 0;
+	size_t						num_out			= 0;
+	ion_fpos_t					out_rows		= 0;
+	ion_err_t					err				= err_ok;
+	ion_flat_file_merge_input_t *inputs;
+	ion_file_handle_t			merged;
+	char						filename[ION_MAX_FILENAME_LENGTH];
+	ion_fpos_t					i;
+	size_t						j;
+
+	inputs = malloc(num_inputs * (sizeof(ion_flat_file_merge_input_t) + chunk * row_size));
+
+	if (NULL == inputs) {
+		return err_out_of_memory;
+	}
+
+	for (i = 0; i < num_inputs; i++) {
+		inputs[i].next		= flat_file->runs[first + i];
+		inputs[i].end		= flat_file_run_end(flat_file, first + i);
+		inputs[i].rows		= (ion_byte_t *) (inputs + num_inputs) + i * chunk * row_size;
+		inputs[i].count		= 0;
+		inputs[i].position	= 0;
+	}
+
+	dictionary_get_filename(flat_file->super.id, "ffm", filename);
+	merged = ion_fopen(filename);
+
+#if defined(ARDUINO)
+
+	if (NULL == merged.file) {
+#else
+
+	if (ION_NOFILE == merged) {
+#endif
+		free(inputs);
+		return err_file_open_error;
+	}
+
+	/* The region buffer gathers the merged rows. */
+	flat_file->current_loaded_region	= -1;
+	flat_file->num_in_buffer			= 0;
+
+	while (err_ok == err) {
+		ion_byte_t *smallest = NULL;
+
+		for (i = 0; (err_ok == err) && (i < num_inputs); i++) {
+			ion_byte_t *row = flat_file_merge_peek(flat_file, &inputs[i], chunk, &err);
+
+			if ((NULL != row) && ((NULL == smallest) || (flat_file->super.compare(row + sizeof(ion_flat_file_row_status_t), smallest, key_size) < 0))) {
+				smallest = row + sizeof(ion_flat_file_row_status_t);
+			}
+		}
+
+		if ((err_ok != err) || (NULL == smallest)) {
+			break;
+		}
+
+		memcpy(key, smallest, key_size);
+		group_size = 0;
+
+		/* The runs are in age order, and so are the rows of each run. */
+		for (i = 0; (err_ok == err) && (i < num_inputs); i++) {
+			ion_byte_t *row;
+
+			while (NULL != (row = flat_file_merge_peek(flat_file, &inputs[i], chunk, &err)) && (0 == flat_file->super.compare(row + sizeof(ion_flat_file_row_status_t), key, key_size))) {
+				if (group_size == group_capacity) {
+					ion_byte_t *grown = realloc(group, (group_capacity > 0 ? group_capacity * 2 : 4) * row_size);
+
+					if (NULL == grown) {
+						err = err_out_of_memory;
+						break;
+					}
+
+					group			= grown;
+					group_capacity	= group_capacity > 0 ? group_capacity * 2 : 4;
+				}
+
+				memcpy(group + group_size * row_size, row, row_size);
+				group_size++;
+				inputs[i].position++;
+			}
+		}
+
+		size_t keep = 0;
+
+		for (j = 0; j < group_size; j++) {
+			if (ION_FLAT_FILE_STATUS_TOMBSTONE == group[j * row_size]) {
+				keep = 0 == first ? j + 1 : j;
+			}
+		}
+
+		for (j = keep; (err_ok == err) && (j < group_size); j++) {
+			memcpy(flat_file->buffer + num_out * row_size, group + j * row_size, row_size);
+			num_out++;
+
+			if (num_out == (size_t) flat_file->num_buffered) {
+				err			= ion_fwrite_at(merged, out_rows * row_size, num_out * row_size, flat_file->buffer);
+				out_rows	+= num_out;
+				num_out		= 0;
+			}
+		}
+	}
+
+	if ((err_ok == err) && (num_out > 0)) {
+		err			= ion_fwrite_at(merged, out_rows * row_size, num_out * row_size, flat_file->buffer);
+		out_rows	+= num_out;
+	}
+
+	for (i = 0; (err_ok == err) && (i < out_rows); i += num_out) {
+		num_out = (out_rows - i) > flat_file->num_buffered ? (size_t) flat_file->num_buffered : (size_t) (out_rows - i);
+		err		= ion_fread_at(merged, i * row_size, num_out * row_size, flat_file->buffer);
+
+		if (err_ok == err) {
+			err = flat_file_write_buffer(flat_file, destination + i, num_out);
+		}
+	}
+
+	if (err_ok == err) {
+		memset(flat_file->buffer, 0, flat_file->num_buffered * row_size);
+
+		for (j = 0; j < (size_t) flat_file->num_buffered; j++) {
+			flat_file->buffer[j * row_size] = ION_FLAT_FILE_STATUS_EMPTY;
+		}
+
+		for (i = destination + out_rows; (err_ok == err) && (i < num_rows); i += num_out) {
+			num_out = (num_rows - i) > flat_file->num_buffered ? (size_t) flat_file->num_buffered : (size_t) (num_rows - i);
+			err		= ion_fwrite_at(flat_file->data_file, flat_file->start_of_data + i * row_size, num_out * row_size, flat_file->buffer);
+		}
+	}
+
+	if (err_ok == err) {
+		flat_file->eof_position = flat_file->start_of_data + (destination + out_rows) * row_size;
+		flat_file->num_runs		= out_rows > 0 ? first + 1 : first;
+		flat_file_fence_truncate(flat_file);
+	}
+
+	flat_file->current_loaded_region	= -1;
+	flat_file->num_in_buffer			= 0;
+
+	free(group);
+	free(inputs);
+	ion_fclose(merged);
+	fremove(filename);
+
+	return err;
+}
+
+/**
+@brief		Appends the memtable to the data file as a new run, then merges the newest runs for as
+			long as they are all of the same tier.
+*/
+static ion_err_t
+flat_file_memtable_flush(
+	ion_flat_file_t *flat_file
+) {
+	ion_fpos_t	location = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_err_t	err;
+	ion_fpos_t	i;
+
+	if (0 == flat_file->num_in_memtable) {
+		return err_ok;
+	}
+
+	/* The region buffer holds as many rows as the memtable. */
+	flat_file->current_loaded_region	= -1;
+	flat_file->num_in_buffer			= 0;
+	memcpy(flat_file->buffer, flat_file->memtable, flat_file->num_in_memtable * flat_file->row_size);
+
+	err = flat_file_write_buffer(flat_file, location, flat_file->num_in_memtable);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	flat_file->eof_position		= flat_file->start_of_data + (location + flat_file->num_in_memtable) * flat_file->row_size;
+	flat_file->num_in_memtable	= 0;
+
+	err							= flat_file_run_add(flat_file, location);
+
+	while ((err_ok == err) && (flat_file->num_runs >= ION_FLAT_FILE_TIER_FANOUT)) {
+		ion_fpos_t	first	= flat_file->num_runs - ION_FLAT_FILE_TIER_FANOUT;
+		int			tier	= flat_file_run_tier(flat_file, first);
+
+		for (i = first + 1; (i < flat_file->num_runs) && (flat_file_run_tier(flat_file, i) == tier); i++) {}
+
+		if (i < flat_file->num_runs) {
+			break;
+		}
+
+		err = flat_file_merge_runs(flat_file, first);
+	}
+
+	return err;
+}
+
+/**
+@brief		Adds a row to the memtable, after the rows with an equal key. A tombstone replaces the
+			rows with its key that are there, as it hides them.
+@param[in]	flat_file
+				Which flat file instance to write to.
+@param[in]	row_status
+				Either @ref ION_FLAT_FILE_STATUS_OCCUPIED or @ref ION_FLAT_FILE_STATUS_TOMBSTONE.
+@param[in]	key
+				Key of the row.
+@param[in]	value
+				Value of the row, or @p NULL for a tombstone.
+@return		Resulting status of the write.
+*/
+static ion_status_t
+flat_file_memtable_write(
+	ion_flat_file_t				*flat_file,
+	ion_flat_file_row_status_t	row_status,
+	ion_key_t					key,
+	ion_value_t					value
+) {
+	ion_key_size_t	key_size	= flat_file->super.record.key_size;
+	size_t			row_size	= flat_file->row_size;
+	size_t			low			= 0;
+	size_t			high		= flat_file->num_in_memtable;
+	size_t			mid;
+	size_t			first;
+	ion_byte_t		*row;
+	ion_err_t		err;
+
+	/* Find the first row with a greater key */
+	while (low < high) {
+		mid = low + (high - low) / 2;
+
+		if (flat_file->super.compare(flat_file->memtable + mid * row_size + sizeof(ion_flat_file_row_status_t), key, key_size) <= 0) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	if (ION_FLAT_FILE_STATUS_TOMBSTONE == row_status) {
+		for (first = low; (first > 0) && (0 == flat_file->super.compare(flat_file->memtable + (first - 1) * row_size + sizeof(ion_flat_file_row_status_t), key, key_size)); first--) {}
+
+		memmove(flat_file->memtable + first * row_size, flat_file->memtable + low * row_size, (flat_file->num_in_memtable - low) * row_size);
+		flat_file->num_in_memtable	-= low - first;
+		low							= first;
+	}
+
+	if (flat_file->num_in_memtable == (size_t) flat_file->num_buffered) {
+		err = flat_file_memtable_flush(flat_file);
+
+		if (err_ok != err) {
+			return ION_STATUS_ERROR(err);
+		}
+
+		low = 0;
+	}
+
+	row = flat_file->memtable + low * row_size;
+	memmove(row + row_size, row, (flat_file->num_in_memtable - low) * row_size);
+
+	*((ion_flat_file_row_status_t *) row) = row_status;
+	memcpy(row + sizeof(ion_flat_file_row_status_t), key, key_size);
+
+	if (NULL != value) {
+		memcpy(row + sizeof(ion_flat_file_row_status_t) + key_size, value, flat_file->super.record.value_size);
+	}
+	else {
+		memset(row + sizeof(ion_flat_file_row_status_t) + key_size, 0, flat_file->super.record.value_size);
+	}
+
+	flat_file->num_in_memtable++;
+
+	return ION_STATUS_OK(1);
+}
+
+/**
+@brief		Finds the rows with a key that a tombstone does not hide, newest first, in the memtable
+			and then in each run.
+@param[in]	flat_file
+				Which flat file instance to search.
+@param[in]	key
+				Key to find.
+@param[out]	value
+				Where to copy the value of the newest row found, or @p NULL.
+@param[in]	count_all
+				Whether to count every row found, instead of stopping at the first.
+@param[out]	count
+				Number of rows found.
+@return		Resulting status of the search.
+*/
+static ion_err_t
+flat_file_tiered_find(
+	ion_flat_file_t		*flat_file,
+	ion_key_t			key,
+	ion_value_t			value,
+	ion_boolean_t		count_all,
+	ion_result_count_t	*count
+) {
+	ion_key_size_t		key_size	= flat_file->super.record.key_size;
+	ion_value_size_t	value_size	= flat_file->super.record.value_size;
+	ion_fpos_t			low			= 0;
+	ion_fpos_t			high		= flat_file->num_in_memtable;
+	ion_fpos_t			mid;
+	ion_fpos_t			run;
+	ion_flat_file_row_t row;
+	ion_err_t			err;
+
+	*count = 0;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+
+		if (flat_file->super.compare(flat_file->memtable + mid * flat_file->row_size + sizeof(ion_flat_file_row_status_t), key, key_size) <= 0) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	while ((low > 0) && (0 == flat_file->super.compare(flat_file->memtable + (low - 1) * flat_file->row_size + sizeof(ion_flat_file_row_status_t), key, key_size))) {
+		ion_byte_t *found = flat_file->memtable + --low * flat_file->row_size;
+
+		if (ION_FLAT_FILE_STATUS_TOMBSTONE == *found) {
+			return err_ok;
+		}
+
+		if ((0 == *count) && (NULL != value)) {
+			memcpy(value, found + sizeof(ion_flat_file_row_status_t) + key_size, value_size);
+		}
+
+		(*count)++;
+
+		if (!count_all) {
+			return err_ok;
+		}
+	}
+
+	for (run = flat_file->num_runs - 1; run >= 0; run--) {
+		ion_fpos_t start = flat_file->runs[run];
+
+		low		= start;
+		high	= flat_file_run_end(flat_file, run);
+
+		while (low < high) {
+			mid = low + (high - low) / 2;
+			err = flat_file_read_row(flat_file, mid, &row);
+
+			if (err_ok != err) {
+				return err;
+			}
+
+			if (flat_file->super.compare(row.key, key, key_size) <= 0) {
+				low = mid + 1;
+			}
+			else {
+				high = mid;
+			}
+		}
+
+		while (low > start) {
+			err = flat_file_read_row(flat_file, --low, &row);
+
+			if (err_ok != err) {
+				return err;
+			}
+
+			if (0 != flat_file->super.compare(row.key, key, key_size)) {
+				break;
+			}
+
+			if (ION_FLAT_FILE_STATUS_TOMBSTONE == row.row_status) {
+				return err_ok;
+			}
+
+			if ((0 == *count) && (NULL != value)) {
+				memcpy(value, row.value, value_size);
+			}
+
+			(*count)++;
+
+			if (!count_all) {
+				return err_ok;
+			}
+		}
+	}
+
+	return err_ok;
+}
+
 ion_err_t
 flat_file_initialize(
 	ion_flat_file_t			*flat_file,
@@ -30,7 +743,8 @@ flat_file_initialize(
 	ion_key_type_t			key_type,
 	ion_key_size_t			key_size,
 	ion_value_size_t		value_size,
-	ion_dictionary_size_t	dictionary_size
+	ion_dictionary_size_t	dictionary_size,
+	ion_boolean_t			mapped
 ) {
 	if (dictionary_size <= 0) {
 		/* Clamp the dictionary size since we always need at least 1 row to buffer */
@@ -51,26 +765,33 @@ flat_file_initialize(
 	flat_file->sorted_mode				= boolean_false;/* By default, we don't use sorted mode */
 	flat_file->num_buffered				= dictionary_size;	/* TODO: Sorted mode needs to be written out as a header? */
 	flat_file->current_loaded_region	= -1;	/* No loaded region yet */
+	flat_file->tiered_mode				= boolean_false;
+	flat_file->memtable					= NULL;
+	flat_file->num_in_memtable			= 0;
+	flat_file->runs						= NULL;
+	flat_file->num_runs					= 0;
+	flat_file->run_capacity				= 0;
 
-	flat_file->data_file				= fopen(filename, "r+b");
+	flat_file->data_file				= mapped ? ion_fopen_mapped(filename) : ion_fopen(filename);
 
-	if (NULL == flat_file->data_file) {
-		/* The file did not exist - lets open to write */
-		flat_file->data_file = fopen(filename, "w+b");
+#if defined(ARDUINO)
 
-		if (NULL == flat_file->data_file) {
-			/* Failed to open, even to create */
-			return err_file_open_error;
-		}
+	if (NULL == flat_file->data_file.file) {
+#else
+
+	if (ION_NOFILE == flat_file->data_file) {
+#endif
+		/* Failed to open, even to create */
+		return err_file_open_error;
 	}
 
 	/* For now, we don't have any header information. But we write some garbage there just so that
 	   we can verify that the code to handle the header is working.*/
-	fwrite(&(int) { 0xADDE }, sizeof(int), 1, flat_file->data_file);
-	flat_file->start_of_data = ftell(flat_file->data_file);
+	ion_fwrite(flat_file->data_file, sizeof(int), (ion_byte_t *) &(int) { 0xADDE });
+	flat_file->start_of_data = ion_ftell(flat_file->data_file);
 
 	if (-1 == flat_file->start_of_data) {
-		fclose(flat_file->data_file);
+		ion_fclose(flat_file->data_file);
 		return err_file_read_error;
 	}
 
@@ -80,29 +801,29 @@ flat_file_initialize(
 	flat_file->buffer	= calloc(flat_file->num_buffered, flat_file->row_size);
 
 	if (NULL == flat_file->buffer) {
-		fclose(flat_file->data_file);
+		ion_fclose(flat_file->data_file);
 		return err_out_of_memory;
 	}
 
-	if (0 != fseek(flat_file->data_file, 0, SEEK_END)) {
-		fclose(flat_file->data_file);
+	if (err_ok != ion_fseek(flat_file->data_file, 0, ION_FILE_END)) {
+		ion_fclose(flat_file->data_file);
 		return err_file_bad_seek;
 	}
 
-	flat_file->eof_position = ftell(flat_file->data_file);
+	flat_file->eof_position = ion_ftell(flat_file->data_file);
 
 	if (-1 == flat_file->eof_position) {
-		fclose(flat_file->data_file);
+		ion_fclose(flat_file->data_file);
 		return err_file_read_error;
 	}
 
 	/* Now move the eof to the last non-empty row in the file */
 	ion_fpos_t			loc = -1;
 	ion_flat_file_row_t row;
-	ion_err_t			err = flat_file_scan(flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_BACKWARDS, flat_file_predicate_not_empty);
+	ion_err_t			err = flat_file_scan(flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_BACKWARDS, flat_file_predicate_written);
 
 	if ((err_ok != err) && (err_file_hit_eof != err)) {
-		fclose(flat_file->data_file);
+		ion_fclose(flat_file->data_file);
 		return err;
 	}
 
@@ -114,6 +835,14 @@ flat_file_initialize(
 	/* Move to its final position as one-past the position found. */
 	flat_file->eof_position = flat_file->start_of_data + (loc + 1) * flat_file->row_size;
 
+	err						= flat_file_fence_build(flat_file);
+
+	if (err_ok != err) {
+		free(flat_file->buffer);
+		ion_fclose(flat_file->data_file);
+		return err;
+	}
+
 	return err_ok;
 }
 
@@ -135,7 +864,7 @@ flat_file_destroy(
 		return err_file_delete_error;
 	}
 
-	flat_file->data_file = NULL;
+	flat_file->data_file = ION_NOFILE;
 
 	return err_ok;
 }
@@ -173,7 +902,7 @@ flat_file_scan(
 	}
 
 	while (cur_offset != end_offset) {
-		if (0 != fseek(flat_file->data_file, cur_offset, SEEK_SET)) {
+		if (err_ok != ion_fseek(flat_file->data_file, cur_offset, ION_FILE_START)) {
 			return err_file_bad_seek;
 		}
 
@@ -188,11 +917,11 @@ flat_file_scan(
 
 			num_records_to_process = records_left > (unsigned) /* TODO HACK: remove this */ flat_file->num_buffered ? (unsigned) flat_file->num_buffered : records_left;
 
-			if (num_records_to_process != fread(flat_file->buffer, flat_file->row_size, num_records_to_process, flat_file->data_file)) {
+			if (err_ok != ion_fread(flat_file->data_file, flat_file->row_size * num_records_to_process, flat_file->buffer)) {
 				return err_file_incomplete_read;
 			}
 
-			if (-1 == (cur_offset = ftell(flat_file->data_file))) {
+			if (-1 == (cur_offset = ion_ftell(flat_file->data_file))) {
 				return err_file_read_error;
 			}
 		}
@@ -206,11 +935,11 @@ flat_file_scan(
 				cur_offset				= flat_file->start_of_data;
 			}
 
-			if (0 != fseek(flat_file->data_file, cur_offset, SEEK_SET)) {
+			if (err_ok != ion_fseek(flat_file->data_file, cur_offset, ION_FILE_START)) {
 				return err_file_bad_seek;
 			}
 
-			if (num_records_to_process != fread(flat_file->buffer, flat_file->row_size, num_records_to_process, flat_file->data_file)) {
+			if (err_ok != ion_fread(flat_file->data_file, flat_file->row_size * num_records_to_process, flat_file->buffer)) {
 				return err_file_incomplete_read;
 			}
 
@@ -314,22 +1043,26 @@ flat_file_write_row(
 	flat_file->current_loaded_region	= -1;
 	flat_file->num_in_buffer			= 0;
 
-	if (0 != fseek(flat_file->data_file, flat_file->start_of_data + location * flat_file->row_size, SEEK_SET)) {
+	if (err_ok != ion_fseek(flat_file->data_file, flat_file->start_of_data + location * flat_file->row_size, ION_FILE_START)) {
 		return err_file_bad_seek;
 	}
 
-	if (1 != fwrite(&row->row_status, sizeof(row->row_status), 1, flat_file->data_file)) {
+	if (err_ok != ion_fwrite(flat_file->data_file, sizeof(row->row_status), &row->row_status)) {
 		return err_file_incomplete_write;
 	}
 
-	if ((NULL != row->key) && (1 != fwrite(row->key, flat_file->super.record.key_size, 1, flat_file->data_file))) {
+	if ((NULL != row->key) && (err_ok != ion_fwrite(flat_file->data_file, flat_file->super.record.key_size, row->key))) {
 		return err_file_incomplete_write;
 	}
 
-	if ((NULL != row->value) && (1 != fwrite(row->value, flat_file->super.record.value_size, 1, flat_file->data_file))) {
+	if ((NULL != row->value) && (err_ok != ion_fwrite(flat_file->data_file, flat_file->super.record.value_size, row->value))) {
 		return err_file_incomplete_write;
 	}
 
+	if (NULL != row->key) {
+		flat_file_fence_set(flat_file, location, row->key);
+	}
+
 	return err_ok;
 }
 
@@ -346,22 +1079,19 @@ flat_file_read_row(
 		read_index = location - flat_file->current_loaded_region;
 	}
 	else {
-		/* Cache miss, have to re-read from file */
-		if (0 != fseek(flat_file->data_file, flat_file->start_of_data + location * flat_file->row_size, SEEK_SET)) {
-			return err_file_bad_seek;
-		}
+		/* Cache miss, have to re-read from file. The row read replaces the loaded region. */
+		flat_file->current_loaded_region = -1;
 
-		if (1 != fread(flat_file->buffer, sizeof(row->row_status), 1, flat_file->data_file)) {
-			return err_file_incomplete_write;
+		if (err_ok != ion_fseek(flat_file->data_file, flat_file->start_of_data + location * flat_file->row_size, ION_FILE_START)) {
+			return err_file_bad_seek;
 		}
 
-		if (1 != fread(flat_file->buffer + sizeof(row->row_status), flat_file->super.record.key_size, 1, flat_file->data_file)) {
+		if (err_ok != ion_fread(flat_file->data_file, flat_file->row_size, flat_file->buffer)) {
 			return err_file_incomplete_write;
 		}
 
-		if (1 != fread(flat_file->buffer + sizeof(row->row_status) + flat_file->super.record.key_size, flat_file->super.record.value_size, 1, flat_file->data_file)) {
-			return err_file_incomplete_write;
-		}
+		flat_file->current_loaded_region	= location;
+		flat_file->num_in_buffer			= 1;
 	}
 
 	row->row_status = *((ion_flat_file_row_status_t *) &flat_file->buffer[read_index * flat_file->row_size]);
@@ -383,6 +1113,10 @@ flat_file_insert(
 	   in sorted mode, we don't allow deletes - so there are no holes to fill. */
 	ion_fpos_t insert_loc	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
 
+	if (flat_file->tiered_mode) {
+		return flat_file_memtable_write(flat_file, ION_FLAT_FILE_STATUS_OCCUPIED, key, value);
+	}
+
 	if (flat_file->sorted_mode) {
 		ion_fpos_t			last_record_loc = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size - 1;
 		ion_flat_file_row_t row;
@@ -410,7 +1144,7 @@ flat_file_insert(
 	}
 
 	/* Record new eof position */
-	flat_file->eof_position = ftell(flat_file->data_file);
+	flat_file->eof_position = ion_ftell(flat_file->data_file);
 
 	if (-1 == flat_file->eof_position) {
 		status.error = err_file_read_error;
@@ -422,6 +1156,101 @@ flat_file_insert(
 	return status;
 }
 
+ion_status_t
+flat_file_insert_batch(
+	ion_flat_file_t *flat_file,
+	ion_key_t		keys,
+	ion_value_t		values,
+	ion_status_t	*statuses,
+	int				num_records
+) {
+	ion_key_size_t		key_size	= flat_file->super.record.key_size;
+	ion_value_size_t	value_size	= flat_file->super.record.value_size;
+	ion_fpos_t			write_loc	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_byte_t			*last_key	= NULL;
+	size_t				num_rows	= 0;
+	int					first		= 0;
+	ion_err_t			err			= err_ok;
+	int					i;
+
+	if (flat_file->tiered_mode) {
+		for (i = 0; i < num_records; i++) {
+			statuses[i] = flat_file_memtable_write(flat_file, ION_FLAT_FILE_STATUS_OCCUPIED, (ion_byte_t *) keys + i * key_size, (ion_byte_t *) values + i * value_size);
+		}
+
+		return dictionary_batch_status(statuses, num_records);
+	}
+
+	if (flat_file->sorted_mode && (write_loc > 0)) {
+		ion_flat_file_row_t row;
+
+		err = flat_file_read_row(flat_file, write_loc - 1, &row);
+
+		if (err_ok != err) {
+			return ION_STATUS_ERROR(err);
+		}
+
+		/* This points into the region buffer, but is replaced before the first row is gathered there. */
+		last_key = row.key;
+	}
+
+	/* Rows are gathered in the region buffer, so it no longer caches anything. */
+	flat_file->current_loaded_region	= -1;
+	flat_file->num_in_buffer			= 0;
+
+	for (i = 0; (err_ok == err) && (i < num_records); i++) {
+		ion_byte_t	*key	= (ion_byte_t *) keys + i * key_size;
+		ion_byte_t	*row	= flat_file->buffer + num_rows * flat_file->row_size;
+
+		if ((NULL != last_key) && (flat_file->super.compare(key, last_key, key_size) < 0)) {
+			statuses[i] = ION_STATUS_ERROR(err_sorted_order_violation);
+			continue;
+		}
+
+		if (flat_file->sorted_mode) {
+			last_key = key;
+		}
+
+		*((ion_flat_file_row_status_t *) row) = ION_FLAT_FILE_STATUS_OCCUPIED;
+		memcpy(row + sizeof(ion_flat_file_row_status_t), key, key_size);
+		memcpy(row + sizeof(ion_flat_file_row_status_t) + key_size, (ion_byte_t *) values + i * value_size, value_size);
+
+		statuses[i] = ION_STATUS_OK(1);
+		num_rows++;
+
+		if (num_rows == flat_file->num_buffered) {
+			err = flat_file_write_buffer(flat_file, write_loc, num_rows);
+
+			if (err_ok == err) {
+				write_loc	+= num_rows;
+				num_rows	= 0;
+				first		= i + 1;
+			}
+		}
+	}
+
+	if ((err_ok == err) && (num_rows > 0)) {
+		err = flat_file_write_buffer(flat_file, write_loc, num_rows);
+
+		if (err_ok == err) {
+			write_loc	+= num_rows;
+			first		= num_records;
+		}
+	}
+
+	/* Record new eof position */
+	flat_file->eof_position = flat_file->start_of_data + write_loc * flat_file->row_size;
+
+	if (err_ok != err) {
+		/* Nothing from the failed write onwards made it to the file. */
+		for (i = first; i < num_records; i++) {
+			statuses[i] = ION_STATUS_ERROR(err);
+		}
+	}
+
+	return dictionary_batch_status(statuses, num_records);
+}
+
 ion_status_t
 flat_file_get(
 	ion_flat_file_t *flat_file,
@@ -433,6 +1262,16 @@ flat_file_get(
 	ion_fpos_t			found_loc	= -1;
 	ion_flat_file_row_t row;
 
+	if (flat_file->tiered_mode) {
+		status.error = flat_file_tiered_find(flat_file, key, value, boolean_false, &status.count);
+
+		if ((err_ok == status.error) && (0 == status.count)) {
+			status.error = err_item_not_found;
+		}
+
+		return status;
+	}
+
 	if (!flat_file->sorted_mode) {
 		err = flat_file_scan(flat_file, -1, &found_loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, flat_file_predicate_key_match, key);
 
@@ -478,11 +1317,152 @@ flat_file_get(
 	return status;
 }
 
+/**
+@brief		The keys still being looked for by @ref flat_file_multi_get.
+*/
+typedef struct {
+	/**> Keys to look for, packed back to back. */
+	ion_byte_t		*keys;
+	/**> Where to write the value found for each key. */
+	ion_byte_t		*values;
+	/**> Status of each key, @ref err_item_not_found until it is found. */
+	ion_status_t	*statuses;
+	/**> Positions of the keys, in ascending key order. */
+	int				*order;
+	/**> Number of keys. */
+	int				num_keys;
+	/**> Number of keys not found yet. */
+	int				remaining;
+} ion_flat_file_multi_get_t;
+
+/**
+@brief		Predicate that hands each row to every key of a batch it matches.
+@details	We expect one @ref ion_flat_file_multi_get_t to be in @p args. The
+			predicate is satisfied, ending the scan, once every key is found.
+@see		ion_flat_file_predicate_t
+*/
+static ion_boolean_t
+flat_file_predicate_multi_get(
+	ion_flat_file_t		*flat_file,
+	ion_flat_file_row_t *row,
+	va_list				*args
+) {
+	ion_flat_file_multi_get_t	*batch		= va_arg(*args, ion_flat_file_multi_get_t *);
+	ion_key_size_t				key_size	= flat_file->super.record.key_size;
+	ion_value_size_t			value_size	= flat_file->super.record.value_size;
+	int							low			= 0;
+	int							high		= batch->num_keys;
+
+	if (ION_FLAT_FILE_STATUS_OCCUPIED != row->row_status) {
+		return boolean_false;
+	}
+
+	/* Find the first key in the batch that is not less than the row's key */
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+
+		if (flat_file->super.compare(batch->keys + batch->order[mid] * key_size, row->key, key_size) < 0) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	for (; (low < batch->num_keys) && (0 == flat_file->super.compare(batch->keys + batch->order[low] * key_size, row->key, key_size)); low++) {
+		int i = batch->order[low];
+
+		if (err_ok != batch->statuses[i].error) {
+			memcpy(batch->values + i * value_size, row->value, value_size);
+			batch->statuses[i] = ION_STATUS_OK(1);
+			batch->remaining--;
+		}
+	}
+
+	return 0 == batch->remaining;
+}
+
+ion_status_t
+flat_file_multi_get(
+	ion_flat_file_t *flat_file,
+	ion_key_t		keys,
+	ion_value_t		values,
+	ion_status_t	*statuses,
+	int				num_keys
+) {
+	ion_flat_file_multi_get_t	batch;
+	ion_flat_file_row_t			row;
+	ion_fpos_t					found_loc;
+	ion_err_t					err;
+	int							i;
+
+	if (flat_file->sorted_mode || flat_file->tiered_mode) {
+		for (i = 0; i < num_keys; i++) {
+			statuses[i] = flat_file_get(flat_file, (ion_byte_t *) keys + i * flat_file->super.record.key_size, (ion_byte_t *) values + i * flat_file->super.record.value_size);
+		}
+
+		return dictionary_batch_status(statuses, num_keys);
+	}
+
+	batch.order = malloc(num_keys * sizeof(int));
+
+	if (NULL == batch.order) {
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	err = dictionary_sort_keys(&flat_file->super, keys, num_keys, batch.order);
+
+	if (err_ok != err) {
+		free(batch.order);
+		return ION_STATUS_ERROR(err);
+	}
+
+	for (i = 0; i < num_keys; i++) {
+		statuses[i] = ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	batch.keys		= keys;
+	batch.values	= values;
+	batch.statuses	= statuses;
+	batch.num_keys	= num_keys;
+	batch.remaining = num_keys;
+
+	if (num_keys > 0) {
+		err = flat_file_scan(flat_file, -1, &found_loc, &row, ION_FLAT_FILE_SCAN_FORWARDS, flat_file_predicate_multi_get, &batch);
+	}
+
+	free(batch.order);
+
+	if ((err_ok != err) && (err_file_hit_eof != err)) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	return dictionary_batch_status(statuses, num_keys);
+}
+
 ion_status_t
 flat_file_delete(
 	ion_flat_file_t *flat_file,
 	ion_key_t		key
 ) {
+	if (flat_file->tiered_mode) {
+		ion_status_t status = ION_STATUS_INITIALIZE;
+
+		status.error = flat_file_tiered_find(flat_file, key, NULL, boolean_true, &status.count);
+
+		if (err_ok != status.error) {
+			return status;
+		}
+
+		if (0 == status.count) {
+			status.error = err_item_not_found;
+			return status;
+		}
+
+		status.error = flat_file_memtable_write(flat_file, ION_FLAT_FILE_STATUS_TOMBSTONE, key, NULL).error;
+		return status;
+	}
+
 	if (flat_file->sorted_mode) {
 		return ION_STATUS_ERROR(err_sorted_order_violation);
 	}
@@ -525,6 +1505,7 @@ flat_file_delete(
 
 		/* Soft truncate the file by bumping the eof position back to cut off the last record. */
 		flat_file->eof_position = last_record_offset;
+		flat_file_fence_truncate(flat_file);
 		status.count++;
 
 		/* No location movement is done here, since we need to check the row we just swapped in to see if it is
@@ -555,6 +1536,27 @@ flat_file_update(
 	ion_flat_file_row_t row;
 	ion_err_t			err;
 
+	if (flat_file->tiered_mode) {
+		ion_result_count_t i;
+
+		status.error = flat_file_tiered_find(flat_file, key, NULL, boolean_true, &status.count);
+
+		if ((err_ok == status.error) && (status.count > 0)) {
+			status.error = flat_file_memtable_write(flat_file, ION_FLAT_FILE_STATUS_TOMBSTONE, key, NULL).error;
+		}
+		else if (err_ok == status.error) {
+			/* Nothing to update, so this is an upsert */
+			status.count = 1;
+		}
+
+		/* The key keeps as many rows as it had, all with the new value */
+		for (i = 0; (err_ok == status.error) && (i < status.count); i++) {
+			status.error = flat_file_memtable_write(flat_file, ION_FLAT_FILE_STATUS_OCCUPIED, key, value).error;
+		}
+
+		return status;
+	}
+
 	if (flat_file->sorted_mode) {
 		err = flat_file_binary_search(flat_file, key, &loc);
 
@@ -607,18 +1609,222 @@ flat_file_update(
 	return status;
 }
 
+ion_err_t
+flat_file_flush(
+	ion_flat_file_t *flat_file,
+	ion_boolean_t	sync
+) {
+	if (sync && flat_file->tiered_mode) {
+		ion_err_t err = flat_file_memtable_flush(flat_file);
+
+		if (err_ok != err) {
+			return err;
+		}
+	}
+
+	return sync ? ion_fsync(flat_file->data_file) : ion_fflush(flat_file->data_file);
+}
+
+ion_err_t
+flat_file_enable_tiered_mode(
+	ion_flat_file_t *flat_file
+) {
+	ion_key_size_t	key_size	= flat_file->super.record.key_size;
+	ion_fpos_t		num_rows	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_byte_t		*last_key	= alloca(key_size);
+	ion_boolean_t	tombstones	= boolean_false;
+	ion_err_t		err			= err_ok;
+	ion_fpos_t		loc;
+	size_t			i;
+
+	if (flat_file->tiered_mode) {
+		return err_ok;
+	}
+
+	if (flat_file->sorted_mode) {
+		return err_illegal_state;
+	}
+
+	flat_file->memtable			= malloc(flat_file->num_buffered * flat_file->row_size);
+	flat_file->runs				= malloc(ION_FLAT_FILE_TIER_FANOUT * sizeof(ion_fpos_t));
+	flat_file->num_in_memtable	= 0;
+	flat_file->num_runs			= 0;
+	flat_file->run_capacity		= ION_FLAT_FILE_TIER_FANOUT;
+
+	if ((NULL == flat_file->memtable) || (NULL == flat_file->runs)) {
+		err = err_out_of_memory;
+	}
+
+	/* A run starts wherever the keys stop ascending. Runs that happen to follow one another in
+	   order are found as one, which holds the same rows in the same age order. */
+	for (loc = 0; (err_ok == err) && (loc < num_rows); loc += flat_file->num_in_buffer) {
+		err = flat_file_load_block(flat_file, loc);
+
+		for (i = 0; (err_ok == err) && (i < flat_file->num_in_buffer); i++) {
+			ion_byte_t *row = flat_file->buffer + i * flat_file->row_size;
+
+			if ((0 == loc + (ion_fpos_t) i) || (flat_file->super.compare(row + sizeof(ion_flat_file_row_status_t), last_key, key_size) < 0)) {
+				err = flat_file_run_add(flat_file, loc + i);
+			}
+
+			tombstones = tombstones || ION_FLAT_FILE_STATUS_TOMBSTONE == *row;
+			memcpy(last_key, row + sizeof(ion_flat_file_row_status_t), key_size);
+		}
+	}
+
+	if (err_ok != err) {
+		free(flat_file->memtable);
+		free(flat_file->runs);
+		flat_file->memtable = NULL;
+		flat_file->runs		= NULL;
+		return err;
+	}
+
+	flat_file->tiered_mode = boolean_true;
+
+	/* A run found this way may hold rows that a tombstone after them in it hides. Scans would
+	   find those, so they are dropped now. */
+	if (tombstones) {
+		return flat_file_merge_runs(flat_file, 0);
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+flat_file_compact(
+	ion_flat_file_t *flat_file
+) {
+	ion_err_t err;
+
+	if (!flat_file->tiered_mode) {
+		return err_ok;
+	}
+
+	err = flat_file_memtable_flush(flat_file);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	/* A lone run has no older rows for its tombstones to hide */
+	if (flat_file->num_runs <= 1) {
+		return err_ok;
+	}
+
+	return flat_file_merge_runs(flat_file, 0);
+}
+
 ion_err_t
 flat_file_close(
 	ion_flat_file_t *flat_file
 ) {
-	free(flat_file->buffer);
-	flat_file->buffer = NULL;
+	ion_err_t err = err_ok;
+
+	if (flat_file->tiered_mode) {
+		err = flat_file_memtable_flush(flat_file);
+	}
 
-	if (0 != fclose(flat_file->data_file)) {
+	free(flat_file->buffer);
+	flat_file->buffer	= NULL;
+	free(flat_file->fences);
+	flat_file->fences	= NULL;
+	free(flat_file->memtable);
+	flat_file->memtable = NULL;
+	free(flat_file->runs);
+	flat_file->runs		= NULL;
+
+	if (err_ok != ion_fclose(flat_file->data_file)) {
 		return err_file_close_error;
 	}
 
-	return err_ok;
+	return err;
+}
+
+/**
+@brief		Finds the same location as @ref flat_file_binary_search does, using
+			the fence index to read only the block the key can be in.
+@details	The fences pick the block holding the first row whose key is not
+			less than @p target_key, which is searched in the region buffer.
+			Should every key in that block be less, the row is the first of
+			the next block, whose key is the next fence.
+@param[in]	flat_file
+				Which flat file instance to search.
+@param[in]	target_key
+				Key to find.
+@param[in]	num_rows
+				Number of rows in the data file, which is more than zero.
+@param[out]	location
+				Where the key was found, as for @ref flat_file_binary_search.
+@return		Resulting status of the search.
+*/
+static ion_err_t
+flat_file_fence_search(
+	ion_flat_file_t *flat_file,
+	ion_key_t		target_key,
+	ion_fpos_t		num_rows,
+	ion_fpos_t		*location
+) {
+	ion_key_size_t	key_size	= flat_file->super.record.key_size;
+	ion_fpos_t		low_idx		= 0;
+	ion_fpos_t		high_idx	= flat_file->num_fences;
+	ion_fpos_t		mid_idx;
+	ion_fpos_t		block;
+	ion_byte_t		*key;
+	ion_err_t		err;
+
+	/* Find the first block that starts at or after the target */
+	while (low_idx < high_idx) {
+		mid_idx = low_idx + (high_idx - low_idx) / 2;
+
+		if (flat_file->super.compare(flat_file->fences + mid_idx * key_size, target_key, key_size) < 0) {
+			low_idx = mid_idx + 1;
+		}
+		else {
+			high_idx = mid_idx;
+		}
+	}
+
+	/* Duplicates of the target may end the block before it */
+	block	= low_idx > 0 ? low_idx - 1 : 0;
+	err		= flat_file_load_block(flat_file, block * flat_file->num_buffered);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	low_idx		= 0;
+	high_idx	= flat_file->num_in_buffer;
+
+	while (low_idx < high_idx) {
+		mid_idx = low_idx + (high_idx - low_idx) / 2;
+
+		if (flat_file->super.compare(flat_file->buffer + mid_idx * flat_file->row_size + sizeof(ion_flat_file_row_status_t), target_key, key_size) < 0) {
+			low_idx = mid_idx + 1;
+		}
+		else {
+			high_idx = mid_idx;
+		}
+	}
+
+	*location = flat_file->current_loaded_region + low_idx;
+
+	if (*location < num_rows) {
+		if ((size_t) low_idx < flat_file->num_in_buffer) {
+			key = flat_file->buffer + low_idx * flat_file->row_size + sizeof(ion_flat_file_row_status_t);
+		}
+		else {
+			key = flat_file->fences + (block + 1) * key_size;
+		}
+
+		if (0 == flat_file->super.compare(key, target_key, key_size)) {
+			return err_ok;
+		}
+	}
+
+	/* Not found, so give the last row less than the target */
+	(*location)--;
+	return *location >= 0 ? err_ok : err_item_not_found;
 }
 
 ion_err_t
@@ -643,6 +1849,10 @@ flat_file_binary_search(
 		return err_item_not_found;
 	}
 
+	if (NULL != flat_file->fences) {
+		return flat_file_fence_search(flat_file, target_key, high_idx + 1, location);
+	}
+
 	while (low_idx < high_idx) {
 		mid_idx = low_idx + (high_idx - low_idx) / 2;
 		err		= flat_file_read_row(flat_file, mid_idx, &row);
@@ -52,6 +52,9 @@ extern "C" {
 @param[in]	dictionary_size
 				Dictionary size is interpreted as how many records (key value pairs) are buffered. This should be given
 				as somewhere between 1 (minimum) and the page size of the device you are working on.
+@param[in]	mapped
+				Whether to access the data file through a memory mapping (see @ref ion_fopen_mapped)
+				instead of a stdio stream. Scans then copy rows out of memory without any system calls.
 @return		The status of initialization.
 @see		ffdict_create_dictionary
 */
@@ -62,7 +65,8 @@ flat_file_initialize(
 	ion_key_type_t			key_type,
 	ion_key_size_t			key_size,
 	ion_value_size_t		value_size,
-	ion_dictionary_size_t	dictionary_size
+	ion_dictionary_size_t	dictionary_size,
+	ion_boolean_t			mapped
 );
 
 /**
@@ -95,6 +99,36 @@ flat_file_insert(
 	ion_value_t		value
 );
 
+/**
+@brief		Inserts a batch of records into the flat file store.
+@details	The records are appended in batch order. They are gathered
+			into the region buffer and written out @p num_buffered rows at
+			a time, instead of with one write per record. In sorted mode, a
+			record whose key is less than the key before it is refused with
+			@ref err_sorted_order_violation, as @ref flat_file_insert would
+			refuse it.
+@param[in]	flat_file
+				Which flat file to insert into.
+@param[in]	keys
+				@p num_records keys, packed back to back.
+@param[in]	values
+				@p num_records values, packed back to back.
+@param[out]	statuses
+				The status of each record's insertion.
+@param[in]	num_records
+				How many records to insert.
+@return		Resulting status of the operation.
+@see		ffdict_insert_batch
+*/
+ion_status_t
+flat_file_insert_batch(
+	ion_flat_file_t *flat_file,
+	ion_key_t		keys,
+	ion_value_t		values,
+	ion_status_t	*statuses,
+	int				num_records
+);
+
 /**
 @brief		Fetches the record stored with the given @p key.
 @param[in]	flat_file
@@ -114,6 +148,35 @@ flat_file_get(
 	ion_value_t		value
 );
 
+/**
+@brief		Fetches the records stored with each of the given keys.
+@details	In sorted mode each key is found by binary search. Otherwise
+			the keys are sorted and the file is scanned once, stopping as
+			soon as every key has been found, instead of once per key. As
+			with @ref flat_file_get, the record found for a key is the
+			first one in the file.
+@param[in]	flat_file
+				Which flat file to look in.
+@param[in]	keys
+				@p num_keys keys to look for, packed back to back.
+@param[out]	values
+				Room for @p num_keys values, packed back to back.
+@param[out]	statuses
+				The status of each key's lookup.
+@param[in]	num_keys
+				How many keys to look for.
+@return		Resulting status of the operation.
+@see		ffdict_multi_get
+*/
+ion_status_t
+flat_file_multi_get(
+	ion_flat_file_t *flat_file,
+	ion_key_t		keys,
+	ion_value_t		values,
+	ion_status_t	*statuses,
+	int				num_keys
+);
+
 /**
 @brief		Deletes all records stored with the given @p key.
 @param[in]	flat_file
@@ -148,6 +211,53 @@ flat_file_update(
 	ion_value_t		value
 );
 
+/**
+@brief		Writes out what is buffered for the flat file.
+@details	In tiered mode, a synchronizing flush also writes the memtable out as a run.
+@param		flat_file
+				Which flat file to flush.
+@param		sync
+				Whether to also wait until the file is on the storage device.
+@return		Status of the flush.
+*/
+ion_err_t
+flat_file_flush(
+	ion_flat_file_t *flat_file,
+	ion_boolean_t	sync
+);
+
+/**
+@brief		Turns on tiered mode, for keys that are written in any order.
+@details	Writes go to a sorted buffer in memory, which is appended to the data file as a sorted
+			run once it is full. A delete writes a tombstone that hides the older rows with its key.
+			When the newest @ref ION_FLAT_FILE_TIER_FANOUT runs are of about the same size, they are
+			merged into one. A get searches the buffer and then each run, from newest to oldest, with
+			a binary search. Tiered mode cannot be combined with sorted mode. It is not recorded in
+			the data file, so it must be turned on each time the flat file is opened. The runs
+			already in the file are found then.
+@param[in]	flat_file
+				Which flat file instance to change.
+@return		Status of turning on tiered mode.
+*/
+ion_err_t
+flat_file_enable_tiered_mode(
+	ion_flat_file_t *flat_file
+);
+
+/**
+@brief		Merges the runs of a flat file in tiered mode into one, dropping the tombstones and the
+			rows they hide.
+@details	This is done before a cursor is opened on the flat file, since scans read the data file
+			as one run. This does nothing for a flat file that is not in tiered mode.
+@param[in]	flat_file
+				Which flat file instance to compact.
+@return		Status of the compaction.
+*/
+ion_err_t
+flat_file_compact(
+	ion_flat_file_t *flat_file
+);
+
 /**
 @brief		Closes and frees any memory associated with the flat file.
 @param		flat_file
@@ -278,6 +388,8 @@ flat_file_read_row(
 			the returned index points to the first key in a contiguous block of duplicate keys. If
 			no key in the flat file satisfies the condition of being less-than-or-equal, then @p -1
 			is written back to @p location. This function will only return records that are not deleted.
+			When the fence index is available, only the block of rows the key can be in is read,
+			in one read into the region buffer.
 @param[in]		flat_file
 				Which flat file instance to search within.
 @param[in]		target_key
@@ -156,6 +156,21 @@ ffdict_open_dictionary(
 	return ffdict_create_dictionary(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, compare, handler, dictionary);
 }
 
+/**
+@brief		Re-instances a previously created flat file store instance,
+			accessing its file through a memory mapping.
+@see		ffdict_open_dictionary
+*/
+ion_err_t
+ffdict_open_mapped_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	return ffdict_create_mapped_dictionary(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, compare, handler, dictionary);
+}
+
 /**
 @brief		Closes this flat file store and persists everything to disk
 			to be brought back later using @ref dictionary_open.
@@ -179,6 +194,22 @@ ffdict_close_dictionary(
 	return err_ok;
 }
 
+/**
+@brief		Writes out what is buffered for this flat file store.
+@param[in]	dictionary
+				Which instance of a flat file store to flush.
+@param[in]	sync
+				Whether to also wait until it is on the storage device.
+@return		The resuling status of the operation.
+*/
+ion_err_t
+ffdict_flush_dictionary(
+	ion_dictionary_t	*dictionary,
+	ion_boolean_t		sync
+) {
+	return flat_file_flush((ion_flat_file_t *) dictionary->instance, sync);
+}
+
 /**
 @brief			Initializes a cursor query and returns an allocated cursor object.
 @details		Given a @p predicate that was previously initialized by @ref dictionary_build_predicate,
@@ -200,9 +231,15 @@ ffdict_find(
 	ion_predicate_t		*predicate,
 	ion_dict_cursor_t	**cursor
 ) {
-	*cursor = malloc(sizeof(ion_flat_file_cursor_t));
+	ion_flat_file_t *flat_file	= (ion_flat_file_t *) dictionary->instance;
+	/* Cursors scan the data file, which in tiered mode must first be merged into one run */
+	ion_err_t		err			= flat_file_compact(flat_file);
 
-	ion_flat_file_t *flat_file = (ion_flat_file_t *) dictionary->instance;
+	if (err_ok != err) {
+		return err;
+	}
+
+	*cursor = malloc(sizeof(ion_flat_file_cursor_t));
 
 	if (NULL == *cursor) {
 		return err_out_of_memory;
@@ -363,7 +400,20 @@ ffdict_init(
 	handler->remove				= ffdict_delete;
 	handler->delete_dictionary	= ffdict_delete_dictionary;
 	handler->open_dictionary	= ffdict_open_dictionary;
+	handler->concurrency		= ion_concurrency_serial;
 	handler->close_dictionary	= ffdict_close_dictionary;
+	handler->multi_get			= ffdict_multi_get;
+	handler->insert_batch		= ffdict_insert_batch;
+	handler->flush_dictionary	= ffdict_flush_dictionary;
+}
+
+void
+ffdict_mapped_init(
+	ion_dictionary_handler_t *handler
+) {
+	ffdict_init(handler);
+	handler->create_dictionary	= ffdict_create_mapped_dictionary;
+	handler->open_dictionary	= ffdict_open_mapped_dictionary;
 }
 
 ion_status_t
@@ -375,6 +425,17 @@ ffdict_insert(
 	return flat_file_insert((ion_flat_file_t *) dictionary->instance, key, value);
 }
 
+ion_status_t
+ffdict_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_records
+) {
+	return flat_file_insert_batch((ion_flat_file_t *) dictionary->instance, keys, values, statuses, num_records);
+}
+
 ion_status_t
 ffdict_get(
 	ion_dictionary_t	*dictionary,
@@ -384,8 +445,24 @@ ffdict_get(
 	return flat_file_get((ion_flat_file_t *) dictionary->instance, key, value);
 }
 
-ion_err_t
-ffdict_create_dictionary(
+ion_status_t
+ffdict_multi_get(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_keys
+) {
+	return flat_file_multi_get((ion_flat_file_t *) dictionary->instance, keys, values, statuses, num_keys);
+}
+
+/**
+@brief		Creates a flat file store, accessing its file through a stdio
+			stream or through a memory mapping as @p mapped says.
+@see		ffdict_create_dictionary
+*/
+static ion_err_t
+ffdict_create(
 	ion_dictionary_id_t			id,
 	ion_key_type_t				key_type,
 	ion_key_size_t				key_size,
@@ -393,7 +470,8 @@ ffdict_create_dictionary(
 	ion_dictionary_size_t		dictionary_size,
 	ion_dictionary_compare_t	compare,
 	ion_dictionary_handler_t	*handler,
-	ion_dictionary_t			*dictionary
+	ion_dictionary_t			*dictionary,
+	ion_boolean_t				mapped
 ) {
 	dictionary->instance = malloc(sizeof(ion_flat_file_t));
 
@@ -403,7 +481,7 @@ ffdict_create_dictionary(
 
 	dictionary->instance->compare = compare;
 
-	ion_err_t result = flat_file_initialize((ion_flat_file_t *) dictionary->instance, id, key_type, key_size, value_size, dictionary_size);
+	ion_err_t result = flat_file_initialize((ion_flat_file_t *) dictionary->instance, id, key_type, key_size, value_size, dictionary_size, mapped);
 
 	if (err_ok == result) {
 		dictionary->handler = handler;
@@ -412,6 +490,34 @@ ffdict_create_dictionary(
 	return result;
 }
 
+ion_err_t
+ffdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	return ffdict_create(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary, boolean_false);
+}
+
+ion_err_t
+ffdict_create_mapped_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	return ffdict_create(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary, boolean_true);
+}
+
 ion_status_t
 ffdict_delete(
 	ion_dictionary_t	*dictionary,
@@ -46,6 +46,22 @@ ffdict_init(
 	ion_dictionary_handler_t *handler
 );
 
+/**
+@brief		Given the @p handler instance, bind the flat file functions so
+			that dictionaries created or opened with it access their file
+			through a memory mapping instead of a stdio stream.
+@details	The file format is the same either way, so a dictionary may be
+			opened with either handler regardless of which created it.
+@param[in]	handler
+				The handler is assumed to be memory that is allocated and initialized
+				by the user.
+@see		ion_fopen_mapped
+*/
+void
+ffdict_mapped_init(
+	ion_dictionary_handler_t *handler
+);
+
 /**
 @brief		Given a record ( @p key, @p value ), insert it into the dictionary.
 @param[in]	dictionary
@@ -63,6 +79,31 @@ ffdict_insert(
 	ion_value_t			value
 );
 
+/**
+@brief		Inserts each record of a batch into the dictionary.
+@details	The rows are written out a region buffer at a time.
+@param[in]	dictionary
+				The initialized dictionary instance we want to insert into.
+@param[in]	keys
+				@p num_records keys, packed back to back.
+@param[in]	values
+				@p num_records values, packed back to back.
+@param[out]	statuses
+				The status of each record's insertion.
+@param[in]	num_records
+				How many records to insert.
+@return		The resulting status of the operation.
+@see		dictionary_insert_batch
+*/
+ion_status_t
+ffdict_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_records
+);
+
 /**
 @brief		Performs a "get" operation on the dictionary to retrieve a single record.
 @details	Given a @p key, returns the associated value stored under
@@ -86,6 +127,33 @@ ffdict_get(
 	ion_value_t			value
 );
 
+/**
+@brief		Performs a "get" operation for each of a batch of keys.
+@details	The file is scanned once for the whole batch.
+@param[in]	dictionary
+				Which dictionary to perform the operation on.
+@param[in]	keys
+				@p num_keys search keys, packed back to back.
+@param[out]	values
+				The output location for the values, packed back to back. This
+				space must be allocated by the user to at least @p num_keys
+				times @p value_size bytes.
+@param[out]	statuses
+				The status of each key's lookup.
+@param[in]	num_keys
+				How many keys to look up.
+@return		The resulting status of the operation.
+@see		dictionary_multi_get
+*/
+ion_status_t
+ffdict_multi_get(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_keys
+);
+
 /**
 @brief		Creates an instance of a flat file backed dictionary.
 @param[in]	id
@@ -122,6 +190,24 @@ ffdict_create_dictionary(
 	ion_dictionary_t			*dictionary
 );
 
+/**
+@brief		Creates a flat file store whose file is accessed through a
+			memory mapping.
+@details	Takes the same parameters as @ref ffdict_create_dictionary.
+@return		The resulting status of the operation.
+*/
+ion_err_t
+ffdict_create_mapped_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
 /**
 @brief		Removes all instances of any record with key equal to @p key.
 @param[in]	dictionary
@@ -30,6 +30,7 @@ extern "C" {
 
 #include "../dictionary.h"
 #include "../../file/SD_stdio_c_iface.h"
+#include "../../file/ion_file.h"
 
 /**
 @brief		This type describes the status flag within a flat file row.
@@ -44,6 +45,11 @@ typedef ion_byte_t ion_flat_file_row_status_t;
 @brief		Signifies that this row in the flat file is currently empty and is okay to be overwritten.
 */
 #define ION_FLAT_FILE_STATUS_EMPTY		0
+/**
+@brief		Signifies that this row deletes the rows with its key that are older than it. Only written in
+			tiered mode.
+*/
+#define ION_FLAT_FILE_STATUS_TOMBSTONE	2
 
 /**
 @brief		Signals to @ref flat_file_scan to scan in a forward direction.
@@ -54,6 +60,13 @@ typedef ion_byte_t ion_flat_file_row_status_t;
 */
 #define ION_FLAT_FILE_SCAN_BACKWARDS	0
 
+/**
+@brief		In tiered mode, how many runs of about the same size are merged into one.
+*/
+#if !defined(ION_FLAT_FILE_TIER_FANOUT)
+#define ION_FLAT_FILE_TIER_FANOUT		4
+#endif
+
 /**
 @brief		Metadata container that holds flat file specific information.
 */
@@ -75,7 +88,7 @@ typedef struct {
 		 for many purposes throughout the flat file. */
 	ion_byte_t				*buffer;
 	/**> The file descriptor of the file this flat file instance operates on. */
-	FILE					*data_file;
+	ion_file_handle_t		data_file;
 	/**> This value expresses the size of one row inside the @p data_file. A row is defined
 		 as a record + metadata. Change this if @ref ion_flat_file_row_t changes!*/
 	size_t					row_size;
@@ -86,6 +99,28 @@ typedef struct {
 	ion_fpos_t	current_loaded_region;
 	/**> Expresses how many valid records are currently in the buffer. */
 	size_t		num_in_buffer;
+	/**> The fence index: the key of the first row of every block of @p num_buffered rows, back to back.
+		 In sorted mode, this finds the one block a key can be in without reading the file. This is
+		 @p NULL if it could not be allocated, and lookups then read a row per probe instead. */
+	ion_byte_t	*fences;
+	/**> Number of blocks, and so of keys in @p fences. */
+	ion_fpos_t	num_fences;
+	/**> Number of keys @p fences has room for. */
+	ion_fpos_t	fence_capacity;
+	/**> Flag for tiered mode, which is turned on with @ref flat_file_enable_tiered_mode. */
+	ion_boolean_t	tiered_mode;
+	/**> In tiered mode, the rows written since the last run was flushed, sorted by key. Rows with
+		 equal keys are kept oldest first. This holds up to @p num_buffered rows. */
+	ion_byte_t		*memtable;
+	/**> Number of rows in @p memtable. */
+	size_t			num_in_memtable;
+	/**> In tiered mode, the row index each sorted run starts at, oldest first. The runs fill the
+		 data file back to back. */
+	ion_fpos_t		*runs;
+	/**> Number of runs. */
+	ion_fpos_t		num_runs;
+	/**> Number of runs @p runs has room for. */
+	ion_fpos_t		run_capacity;
 } ion_flat_file_t;
 
 /**
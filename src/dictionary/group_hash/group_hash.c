@@ -0,0 +1,506 @@
+/******************************************************************************/
+/**
+@file
+@brief		An in memory hash table that probes groups of control bytes.
+@details	The table is split into groups of @ref ION_GH_GROUP_SIZE slots.
+			A key's hash picks its first group and a seven bit tag. Probing
+			compares the tag against the control bytes of a whole group at
+			once, with SSE2 or NEON where available, and only compares keys
+			for the slots whose tag matches. A probe ends at the first group
+			with an empty slot. The number of slots is a power of two, so
+			groups are picked by masking rather than by division.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#include "group_hash.h"
+
+/* Define ION_GH_NO_SIMD to use the portable group scan everywhere */
+#if !defined(ION_GH_NO_SIMD) && defined(__SSE2__)
+#define ION_GH_SSE2
+#include <emmintrin.h>
+#elif !defined(ION_GH_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#define ION_GH_NEON
+#include <arm_neon.h>
+#endif
+
+typedef uint32_t ion_gh_mask_t;	/**< One bit per slot of a group */
+
+/**
+@brief		Returns a mask of the slots in @p group whose control byte is
+			@p byte.
+*/
+static ion_gh_mask_t
+gh_match(
+	ion_byte_t	*group,
+	ion_byte_t	byte
+) {
+#if defined(ION_GH_SSE2)
+
+	__m128i control = _mm_loadu_si128((__m128i *) group);
+
+	return (ion_gh_mask_t) _mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8((char) byte)));
+#elif defined(ION_GH_NEON)
+
+	static const uint8_t	bits[ION_GH_GROUP_SIZE] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	uint8x16_t				matches					= vandq_u8(vceqq_u8(vld1q_u8(group), vdupq_n_u8(byte)), vld1q_u8(bits));
+
+	return (ion_gh_mask_t) vaddv_u8(vget_low_u8(matches)) | ((ion_gh_mask_t) vaddv_u8(vget_high_u8(matches)) << 8);
+#else
+
+	ion_gh_mask_t	mask = 0;
+	int				i;
+
+	for (i = 0; i < ION_GH_GROUP_SIZE; i++) {
+		if (group[i] == byte) {
+			mask |= (ion_gh_mask_t) 1 << i;
+		}
+	}
+
+	return mask;
+#endif
+}
+
+/**
+@brief		Returns a mask of the slots in @p group that do not hold a
+			record, which are those whose control byte has the top bit set.
+*/
+static ion_gh_mask_t
+gh_match_free(
+	ion_byte_t *group
+) {
+#if defined(ION_GH_SSE2)
+	return (ion_gh_mask_t) _mm_movemask_epi8(_mm_loadu_si128((__m128i *) group));
+#elif defined(ION_GH_NEON)
+
+	static const uint8_t	bits[ION_GH_GROUP_SIZE] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	uint8x16_t				matches					= vandq_u8(vtstq_u8(vld1q_u8(group), vdupq_n_u8(0x80)), vld1q_u8(bits));
+
+	return (ion_gh_mask_t) vaddv_u8(vget_low_u8(matches)) | ((ion_gh_mask_t) vaddv_u8(vget_high_u8(matches)) << 8);
+#else
+
+	ion_gh_mask_t	mask = 0;
+	int				i;
+
+	for (i = 0; i < ION_GH_GROUP_SIZE; i++) {
+		if (0 != (group[i] & 0x80)) {
+			mask |= (ion_gh_mask_t) 1 << i;
+		}
+	}
+
+	return mask;
+#endif
+}
+
+/**
+@brief		Returns the index of the lowest set bit of a non-zero @p mask.
+*/
+static int
+gh_lowest(
+	ion_gh_mask_t mask
+) {
+#if defined(__GNUC__)
+	return __builtin_ctz(mask);
+#else
+
+	int i = 0;
+
+	while (0 == (mask & 1)) {
+		mask >>= 1;
+		i++;
+	}
+
+	return i;
+#endif
+}
+
+/**
+@brief		Hashes @p key. String keys are hashed up to their terminator,
+			to agree with the way they are compared.
+*/
+static ion_gh_hash_t
+gh_hash(
+	ion_group_hash_t	*table,
+	ion_key_t			key
+) {
+	ion_byte_t		*bytes		= key;
+	ion_boolean_t	is_string	= (key_type_char_array == table->super.key_type) || (key_type_null_terminated_string == table->super.key_type);
+	ion_gh_hash_t	hash		= 2166136261u;
+	int				i;
+
+	/* FNV-1a */
+	for (i = 0; i < table->super.record.key_size; i++) {
+		if (is_string && (0 == bytes[i])) {
+			break;
+		}
+
+		hash	^= bytes[i];
+		hash	*= 16777619u;
+	}
+
+	/* Mix the high bits down, as the low bits become the tag */
+	hash	^= hash >> 16;
+	hash	*= 0x85EBCA6Bu;
+	hash	^= hash >> 13;
+	hash	*= 0xC2B2AE35u;
+	hash	^= hash >> 16;
+
+	return hash;
+}
+
+/**
+@brief		Returns the tag stored in the control byte of a slot holding a
+			key with @p hash.
+*/
+#define GH_TAG(hash)	((ion_byte_t) ((hash) & 0x7F))
+
+/**
+@brief		Returns the first group probed for a key with @p hash.
+*/
+#define GH_HOME(table, hash) \
+	((int) ((hash) >> 7) & ((table)->capacity / ION_GH_GROUP_SIZE - 1))
+
+/**
+@brief		Looks for @p key, which hashes to @p hash.
+*/
+static ion_err_t
+gh_probe(
+	ion_group_hash_t	*table,
+	ion_key_t			key,
+	ion_gh_hash_t		hash,
+	int					*slot
+) {
+	int				num_groups	= table->capacity / ION_GH_GROUP_SIZE;
+	int				group		= GH_HOME(table, hash);
+	ion_byte_t		tag			= GH_TAG(hash);
+	ion_gh_mask_t	mask;
+	int				step;
+
+	/* Triangular steps visit every group, as there is a power of two of them */
+	for (step = 1; step <= num_groups; step++) {
+		ion_byte_t *control = table->control + group * ION_GH_GROUP_SIZE;
+
+		for (mask = gh_match(control, tag); 0 != mask; mask &= mask - 1) {
+			int candidate = group * ION_GH_GROUP_SIZE + gh_lowest(mask);
+
+			if (0 == table->super.compare(GH_SLOT_KEY(table, candidate), key, table->super.record.key_size)) {
+				*slot = candidate;
+				return err_ok;
+			}
+		}
+
+		if (0 != gh_match(control, ION_GH_EMPTY)) {
+			return err_item_not_found;
+		}
+
+		group = (group + step) & (num_groups - 1);
+	}
+
+	return err_item_not_found;
+}
+
+/**
+@brief		Returns the first slot on the probe sequence of @p hash that does
+			not hold a record, or -1 if every slot does.
+*/
+static int
+gh_free_slot(
+	ion_group_hash_t	*table,
+	ion_gh_hash_t		hash
+) {
+	int				num_groups	= table->capacity / ION_GH_GROUP_SIZE;
+	int				group		= GH_HOME(table, hash);
+	ion_gh_mask_t	mask;
+	int				step;
+
+	for (step = 1; step <= num_groups; step++) {
+		mask = gh_match_free(table->control + group * ION_GH_GROUP_SIZE);
+
+		if (0 != mask) {
+			return group * ION_GH_GROUP_SIZE + gh_lowest(mask);
+		}
+
+		group = (group + step) & (num_groups - 1);
+	}
+
+	return -1;
+}
+
+/**
+@brief		Stores a record known not to be in the table into @p slot.
+*/
+static void
+gh_place(
+	ion_group_hash_t	*table,
+	int					slot,
+	ion_gh_hash_t		hash,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	if (ION_GH_EMPTY == table->control[slot]) {
+		table->used++;
+	}
+
+	table->control[slot] = GH_TAG(hash);
+	memcpy(GH_SLOT_KEY(table, slot), key, table->super.record.key_size);
+	memcpy(GH_SLOT_VALUE(table, slot), value, table->super.record.value_size);
+	table->count++;
+}
+
+/**
+@brief		Allocates empty control bytes and slots for @p capacity slots.
+*/
+static ion_err_t
+gh_allocate(
+	ion_group_hash_t	*table,
+	int					capacity
+) {
+	table->control = malloc(capacity);
+
+	if (NULL == table->control) {
+		return err_out_of_memory;
+	}
+
+	table->slots = malloc((size_t) capacity * (table->super.record.key_size + table->super.record.value_size));
+
+	if (NULL == table->slots) {
+		free(table->control);
+		table->control = NULL;
+		return err_out_of_memory;
+	}
+
+	memset(table->control, ION_GH_EMPTY, capacity);
+	table->capacity = capacity;
+	table->count	= 0;
+	table->used		= 0;
+
+	return err_ok;
+}
+
+/**
+@brief		Rebuilds the table into @p capacity slots, which clears out the
+			deleted slots. The table is left as it was if there is no memory.
+*/
+static ion_err_t
+gh_resize(
+	ion_group_hash_t	*table,
+	int					capacity
+) {
+	ion_byte_t	*control	= table->control;
+	ion_byte_t	*slots		= table->slots;
+	int			old_capacity;
+	int			count;
+	int			used;
+	int			i;
+	ion_err_t	err;
+
+	old_capacity	= table->capacity;
+	count			= table->count;
+	used			= table->used;
+	err				= gh_allocate(table, capacity);
+
+	if (err_ok != err) {
+		table->control	= control;
+		table->slots	= slots;
+		table->capacity = old_capacity;
+		table->count	= count;
+		table->used		= used;
+		return err;
+	}
+
+	for (i = 0; i < old_capacity; i++) {
+		if (0 == (control[i] & 0x80)) {
+			ion_byte_t		*key	= slots + i * (table->super.record.key_size + table->super.record.value_size);
+			ion_gh_hash_t	hash	= gh_hash(table, key);
+
+			gh_place(table, gh_free_slot(table, hash), hash, key, key + table->super.record.key_size);
+		}
+	}
+
+	free(control);
+	free(slots);
+
+	return err_ok;
+}
+
+ion_err_t
+gh_initialize(
+	ion_group_hash_t	*table,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size,
+	int					size
+) {
+	int capacity = ION_GH_GROUP_SIZE;
+
+	table->super.key_type			= key_type;
+	table->super.record.key_size	= key_size;
+	table->super.record.value_size	= value_size;
+
+	while ((long) capacity * ION_GH_MAX_LOAD_PERCENT < (long) size * 100) {
+		capacity *= 2;
+	}
+
+	return gh_allocate(table, capacity);
+}
+
+ion_err_t
+gh_destroy(
+	ion_group_hash_t *table
+) {
+	if (NULL == table->control) {
+		return err_dictionary_destruction_error;
+	}
+
+	free(table->control);
+	free(table->slots);
+	table->control	= NULL;
+	table->slots	= NULL;
+	table->capacity = 0;
+	table->count	= 0;
+	table->used		= 0;
+
+	return err_ok;
+}
+
+/**
+@brief		Inserts or, if @p update is set, updates a record.
+*/
+static ion_status_t
+gh_put(
+	ion_group_hash_t	*table,
+	ion_key_t			key,
+	ion_value_t			value,
+	ion_boolean_t		update
+) {
+	ion_gh_hash_t	hash = gh_hash(table, key);
+	int				slot;
+
+	if (err_ok == gh_probe(table, key, hash, &slot)) {
+		if (!update) {
+			return ION_STATUS_ERROR(err_duplicate_key);
+		}
+
+		memcpy(GH_SLOT_VALUE(table, slot), value, table->super.record.value_size);
+		return ION_STATUS_OK(1);
+	}
+
+	if ((long) (table->used + 1) * 100 > (long) table->capacity * ION_GH_MAX_LOAD_PERCENT) {
+		/* Double, unless most of the load is deleted slots that a rebuild will clear */
+		int capacity = table->capacity;
+
+		if ((long) table->count * 200 >= (long) capacity * ION_GH_MAX_LOAD_PERCENT) {
+			capacity *= 2;
+		}
+
+		/* Without memory to grow, carry on while there are free slots */
+		gh_resize(table, capacity);
+	}
+
+	slot = gh_free_slot(table, hash);
+
+	if (-1 == slot) {
+		return ION_STATUS_ERROR(err_max_capacity);
+	}
+
+	gh_place(table, slot, hash, key, value);
+
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+gh_insert(
+	ion_group_hash_t	*table,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return gh_put(table, key, value, boolean_false);
+}
+
+ion_status_t
+gh_update(
+	ion_group_hash_t	*table,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return gh_put(table, key, value, boolean_true);
+}
+
+ion_err_t
+gh_find_slot(
+	ion_group_hash_t	*table,
+	ion_key_t			key,
+	int					*slot
+) {
+	return gh_probe(table, key, gh_hash(table, key), slot);
+}
+
+ion_status_t
+gh_query(
+	ion_group_hash_t	*table,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	int slot;
+
+	if (err_ok != gh_find_slot(table, key, &slot)) {
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	memcpy(value, GH_SLOT_VALUE(table, slot), table->super.record.value_size);
+
+	return ION_STATUS_OK(1);
+}
+
+ion_status_t
+gh_delete(
+	ion_group_hash_t	*table,
+	ion_key_t			key
+) {
+	int slot;
+
+	if (err_ok != gh_find_slot(table, key, &slot)) {
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	/* A probe never passes a group with an empty slot, so in such a group the slot can be freed outright */
+	if (0 != gh_match(table->control + (slot - slot % ION_GH_GROUP_SIZE), ION_GH_EMPTY)) {
+		table->control[slot] = ION_GH_EMPTY;
+		table->used--;
+	}
+	else {
+		table->control[slot] = ION_GH_DELETED;
+	}
+
+	table->count--;
+
+	return ION_STATUS_OK(1);
+}
+
+int
+gh_next_slot(
+	ion_group_hash_t	*table,
+	int					slot
+) {
+	for (; slot < table->capacity; slot++) {
+		if (0 == (table->control[slot] & 0x80)) {
+			return slot;
+		}
+	}
+
+	return -1;
+}
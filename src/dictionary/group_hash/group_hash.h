@@ -0,0 +1,193 @@
+/******************************************************************************/
+/**
+@file
+@brief		An in memory hash table that probes groups of control bytes.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#if !defined(GROUP_HASH_H_)
+#define GROUP_HASH_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "group_hash_types.h"
+
+/**
+@brief		Initializes an in memory group hash.
+
+@param		table
+				Pointer to the group hash instance to initialize.
+@param		key_type
+				The type of key that is being stored in the table.
+@param		key_size
+				The size of the key in bytes.
+@param		value_size
+				The size of the value in bytes.
+@param		size
+				The number of records the table should hold before it first
+				grows.
+@return		The status of the initialization.
+*/
+ion_err_t
+gh_initialize(
+	ion_group_hash_t	*table,
+	ion_key_type_t		key_type,
+	ion_key_size_t		key_size,
+	ion_value_size_t	value_size,
+	int					size
+);
+
+/**
+@brief		Destroys the table and frees its slots.
+
+@param		table
+				The table to destroy.
+@return		The status of the destruction.
+*/
+ion_err_t
+gh_destroy(
+	ion_group_hash_t *table
+);
+
+/**
+@brief		Inserts a @p key and @p value into the table.
+
+@details	The table grows as needed, so this only fails with
+			@ref err_max_capacity if there is no memory for a larger table.
+
+@param		table
+				The table to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to insert.
+@return		The status of the insertion. Inserting a key already in the
+			table fails with @ref err_duplicate_key.
+*/
+ion_status_t
+gh_insert(
+	ion_group_hash_t	*table,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Updates the value of @p key, inserting it if it is not in the
+			table.
+
+@param		table
+				The table to update.
+@param		key
+				The key to update.
+@param		value
+				The new value.
+@return		The status of the update.
+*/
+ion_status_t
+gh_update(
+	ion_group_hash_t	*table,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Looks up @p key and copies its value into @p value.
+
+@param		table
+				The table to search.
+@param		key
+				The key to search for.
+@param		value
+				Memory allocated by the caller to hold the value.
+@return		The status of the query.
+*/
+ion_status_t
+gh_query(
+	ion_group_hash_t	*table,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Deletes @p key and its value from the table.
+
+@param		table
+				The table to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+gh_delete(
+	ion_group_hash_t	*table,
+	ion_key_t			key
+);
+
+/**
+@brief		Finds the slot holding @p key.
+
+@param		table
+				The table to search.
+@param		key
+				The key to search for.
+@param		slot
+				Set to the slot holding the key, if it is found.
+@return		@ref err_ok if the key was found, or @ref err_item_not_found.
+*/
+ion_err_t
+gh_find_slot(
+	ion_group_hash_t	*table,
+	ion_key_t			key,
+	int					*slot
+);
+
+/**
+@brief		Returns the first slot from @p slot on that holds a record, or
+			-1 if there is none.
+
+@param		table
+				The table to scan.
+@param		slot
+				The slot to start from.
+@return		The slot found.
+*/
+int
+gh_next_slot(
+	ion_group_hash_t	*table,
+	int					slot
+);
+
+/**
+@brief		Returns the key held in @p slot.
+*/
+#define GH_SLOT_KEY(table, slot) \
+	((table)->slots + (slot) * ((table)->super.record.key_size + (table)->super.record.value_size))
+
+/**
+@brief		Returns the value held in @p slot.
+*/
+#define GH_SLOT_VALUE(table, slot) \
+	(GH_SLOT_KEY(table, slot) + (table)->super.record.key_size)
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GROUP_HASH_H_ */
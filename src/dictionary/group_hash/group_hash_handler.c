@@ -0,0 +1,353 @@
+/******************************************************************************/
+/**
+@file
+@brief		Handler liaison between dictionary API and group hash
+			implementation.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#include "group_hash_handler.h"
+
+ion_status_t
+ghdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return gh_query((ion_group_hash_t *) dictionary->instance, key, value);
+}
+
+/**
+@brief	  Returns the first slot from @p slot on whose record satisfies the
+			predicate of @p cursor, or -1 if there is none.
+*/
+static int
+ghdict_scan(
+	ion_dict_cursor_t	*cursor,
+	int					slot
+) {
+	ion_group_hash_t *table = (ion_group_hash_t *) cursor->dictionary->instance;
+
+	for (slot = gh_next_slot(table, slot); -1 != slot; slot = gh_next_slot(table, slot + 1)) {
+		if (test_predicate(cursor, GH_SLOT_KEY(table, slot))) {
+			break;
+		}
+	}
+
+	return slot;
+}
+
+/**
+@brief	  Next function queries and retrieves the next key/value pair that
+			satisfies the predicate of the cursor.
+
+@param	  cursor
+				The cursor used to iterate over results.
+@param	  record
+				A record pointer that is allocated by the caller in which the
+				cursor will fill with the next key/value result. The assumption
+				is that the caller will also free this memory.
+@return	 Status of cursor.
+*/
+static ion_cursor_status_t
+ghdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_ghdict_cursor_t *gh_cursor	= (ion_ghdict_cursor_t *) cursor;
+	ion_group_hash_t	*table		= (ion_group_hash_t *) cursor->dictionary->instance;
+
+	if ((cursor->status == cs_cursor_uninitialized) || (cursor->status == cs_end_of_results)) {
+		return cursor->status;
+	}
+	else if ((cursor->status == cs_cursor_initialized) || (cursor->status == cs_cursor_active)) {
+		if (-1 == gh_cursor->current) {
+			cursor->status = cs_end_of_results;
+			return cursor->status;
+		}
+
+		cursor->status = cs_cursor_active;
+
+		memcpy(record->key, GH_SLOT_KEY(table, gh_cursor->current), table->super.record.key_size);
+		memcpy(record->value, GH_SLOT_VALUE(table, gh_cursor->current), table->super.record.value_size);
+
+		/* Keys are unique, so an equality match has no more results */
+		if (predicate_equality == cursor->predicate->type) {
+			gh_cursor->current = -1;
+		}
+		else {
+			gh_cursor->current = ghdict_scan(cursor, gh_cursor->current + 1);
+		}
+
+		return cursor->status;
+	}
+
+	return cs_invalid_cursor;
+}
+
+/**
+@brief			Closes a group hash instance of a dictionary.
+
+@param			dictionary
+					A pointer to the specific dictionary instance to be closed.
+
+@return			The status of closing the dictionary.
+ */
+static ion_err_t
+ghdict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	UNUSED(dictionary);
+	return err_not_implemented;
+}
+
+/**
+@brief	  Destroys the cursor.
+
+@param	  cursor
+				Pointer to a pointer of a cursor.
+*/
+static void
+ghdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	(*cursor)->predicate->destroy(&(*cursor)->predicate);
+	free(*cursor);
+	*cursor = NULL;
+}
+
+ion_err_t
+ghdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_group_hash_t	*table		= (ion_group_hash_t *) dictionary->instance;
+	ion_key_size_t		key_size	= table->super.record.key_size;
+	ion_ghdict_cursor_t *gh_cursor;
+
+	*cursor = malloc(sizeof(ion_ghdict_cursor_t));
+
+	if (NULL == *cursor) {
+		return err_out_of_memory;
+	}
+
+	gh_cursor				= (ion_ghdict_cursor_t *) (*cursor);
+
+	(*cursor)->dictionary	= dictionary;
+	(*cursor)->status		= cs_cursor_uninitialized;
+
+	(*cursor)->destroy		= ghdict_destroy_cursor;
+	(*cursor)->next			= ghdict_next;
+
+	(*cursor)->predicate	= malloc(sizeof(ion_predicate_t));
+
+	if (NULL == (*cursor)->predicate) {
+		free(*cursor);
+		return err_out_of_memory;
+	}
+
+	(*cursor)->predicate->type		= predicate->type;
+	(*cursor)->predicate->destroy	= predicate->destroy;
+
+	switch (predicate->type) {
+		case predicate_equality: {
+			(*cursor)->predicate->statement.equality.equality_value = malloc(key_size);
+
+			if (NULL == (*cursor)->predicate->statement.equality.equality_value) {
+				free((*cursor)->predicate);
+				free(*cursor);
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.equality.equality_value, predicate->statement.equality.equality_value, key_size);
+
+			if (err_ok != gh_find_slot(table, (*cursor)->predicate->statement.equality.equality_value, &gh_cursor->current)) {
+				(*cursor)->status = cs_end_of_results;
+				return err_ok;
+			}
+
+			(*cursor)->status = cs_cursor_initialized;
+			return err_ok;
+		}
+
+		case predicate_range: {
+			(*cursor)->predicate->statement.range.lower_bound = malloc(key_size);
+
+			if (NULL == (*cursor)->predicate->statement.range.lower_bound) {
+				free((*cursor)->predicate);
+				free(*cursor);
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
+
+			(*cursor)->predicate->statement.range.upper_bound = malloc(key_size);
+
+			if (NULL == (*cursor)->predicate->statement.range.upper_bound) {
+				free((*cursor)->predicate->statement.range.lower_bound);
+				free((*cursor)->predicate);
+				free(*cursor);
+				return err_out_of_memory;
+			}
+
+			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
+			break;
+		}
+
+		case predicate_all_records: {
+			break;
+		}
+
+		case predicate_predicate: {
+			/* TODO not implemented */
+			return err_ok;
+		}
+
+		default: {
+			free((*cursor)->predicate);
+			free(*cursor);
+			*cursor = NULL;
+			return err_invalid_predicate;
+		}
+	}
+
+	gh_cursor->current	= ghdict_scan(*cursor, 0);
+	(*cursor)->status	= (-1 == gh_cursor->current) ? cs_end_of_results : cs_cursor_initialized;
+
+	return err_ok;
+}
+
+/**
+@brief			Opens a specific group hash instance of a dictionary.
+
+@param			handler
+					A pointer to the handler for the specific dictionary being opened.
+@param			dictionary
+					The pointer declared by the caller that will reference
+					the instance of the dictionary opened.
+@param			config
+					The configuration info of the specific dictionary to be opened.
+@param			compare
+					Function pointer for the comparison function for the dictionary.
+
+@return			The status of opening the dictionary.
+ */
+static ion_err_t
+ghdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	UNUSED(handler);
+	UNUSED(dictionary);
+	UNUSED(config);
+	UNUSED(compare);
+	return err_not_implemented;
+}
+
+void
+ghdict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= ghdict_insert;
+	handler->get				= ghdict_query;
+	handler->create_dictionary	= ghdict_create_dictionary;
+	handler->remove				= ghdict_delete;
+	handler->delete_dictionary	= ghdict_delete_dictionary;
+	handler->update				= ghdict_update;
+	handler->find				= ghdict_find;
+	handler->close_dictionary	= ghdict_close_dictionary;
+	handler->multi_get			= NULL;
+	handler->insert_batch		= NULL;
+	handler->open_dictionary	= ghdict_open_dictionary;
+	handler->flush_dictionary	= NULL;
+	handler->concurrency		= ion_concurrency_shared_get;
+}
+
+ion_status_t
+ghdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return gh_insert((ion_group_hash_t *) dictionary->instance, key, value);
+}
+
+ion_err_t
+ghdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	UNUSED(id);
+
+	dictionary->instance = malloc(sizeof(ion_group_hash_t));
+
+	if (NULL == dictionary->instance) {
+		return err_out_of_memory;
+	}
+
+	dictionary->instance->compare = compare;
+
+	ion_err_t result = gh_initialize((ion_group_hash_t *) dictionary->instance, key_type, key_size, value_size, dictionary_size);
+
+	if (err_ok != result) {
+		free(dictionary->instance);
+		dictionary->instance = NULL;
+		return result;
+	}
+
+	dictionary->handler = handler;
+
+	return err_ok;
+}
+
+ion_status_t
+ghdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	return gh_delete((ion_group_hash_t *) dictionary->instance, key);
+}
+
+ion_err_t
+ghdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_err_t result = gh_destroy((ion_group_hash_t *) dictionary->instance);
+
+	free(dictionary->instance);
+	dictionary->instance = NULL;
+	return result;
+}
+
+ion_status_t
+ghdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return gh_update((ion_group_hash_t *) dictionary->instance, key, value);
+}
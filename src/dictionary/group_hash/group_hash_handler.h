@@ -0,0 +1,202 @@
+/******************************************************************************/
+/**
+@file
+@brief		Handler liaison between dictionary API and group hash
+			implementation.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#if !defined(GROUP_HASH_HANDLER_H_)
+#define GROUP_HASH_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "group_hash_types.h"
+#include "group_hash.h"
+
+/**
+@brief	  Registers a group hash handler to a dictionary instance.
+
+@details	Binds each unique group hash function to the generic dictionary
+			interface. Only needs to be called once when the group hash is
+			initialized.
+
+@param	  handler
+				An instance of a dictionary handler that is to be bound.
+				It is assumed @p handler is initialized by the user.
+*/
+void
+ghdict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief	  Inserts a @p key and @p value pair into the dictionary.
+
+@param	  dictionary
+				The dictionary instance to insert the value into.
+@param	  key
+				The key to use.
+@param	  value
+				The value to use.
+@return	 Status of insertion.
+*/
+ion_status_t
+ghdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief	  Queries a dictionary instance for the given @p key and returns
+			the associated @p value.
+
+@param	  dictionary
+				The instance of the dictionary to query.
+@param	  key
+				The key to search for.
+@param	  value
+				A pointer used to hold the returned value from the query. The
+				memory for value is assumed to be allocated and freed by the
+				user.
+@return	 Status of query.
+*/
+ion_status_t
+ghdict_query(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief	  Creates an instance of a dictionary.
+
+@details	Creates an instance of a dictionary given a @p key_size and
+			@p value_size, in bytes. The @p dictionary_size is the number of
+			records the table is sized for at first; it grows as needed
+			after that.
+
+@param		id
+@param		key_type
+@param	  key_size
+				Size of the key in bytes.
+@param	  value_size
+				Size of the value in bytes.
+@param		dictionary_size
+				The number of records to size the table for.
+@param		compare
+@param	  handler
+				Handler to be bound to the dictionary instance being created.
+				Assumption is that the handler has been initialized prior.
+@param	  dictionary
+				Pointer in which the created dictionary instance is to be
+				stored. Assumption is that it has been properly allocated by
+				the user.
+@return	 Status of creation.
+*/
+ion_err_t
+ghdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief	  Deletes the @p key and associated value from the given dictionary
+			instance.
+
+@param	  dictionary
+				The instance of the dictionary to delete from.
+@param	  key
+				The key to be deleted.
+@return	 Status of deletion.
+*/
+ion_status_t
+ghdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief	  Deletes an instance of a dictionary and its associated data.
+
+@param	  dictionary
+				The instance of the dictionary to be deleted.
+@return	 Status of dictionary deletion.
+*/
+ion_err_t
+ghdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief	  Updates the value stored at a given key.
+
+@details	Updates the value for a given @p key. If the key doesn't exist,
+			the key value pair will be added as if it was an insert.
+
+@param	  dictionary
+				The instance of the dictionary to be updated.
+@param	  key
+				The key that is to be updated.
+@param	  value
+				The new value to be used.
+@return Status of update.
+*/
+ion_status_t
+ghdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief	  Finds multiple keys based on the provided predicate.
+
+@details	Gives a cursor over the records whose keys satisfy the
+			@p predicate, in no particular order.
+
+@param	  dictionary
+				The instance of a dictionary to search within.
+@param	  predicate
+				The predicate used to match.
+@param	  cursor
+				The pointer to a cursor declared by the caller, but initialized
+				and populated within the function.
+@return	 Status of find.
+*/
+ion_err_t
+ghdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GROUP_HASH_HANDLER_H_ */
@@ -0,0 +1,92 @@
+/******************************************************************************/
+/**
+@file
+@brief		Contains all types local to the group hash data structure.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#if !defined(GROUP_HASH_TYPES_H_)
+#define GROUP_HASH_TYPES_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "./../dictionary.h"
+
+#include "../../key_value/kv_system.h"
+
+/**
+@brief		Number of slots whose control bytes are examined together.
+*/
+#define ION_GH_GROUP_SIZE 16
+
+/**
+@brief		Control byte of a slot that has never held a record.
+*/
+#define ION_GH_EMPTY ((ion_byte_t) 0x80)
+
+/**
+@brief		Control byte of a slot whose record was deleted.
+*/
+#define ION_GH_DELETED ((ion_byte_t) 0xFE)
+
+/**
+@brief		The percentage of slots, in use or deleted, past which the table
+			is rebuilt into a larger one.
+*/
+#if !defined(ION_GH_MAX_LOAD_PERCENT)
+#define ION_GH_MAX_LOAD_PERCENT 87
+#endif
+
+typedef uint32_t ion_gh_hash_t;	/**< Hash of a key */
+
+/**
+@brief		Struct of the group hash, an in memory hash table that keeps the
+			probe information apart from the records.
+
+@details	Each slot has a control byte. A slot holding a record has the low
+			seven bits of its key's hash as control byte, any other slot has
+			@ref ION_GH_EMPTY or @ref ION_GH_DELETED, both of which have the
+			top bit set. The control bytes are probed a group at a time, so
+			keys are only compared where the hash bits match.
+*/
+typedef struct group_hash {
+	ion_dictionary_parent_t super;		/**< Parent structure holding dictionary level
+										information */
+	ion_byte_t				*control;	/**< One control byte per slot */
+	ion_byte_t				*slots;		/**< Key and value of each slot */
+	int						capacity;	/**< Number of slots, a power of two no
+											 smaller than a group */
+	int						count;		/**< Records held by the table */
+	int						used;		/**< Slots in use or deleted */
+} ion_group_hash_t;
+
+typedef struct
+	ghdict_cursor {
+	ion_dict_cursor_t	super;			/**< Supertype of cursor */
+	int					current;		/**< Slot of the next record to return,
+											 or -1 if there is none */
+} ion_ghdict_cursor_t;
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GROUP_HASH_TYPES_H_ */
@@ -26,14 +26,41 @@
 FILE				*ion_master_table_file		= NULL;
 ion_dictionary_id_t ion_master_table_next_id	= 1;
 
+/**
+@brief		Latches the master table file and next ID, so that threads can
+			neither be handed the same ID nor move the file position under
+			each other.
+*/
+static ion_latch_t ion_master_table_latch;
+
+/**
+@brief		Master table format whose records have no hash function family.
+			Every dictionary in it uses @ref hash_function_default.
+*/
+#define ION_MASTER_TABLE_FORMAT_LEGACY	0
+
+/**
+@brief		Master table format whose records end with the hash function
+			family of their dictionary.
+*/
+#define ION_MASTER_TABLE_FORMAT_HASHED	1
+
+/**
+@brief		Format of the open master table. It is kept in the use type of the
+			master row, which tables written before formats existed leave as
+			zero.
+*/
+static ion_dict_use_t ion_master_table_format = ION_MASTER_TABLE_FORMAT_HASHED;
+
 #define ION_MASTER_TABLE_CALCULATE_POS	-1
 #define ION_MASTER_TABLE_WRITE_FROM_END -2
-#define ION_MASTER_TABLE_RECORD_SIZE(cp) (sizeof((cp)->id) + sizeof((cp)->use_type) + sizeof((cp)->type) + sizeof((cp)->key_size) + sizeof((cp)->value_size) + sizeof((cp)->dictionary_size))
+#define ION_MASTER_TABLE_RECORD_SIZE(cp) (sizeof((cp)->id) + sizeof((cp)->use_type) + sizeof((cp)->type) + sizeof((cp)->key_size) + sizeof((cp)->value_size) + sizeof((cp)->dictionary_size) + ((ION_MASTER_TABLE_FORMAT_HASHED <= ion_master_table_format) ? sizeof((cp)->hash_function) : 0))
 
 /**
 @brief		Write a record to the master table.
 @details	Automatically, this call will reposition the file position
 			back to where it was once the call is complete.
+			The caller must hold the master table latch.
 @param[in]	config
 				A pointer to a previously allocated config object to write from.
 @param[in]	where
@@ -91,6 +118,10 @@ ion_master_table_write(
 		return err_file_write_error;
 	}
 
+	if ((ION_MASTER_TABLE_FORMAT_HASHED <= ion_master_table_format) && (1 != fwrite(&(config->hash_function), sizeof(config->hash_function), 1, ion_master_table_file))) {
+		return err_file_write_error;
+	}
+
 	if (0 != fseek(ion_master_table_file, old_pos, SEEK_SET)) {
 		return err_file_bad_seek;
 	}
@@ -102,6 +133,7 @@ ion_master_table_write(
 @brief		Read a record to the master table.
 @details	Automatically, this call will reposition the file position
 			back to where it was once the call is complete.
+			The caller must hold the master table latch.
 @param[out]	config
 				A pointer to a previously allocated config object to write to.
 @param[in]	where
@@ -152,6 +184,12 @@ ion_master_table_read(
 		return err_file_write_error;
 	}
 
+	config->hash_function = hash_function_default;
+
+	if ((ION_MASTER_TABLE_FORMAT_HASHED <= ion_master_table_format) && (1 != fread(&(config->hash_function), sizeof(config->hash_function), 1, ion_master_table_file))) {
+		return err_file_write_error;
+	}
+
 	if (0 != fseek(ion_master_table_file, old_pos, SEEK_SET)) {
 		return err_file_bad_seek;
 	}
@@ -168,20 +206,23 @@ ion_err_t
 ion_master_table_get_next_id(
 	ion_dictionary_id_t *id
 ) {
-	ion_err_t error								= err_ok;
+	ion_err_t						error;
+	ion_dictionary_config_info_t	master_config = { 0 };
 
-	/* Flush master row. This writes the next ID to be used, so add 1. */
-	ion_dictionary_config_info_t master_config	= { .id = ion_master_table_next_id + 1 };
+	dictionary_latch_acquire_exclusive(&ion_master_table_latch);
 
-	error = ion_master_table_write(&master_config, 0);
+	/* Flush master row. This writes the next ID to be used, so add 1. */
+	master_config.id		= ion_master_table_next_id + 1;
+	master_config.use_type	= ion_master_table_format;
+	error					= ion_master_table_write(&master_config, 0);
 
-	if (err_ok != error) {
-		return error;
+	if (err_ok == error) {
+		*id = ion_master_table_next_id++;
 	}
 
-	*id = ion_master_table_next_id++;
+	dictionary_latch_release_exclusive(&ion_master_table_latch);
 
-	return err_ok;
+	return error;
 }
 
 ion_err_t
@@ -207,7 +248,9 @@ ion_init_master_table(
 
 		/* Clean fresh file was opened. */
 		/* Write master row. */
-		ion_dictionary_config_info_t master_config = { .id = ion_master_table_next_id };
+		ion_master_table_format = ION_MASTER_TABLE_FORMAT_HASHED;
+
+		ion_dictionary_config_info_t master_config = { .id = ion_master_table_next_id, .use_type = ion_master_table_format };
 
 		if (err_ok != (error = ion_master_table_write(&master_config, 0))) {
 			return error;
@@ -216,14 +259,18 @@ ion_init_master_table(
 	else {
 		/* Here we read an existing file. */
 
-		/* Find existing ID count. */
+		/* Find existing ID count. The master row is read without the hash
+		   function family, since the format is not known yet. */
 		ion_dictionary_config_info_t master_config;
 
+		ion_master_table_format = ION_MASTER_TABLE_FORMAT_LEGACY;
+
 		if (ion_master_table_read(&master_config, 0)) {
 			return err_file_read_error;
 		}
 
-		ion_master_table_next_id = master_config.id;
+		ion_master_table_next_id	= master_config.id;
+		ion_master_table_format		= master_config.use_type;
 	}
 
 	return err_ok;
@@ -272,11 +319,16 @@ ion_add_to_master_table(
 	ion_dictionary_t		*dictionary,
 	ion_dictionary_size_t	dictionary_size
 ) {
-	ion_dictionary_config_info_t config = {
-		.id = dictionary->instance->id, .use_type = 0, .type = dictionary->instance->key_type, .key_size = dictionary->instance->record.key_size, .value_size = dictionary->instance->record.value_size, .dictionary_size = dictionary_size
+	ion_err_t						error;
+	ion_dictionary_config_info_t	config = {
+		.id = dictionary->instance->id, .use_type = 0, .type = dictionary->instance->key_type, .key_size = dictionary->instance->record.key_size, .value_size = dictionary->instance->record.value_size, .dictionary_size = dictionary_size, .hash_function = dictionary->hash_function
 	};
 
-	return ion_master_table_write(&config, ION_MASTER_TABLE_WRITE_FROM_END);
+	dictionary_latch_acquire_exclusive(&ion_master_table_latch);
+	error = ion_master_table_write(&config, ION_MASTER_TABLE_WRITE_FROM_END);
+	dictionary_latch_release_exclusive(&ion_master_table_latch);
+
+	return error;
 }
 
 ion_err_t
@@ -287,17 +339,35 @@ ion_master_table_create_dictionary(
 	ion_key_size_t				key_size,
 	ion_value_size_t			value_size,
 	ion_dictionary_size_t		dictionary_size
+) {
+	return ion_master_table_create_hashed_dictionary(handler, dictionary, key_type, key_size, value_size, dictionary_size, hash_function_default);
+}
+
+ion_err_t
+ion_master_table_create_hashed_dictionary(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_hash_function_t			hash_function
 ) {
 	ion_err_t			err;
 	ion_dictionary_id_t id;
 
+	/* A legacy table has nowhere to record any other family */
+	if ((ION_MASTER_TABLE_FORMAT_LEGACY == ion_master_table_format) && (hash_function_default != hash_function) && (hash_function_modulo != hash_function)) {
+		return err_dictionary_initialization_failed;
+	}
+
 	err = ion_master_table_get_next_id(&id);
 
 	if (err_ok != err) {
 		return err;
 	}
 
-	err = dictionary_create(handler, dictionary, id, key_type, key_size, value_size, dictionary_size);
+	err = dictionary_create_hashed(handler, dictionary, id, key_type, key_size, value_size, dictionary_size, hash_function);
 
 	if (err_ok != err) {
 		return err;
@@ -316,7 +386,10 @@ ion_lookup_in_master_table(
 	ion_err_t error = err_ok;
 
 	config->id	= id;
+
+	dictionary_latch_acquire_exclusive(&ion_master_table_latch);
 	error		= ion_master_table_read(config, ION_MASTER_TABLE_CALCULATE_POS);
+	dictionary_latch_release_exclusive(&ion_master_table_latch);
 
 	if (err_ok != error) {
 		return error;
@@ -339,31 +412,37 @@ ion_find_by_use_master_table(
 
 	id			= 1;
 
+	dictionary_latch_acquire_exclusive(&ion_master_table_latch);
+
 	if (ION_MASTER_TABLE_FIND_LAST == whence) {
 		id = ion_master_table_next_id - 1;
 	}
 
 	/* Loop through all items. */
-	for (; id < ion_master_table_next_id && id > 0; id += whence) {
-		error = ion_lookup_in_master_table(id, &tconfig);
+	for (error = err_item_not_found; id < ion_master_table_next_id && id > 0; id += whence) {
+		tconfig.id	= id;
+		error		= ion_master_table_read(&tconfig, ION_MASTER_TABLE_CALCULATE_POS);
 
 		if (err_item_not_found == error) {
 			continue;
 		}
 
 		if (err_ok != error) {
-			return error;
+			break;
 		}
 
 		/* If this config has the right type, set the output pointer. */
 		if (tconfig.use_type == use_type) {
 			*config = tconfig;
-
-			return err_ok;
+			break;
 		}
+
+		error = err_item_not_found;
 	}
 
-	return err_item_not_found;
+	dictionary_latch_release_exclusive(&ion_master_table_latch);
+
+	return error;
 }
 
 ion_err_t
@@ -380,7 +459,11 @@ ion_delete_from_master_table(
 		return error;
 	}
 
-	return ion_master_table_write(&blank, where);
+	dictionary_latch_acquire_exclusive(&ion_master_table_latch);
+	error = ion_master_table_write(&blank, where);
+	dictionary_latch_release_exclusive(&ion_master_table_latch);
+
+	return error;
 }
 
 ion_err_t
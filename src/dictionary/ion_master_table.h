@@ -80,6 +80,8 @@ extern FILE *ion_master_table_file;
 /**
 @brief	  Opens the master table.
 @details	Can be safely called multiple times without closing.
+			Must not be called alongside other master table calls, unlike
+			the rest, which latch the master table.
 */
 ion_err_t
 ion_init_master_table(
@@ -88,6 +90,7 @@ ion_init_master_table(
 
 /**
 @brief		Closes the master table.
+@details	Must not be called alongside other master table calls.
 */
 ion_err_t
 ion_close_master_table(
@@ -133,6 +136,31 @@ ion_master_table_create_dictionary(
 	ion_dictionary_size_t		dictionary_size
 );
 
+/**
+@brief		Creates a dictionary through use of the master table, placing
+			keys with the given hash function family.
+@details	Takes the same parameters as
+			@ref ion_master_table_create_dictionary. The family is recorded
+			in the master table, so the dictionary is reopened with it.
+			Master tables written before families were recorded are read
+			as using @ref hash_function_default, and can only create
+			dictionaries with the legacy hash.
+@param		hash_function
+				The hash function family to use, or
+				@ref hash_function_default.
+@returns	An error code describing the result of the operation.
+*/
+ion_err_t
+ion_master_table_create_hashed_dictionary(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_hash_function_t			hash_function
+);
+
 /**
 @brief		Looks up the config of the given id.
 @param		id
@@ -17,13 +17,902 @@
 
 #define ION_TEST_FILE "file.bin"
 
+/**
+@brief		Gives the header of page @p page_id of a map with the paged
+			layout.
+*/
+static ion_oafh_page_header_t *
+oafh_page_header(
+	ion_file_hashmap_t	*hash_map,
+	int					page_id
+) {
+	if (page_id < hash_map->num_buckets) {
+		return &hash_map->buckets[page_id];
+	}
+
+	return &hash_map->overflow[page_id - hash_map->num_buckets];
+}
+
+/**
+@brief		Gives the file holding page @p page_id, and where in it the page
+			starts.
+*/
+static ion_file_handle_t
+oafh_page_file(
+	ion_file_hashmap_t	*hash_map,
+	int					page_id,
+	ion_file_offset_t	*offset
+) {
+	if (page_id < hash_map->num_buckets) {
+		*offset = (ion_file_offset_t) page_id * hash_map->page_size;
+		return hash_map->file;
+	}
+
+	*offset = (ion_file_offset_t) (page_id - hash_map->num_buckets) * hash_map->page_size;
+	return hash_map->overflow_file;
+}
+
+/**
+@brief		Reads page @p page_id into the page buffer, unless it is there
+			already.
+*/
+static ion_err_t
+oafh_page_load(
+	ion_file_hashmap_t	*hash_map,
+	int					page_id
+) {
+	ion_file_offset_t	offset;
+	ion_file_handle_t	file;
+	ion_err_t			err;
+
+	if (page_id == hash_map->page_id) {
+		return err_ok;
+	}
+
+	file				= oafh_page_file(hash_map, page_id, &offset);
+	hash_map->page_id	= -1;
+	err					= ion_fread_at(file, offset, hash_map->page_size, hash_map->page);
+
+	if (err_ok == err) {
+		hash_map->page_id = page_id;
+	}
+
+	return err;
+}
+
+/**
+@brief		Gives slot @p slot of the page buffer.
+*/
+static ion_hash_bucket_t *
+oafh_page_slot(
+	ion_file_hashmap_t	*hash_map,
+	int					slot
+) {
+	int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+
+	return (ion_hash_bucket_t *) (hash_map->page + sizeof(ion_oafh_page_header_t) + slot * record_size);
+}
+
+/**
+@brief		Writes slot @p slot of the page buffer to the file.
+*/
+static ion_err_t
+oafh_page_write_slot(
+	ion_file_hashmap_t	*hash_map,
+	int					slot
+) {
+	int					record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	ion_file_offset_t	offset;
+	ion_file_handle_t	file		= oafh_page_file(hash_map, hash_map->page_id, &offset);
+
+	return ion_fwrite_at(file, offset + sizeof(ion_oafh_page_header_t) + slot * record_size, record_size, (ion_byte_t *) oafh_page_slot(hash_map, slot));
+}
+
+/**
+@brief		Writes the header of page @p page_id to the file, from the copy
+			kept in memory.
+*/
+static ion_err_t
+oafh_page_write_header(
+	ion_file_hashmap_t	*hash_map,
+	int					page_id
+) {
+	ion_oafh_page_header_t	*header = oafh_page_header(hash_map, page_id);
+	ion_file_offset_t		offset;
+	ion_file_handle_t		file	= oafh_page_file(hash_map, page_id, &offset);
+
+	if (page_id == hash_map->page_id) {
+		memcpy(hash_map->page, header, sizeof(ion_oafh_page_header_t));
+	}
+
+	return ion_fwrite_at(file, offset, sizeof(ion_oafh_page_header_t), (ion_byte_t *) header);
+}
+
+/**
+@brief		Gives the page that follows page @p page_id in its bucket, or -1
+			if none does.
+*/
+static int
+oafh_page_next(
+	ion_file_hashmap_t	*hash_map,
+	int					page_id
+) {
+	uint32_t next = oafh_page_header(hash_map, page_id)->next;
+
+	return (0 == next) ? -1 : hash_map->num_buckets + (int) next - 1;
+}
+
+/**
+@brief		Hashes @p key for a map with the paged layout.
+
+@details	The number of buckets changes as the map grows, so the hash is
+			not reduced to the size of the map as @p compute_hash does.
+			Without a key hash, the key itself is used, as by
+			@ref oafh_compute_simple_hash.
+*/
+static uint32_t
+oafh_page_hash(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			key
+) {
+	int value;
+
+	if (NULL != hash_map->hash) {
+		return hash_map->hash(key, hash_map->super.record.key_size);
+	}
+
+	memcpy(&value, key, sizeof(value));
+	return (uint32_t) value;
+}
+
+/**
+@brief		Gives the bucket of @p key in a map with the paged layout.
+
+@details	Buckets from the first up to the next one to be split are placed
+			by a hash on twice the buckets of the round, as they have been
+			split already.
+*/
+static int
+oafh_page_bucket(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			key
+) {
+	uint32_t	hash	= oafh_page_hash(hash_map, key);
+	int			bucket	= (int) (hash % (uint32_t) hash_map->split_round);
+
+	if (bucket < hash_map->num_buckets - hash_map->split_round) {
+		bucket = (int) (hash % (uint32_t) (hash_map->split_round * 2));
+	}
+
+	return bucket;
+}
+
+/**
+@brief		Looks for @p key in the pages of its bucket.
+
+@param		hash_map
+				The map to search.
+@param		key
+				The key to look for.
+@param		page_id
+				Set to the page holding the key, which is left in the page
+				buffer, or if the key is not found, to the last page of the
+				bucket.
+@param		slot
+				Set to the slot holding the key.
+@param		room
+				Set to the first page of the bucket with a free slot, or to
+				-1 if every page is full.
+@return		@ref err_ok if the key is found, @ref err_item_not_found if it
+			is not, or the status of reading a page.
+*/
+static ion_err_t
+oafh_page_find(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			key,
+	int					*page_id,
+	int					*slot,
+	int					*room
+) {
+	ion_oafh_page_header_t	*header;
+	ion_err_t				err;
+	int						next;
+	int						id;
+	int						i;
+
+	*room = -1;
+
+	for (id = oafh_page_bucket(hash_map, key); -1 != id; id = next) {
+		header		= oafh_page_header(hash_map, id);
+		next		= oafh_page_next(hash_map, id);
+		*page_id	= id;
+
+		if ((-1 == *room) && (header->count < hash_map->slots_per_page)) {
+			*room = id;
+		}
+
+		/* Pages with no records are passed over without being read */
+		if (0 == header->count) {
+			continue;
+		}
+
+		err = oafh_page_load(hash_map, id);
+
+		if (err_ok != err) {
+			return err;
+		}
+
+		for (i = 0; i < header->count; i++) {
+			if (ION_IS_EQUAL == hash_map->super.compare(oafh_page_slot(hash_map, i)->data, key, hash_map->super.record.key_size)) {
+				*slot = i;
+				return err_ok;
+			}
+		}
+	}
+
+	return err_item_not_found;
+}
+
+/**
+@brief		Adds an empty overflow page to the end of the pages of a bucket.
+
+@param		hash_map
+				The map to grow.
+@param		last
+				The last page of the bucket.
+@param		page_id
+				Set to the new page, which is left in the page buffer.
+@return		The status of adding the page.
+*/
+static ion_err_t
+oafh_page_extend(
+	ion_file_hashmap_t	*hash_map,
+	int					last,
+	int					*page_id
+) {
+	ion_oafh_page_header_t	*overflow;
+	ion_err_t				err;
+
+	overflow = realloc(hash_map->overflow, (hash_map->num_overflow + 1) * sizeof(ion_oafh_page_header_t));
+
+	if (NULL == overflow) {
+		return err_out_of_memory;
+	}
+
+	hash_map->overflow	= overflow;
+	hash_map->page_id	= -1;
+	memset(&overflow[hash_map->num_overflow], 0, sizeof(ion_oafh_page_header_t));
+	memset(hash_map->page, 0, hash_map->page_size);
+
+	/* The page is written before it is linked in, so that no page links to one the file does not hold */
+	err = ion_fwrite_at(hash_map->overflow_file, (ion_file_offset_t) hash_map->num_overflow * hash_map->page_size, hash_map->page_size, hash_map->page);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	*page_id							= hash_map->num_buckets + hash_map->num_overflow;
+	hash_map->page_id					= *page_id;
+	hash_map->num_overflow++;
+	oafh_page_header(hash_map, last)->next = (uint32_t) hash_map->num_overflow;
+
+	return oafh_page_write_header(hash_map, last);
+}
+
+/**
+@brief		Splits the next bucket in turn, so that the map grows by one
+			bucket.
+
+@details	This is linear hashing. The buckets of a round are split in
+			order, each into itself and a new bucket at the end of the map
+			file, and the records of the bucket are divided between the two
+			by a hash on twice the buckets of the round. Once each has been
+			split, the number of buckets has doubled and a new round starts.
+			Only the records of the one bucket are moved, and they are held
+			in memory while they are.
+
+			The new bucket is written before the records that moved to it
+			are dropped from the bucket split, so that a key is always in
+			the bucket it is looked up in. If there is no memory to split,
+			the map carries on at its current size.
+*/
+static ion_err_t
+oafh_page_split(
+	ion_file_hashmap_t *hash_map
+) {
+	int						record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	int						split		= hash_map->num_buckets - hash_map->split_round;
+	int						added		= hash_map->num_buckets;
+	int						num_records = 0;
+	int						num_kept	= 0;
+	int						num_moved	= 0;
+	int						chain_length = 0;
+	int						num_pages;
+	int						*chain;
+	ion_byte_t				*records;
+	ion_oafh_page_header_t	*headers;
+	ion_err_t				err			= err_ok;
+	int						id;
+	int						i;
+	int						j;
+
+	if (hash_map->num_buckets == hash_map->bucket_capacity) {
+		headers = realloc(hash_map->buckets, hash_map->bucket_capacity * 2 * sizeof(ion_oafh_page_header_t));
+
+		if (NULL == headers) {
+			return err_ok;
+		}
+
+		hash_map->buckets			= headers;
+		hash_map->bucket_capacity	*= 2;
+	}
+
+	for (id = split; -1 != id; id = oafh_page_next(hash_map, id)) {
+		chain_length++;
+		num_records += oafh_page_header(hash_map, id)->count;
+	}
+
+	num_pages	= (num_records + hash_map->slots_per_page - 1) / hash_map->slots_per_page;
+	num_pages	= (num_pages < 1) ? 1 : num_pages;
+	chain		= malloc(chain_length * sizeof(int));
+	records		= malloc((num_records > 0) ? num_records * record_size : 1);
+	headers		= realloc(hash_map->overflow, (hash_map->num_overflow + num_pages) * sizeof(ion_oafh_page_header_t));
+
+	if (NULL != headers) {
+		hash_map->overflow = headers;
+	}
+
+	if ((NULL == chain) || (NULL == records) || (NULL == headers)) {
+		free(chain);
+		free(records);
+		return err_ok;
+	}
+
+	/* Records that stay are gathered from the front of the buffer, and those that move from the back */
+	for (i = 0, id = split; (err_ok == err) && (-1 != id); i++, id = oafh_page_next(hash_map, id)) {
+		chain[i] = id;
+
+		if (0 == oafh_page_header(hash_map, id)->count) {
+			continue;
+		}
+
+		err = oafh_page_load(hash_map, id);
+
+		for (j = 0; (err_ok == err) && (j < oafh_page_header(hash_map, id)->count); j++) {
+			ion_hash_bucket_t *item = oafh_page_slot(hash_map, j);
+
+			if (split == (int) (oafh_page_hash(hash_map, item->data) % (uint32_t) (hash_map->split_round * 2))) {
+				memcpy(records + (num_kept++) * record_size, item, record_size);
+			}
+			else {
+				memcpy(records + (num_records - ++num_moved) * record_size, item, record_size);
+			}
+		}
+	}
+
+	num_pages			= (num_moved + hash_map->slots_per_page - 1) / hash_map->slots_per_page;
+	num_pages			= (num_pages < 1) ? 1 : num_pages;
+	hash_map->page_id	= -1;
+
+	/* The pages of the new bucket are written from the last, so that none links to a page the file does not hold */
+	for (i = num_pages - 1; (err_ok == err) && (i >= 0); i--) {
+		ion_oafh_page_header_t	*header = (0 == i) ? &hash_map->buckets[added] : &hash_map->overflow[hash_map->num_overflow + i - 1];
+		ion_file_handle_t		file	= (0 == i) ? hash_map->file : hash_map->overflow_file;
+		ion_file_offset_t		offset	= (ion_file_offset_t) ((0 == i) ? added : hash_map->num_overflow + i - 1) * hash_map->page_size;
+
+		header->count		= (uint16_t) ((num_moved - i * hash_map->slots_per_page < hash_map->slots_per_page) ? num_moved - i * hash_map->slots_per_page : hash_map->slots_per_page);
+		header->next		= (i == num_pages - 1) ? 0 : (uint32_t) (hash_map->num_overflow + i + 1);
+		header->reserved	= 0;
+
+		memset(hash_map->page, 0, hash_map->page_size);
+		memcpy(hash_map->page, header, sizeof(ion_oafh_page_header_t));
+		memcpy(hash_map->page + sizeof(ion_oafh_page_header_t), records + (num_kept + i * hash_map->slots_per_page) * record_size, header->count * record_size);
+		err = ion_fwrite_at(file, offset, hash_map->page_size, hash_map->page);
+	}
+
+	if (err_ok == err) {
+		hash_map->num_overflow += num_pages - 1;
+	}
+
+	/* The pages of the bucket split keep their places, and those it no longer needs are left empty */
+	for (i = 0; (err_ok == err) && (i < chain_length); i++) {
+		ion_oafh_page_header_t	*header = oafh_page_header(hash_map, chain[i]);
+		int						count	= num_kept - i * hash_map->slots_per_page;
+		ion_file_offset_t		offset;
+		ion_file_handle_t		file	= oafh_page_file(hash_map, chain[i], &offset);
+
+		count = (count < 0) ? 0 : (count > hash_map->slots_per_page) ? hash_map->slots_per_page : count;
+
+		if ((0 == count) && (0 == header->count)) {
+			continue;
+		}
+
+		header->count = (uint16_t) count;
+		memcpy(hash_map->page, header, sizeof(ion_oafh_page_header_t));
+		memcpy(hash_map->page + sizeof(ion_oafh_page_header_t), records + i * hash_map->slots_per_page * record_size, count * record_size);
+		err = ion_fwrite_at(file, offset, hash_map->page_size, hash_map->page);
+	}
+
+	if (err_ok == err) {
+		hash_map->num_buckets++;
+
+		if (hash_map->num_buckets == hash_map->split_round * 2) {
+			hash_map->split_round *= 2;
+		}
+	}
+
+	free(chain);
+	free(records);
+
+	return err;
+}
+
+/**
+@brief		Inserts a record into a map with the paged layout.
+@see		oafh_insert
+*/
+static ion_status_t
+oafh_page_insert(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_oafh_page_header_t	*header;
+	ion_hash_bucket_t		*item;
+	ion_err_t				err;
+	int						page_id;
+	int						slot;
+	int						room;
+
+	err = oafh_page_find(hash_map, key, &page_id, &slot, &room);
+
+	if (err_ok == err) {
+		if (hash_map->write_concern == wc_insert_unique) {
+			return ION_STATUS_ERROR(err_duplicate_key);
+		}
+		else if (hash_map->write_concern != wc_update) {
+			return ION_STATUS_ERROR(err_write_concern);
+		}
+
+		memcpy(oafh_page_slot(hash_map, slot)->data + hash_map->super.record.key_size, value, hash_map->super.record.value_size);
+		err = oafh_page_write_slot(hash_map, slot);
+
+		return (err_ok == err) ? ION_STATUS_OK(1) : ION_STATUS_ERROR(err);
+	}
+
+	if (err_item_not_found != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	err = (-1 == room) ? oafh_page_extend(hash_map, page_id, &room) : err_ok;
+
+	if (err_ok == err) {
+		err = oafh_page_load(hash_map, room);
+	}
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	header			= oafh_page_header(hash_map, room);
+	item			= oafh_page_slot(hash_map, header->count);
+	item->status	= ION_IN_USE;
+	memcpy(item->data, key, hash_map->super.record.key_size);
+	memcpy(item->data + hash_map->super.record.key_size, value, hash_map->super.record.value_size);
+
+	/* The record is written before the count that takes it in */
+	err = oafh_page_write_slot(hash_map, header->count);
+
+	if (err_ok == err) {
+		header->count++;
+		err = oafh_page_write_header(hash_map, room);
+	}
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	hash_map->count++;
+
+	if ((hash_map->max_load > 0) && (hash_map->count * 100 > hash_map->num_buckets * hash_map->slots_per_page * hash_map->max_load)) {
+		return ION_STATUS_CREATE(oafh_page_split(hash_map), 1);
+	}
+
+	return ION_STATUS_OK(1);
+}
+
+/**
+@brief		Deletes a record from a map with the paged layout.
+
+@details	The last record of the page is moved into the freed slot, so
+			that the records of a page stay packed together.
+@see		oafh_delete
+*/
+static ion_status_t
+oafh_page_delete(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			key
+) {
+	int						record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	ion_oafh_page_header_t	*header;
+	ion_err_t				err;
+	int						page_id;
+	int						slot;
+	int						room;
+
+	err = oafh_page_find(hash_map, key, &page_id, &slot, &room);
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	header = oafh_page_header(hash_map, page_id);
+
+	if (slot != header->count - 1) {
+		memcpy(oafh_page_slot(hash_map, slot), oafh_page_slot(hash_map, header->count - 1), record_size);
+		err = oafh_page_write_slot(hash_map, slot);
+	}
+
+	if (err_ok == err) {
+		header->count--;
+		hash_map->count--;
+		err = oafh_page_write_header(hash_map, page_id);
+	}
+
+	return (err_ok == err) ? ION_STATUS_OK(1) : ION_STATUS_ERROR(err);
+}
+
+/**
+@brief		Looks up a record in a map with the paged layout.
+@see		oafh_query
+*/
+static ion_status_t
+oafh_page_query(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_err_t	err;
+	int			page_id;
+	int			slot;
+	int			room;
+
+	err = oafh_page_find(hash_map, key, &page_id, &slot, &room);
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	memcpy(value, oafh_page_slot(hash_map, slot)->data + hash_map->super.record.key_size, hash_map->super.record.value_size);
+
+	return ION_STATUS_OK(1);
+}
+
+/**
+@brief		Releases the memory held for the paged layout.
+*/
+static void
+oafh_page_free(
+	ion_file_hashmap_t *hash_map
+) {
+	free(hash_map->buckets);
+	free(hash_map->overflow);
+	free(hash_map->page);
+	hash_map->buckets		= NULL;
+	hash_map->overflow		= NULL;
+	hash_map->page			= NULL;
+	hash_map->num_overflow	= 0;
+	hash_map->page_id		= -1;
+}
+
+/**
+@brief		Sets up the paged layout for a map whose file is open, creating
+			the pages of its buckets if the file is new, and otherwise
+			reading their headers into memory.
+*/
+static ion_err_t
+oafh_page_initialize(
+	ion_file_hashmap_t	*hashmap,
+	ion_dictionary_id_t id,
+	ion_boolean_t		exists,
+	ion_boolean_t		mapped
+) {
+	int		record_size = SIZEOF(STATUS) + hashmap->super.record.key_size + hashmap->super.record.value_size;
+	char	overflow_filename[ION_MAX_FILENAME_LENGTH];
+	int		i;
+
+	hashmap->page_size = ION_OAFH_PAGE_SIZE;
+
+	if (hashmap->page_size < (int) sizeof(ion_oafh_page_header_t) + record_size) {
+		hashmap->page_size = sizeof(ion_oafh_page_header_t) + record_size;
+	}
+
+	hashmap->slots_per_page = (hashmap->page_size - sizeof(ion_oafh_page_header_t)) / record_size;
+	hashmap->num_buckets	= (hashmap->map_size + hashmap->slots_per_page - 1) / hashmap->slots_per_page;
+
+	if (hashmap->num_buckets < 1) {
+		hashmap->num_buckets = 1;
+	}
+
+	/* The map file ends at the last bucket split off, so its size is all there is to know of how far the map has grown */
+	if (exists && (ion_fend(hashmap->file) / hashmap->page_size > hashmap->num_buckets)) {
+		hashmap->num_buckets = ion_fend(hashmap->file) / hashmap->page_size;
+	}
+
+	hashmap->split_round = (hashmap->map_size + hashmap->slots_per_page - 1) / hashmap->slots_per_page;
+
+	if (hashmap->split_round < 1) {
+		hashmap->split_round = 1;
+	}
+
+	while (hashmap->split_round * 2 <= hashmap->num_buckets) {
+		hashmap->split_round *= 2;
+	}
+
+	if (dictionary_get_filename(id, "oao", overflow_filename) >= ION_MAX_FILENAME_LENGTH) {
+		return err_dictionary_initialization_failed;
+	}
+
+	hashmap->overflow_file = mapped ? ion_fopen_mapped(overflow_filename) : ion_fopen(overflow_filename);
+
+#if defined(ARDUINO)
+
+	if (NULL == hashmap->overflow_file.file) {
+#else
+
+	if (ION_NOFILE == hashmap->overflow_file) {
+#endif
+		return err_file_open_error;
+	}
+
+	hashmap->bucket_capacity	= hashmap->num_buckets;
+	hashmap->buckets			= calloc(hashmap->num_buckets, sizeof(ion_oafh_page_header_t));
+	hashmap->page		= calloc(hashmap->page_size, 1);
+	hashmap->overflow	= NULL;
+
+	if ((NULL == hashmap->buckets) || (NULL == hashmap->page)) {
+		oafh_page_free(hashmap);
+		ion_fclose(hashmap->overflow_file);
+		return err_out_of_memory;
+	}
+
+	if (exists) {
+		hashmap->num_overflow = ion_fend(hashmap->overflow_file) / hashmap->page_size;
+
+		if (hashmap->num_overflow > 0) {
+			hashmap->overflow = malloc(hashmap->num_overflow * sizeof(ion_oafh_page_header_t));
+		}
+
+		if ((hashmap->num_overflow > 0) && (NULL == hashmap->overflow)) {
+			oafh_page_free(hashmap);
+			ion_fclose(hashmap->overflow_file);
+			return err_out_of_memory;
+		}
+	}
+
+	/* A page of zeros is an empty one with nothing following it, so a new file only has to be made long enough */
+	if (!exists && (err_ok != ion_ftruncate(hashmap->file, (ion_file_offset_t) hashmap->num_buckets * hashmap->page_size))) {
+		oafh_page_free(hashmap);
+		ion_fclose(hashmap->overflow_file);
+		return err_file_write_error;
+	}
+
+	/* The headers kept in memory start out as those in the file, or for a new file, as the zeros they were allocated with */
+	for (i = 0; exists && i < hashmap->num_buckets + hashmap->num_overflow; i++) {
+		ion_file_offset_t	offset;
+		ion_file_handle_t	file	= oafh_page_file(hashmap, i, &offset);
+		ion_err_t			err		= ion_fread_at(file, offset, sizeof(ion_oafh_page_header_t), (ion_byte_t *) oafh_page_header(hashmap, i));
+
+		if (err_ok != err) {
+			oafh_page_free(hashmap);
+			ion_fclose(hashmap->overflow_file);
+			return err;
+		}
+
+		hashmap->count += oafh_page_header(hashmap, i)->count;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Replaces the legacy empty marker of every slot of a map file from
+			before @ref ION_OAFH_SLOT_FORMAT, and records the format after
+			the slots.
+
+@details	The format is only recorded once every slot has been converted,
+			so a conversion that is cut short is done again on the next open.
+			Converting slots that were already converted changes nothing.
+*/
+static ion_err_t
+oafh_slot_upgrade(
+	ion_file_hashmap_t *hashmap
+) {
+	int					record_size = SIZEOF(STATUS) + hashmap->super.record.key_size + hashmap->super.record.value_size;
+	int					per_read	= ION_OAFH_READ_BUFFER_SIZE / record_size;
+	int32_t				format		= ION_OAFH_SLOT_FORMAT;
+	ion_byte_t			*buckets;
+	ion_err_t			err			= err_ok;
+	int					start;
+	int					i;
+
+	if (per_read < 1) {
+		per_read = 1;
+	}
+
+	buckets = malloc(per_read * record_size);
+
+	if (NULL == buckets) {
+		return err_out_of_memory;
+	}
+
+	for (start = 0; (err_ok == err) && (start < hashmap->map_size); start += per_read) {
+		int					count	= (hashmap->map_size - start < per_read) ? hashmap->map_size - start : per_read;
+		ion_file_offset_t	offset	= (ion_file_offset_t) start * record_size;
+
+		err = ion_fread_at(hashmap->file, offset, count * record_size, buckets);
+
+		for (i = 0; (err_ok == err) && (i < count); i++) {
+			ion_hash_bucket_t *item = (ion_hash_bucket_t *) (buckets + i * record_size);
+
+			if (ION_OAFH_LEGACY_EMPTY == item->status) {
+				item->status = ION_EMPTY;
+			}
+		}
+
+		if (err_ok == err) {
+			err = ion_fwrite_at(hashmap->file, offset, count * record_size, buckets);
+		}
+	}
+
+	free(buckets);
+
+	if (err_ok == err) {
+		err = ion_fwrite_at(hashmap->file, (ion_file_offset_t) hashmap->map_size * record_size, sizeof(format), (ion_byte_t *) &format);
+	}
+
+	if (err_ok == err) {
+		err = ion_fflush(hashmap->file);
+	}
+
+	return err;
+}
+
+/**
+@brief		Sets up the slot layout for a map whose file is open, creating the
+			file if it is new, and otherwise checking its format.
+
+@return		The status of setting up the map, which is
+			@ref err_dictionary_initialization_failed for a file that is not
+			of a format this version reads.
+*/
+static ion_err_t
+oafh_slot_initialize(
+	ion_file_hashmap_t	*hashmap,
+	ion_boolean_t		exists
+) {
+	int					record_size = SIZEOF(STATUS) + hashmap->super.record.key_size + hashmap->super.record.value_size;
+	ion_file_offset_t	slots_end	= (ion_file_offset_t) hashmap->map_size * record_size;
+	int32_t				format		= ION_OAFH_SLOT_FORMAT;
+	ion_file_offset_t	end;
+
+	if (!exists) {
+		/* The empty slots are zeros, which the file reads as once it is made long enough */
+		if ((err_ok != ion_ftruncate(hashmap->file, slots_end + sizeof(format))) || (err_ok != ion_fwrite_at(hashmap->file, slots_end, sizeof(format), (ion_byte_t *) &format)) || (err_ok != ion_fflush(hashmap->file))) {
+			return err_file_write_error;
+		}
+
+		return err_ok;
+	}
+
+	end = ion_fend(hashmap->file);
+
+	/* Files from before the format was recorded end with their last slot */
+	if (end == slots_end) {
+		return oafh_slot_upgrade(hashmap);
+	}
+
+	if ((end != slots_end + (ion_file_offset_t) sizeof(format)) || (err_ok != ion_fread_at(hashmap->file, slots_end, sizeof(format), (ion_byte_t *) &format)) || (ION_OAFH_SLOT_FORMAT != format)) {
+		return err_dictionary_initialization_failed;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Orders a batch by the bucket each key hashes to.
+*/
+static int
+oafh_compare_location_order(
+	void	*context,
+	int		a,
+	int		b
+) {
+	int *locations = (int *) context;
+
+	return locations[a] - locations[b];
+}
+
+/**
+@brief		Looks up or inserts a batch of records in a map with the paged
+			layout.
+
+@details	The records are visited in order of their bucket, so that the
+			records of a bucket share the reads of its pages.
+*/
+static ion_status_t
+oafh_page_batch(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_records,
+	ion_boolean_t		insert
+) {
+	int			*order		= malloc(num_records * sizeof(int));
+	int			*buckets	= malloc(num_records * sizeof(int));
+	ion_err_t	err			= err_out_of_memory;
+	int			i;
+
+	if ((NULL != order) && (NULL != buckets)) {
+		for (i = 0; i < num_records; i++) {
+			buckets[i] = oafh_page_bucket(hash_map, (ion_byte_t *) keys + i * hash_map->super.record.key_size);
+		}
+
+		err = dictionary_sort_order(order, num_records, oafh_compare_location_order, buckets);
+	}
+
+	for (i = 0; (err_ok == err) && (i < num_records); i++) {
+		int			j		= order[i];
+		ion_byte_t	*key	= (ion_byte_t *) keys + j * hash_map->super.record.key_size;
+		ion_byte_t	*value	= (ion_byte_t *) values + j * hash_map->super.record.value_size;
+
+		statuses[j] = insert ? oafh_page_insert(hash_map, key, value) : oafh_page_query(hash_map, key, value);
+	}
+
+	free(order);
+	free(buckets);
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	return dictionary_batch_status(statuses, num_records);
+}
+
+ion_err_t
+oafh_flush(
+	ion_file_hashmap_t	*hash_map,
+	ion_boolean_t		sync
+) {
+	ion_err_t err = sync ? ion_fsync(hash_map->file) : ion_fflush(hash_map->file);
+
+	if ((err_ok == err) && (0 != hash_map->page_size)) {
+		err = sync ? ion_fsync(hash_map->overflow_file) : ion_fflush(hash_map->overflow_file);
+	}
+
+	return err;
+}
+
 ion_err_t
 oafh_close(
 	ion_file_hashmap_t *hash_map
 ) {
-	if (NULL != hash_map->file) {
+#if defined(ARDUINO)
+
+	if (NULL != hash_map->file.file) {
+#else
+
+	if (ION_NOFILE != hash_map->file) {
+#endif
 		/* check to ensure that you are not freeing something already free */
-		fclose(hash_map->file);
+		ion_fclose(hash_map->file);
+
+		if (0 != hash_map->page_size) {
+			ion_fclose(hash_map->overflow_file);
+			oafh_page_free(hash_map);
+		}
+
 		free(hash_map);
 		return err_ok;
 	}
@@ -40,7 +929,9 @@ oafh_initialize(
 	ion_key_size_t key_size,
 	ion_value_size_t value_size,
 	int size,
-	ion_dictionary_id_t id
+	ion_dictionary_id_t id,
+	ion_boolean_t mapped,
+	ion_boolean_t paged
 ) {
 	hashmap->write_concern				= wc_insert_unique;			/* By default allow unique inserts only */
 	hashmap->super.record.key_size		= key_size;
@@ -52,6 +943,21 @@ oafh_initialize(
 
 	hashmap->compute_hash				= (*hashing_function);	/* Allows for binding of different hash functions
 																depending on requirements */
+	hashmap->hash						= NULL;
+
+	hashmap->page_size					= 0;
+	hashmap->slots_per_page				= 1;
+	hashmap->num_buckets				= size;
+	hashmap->bucket_capacity			= 0;
+	hashmap->split_round				= size;
+	hashmap->count						= 0;
+	hashmap->max_load					= 0;
+	hashmap->buckets					= NULL;
+	hashmap->overflow					= NULL;
+	hashmap->num_overflow				= 0;
+	hashmap->overflow_file				= ION_NOFILE;
+	hashmap->page						= NULL;
+	hashmap->page_id					= -1;
 
 	char addr_filename[ION_MAX_FILENAME_LENGTH];
 
@@ -62,43 +968,38 @@ oafh_initialize(
 		return err_dictionary_initialization_failed;
 	}
 
-	hashmap->file = fopen(addr_filename, "r+b");
-
-	if (NULL != hashmap->file) {
-		return err_ok;
-	}
-
-	/* open the file */
-	hashmap->file = fopen(addr_filename, "w+b");
+	ion_boolean_t exists = ion_fexists(addr_filename);
 
-	ion_hash_bucket_t *file_record;
+	hashmap->file = mapped ? ion_fopen_mapped(addr_filename) : ion_fopen(addr_filename);
 
-	int record_size = SIZEOF(STATUS) + hashmap->super.record.key_size + hashmap->super.record.value_size;
+#if defined(ARDUINO)
 
-	file_record			= calloc(record_size, 1);
-	file_record->status = ION_EMPTY;
+	if (NULL == hashmap->file.file) {
+#else
 
-	/* write out the records to disk to prep */
-#if ION_DEBUG
-	printf("Initializing hash table\n");
+	if (ION_NOFILE == hashmap->file) {
 #endif
+		return err_file_open_error;
+	}
+
+	if (paged) {
+		ion_err_t err = oafh_page_initialize(hashmap, id, exists, mapped);
 
-	int i, writes = 0;
+		if (err_ok != err) {
+			ion_fclose(hashmap->file);
+			return err;
+		}
 
-	for (i = 0; i < hashmap->map_size; i++) {
-		writes	+= fwrite(&file_record->status, SIZEOF(STATUS), 1, hashmap->file);
-		writes	+= fwrite(file_record->data, record_size - SIZEOF(STATUS), 1, hashmap->file);
+		return err_ok;
 	}
 
-	fflush(hashmap->file);
+	ion_err_t err = oafh_slot_initialize(hashmap, exists);
 
-	if (writes / 2 != hashmap->map_size) {
-		fclose(hashmap->file);
-		return err_file_write_error;
+	if (err_ok != err) {
+		ion_fclose(hashmap->file);
+		return err;
 	}
 
-	free(file_record);
-
 	return err_ok;
 }
 
@@ -121,17 +1022,35 @@ oafh_destroy(
 
 	char addr_filename[ION_MAX_FILENAME_LENGTH];
 
+	if (0 != hash_map->page_size) {
+		if (dictionary_get_filename(hash_map->super.id, "oao", addr_filename) >= ION_MAX_FILENAME_LENGTH) {
+			return err_dictionary_destruction_error;
+		}
+
+		ion_fclose(hash_map->overflow_file);
+		fremove(addr_filename);
+		hash_map->overflow_file = ION_NOFILE;
+		hash_map->page_size		= 0;
+		oafh_page_free(hash_map);
+	}
+
 	int actual_filename_length = dictionary_get_filename(hash_map->super.id, "oaf", addr_filename);
 
 	if (actual_filename_length >= ION_MAX_FILENAME_LENGTH) {
 		return err_dictionary_destruction_error;
 	}
 
-	if (hash_map->file != NULL) {
+#if defined(ARDUINO)
+
+	if (NULL != hash_map->file.file) {
+#else
+
+	if (ION_NOFILE != hash_map->file) {
+#endif
 		/* check to ensure that you are not freeing something already free */
-		fclose(hash_map->file);
+		ion_fclose(hash_map->file);
 		fremove(addr_filename);
-		hash_map->file = NULL;
+		hash_map->file = ION_NOFILE;
 		return err_ok;
 	}
 	else {
@@ -162,6 +1081,10 @@ oafh_insert(
 	ion_key_t			key,
 	ion_value_t			value
 ) {
+	if (0 != hash_map->page_size) {
+		return oafh_page_insert(hash_map, key, value);
+	}
+
 	ion_hash_t hash = hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);	/* compute hash value for given key */
 
 	int loc			= oafh_get_location(hash, hash_map->map_size);
@@ -176,12 +1099,12 @@ oafh_insert(
 	item = malloc(record_size);
 
 	/* set file position */
-	fseek(hash_map->file, loc * record_size, SEEK_SET);
+	ion_fseek(hash_map->file, loc * record_size, ION_FILE_START);
 
 	while (count != hash_map->map_size) {
-		fread(item, record_size, 1, hash_map->file);
+		ion_fread(hash_map->file, record_size, (ion_byte_t *) item);
 #if ION_DEBUG
-		DUMP((int) ftell(hash_map->file), "%i");
+		DUMP((int) ion_ftell(hash_map->file), "%i");
 #endif
 
 		if (item->status == ION_IN_USE) {
@@ -196,12 +1119,12 @@ oafh_insert(
 				else if (hash_map->write_concern == wc_update) {
 					/* allows for values to be updated											// */
 					/* backup and write */
-					fseek(hash_map->file, SIZEOF(STATUS) + hash_map->super.record.key_size - record_size, SEEK_CUR);
+					ion_fseek(hash_map->file, SIZEOF(STATUS) + hash_map->super.record.key_size - record_size, ION_FILE_CURRENT);
 #if ION_DEBUG
-					DUMP((int) ftell(hash_map->file), "%i");
+					DUMP((int) ion_ftell(hash_map->file), "%i");
 					DUMP(value, "%s");
 #endif
-					fwrite(value, hash_map->super.record.value_size, 1, hash_map->file);
+					ion_fwrite(hash_map->file, hash_map->super.record.value_size, value);
 					free(item);
 					return ION_STATUS_OK(1);
 				}
@@ -214,14 +1137,14 @@ oafh_insert(
 		else if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
 			/* problem is here with base types as it is just an array of data.  Need better way */
 			/* printf("empty\n"); */
-			fseek(hash_map->file, -record_size, SEEK_CUR);
+			ion_fseek(hash_map->file, -record_size, ION_FILE_CURRENT);
 #if ION_DEBUG
-			DUMP((int) ftell(hash_map->file), "%i");
+			DUMP((int) ion_ftell(hash_map->file), "%i");
 #endif
 			item->status = ION_IN_USE;
 			memcpy(item->data, key, (hash_map->super.record.key_size));
 			memcpy(item->data + hash_map->super.record.key_size, value, (hash_map->super.record.value_size));
-			fwrite(item, record_size, 1, hash_map->file);
+			ion_fwrite(hash_map->file, record_size, (ion_byte_t *) item);
 			free(item);
 
 			return ION_STATUS_OK(1);
@@ -233,7 +1156,7 @@ oafh_insert(
 			/* Perform wrapping */
 			loc = 0;
 			/* rewind the file */
-			frewind(hash_map->file);
+			ion_fseek(hash_map->file, 0, ION_FILE_START);
 		}
 
 #if ION_DEBUG
@@ -255,6 +1178,19 @@ oafh_find_item_loc(
 	ion_key_t			key,
 	int					*location
 ) {
+	if (0 != hash_map->page_size) {
+		int			page_id;
+		int			slot;
+		int			room;
+		ion_err_t	err = oafh_page_find(hash_map, key, &page_id, &slot, &room);
+
+		if (err_ok == err) {
+			*location = page_id * hash_map->slots_per_page + slot;
+		}
+
+		return err;
+	}
+
 	ion_hash_t hash = hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);
 	/* compute hash value for given key */
 
@@ -270,12 +1206,11 @@ oafh_find_item_loc(
 	item = malloc(record_size);
 
 	/* set file position */
-	fseek(hash_map->file, loc * record_size, SEEK_SET);
+	ion_fseek(hash_map->file, loc * record_size, ION_FILE_START);
 
 	/* needs to traverse file again */
 	while (count != hash_map->map_size) {
-		fread(&item->status, SIZEOF(STATUS), 1, hash_map->file);
-		fread(item->data, record_size - SIZEOF(STATUS), 1, hash_map->file);
+		ion_fread(hash_map->file, record_size, (ion_byte_t *) item);
 
 		if (item->status == ION_EMPTY) {
 			free(item);
@@ -301,7 +1236,7 @@ oafh_find_item_loc(
 			if (loc >= hash_map->map_size) {
 				/* Perform wrapping */
 				loc = 0;
-				frewind(hash_map->file);
+				ion_fseek(hash_map->file, 0, ION_FILE_START);
 			}
 		}
 	}
@@ -310,6 +1245,112 @@ oafh_find_item_loc(
 	return err_item_not_found;	/* key have not been found */
 }
 
+int
+oafh_location_count(
+	ion_file_hashmap_t *hash_map
+) {
+	return (hash_map->num_buckets + hash_map->num_overflow) * hash_map->slots_per_page;
+}
+
+ion_err_t
+oafh_page_record(
+	ion_file_hashmap_t	*hash_map,
+	int					location,
+	ion_hash_bucket_t	**item
+) {
+	int			page_id = location / hash_map->slots_per_page;
+	int			slot	= location % hash_map->slots_per_page;
+	ion_err_t	err;
+
+	*item = NULL;
+
+	if (slot >= oafh_page_header(hash_map, page_id)->count) {
+		return err_ok;
+	}
+
+	err = oafh_page_load(hash_map, page_id);
+
+	if (err_ok == err) {
+		*item = oafh_page_slot(hash_map, slot);
+	}
+
+	return err;
+}
+
+/**
+@brief		Empties the slot at @p loc, moving back any records after it
+			that would otherwise no longer be found.
+
+@details	This is backward shift deletion. The records following the hole
+			up to the next empty slot are read in turn, and each one whose
+			home slot is not between the hole and itself is written into
+			the hole, which then moves to where that record was. No deleted
+			marker is left behind, so probes still stop at the first empty
+			slot however many records have been deleted. Markers left in
+			the file by earlier versions are passed over.
+*/
+static ion_err_t
+oafh_shift_back(
+	ion_file_hashmap_t	*hash_map,
+	int					loc
+) {
+	int					record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	int					hole		= loc;
+	int					count;
+	ion_hash_bucket_t	*item;
+	ion_key_t			key;
+	ion_err_t			err			= err_ok;
+
+	item	= malloc(record_size);
+	key		= malloc(hash_map->super.record.key_size);
+
+	if ((NULL == item) || (NULL == key)) {
+		free(item);
+		free(key);
+		return err_out_of_memory;
+	}
+
+	for (count = 1; (err_ok == err) && (count < hash_map->map_size); count++) {
+		int home;
+
+		loc++;
+
+		if (loc >= hash_map->map_size) {
+			loc = 0;
+		}
+
+		err = ion_fread_at(hash_map->file, (ion_file_offset_t) loc * record_size, record_size, (ion_byte_t *) item);
+
+		if ((err_ok != err) || (item->status == ION_EMPTY)) {
+			break;
+		}
+
+		if (item->status != ION_IN_USE) {
+			continue;
+		}
+
+		/* The key is one byte into the record, so it is hashed from an aligned copy */
+		memcpy(key, item->data, hash_map->super.record.key_size);
+		home = oafh_get_location(hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size), hash_map->map_size);
+
+		/* A record whose home is in (hole, loc] is still reached from there */
+		if ((hole <= loc) ? ((home <= hole) || (home > loc)) : ((home <= hole) && (home > loc))) {
+			err		= ion_fwrite_at(hash_map->file, (ion_file_offset_t) hole * record_size, record_size, (ion_byte_t *) item);
+			hole	= loc;
+		}
+	}
+
+	if (err_ok == err) {
+		memset(item, 0, record_size);
+		item->status	= ION_EMPTY;
+		err				= ion_fwrite_at(hash_map->file, (ion_file_offset_t) hole * record_size, record_size, (ion_byte_t *) item);
+	}
+
+	free(item);
+	free(key);
+	return err;
+}
+
 ion_status_t
 oafh_delete(
 	ion_file_hashmap_t	*hash_map,
@@ -317,6 +1358,10 @@ oafh_delete(
 ) {
 	int loc;
 
+	if (0 != hash_map->page_size) {
+		return oafh_page_delete(hash_map, key);
+	}
+
 	if (oafh_find_item_loc(hash_map, key, &loc) == err_item_not_found) {
 #if ION_DEBUG
 		printf("Item not found when trying to oah_delete.\n");
@@ -324,27 +1369,12 @@ oafh_delete(
 		return ION_STATUS_ERROR(err_item_not_found);
 	}
 	else {
-		/* locate item */
-		ion_hash_bucket_t *item;
+		ion_err_t err = oafh_shift_back(hash_map, loc);
 
-		int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
-
-		item = malloc(record_size);
-
-		/* set file position */
-		fseek(hash_map->file, loc * record_size, SEEK_SET);
-
-		fread(&item->status, SIZEOF(STATUS), 1, hash_map->file);
-		fread(item->data, record_size - SIZEOF(STATUS), 1, hash_map->file);
-
-		item->status = ION_DELETED;	/* delete item */
-
-		/* backup */
-		fseek(hash_map->file, -record_size, SEEK_CUR);
-		fwrite(&item->status, SIZEOF(STATUS), 1, hash_map->file);
-		fwrite(item->data, record_size - SIZEOF(STATUS), 1, hash_map->file);
+		if (err_ok != err) {
+			return ION_STATUS_ERROR(err);
+		}
 
-		free(item);
 #if ION_DEBUG
 		printf("Item deleted at location %d\n", loc);
 #endif
@@ -360,6 +1390,10 @@ oafh_query(
 ) {
 	int loc;
 
+	if (0 != hash_map->page_size) {
+		return oafh_page_query(hash_map, key, value);
+	}
+
 	if (oafh_find_item_loc(hash_map, key, &loc) == err_ok) {
 #if ION_DEBUG
 		printf("Item found at location %d\n", loc);
@@ -368,11 +1402,11 @@ oafh_query(
 		int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
 
 		/* set file position */
-		fseek(hash_map->file, (loc * record_size) + SIZEOF(STATUS) + hash_map->super.record.key_size, SEEK_SET);
+		ion_fseek(hash_map->file, (loc * record_size) + SIZEOF(STATUS) + hash_map->super.record.key_size, ION_FILE_START);
 #if ION_DEBUG
 		printf("seeking %i\n", (loc * record_size) + SIZEOF(STATUS) + hash_map->super.record.key_size);
 #endif
-		fread(value, hash_map->super.record.value_size, 1, hash_map->file);
+		ion_fread(hash_map->file, hash_map->super.record.value_size, value);
 
 		return ION_STATUS_OK(1);
 	}
@@ -385,6 +1419,320 @@ oafh_query(
 	}
 }
 
+/**
+@brief		A run of consecutive buckets held in memory by a batched
+			operation.
+*/
+typedef struct {
+	ion_byte_t		*buckets;	/**< The buckets, back to back. */
+	int				size;		/**< Room in @p buckets, in buckets. */
+	int				start;		/**< Index of the first bucket held. */
+	int				count;		/**< Number of buckets held. */
+	ion_boolean_t	dirty;		/**< Whether the buckets have been changed since they were read. */
+} ion_oafh_window_t;
+
+/**
+@brief		Allocates a window of @ref ION_OAFH_READ_BUFFER_SIZE bytes of
+			buckets, and the position and bucket arrays for a batch.
+
+@details	The positions in @p order are sorted by the bucket each key
+			hashes to, which is stored in @p locations.
+*/
+static ion_err_t
+oafh_batch_begin(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			keys,
+	int					num_keys,
+	ion_oafh_window_t	*window,
+	int					**order,
+	int					**locations
+) {
+	int			record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	ion_err_t	err;
+	int			i;
+
+	window->size	= ION_OAFH_READ_BUFFER_SIZE / record_size;
+	window->start	= 0;
+	window->count	= 0;
+	window->dirty	= boolean_false;
+
+	if (window->size < 1) {
+		window->size = 1;
+	}
+
+	if (window->size > hash_map->map_size) {
+		window->size = hash_map->map_size;
+	}
+
+	*order				= malloc(num_keys * sizeof(int));
+	*locations			= malloc(num_keys * sizeof(int));
+	window->buckets		= malloc(window->size * record_size);
+
+	if ((NULL == *order) || (NULL == *locations) || (NULL == window->buckets)) {
+		err = err_out_of_memory;
+	}
+	else {
+		for (i = 0; i < num_keys; i++) {
+			ion_key_t key = (ion_byte_t *) keys + i * hash_map->super.record.key_size;
+
+			(*locations)[i] = oafh_get_location(hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size), hash_map->map_size);
+		}
+
+		err = dictionary_sort_order(*order, num_keys, oafh_compare_location_order, *locations);
+	}
+
+	if (err_ok != err) {
+		free(*order);
+		free(*locations);
+		free(window->buckets);
+	}
+
+	return err;
+}
+
+/**
+@brief		Writes the buckets held by a window back to the file, if they
+			have been changed.
+*/
+static ion_err_t
+oafh_window_flush(
+	ion_file_hashmap_t	*hash_map,
+	ion_oafh_window_t	*window
+) {
+	int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+
+	if (!window->dirty) {
+		return err_ok;
+	}
+
+	if (err_ok != ion_fseek(hash_map->file, window->start * record_size, ION_FILE_START)) {
+		return err_file_bad_seek;
+	}
+
+	if (err_ok != ion_fwrite(hash_map->file, window->count * record_size, window->buckets)) {
+		return err_file_write_error;
+	}
+
+	window->dirty = boolean_false;
+
+	return err_ok;
+}
+
+/**
+@brief		Returns the bucket at @p loc, moving the window to hold it if
+			it does not already.
+
+@details	A moved window holds the buckets from @p loc on, stopping at
+			the end of the map. Changed buckets are written back before
+			the window moves.
+*/
+static ion_err_t
+oafh_window_bucket(
+	ion_file_hashmap_t	*hash_map,
+	ion_oafh_window_t	*window,
+	int					loc,
+	ion_hash_bucket_t	**item
+) {
+	int			record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	ion_err_t	err;
+
+	if ((loc < window->start) || (loc >= window->start + window->count)) {
+		err = oafh_window_flush(hash_map, window);
+
+		if (err_ok != err) {
+			return err;
+		}
+
+		window->start	= loc;
+		window->count	= hash_map->map_size - loc;
+
+		if (window->count > window->size) {
+			window->count = window->size;
+		}
+
+		if (err_ok != ion_fseek(hash_map->file, window->start * record_size, ION_FILE_START)) {
+			window->count = 0;
+			return err_file_bad_seek;
+		}
+
+		if (err_ok != ion_fread(hash_map->file, window->count * record_size, window->buckets)) {
+			window->count = 0;
+			return err_file_read_error;
+		}
+	}
+
+	*item = (ion_hash_bucket_t *) (window->buckets + (loc - window->start) * record_size);
+
+	return err_ok;
+}
+
+ion_status_t
+oafh_multi_query(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_keys
+) {
+	ion_oafh_window_t	window;
+	int					*order;
+	int					*locations;
+	ion_err_t			err;
+	int					i;
+
+	if (0 != hash_map->page_size) {
+		return oafh_page_batch(hash_map, keys, values, statuses, num_keys, boolean_false);
+	}
+
+	err = oafh_batch_begin(hash_map, keys, num_keys, &window, &order, &locations);
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	for (i = 0; (err_ok == err) && (i < num_keys); i++) {
+		int		j		= order[i];
+		int		loc		= locations[j];
+		int		count	= 0;
+		void	*key	= (ion_byte_t *) keys + j * hash_map->super.record.key_size;
+
+		statuses[j] = ION_STATUS_ERROR(err_item_not_found);
+
+		while (count != hash_map->map_size) {
+			ion_hash_bucket_t *item;
+
+			err = oafh_window_bucket(hash_map, &window, loc, &item);
+
+			if (err_ok != err) {
+				break;
+			}
+
+			if (item->status == ION_EMPTY) {
+				break;
+			}
+
+			if ((item->status != ION_DELETED) && (ION_IS_EQUAL == hash_map->super.compare(item->data, key, hash_map->super.record.key_size))) {
+				memcpy((ion_byte_t *) values + j * hash_map->super.record.value_size, item->data + hash_map->super.record.key_size, hash_map->super.record.value_size);
+				statuses[j] = ION_STATUS_OK(1);
+				break;
+			}
+
+			loc++;
+			count++;
+
+			if (loc >= hash_map->map_size) {
+				/* Perform wrapping */
+				loc = 0;
+			}
+		}
+	}
+
+	free(order);
+	free(locations);
+	free(window.buckets);
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	return dictionary_batch_status(statuses, num_keys);
+}
+
+ion_status_t
+oafh_insert_batch(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_records
+) {
+	ion_oafh_window_t	window;
+	int					*order;
+	int					*locations;
+	ion_err_t			err;
+	int					i;
+
+	if (0 != hash_map->page_size) {
+		return oafh_page_batch(hash_map, keys, values, statuses, num_records, boolean_true);
+	}
+
+	err = oafh_batch_begin(hash_map, keys, num_records, &window, &order, &locations);
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	for (i = 0; i < num_records; i++) {
+		statuses[order[i]] = ION_STATUS_ERROR(err_max_capacity);
+	}
+
+	for (i = 0; (err_ok == err) && (i < num_records); i++) {
+		int			j		= order[i];
+		int			loc		= locations[j];
+		int			count	= 0;
+		ion_byte_t	*key	= (ion_byte_t *) keys + j * hash_map->super.record.key_size;
+		ion_byte_t	*value	= (ion_byte_t *) values + j * hash_map->super.record.value_size;
+
+		while (count != hash_map->map_size) {
+			ion_hash_bucket_t *item;
+
+			err = oafh_window_bucket(hash_map, &window, loc, &item);
+
+			if (err_ok != err) {
+				break;
+			}
+
+			if (item->status == ION_IN_USE) {
+				if (hash_map->super.compare(item->data, key, hash_map->super.record.key_size) == ION_IS_EQUAL) {
+					if (hash_map->write_concern == wc_insert_unique) {
+						statuses[j] = ION_STATUS_ERROR(err_duplicate_key);
+					}
+					else if (hash_map->write_concern == wc_update) {
+						memcpy(item->data + hash_map->super.record.key_size, value, hash_map->super.record.value_size);
+						window.dirty	= boolean_true;
+						statuses[j]		= ION_STATUS_OK(1);
+					}
+					else {
+						statuses[j] = ION_STATUS_ERROR(err_write_concern);
+					}
+
+					break;
+				}
+			}
+			else if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
+				item->status = ION_IN_USE;
+				memcpy(item->data, key, hash_map->super.record.key_size);
+				memcpy(item->data + hash_map->super.record.key_size, value, hash_map->super.record.value_size);
+				window.dirty	= boolean_true;
+				statuses[j]		= ION_STATUS_OK(1);
+				break;
+			}
+
+			loc++;
+			count++;
+
+			if (loc >= hash_map->map_size) {
+				/* Perform wrapping */
+				loc = 0;
+			}
+		}
+	}
+
+	if (err_ok == err) {
+		err = oafh_window_flush(hash_map, &window);
+	}
+
+	free(order);
+	free(locations);
+	free(window.buckets);
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err);
+	}
+
+	return dictionary_batch_status(statuses, num_records);
+}
+
 ion_hash_t
 oafh_compute_simple_hash(
 	ion_file_hashmap_t	*hashmap,
@@ -398,3 +1746,12 @@ oafh_compute_simple_hash(
 
 	return hash;
 }
+
+ion_hash_t
+oafh_compute_dictionary_hash(
+	ion_file_hashmap_t	*hashmap,
+	ion_key_t			key,
+	int					size_of_key
+) {
+	return (ion_hash_t) (hashmap->hash(key, size_of_key) % (uint32_t) hashmap->map_size);
+}
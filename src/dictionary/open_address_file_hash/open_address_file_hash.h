@@ -21,15 +21,79 @@ extern "C" {
 #include "open_address_file_hash_dictionary.h"
 
 #include "../../key_value/kv_system.h"
+#include "../../file/ion_file.h"
 
 /*edefines file operations for arduino */
 #include "./../../file/SD_stdio_c_iface.h"
 
-#define ION_EMPTY	-1
+/* A slot of zeros is empty, so that a new file needs nothing written to it */
+#define ION_EMPTY	0
 #define ION_DELETED -2
 #define ION_IN_USE	-3
 #define SIZEOF(STATUS) 1
 
+/**
+@brief		Format of a map file with the slot layout, kept in a word after its
+			last slot. Files from before the format was recorded have no such
+			word, and mark an empty slot with @ref ION_OAFH_LEGACY_EMPTY. They
+			are converted to the current format when opened.
+*/
+#define ION_OAFH_SLOT_FORMAT	1
+
+/**
+@brief		The status of an empty slot in a map file from before
+			@ref ION_OAFH_SLOT_FORMAT.
+*/
+#define ION_OAFH_LEGACY_EMPTY	-1
+
+/**
+@brief		Bytes of buckets held in memory at a time by @ref oafh_multi_query
+			and @ref oafh_insert_batch.
+*/
+#if !defined(ION_OAFH_READ_BUFFER_SIZE)
+#if defined(ARDUINO)
+#define ION_OAFH_READ_BUFFER_SIZE 128
+#else
+#define ION_OAFH_READ_BUFFER_SIZE 4096
+#endif
+#endif
+
+/**
+@brief		Bytes in a page of a map with the paged layout. A page holds as
+			many records as fit after its header, and is made larger if not
+			even one does.
+*/
+#if !defined(ION_OAFH_PAGE_SIZE)
+#if defined(ARDUINO)
+#define ION_OAFH_PAGE_SIZE 512
+#else
+#define ION_OAFH_PAGE_SIZE 4096
+#endif
+#endif
+
+/**
+@brief		The percentage of the slots of a map with the paged layout which
+			may hold records before the map grows by a bucket, as set for
+			the dictionaries made by @ref oafdict_create_paged_dictionary.
+*/
+#if !defined(ION_OAFH_MAX_LOAD_PERCENT)
+#define ION_OAFH_MAX_LOAD_PERCENT 80
+#endif
+
+/**
+@brief		The header at the start of each page of a map with the paged
+			layout.
+@details	The records of a page are packed into its first @p count slots.
+			A bucket is a page of the map file, followed by a chain of pages
+			in the overflow file when it holds more records than fit in one.
+*/
+typedef struct {
+	uint32_t	next;		/**< One more than the index of the overflow page
+								 that follows, or 0 if none does */
+	uint16_t	count;		/**< Records in the page */
+	uint16_t	reserved;	/**< Zero */
+} ion_oafh_page_header_t;
+
 /**
 @brief		Prototype declaration for hashmap
 */
@@ -52,7 +116,36 @@ struct file_hashmap {
 
 	/**< The hashing function to be used for
 		 the instance*/
-	FILE *file;	/**< file pointer */
+	ion_file_handle_t		file;	/**< file handle */
+	ion_dictionary_hash_t	hash;	/**< Key hash used by
+										 @ref oafh_compute_dictionary_hash */
+	int						page_size;	/**< Bytes in a page with the paged
+											 layout, or 0 with one record per
+											 bucket */
+	int						slots_per_page;	/**< Records that fit in a page */
+	int						num_buckets;	/**< Pages in the map file, one for
+											 each bucket */
+	int						bucket_capacity;	/**< Room in @p buckets */
+	int						split_round;	/**< Buckets at the start of the
+											 current round of splits. Those
+											 below @p num_buckets less this
+											 have been split in the round */
+	int						count;		/**< Records held by a map with the
+										 paged layout */
+	int						max_load;	/**< Percentage of the slots of a map
+										 with the paged layout that may hold
+										 records before it grows, or 0 to keep
+										 a fixed number of buckets */
+	ion_oafh_page_header_t	*buckets;	/**< The header of the page of each
+										 bucket, kept in memory so that pages
+										 with no records are never read */
+	ion_oafh_page_header_t	*overflow;	/**< The header of each overflow page */
+	int						num_overflow;	/**< Pages in the overflow file */
+	ion_file_handle_t		overflow_file;	/**< The file holding the pages of
+											 buckets that have outgrown one */
+	ion_byte_t				*page;		/**< The page last read */
+	int						page_id;	/**< The page held by @p page, as
+										 numbered for locations, or -1 */
 };
 
 /**
@@ -70,6 +163,22 @@ oafh_open(
 	ion_file_hashmap_t				*hash_map
 );
 
+/**
+@brief		This function writes out what is buffered for a hashmap
+			dictionary.
+
+@param		hash_map
+				Pointer to the hashmap instance to flush.
+@param		sync
+				Whether to also wait until it is on the storage device.
+@return		The status describing the result of the flush.
+ */
+ion_err_t
+oafh_flush(
+	ion_file_hashmap_t	*hash_map,
+	ion_boolean_t		sync
+);
+
 /**
 @brief		This function closes a hashmap dictionary.
 
@@ -84,6 +193,10 @@ oafh_close(
 
 /**
 @brief		This function initializes an open address in memory hash map.
+@details	A new map file is only extended to its full size, since a
+			region of zeros reads as empty slots or pages. Where the file
+			system supports sparse files, creating a large map is then
+			close to instant and takes no space until records are written.
 
 @param		hashmap
 				Pointer to the hashmap instance to initialize.
@@ -100,6 +213,21 @@ oafh_close(
 				(@p key_size + @p value_size + @c 1)
 @param		id
 				The id of hashmap.
+@param		mapped
+				Whether the file is accessed through a memory mapping
+				(see @ref ion_fopen_mapped) rather than a stdio stream.
+@param		paged
+				Whether to use the paged layout, in which each bucket is a
+				page of @ref ION_OAFH_PAGE_SIZE bytes holding many records.
+				A lookup then reads one page rather than one record per
+				probe, and a full bucket grows a chain of overflow pages
+				instead of spilling into its neighbours. @p size is then the
+				number of records the map is expected to hold, from which
+				the number of buckets is worked out. The map keeps that
+				many buckets unless @p max_load is set afterwards; it then
+				grows by splitting one bucket at a time whenever more than
+				@p max_load percent of its slots hold records. It is
+				reopened at the size it had grown to.
 @return		The status describing the result of the initialization.
 */
 ion_err_t
@@ -110,7 +238,9 @@ oafh_initialize(
 	ion_key_size_t key_size,
 	ion_value_size_t value_size,
 	int size,
-	ion_dictionary_id_t id
+	ion_dictionary_id_t id,
+	ion_boolean_t mapped,
+	ion_boolean_t paged
 );
 
 /**
@@ -153,6 +283,41 @@ oafh_insert(
 	ion_value_t			value
 );
 
+/**
+@brief		Insert a batch of records into hashmap
+
+@details	The records are placed in order of the bucket each key hashes
+			to. Buckets are read @ref ION_OAFH_READ_BUFFER_SIZE bytes at a
+			time and changed in memory, and each stretch is written back
+			once when the batch moves past it, instead of once per record.
+			Records whose keys hash to the same bucket are placed in batch
+			order, so the outcome for each record is the same as for
+			@ref oafh_insert. If a file operation fails, the batch may have
+			been partly applied. With the paged layout, the records are
+			inserted one by one in order of their bucket, so that each page
+			is read once for the batch.
+
+@param		hash_map
+				The map into which the data is going to be inserted.
+@param		keys
+				@p num_records keys, packed back to back.
+@param		values
+				@p num_records values, packed back to back.
+@param		statuses
+				The status of each record's insert.
+@param		num_records
+				The number of records.
+@return		The combined status of the inserts.
+*/
+ion_status_t
+oafh_insert_batch(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_records
+);
+
 /**
 @brief		Updates a value in the map.
 
@@ -195,7 +360,9 @@ oafh_get_location(
 /**
 @brief	  Locates item in map.
 
-@details	Based on a key, function locates the record in the map.
+@details	Based on a key, function locates the record in the map. With
+			the paged layout, a location is a slot numbered across the
+			pages of the map file and then those of the overflow file.
 
 @param		hash_map
 				The map into which the data is going to be inserted.
@@ -212,11 +379,45 @@ oafh_find_item_loc(
 	int					*location
 );
 
+/**
+@brief		Gives the number of locations in the map.
+
+@param		hash_map
+				The map to measure.
+@return		One more than the last location a record may be at.
+*/
+int
+oafh_location_count(
+	ion_file_hashmap_t *hash_map
+);
+
+/**
+@brief		Reads the record at a location of a map with the paged layout.
+
+@param		hash_map
+				The map to read.
+@param		location
+				The location to read, less than @ref oafh_location_count.
+@param		item
+				Set to the record, which stays valid until the next call on
+				the map, or to NULL if the slot is not in use.
+@return		The status of reading the page holding the location.
+*/
+ion_err_t
+oafh_page_record(
+	ion_file_hashmap_t	*hash_map,
+	int					location,
+	ion_hash_bucket_t	**item
+);
+
 /**
 @brief		Deletes item from map.
 
 @details	Deletes item from map based on key.  If key does not exist
-			error is returned
+			error is returned. In the slot layout, records following the
+			deleted one may be moved back into its slot, so that no deleted
+			marker is needed to keep them reachable. A cursor open across a
+			delete may therefore miss or repeat a record.
 
 @param		hash_map
 				The map into which the data is going to be inserted.
@@ -251,6 +452,37 @@ oafh_query(
 	ion_value_t			value
 );
 
+/**
+@brief		Locates the records for a batch of keys.
+
+@details	The keys are visited in order of the bucket they hash to, and
+			buckets are read @ref ION_OAFH_READ_BUFFER_SIZE bytes at a
+			time, so each stretch of the file is read once for the whole
+			batch instead of once per key. With the paged layout, the keys
+			are looked up one by one in order of their bucket, which has the
+			same effect.
+
+@param		hash_map
+				The map to search.
+@param		keys
+				@p num_keys keys, packed back to back.
+@param		values
+				Room for @p num_keys values, packed back to back.
+@param		statuses
+				The status of each key's lookup.
+@param		num_keys
+				The number of keys.
+@return		The combined status of the lookups.
+*/
+ion_status_t
+oafh_multi_query(
+	ion_file_hashmap_t	*hash_map,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_keys
+);
+
 /**
 @brief		A simple hashing algorithm implementation.
 
@@ -269,6 +501,27 @@ oafh_compute_simple_hash(
 	int					size_of_key
 );
 
+/**
+@brief		Hashes a key with the key hash bound to the map.
+
+@details	The key is hashed by @p hash of the map, as picked by
+			@ref dictionary_switch_hash, and reduced to the map size.
+
+@param		hashmap
+				The hash function is associated with.
+@param		key
+				The original key value to find hash value for.
+@param		size_of_key
+				The size of the key in bytes.
+@return		The hashed value for the key.
+*/
+ion_hash_t
+oafh_compute_dictionary_hash(
+	ion_file_hashmap_t	*hashmap,
+	ion_key_t			key,
+	int					size_of_key
+);
+
 /*void
 static_hash_init(ion_dictonary_handler_t * client);*/
 
@@ -44,12 +44,105 @@ oafdict_query(
 	return oafh_query((ion_file_hashmap_t *) dictionary->instance, key, value);
 }
 
+/**
+@brief		Inserts a batch of records into the dictionary instance.
+
+@param	  dictionary
+				The instance of the dictionary to insert into.
+@param	  keys
+				The keys to insert, packed back to back.
+@param	  values
+				The value for each key, packed back to back.
+@param	  statuses
+				The status of each record's insert.
+@param	  num_records
+				The number of records.
+@return		The combined status of the inserts.
+*/
+ion_status_t
+oafdict_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_records
+) {
+	return oafh_insert_batch((ion_file_hashmap_t *) dictionary->instance, keys, values, statuses, num_records);
+}
+
+/**
+@brief		Queries a dictionary instance for a batch of keys.
+
+@param	  dictionary
+				The instance of the dictionary to query.
+@param	  keys
+				The keys to search for, packed back to back.
+@param	  values
+				Room for the value of each key, packed back to back.
+@param	  statuses
+				The status of each key's query.
+@param	  num_keys
+				The number of keys.
+@return		The combined status of the queries.
+*/
+ion_status_t
+oafdict_multi_get(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			keys,
+	ion_value_t			values,
+	ion_status_t		*statuses,
+	int					num_keys
+) {
+	return oafh_multi_query((ion_file_hashmap_t *) dictionary->instance, keys, values, statuses, num_keys);
+}
+
+/**
+@brief			Scans a map with the paged layout for the next record that
+				satisfies the predicate of the cursor.
+
+@details		Slots past the records of a page are passed over without
+				reading it. A key is in one slot of the pages of its bucket,
+				so an equality cursor has no more results after its match.
+
+@param			cursor
+					A pointer to the cursor that is operating on the map.
+
+@return			The status of the scan.
+*/
+static ion_err_t
+oafdict_page_scan(
+	ion_oafdict_cursor_t *cursor
+) {
+	ion_file_hashmap_t	*hash_map = (ion_file_hashmap_t *) (cursor->super.dictionary->instance);
+	ion_hash_bucket_t	*item;
+	int					loc;
+
+	if (predicate_equality == cursor->super.predicate->type) {
+		return cs_end_of_results;
+	}
+
+	for (loc = cursor->current + 1; loc < oafh_location_count(hash_map); loc++) {
+		if (err_ok != oafh_page_record(hash_map, loc, &item)) {
+			break;
+		}
+
+		if ((NULL != item) && test_predicate(&(cursor->super), item->data)) {
+			cursor->current = loc;
+			return cs_valid_data;
+		}
+	}
+
+	return cs_end_of_results;
+}
+
 /**
 @brief			Starts scanning map looking for conditions that match
 				predicate and returns result.
 
 @details		Scans that map looking for the next value that satisfies the predicate.
-				The next valid index is returned through the cursor
+				The next valid index is returned through the cursor. An equality
+				cursor starts at the bucket of its key, and so stops at the first
+				empty bucket, past which the key cannot be.
 
 @param			cursor
 					A pointer to the cursor that is operating on the map.
@@ -63,6 +156,10 @@ oafdict_scan(
 	/* need to scan hashmap fully looking for values that satisfy - need to think about */
 	ion_file_hashmap_t *hash_map	= (ion_file_hashmap_t *) (cursor->super.dictionary->instance);
 
+	if (0 != hash_map->page_size) {
+		return oafdict_page_scan(cursor);
+	}
+
 	int loc							= (cursor->current + 1) % hash_map->map_size;
 	/* this is the current position of the cursor */
 	/* and start scanning 1 ahead */
@@ -70,7 +167,7 @@ oafdict_scan(
 	int record_size = SIZEOF(STATUS) + hash_map->super.record.key_size + hash_map->super.record.value_size;
 
 	/* move to the correct position in the fie */
-	fseek(hash_map->file, loc * record_size, SEEK_SET);
+	ion_fseek(hash_map->file, loc * record_size, ION_FILE_START);
 
 	ion_hash_bucket_t *item;
 
@@ -78,9 +175,14 @@ oafdict_scan(
 
 	/* start at the current position, scan forward */
 	while (loc != cursor->first) {
-		fread(item, record_size, 1, hash_map->file);
+		ion_fread(hash_map->file, record_size, (ion_byte_t *) item);
 
-		if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
+		if ((item->status == ION_EMPTY) && (predicate_equality == cursor->super.predicate->type)) {
+			/* an equality cursor follows the probe sequence of its key, which ends here */
+			free(item);
+			return cs_end_of_results;
+		}
+		else if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
 			/* if empty, just skip to next cell */
 			loc++;
 		}
@@ -104,6 +206,7 @@ oafdict_scan(
 		if (loc >= hash_map->map_size) {
 			/* Perform wrapping */
 			loc = 0;
+			ion_fseek(hash_map->file, 0, ION_FILE_START);
 		}
 	}
 
@@ -164,14 +267,28 @@ oafdict_next(
 
 		/* the results are now ready //reference item at given position */
 
+		if (0 != hash_map->page_size) {
+			ion_hash_bucket_t *item;
+
+			if ((err_ok != oafh_page_record(hash_map, oafdict_cursor->current, &item)) || (NULL == item)) {
+				cursor->status = cs_end_of_results;
+				return cursor->status;
+			}
+
+			memcpy(record->key, item->data, hash_map->super.record.key_size);
+			memcpy(record->value, item->data + hash_map->super.record.key_size, hash_map->super.record.value_size);
+
+			return cursor->status;
+		}
+
 		/* set position in file to read value */
-		fseek(hash_map->file, (SIZEOF(STATUS) + data_length) * oafdict_cursor->current	/* position is based on indexes (not abs file pos) */
-			+ SIZEOF(STATUS), SEEK_SET);
+		ion_fseek(hash_map->file, (SIZEOF(STATUS) + data_length) * oafdict_cursor->current	/* position is based on indexes (not abs file pos) */
+			+ SIZEOF(STATUS), ION_FILE_START);
 
 /*@todo this needs to be addressed in terms of return type
 */
-		fread(record->key, hash_map->super.record.key_size, 1, hash_map->file);
-		fread(record->value, hash_map->super.record.value_size, 1, hash_map->file);
+		ion_fread(hash_map->file, hash_map->super.record.key_size, record->key);
+		ion_fread(hash_map->file, hash_map->super.record.value_size, record->value);
 
 		/* and update current cursor position */
 		return cursor->status;
@@ -340,6 +457,36 @@ oafdict_open_dictionary(
 	return oafdict_create_dictionary(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, compare, handler, dictionary);
 }
 
+/**
+@brief			Opens an open address file hash instance of a dictionary,
+				accessing its file through a memory mapping.
+@see			oafdict_open_dictionary
+ */
+ion_err_t
+oafdict_open_mapped_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	return oafdict_create_mapped_dictionary(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, compare, handler, dictionary);
+}
+
+/**
+@brief			Opens an open address file hash instance of a dictionary
+				with the paged layout.
+@see			oafdict_open_dictionary
+ */
+ion_err_t
+oafdict_open_paged_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	return oafdict_create_paged_dictionary(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, compare, handler, dictionary);
+}
+
 /**
 @brief			Closes an open address file hash instance of a dictionary.
 
@@ -370,6 +517,25 @@ oafdict_close_dictionary(
 	return err_ok;
 }
 
+/**
+@brief			Writes out what is buffered for an open address file hash
+				instance of a dictionary.
+
+@param			dictionary
+					A pointer to the specific dictionary instance to be flushed.
+@param			sync
+					Whether to also wait until it is on the storage device.
+
+@return			The status of flushing the dictionary.
+ */
+ion_err_t
+oafdict_flush_dictionary(
+	ion_dictionary_t	*dictionary,
+	ion_boolean_t		sync
+) {
+	return oafh_flush((ion_file_hashmap_t *) dictionary->instance, sync);
+}
+
 void
 oafdict_init(
 	ion_dictionary_handler_t *handler
@@ -382,7 +548,29 @@ oafdict_init(
 	handler->remove				= oafdict_delete;
 	handler->delete_dictionary	= oafdict_delete_dictionary;
 	handler->open_dictionary	= oafdict_open_dictionary;
+	handler->concurrency		= ion_concurrency_serial;
 	handler->close_dictionary	= oafdict_close_dictionary;
+	handler->multi_get			= oafdict_multi_get;
+	handler->insert_batch		= oafdict_insert_batch;
+	handler->flush_dictionary	= oafdict_flush_dictionary;
+}
+
+void
+oafdict_mapped_init(
+	ion_dictionary_handler_t *handler
+) {
+	oafdict_init(handler);
+	handler->create_dictionary	= oafdict_create_mapped_dictionary;
+	handler->open_dictionary	= oafdict_open_mapped_dictionary;
+}
+
+void
+oafdict_paged_init(
+	ion_dictionary_handler_t *handler
+) {
+	oafdict_init(handler);
+	handler->create_dictionary	= oafdict_create_paged_dictionary;
+	handler->open_dictionary	= oafdict_open_paged_dictionary;
 }
 
 ion_status_t
@@ -394,8 +582,14 @@ oafdict_insert(
 	return oafh_insert((ion_file_hashmap_t *) dictionary->instance, key, value);
 }
 
-ion_err_t
-oafdict_create_dictionary(
+/**
+@brief		Creates an instance of a dictionary, accessing its file through a
+			stdio stream or through a memory mapping as @p mapped says, and
+			with the paged layout if @p paged says so.
+@see		oafdict_create_dictionary
+*/
+static ion_err_t
+oafdict_create(
 	ion_dictionary_id_t			id,
 	ion_key_type_t				key_type,
 	ion_key_size_t				key_size,
@@ -403,16 +597,32 @@ oafdict_create_dictionary(
 	ion_dictionary_size_t		dictionary_size,
 	ion_dictionary_compare_t	compare,
 	ion_dictionary_handler_t	*handler,
-	ion_dictionary_t			*dictionary
+	ion_dictionary_t			*dictionary,
+	ion_boolean_t				mapped,
+	ion_boolean_t				paged
 ) {
-	UNUSED(id);
+	ion_err_t				err;
+	ion_dictionary_hash_t	hash = dictionary_switch_hash(key_type, key_size, dictionary->hash_function);
+
 	/* this is the instance of the hashmap */
 	dictionary->instance			= malloc(sizeof(ion_file_hashmap_t));
 
 	dictionary->instance->compare	= compare;
 
 	/* this registers the dictionary the dictionary */
-	oafh_initialize((ion_file_hashmap_t *) dictionary->instance, oafh_compute_simple_hash, key_type, key_size, value_size, dictionary_size, id);/* just pick an arbitary size for testing atm */
+	err								= oafh_initialize((ion_file_hashmap_t *) dictionary->instance, (NULL == hash) ? oafh_compute_simple_hash : oafh_compute_dictionary_hash, key_type, key_size, value_size, dictionary_size, id, mapped, paged);
+
+	if (err_ok != err) {
+		free(dictionary->instance);
+		dictionary->instance = NULL;
+		return err;
+	}
+
+	((ion_file_hashmap_t *) dictionary->instance)->hash = hash;
+
+	if (paged) {
+		((ion_file_hashmap_t *) dictionary->instance)->max_load = ION_OAFH_MAX_LOAD_PERCENT;
+	}
 
 	/*TODO The correct comparison operator needs to be bound at run time
 	 * based on the type of key defined
@@ -421,7 +631,49 @@ oafdict_create_dictionary(
 	/* register the correct handler */
 	dictionary->handler = handler;	/* todo: need to check to make sure that the handler is registered */
 
-	return 0;
+	return err_ok;
+}
+
+ion_err_t
+oafdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	return oafdict_create(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary, boolean_false, boolean_false);
+}
+
+ion_err_t
+oafdict_create_mapped_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	return oafdict_create(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary, boolean_true, boolean_false);
+}
+
+ion_err_t
+oafdict_create_paged_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	return oafdict_create(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary, boolean_false, boolean_true);
 }
 
 ion_status_t
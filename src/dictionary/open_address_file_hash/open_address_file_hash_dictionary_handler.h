@@ -87,6 +87,40 @@ oafdict_init(
 	ion_dictionary_handler_t *handler
 );
 
+/**
+@brief		Registers the handler for dictionaries whose file is accessed
+			through a memory mapping instead of a stdio stream.
+
+@details	The file layout is unchanged, so a dictionary may be reopened
+			with either handler.
+
+@param	  handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+oafdict_mapped_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Registers the handler for dictionaries with the paged layout, in
+			which each bucket is a page holding many records.
+
+@details	A lookup reads one page of the file, where the default layout
+			reads one record for each step of its probe. The layout is kept
+			in the file, so a dictionary must be reopened with the handler
+			it was created with.
+
+@param	  handler
+				The handler for the dictionary instance that is to be
+				initialized.
+*/
+void
+oafdict_paged_init(
+	ion_dictionary_handler_t *handler
+);
+
 /**
 @brief		Inserts a @p key and @p value into the dictionary.
 
@@ -141,6 +175,48 @@ oafdict_create_dictionary(
 	ion_dictionary_t			*dictionary
 );
 
+/**
+@brief		Creates an instance of a dictionary whose file is accessed
+			through a memory mapping.
+
+@details	Takes the same parameters as @ref oafdict_create_dictionary.
+
+@return		The status of the creation of the dictionary.
+*/
+ion_err_t
+oafdict_create_mapped_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Creates an instance of a dictionary with the paged layout.
+
+@details	Takes the same parameters as @ref oafdict_create_dictionary,
+			with @p dictionary_size the number of records the dictionary is
+			expected to hold at first. It grows a bucket at a time as it
+			fills, without being rebuilt.
+
+@return		The status of the creation of the dictionary.
+*/
+ion_err_t
+oafdict_create_paged_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
 /**
 @brief		Deletes the @p key and assoicated value from the dictionary
 			instance.
@@ -38,8 +38,22 @@ oah_initialize(
 	hashmap->entry			= malloc((hashmap->super.record.key_size + hashmap->super.record.value_size + 1) * hashmap->map_size);
 	/* Allows for binding of different hash function depending on requirements. */
 	hashmap->compute_hash	= (*hashing_function);
-
-	if (NULL == hashmap->entry) {
+	hashmap->hash			= NULL;
+
+	/* Fixed size unless asked to grow */
+	hashmap->max_load		= 0;
+	hashmap->used			= 0;
+	hashmap->count			= 0;
+	hashmap->old_entry		= NULL;
+	hashmap->old_size		= 0;
+	hashmap->migrated		= 0;
+	hashmap->scratch_key	= malloc(hashmap->super.record.key_size);
+
+	if ((NULL == hashmap->entry) || (NULL == hashmap->scratch_key)) {
+		free(hashmap->entry);
+		free(hashmap->scratch_key);
+		hashmap->entry			= NULL;
+		hashmap->scratch_key	= NULL;
 		return 1;
 	}
 
@@ -63,6 +77,211 @@ oah_get_location(
 	return num % size;
 }
 
+/**
+@brief		Probes the @p size buckets at @p entry for @p key, starting
+			from the home bucket of @p hash.
+*/
+static ion_err_t
+oah_find_in(
+	ion_hashmap_t	*hash_map,
+	char			*entry,
+	int				size,
+	ion_hash_t		hash,
+	ion_key_t		key,
+	int				*location
+) {
+	int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	int loc			= oah_get_location(hash, size);
+	int count		= 0;
+
+	while (count != size) {
+		ion_hash_bucket_t *item = (ion_hash_bucket_t *) (entry + record_size * loc);
+
+		if (item->status == ION_EMPTY) {
+			return err_item_not_found;
+		}
+
+		if ((item->status != ION_DELETED) && (ION_IS_EQUAL == hash_map->super.compare(item->data, key, hash_map->super.record.key_size))) {
+			*location = loc;
+			return err_ok;
+		}
+
+		count++;
+		loc++;
+
+		if (loc >= size) {
+			loc = 0;
+		}
+	}
+
+	return err_item_not_found;
+}
+
+/**
+@brief		Hashes the key of the record in @p item.
+
+@details	The key sits one byte into the bucket, after its status, so it
+			is first copied to @p key, which is suitably aligned for the
+			hash functions that read keys by their type.
+*/
+static ion_hash_t
+oah_bucket_hash(
+	ion_hashmap_t		*hash_map,
+	ion_hash_bucket_t	*item,
+	ion_key_t			key
+) {
+	memcpy(key, item->data, hash_map->super.record.key_size);
+	return hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);
+}
+
+/**
+@brief		Empties the bucket at @p loc of the current bucket array, moving
+			back any records after it that would otherwise no longer be
+			found.
+
+@details	This is backward shift deletion. The records following the hole
+			up to the next empty bucket are visited in turn, and each one
+			whose home bucket is not between the hole and itself is moved
+			into the hole, which then moves to where that record was. No
+			deleted marker is left behind, so probes still stop at the first
+			empty bucket however many records have been deleted.
+*/
+static void
+oah_shift_back(
+	ion_hashmap_t	*hash_map,
+	int				loc
+) {
+	int			record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	int			hole		= loc;
+	int			count;
+	ion_key_t	key			= hash_map->scratch_key;
+
+	for (count = 1; count < hash_map->map_size; count++) {
+		ion_hash_bucket_t	*item;
+		int					home;
+
+		loc++;
+
+		if (loc >= hash_map->map_size) {
+			loc = 0;
+		}
+
+		item = (ion_hash_bucket_t *) (hash_map->entry + record_size * loc);
+
+		if (item->status == ION_EMPTY) {
+			break;
+		}
+
+		if (item->status != ION_IN_USE) {
+			continue;
+		}
+
+		home = oah_get_location(oah_bucket_hash(hash_map, item, key), hash_map->map_size);
+
+		/* A record whose home is in (hole, loc] is still reached from there */
+		if ((hole <= loc) ? ((home <= hole) || (home > loc)) : ((home <= hole) && (home > loc))) {
+			memcpy(hash_map->entry + record_size * hole, item, record_size);
+			hole = loc;
+		}
+	}
+
+	((ion_hash_bucket_t *) (hash_map->entry + record_size * hole))->status = ION_EMPTY;
+}
+
+/**
+@brief		Starts moving the records into a new bucket array twice the size
+			of the current one.
+
+@details	If there is no memory for the new array, the map carries on at
+			its current size.
+*/
+static void
+oah_rehash_start(
+	ion_hashmap_t *hash_map
+) {
+	int		record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	int		new_size	= hash_map->map_size * 2;
+	char	*entry;
+	int		i;
+
+	entry = malloc(record_size * new_size);
+
+	if (NULL == entry) {
+		return;
+	}
+
+	for (i = 0; i < new_size; i++) {
+		((ion_hash_bucket_t *) (entry + record_size * i))->status = ION_EMPTY;
+	}
+
+	hash_map->old_entry = hash_map->entry;
+	hash_map->old_size	= hash_map->map_size;
+	hash_map->migrated	= 0;
+	hash_map->entry		= entry;
+	hash_map->map_size	= new_size;
+	hash_map->used		= 0;
+}
+
+/**
+@brief		Moves up to @p num_buckets buckets of a pending rehash into the
+			current bucket array, and releases the old array once it has
+			been emptied.
+
+@details	Moved buckets are marked deleted rather than empty, so that the
+			probe sequences of the records still waiting to be moved stay
+			intact.
+*/
+static void
+oah_rehash_step(
+	ion_hashmap_t	*hash_map,
+	int				num_buckets
+) {
+	int			record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	ion_key_t	key			= hash_map->scratch_key;
+
+	while ((NULL != hash_map->old_entry) && (num_buckets > 0)) {
+		ion_hash_bucket_t *item = (ion_hash_bucket_t *) (hash_map->old_entry + record_size * hash_map->migrated);
+
+		if (item->status == ION_IN_USE) {
+			ion_hash_t	hash	= oah_bucket_hash(hash_map, item, key);
+			int			loc		= oah_get_location(hash, hash_map->map_size);
+
+			/* There is always a free bucket, as the new array is never filled by a rehash */
+			while (((ion_hash_bucket_t *) (hash_map->entry + record_size * loc))->status == ION_IN_USE) {
+				loc++;
+
+				if (loc >= hash_map->map_size) {
+					loc = 0;
+				}
+			}
+
+			if (((ion_hash_bucket_t *) (hash_map->entry + record_size * loc))->status == ION_EMPTY) {
+				hash_map->used++;
+			}
+
+			memcpy(hash_map->entry + record_size * loc, item, record_size);
+			item->status = ION_DELETED;
+		}
+
+		hash_map->migrated++;
+		num_buckets--;
+
+		if (hash_map->migrated >= hash_map->old_size) {
+			free(hash_map->old_entry);
+			hash_map->old_entry = NULL;
+			hash_map->old_size	= 0;
+			hash_map->migrated	= 0;
+		}
+	}
+}
+
+void
+oah_complete_rehash(
+	ion_hashmap_t *hash_map
+) {
+	oah_rehash_step(hash_map, hash_map->old_size);
+}
+
 ion_err_t
 oah_destroy(
 	ion_hashmap_t *hash_map
@@ -72,6 +291,15 @@ oah_destroy(
 	hash_map->super.record.key_size		= 0;
 	hash_map->super.record.value_size	= 0;
 
+	if (NULL != hash_map->old_entry) {
+		free(hash_map->old_entry);
+		hash_map->old_entry = NULL;
+		hash_map->old_size	= 0;
+	}
+
+	free(hash_map->scratch_key);
+	hash_map->scratch_key = NULL;
+
 	if (hash_map->entry != NULL) {
 		/* check to ensure that you are not freeing something already free */
 		free(hash_map->entry);
@@ -106,17 +334,45 @@ oah_insert(
 	ion_key_t		key,
 	ion_value_t		value
 ) {
+	int				record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	ion_status_t	status		= ION_STATUS_ERROR(err_max_capacity);
+	int				loc;
+
+	if ((NULL == hash_map->old_entry) && (hash_map->max_load > 0) && ((hash_map->used + 1) * 100 > hash_map->map_size * hash_map->max_load)) {
+		oah_rehash_start(hash_map);
+	}
+
+	if (NULL != hash_map->old_entry) {
+		/* The key may not have been moved over yet */
+		ion_hash_t hash = hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);
+
+		if (err_ok == oah_find_in(hash_map, hash_map->old_entry, hash_map->old_size, hash, key, &loc)) {
+			ion_hash_bucket_t *item = (ion_hash_bucket_t *) (hash_map->old_entry + record_size * loc);
+
+			if (hash_map->write_concern == wc_insert_unique) {
+				return ION_STATUS_ERROR(err_duplicate_key);
+			}
+			else if (hash_map->write_concern != wc_update) {
+				return ION_STATUS_ERROR(err_write_concern);
+			}
+
+			memcpy(item->data + hash_map->super.record.key_size, value, (hash_map->super.record.value_size));
+			oah_rehash_step(hash_map, ION_OAH_REHASH_STEP);
+			return ION_STATUS_OK(1);
+		}
+	}
+
 	ion_hash_t hash = hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);	/* compute hash value for given key */
 
-	int loc			= oah_get_location(hash, hash_map->map_size);
+	loc = oah_get_location(hash, hash_map->map_size);
 
 	/* Scan until find an empty location - oah_insert if found */
-	int count		= 0;
+	int count = 0;
 
 	ion_hash_bucket_t *item;
 
 	while (count != hash_map->map_size) {
-		item = ((ion_hash_bucket_t *) ((hash_map->entry + (hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS)) * loc)));
+		item = ((ion_hash_bucket_t *) ((hash_map->entry + record_size * loc)));
 
 		if (item->status == ION_IN_USE) {
 			/* if a cell is in use, need to key to */
@@ -129,7 +385,8 @@ oah_insert(
 				else if (hash_map->write_concern == wc_update) {
 					/* allows for values to be updated */
 					memcpy(item->data + hash_map->super.record.key_size, value, (hash_map->super.record.value_size));
-					return ION_STATUS_OK(1);
+					status = ION_STATUS_OK(1);
+					break;
 				}
 				else {
 					return ION_STATUS_ERROR(err_write_concern);	/* there is a configuration issue with write concern */
@@ -138,10 +395,16 @@ oah_insert(
 		}
 		else if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
 			/* problem is here with base types as it is just an array of data.  Need better way */
+			if (item->status == ION_EMPTY) {
+				hash_map->used++;
+			}
+
 			item->status = ION_IN_USE;
 			memcpy(item->data, key, (hash_map->super.record.key_size));
 			memcpy(item->data + hash_map->super.record.key_size, value, (hash_map->super.record.value_size));
-			return ION_STATUS_OK(1);
+			hash_map->count++;
+			status = ION_STATUS_OK(1);
+			break;
 		}
 
 		loc++;
@@ -158,10 +421,15 @@ oah_insert(
 	}
 
 #if ION_DEBUG
-	printf("Hash table full.  Insert not done");
+
+	if (err_max_capacity == status.error) {
+		printf("Hash table full.  Insert not done");
+	}
+
 #endif
 
-	return ION_STATUS_ERROR(err_max_capacity);
+	oah_rehash_step(hash_map, ION_OAH_REHASH_STEP);
+	return status;
 }
 
 ion_err_t
@@ -170,49 +438,38 @@ oah_find_item_loc(
 	ion_key_t		key,
 	int				*location
 ) {
+	/* locations are only meaningful in a single bucket array */
+	oah_complete_rehash(hash_map);
+
 	/* compute hash value for given key */
 	ion_hash_t hash = hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);
 
-	int loc			= oah_get_location(hash, hash_map->map_size);
-	/* determine bucket based on hash */
-
-	int count		= 0;
-
-	while (count != hash_map->map_size) {
-		/* check to see if current item is a match based on key */
-		/* locate first item */
-		ion_hash_bucket_t *item = (((ion_hash_bucket_t *) ((hash_map->entry + (hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS)) * loc))));
-
-		if (item->status == ION_EMPTY) {
-			return err_item_not_found;	/* if you hit an empty cell, exit */
-		}
-		else {
-			/* calculate if there is a match */
-
-			if (item->status != ION_DELETED) {
-				/*@todo correct compare to use proper returen type*/
-				/*@todo An error exisits with the comparitor from the dictionary and will need to be
-				 * revisitied onced fixed */
-
-				int key_is_equal = hash_map->super.compare(item->data, key, hash_map->super.record.key_size);
+	return oah_find_in(hash_map, hash_map->entry, hash_map->map_size, hash, key, location);
+}
 
-				if (ION_IS_EQUAL == key_is_equal) {
-					(*location) = loc;
-					return err_ok;
-				}
-			}
+/**
+@brief		Returns the bucket holding @p key, looking in the buckets still
+			waiting to be moved by a rehash if need be, or NULL if the key
+			is not in the map.
+*/
+static ion_hash_bucket_t *
+oah_locate(
+	ion_hashmap_t	*hash_map,
+	ion_key_t		key
+) {
+	int			record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	ion_hash_t	hash		= hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);
+	int			loc;
 
-			count++;
-			loc++;
+	if (err_ok == oah_find_in(hash_map, hash_map->entry, hash_map->map_size, hash, key, &loc)) {
+		return (ion_hash_bucket_t *) (hash_map->entry + record_size * loc);
+	}
 
-			if (loc >= hash_map->map_size) {
-				/* Perform wrapping */
-				loc = 0;
-			}
-		}
+	if ((NULL != hash_map->old_entry) && (err_ok == oah_find_in(hash_map, hash_map->old_entry, hash_map->old_size, hash, key, &loc))) {
+		return (ion_hash_bucket_t *) (hash_map->old_entry + record_size * loc);
 	}
 
-	return err_item_not_found;	/* key have not been found */
+	return NULL;
 }
 
 ion_status_t
@@ -220,25 +477,29 @@ oah_delete(
 	ion_hashmap_t	*hash_map,
 	ion_key_t		key
 ) {
-	int loc = -1;
+	int			record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
+	ion_hash_t	hash		= hash_map->compute_hash(hash_map, key, hash_map->super.record.key_size);
+	int			loc;
 
-	if (oah_find_item_loc(hash_map, key, &loc) == err_item_not_found) {
+	if (err_ok == oah_find_in(hash_map, hash_map->entry, hash_map->map_size, hash, key, &loc)) {
+		oah_shift_back(hash_map, loc);
+		hash_map->used--;
+	}
+	else if ((NULL != hash_map->old_entry) && (err_ok == oah_find_in(hash_map, hash_map->old_entry, hash_map->old_size, hash, key, &loc))) {
+		/* The rehash walks the old buckets in order, so records there must stay where they are */
+		((ion_hash_bucket_t *) (hash_map->old_entry + record_size * loc))->status = ION_DELETED;
+	}
+	else {
 #if ION_DEBUG
 		printf("Item not found when trying to oah_delete.\n");
 #endif
 		return ION_STATUS_ERROR(err_item_not_found);
 	}
-	else {
-		/* locate item */
-		ion_hash_bucket_t *item = (((ion_hash_bucket_t *) ((hash_map->entry + (hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS)) * loc))));
 
-		item->status = ION_DELETED;	/* delete item */
+	hash_map->count--;
 
-#if ION_DEBUG
-		printf("Item deleted at location %d\n", loc);
-#endif
-		return ION_STATUS_OK(1);
-	}
+	oah_rehash_step(hash_map, ION_OAH_REHASH_STEP);
+	return ION_STATUS_OK(1);
 }
 
 ion_status_t
@@ -247,16 +508,9 @@ oah_query(
 	ion_key_t		key,
 	ion_value_t		value
 ) {
-	int loc;
-
-	if (oah_find_item_loc(hash_map, key, &loc) == err_ok) {
-#if ION_DEBUG
-		printf("Item found at location %d\n", loc);
-#endif
-
-		int					data_length = hash_map->super.record.key_size + hash_map->super.record.value_size;
-		ion_hash_bucket_t	*item		= (((ion_hash_bucket_t *) ((hash_map->entry + (data_length + SIZEOF(STATUS)) * loc))));
+	ion_hash_bucket_t *item = oah_locate(hash_map, key);
 
+	if (NULL != item) {
 		/* *value				   = malloc(sizeof(char) * (hash_map->super.record.value_size)); */
 		memcpy(value, (item->data + hash_map->super.record.key_size), hash_map->super.record.value_size);
 		return ION_STATUS_OK(1);
@@ -295,7 +549,9 @@ oah_print(
 	for (i = 0; i < size; i++) {
 		printf("%d -- %i ", i, ((ion_hash_bucket_t *) ((hash_map->entry + (record->key_size + record->value_size + SIZEOF(STATUS)) * i)))->status);
 		{
-			if (((ion_hash_bucket_t *) ((hash_map->entry + (record->key_size + record->value_size + SIZEOF(STATUS)) * i)))->status == (ION_EMPTY | ION_DELETED)) {
+			ion_hash_bucket_t *item = (ion_hash_bucket_t *) (hash_map->entry + (record->key_size + record->value_size + SIZEOF(STATUS)) * i);
+
+			if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
 				printf("(null)");
 			}
 			else {
@@ -325,3 +581,12 @@ oah_compute_simple_hash(
 
 	return hash;
 }
+
+ion_hash_t
+oah_compute_dictionary_hash(
+	ion_hashmap_t	*hashmap,
+	ion_key_t		key,
+	int				size_of_key
+) {
+	return (ion_hash_t) (hashmap->hash(key, size_of_key) % (uint32_t) hashmap->map_size);
+}
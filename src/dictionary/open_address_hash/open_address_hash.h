@@ -26,11 +26,28 @@ extern "C" {
 
 #include "../../key_value/kv_system.h"
 
-#define ION_EMPTY	-1
+/* The same as for the file hash, where a slot of zeros is empty */
+#define ION_EMPTY	0
 #define ION_DELETED -2
 #define ION_IN_USE	-3
 #define SIZEOF(STATUS) 1
 
+/**
+@brief		The percentage of buckets, in use or deleted, past which a map
+			created through the dictionary interface starts to grow.
+*/
+#if !defined(ION_OAH_MAX_LOAD_PERCENT)
+#define ION_OAH_MAX_LOAD_PERCENT 75
+#endif
+
+/**
+@brief		The number of buckets moved by each insert or delete while a map
+			is being rehashed into a larger bucket array.
+*/
+#if !defined(ION_OAH_REHASH_STEP)
+#define ION_OAH_REHASH_STEP 4
+#endif
+
 /**
 @brief		Prototype declaration for hashmap
 */
@@ -53,12 +70,30 @@ struct hashmap {
 
 	/**< The hashing function to be used for
 		 the instance*/
-	char *entry;/**< Pointer to the entries in the hashmap*/
+	char	*entry;/**< Pointer to the entries in the hashmap*/
+	int		max_load;	/**< Percentage of buckets that may be used before
+							 the map grows, or 0 to keep a fixed size */
+	int		used;		/**< Buckets of @p entry in use */
+	int		count;		/**< Records held by the map */
+	char	*old_entry;	/**< Buckets still being moved into @p entry by a
+							 rehash, or NULL if none is under way */
+	int		old_size;	/**< The size of @p old_entry in items */
+	int		migrated;	/**< Buckets of @p old_entry moved so far */
+	ion_key_t	scratch_key;/**< Aligned copy of a stored key, for hashing
+								 the records that deletes and rehashes move */
+	ion_dictionary_hash_t	hash;	/**< Key hash used by
+										 @ref oah_compute_dictionary_hash */
 };
 
 /**
 @brief		This function initializes an open address in memory hash map.
 
+@details	The map keeps this size. To have it grow instead, set
+			@p max_load afterwards; it is then rehashed into a bucket array
+			twice the size when more than @p max_load percent of the buckets
+			are used. The records are moved a few buckets per insert or
+			delete, so no single operation pays for the whole copy.
+
 @param		hashmap
 				Pointer to the hashmap instance to initialize.
 @param		hashing_function
@@ -166,7 +201,9 @@ oah_update(
 /**
 @brief	  Locates item in map.
 
-@details	Based on a key, function locates the record in the map.
+@details	Based on a key, function locates the record in the map. Any
+			rehash under way is completed first, so that the location is
+			an index into @p entry.
 
 @param		hash_map
 				The map into which the data is going to be inserted.
@@ -183,11 +220,29 @@ oah_find_item_loc(
 	int				*location
 );
 
+/**
+@brief		Moves every record still waiting on a rehash into the current
+			bucket array.
+
+@details	Afterwards all records are in @p entry, so it can be walked by
+			position as with a fixed size map.
+
+@param		hash_map
+				The map to finish rehashing.
+*/
+void
+oah_complete_rehash(
+	ion_hashmap_t *hash_map
+);
+
 /**
 @brief		Deletes item from map.
 
 @details	Deletes item from map based on key.  If key does not exist
-			error is returned
+			error is returned. Records following the deleted one may be
+			moved back into its bucket, so that no deleted marker is needed
+			to keep them reachable. A cursor open across a delete may
+			therefore miss or repeat a record.
 
 @param		hash_map
 				The map into which the data is going to be inserted.
@@ -240,6 +295,27 @@ oah_compute_simple_hash(
 	int				size_of_key
 );
 
+/**
+@brief		Hashes a key with the key hash bound to the map.
+
+@details	The key is hashed by @p hash of the map, as picked by
+			@ref dictionary_switch_hash, and reduced to the map size.
+
+@param		hashmap
+				The hash function is associated with.
+@param		key
+				The original key value to find hash value for.
+@param		size_of_key
+				The size of the key in bytes.
+@return		The hashed value for the key.
+*/
+ion_hash_t
+oah_compute_dictionary_hash(
+	ion_hashmap_t	*hashmap,
+	ion_key_t		key,
+	int				size_of_key
+);
+
 #if defined(__cplusplus)
 }
 #endif
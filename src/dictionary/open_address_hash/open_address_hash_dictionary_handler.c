@@ -47,7 +47,9 @@ oadict_query(
 				predicate and returns result.
 
 @details		Scans that map looking for the next value that satisfies the predicate.
-				The next valid index is returned through the cursor
+				The next valid index is returned through the cursor. An equality
+				cursor starts at the bucket of its key, and so stops at the first
+				empty bucket, past which the key cannot be.
 
 @param		  cursor
 					A pointer to the cursor that is operating on the map.
@@ -72,7 +74,11 @@ oadict_scan(
 		/* locate first item */
 		ion_hash_bucket_t *item = (((ion_hash_bucket_t *) ((hash_map->entry + (hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS)) * loc))));
 
-		if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
+		if ((item->status == ION_EMPTY) && (predicate_equality == cursor->super.predicate->type)) {
+			/* an equality cursor follows the probe sequence of its key, which ends here */
+			return cs_end_of_results;
+		}
+		else if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
 			/* if empty, just skip to next cell */
 			loc++;
 		}
@@ -126,6 +132,9 @@ oadict_find(
 	ion_predicate_t		*predicate,
 	ion_dict_cursor_t	**cursor
 ) {
+	/* cursors walk the bucket array by position */
+	oah_complete_rehash((ion_hashmap_t *) dictionary->instance);
+
 	/* allocate memory for cursor */
 	if ((*cursor = malloc(sizeof(ion_oadict_cursor_t))) == NULL) {
 		return err_out_of_memory;
@@ -307,7 +316,11 @@ oadict_init(
 	handler->remove				= oadict_delete;
 	handler->delete_dictionary	= oadict_delete_dictionary;
 	handler->close_dictionary	= oadict_close_dictionary;
+	handler->multi_get			= NULL;
+	handler->insert_batch		= NULL;
 	handler->open_dictionary	= oadict_open_dictionary;
+	handler->flush_dictionary	= NULL;
+	handler->concurrency		= ion_concurrency_shared_get;
 }
 
 ion_status_t
@@ -331,13 +344,21 @@ oadict_create_dictionary(
 	ion_dictionary_t			*dictionary
 ) {
 	UNUSED(id);
+
+	ion_dictionary_hash_t hash		= dictionary_switch_hash(key_type, key_size, dictionary->hash_function);
+
 	/* this is the instance of the hashmap */
 	dictionary->instance			= malloc(sizeof(ion_hashmap_t));
 
 	dictionary->instance->compare	= compare;
 
 	/* this registers the dictionary the dictionary */
-	oah_initialize((ion_hashmap_t *) dictionary->instance, oah_compute_simple_hash, key_type, key_size, value_size, dictionary_size);	/* just pick an arbitary size for testing atm */
+	oah_initialize((ion_hashmap_t *) dictionary->instance, (NULL == hash) ? oah_compute_simple_hash : oah_compute_dictionary_hash, key_type, key_size, value_size, dictionary_size);	/* just pick an arbitary size for testing atm */
+
+	((ion_hashmap_t *) dictionary->instance)->hash = hash;
+
+	/* dictionary_size is only the starting size, the map grows as records are added */
+	((ion_hashmap_t *) dictionary->instance)->max_load = ION_OAH_MAX_LOAD_PERCENT;
 
 	/*TODO The correct comparison operator needs to be bound at run time
 	 * based on the type of key defined
@@ -9,6 +9,80 @@
 #include "skip_list.h"
 /* #include "serial_c_iface.h" */
 
+/* Rounds a size up so that what follows it stays aligned. */
+#define SL_ALIGN(size) (((size) + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *))
+
+/**
+@brief		Takes a node of the given height from the free nodes of that
+			height, or else carves it from the arena.
+
+@param		skiplist
+				The skiplist the node is for.
+@param		height
+				Height index of the node.
+@return		The node, with its @p next, @p key and @p value pointing into
+			it, or @c NULL if out of memory.
+*/
+static ion_sl_node_t *
+sl_allocate_node(
+	ion_skiplist_t	*skiplist,
+	ion_sl_level_t	height
+) {
+	ion_sl_node_t	*node		= skiplist->free_nodes[height];
+	size_t			next_size	= SL_ALIGN(sizeof(ion_sl_node_t *) * (height + 1));
+	size_t			key_size	= SL_ALIGN(skiplist->super.record.key_size);
+
+	if (NULL != node) {
+		skiplist->free_nodes[height] = node->next[0];
+	}
+	else {
+		size_t node_size = SL_ALIGN(sizeof(ion_sl_node_t)) + next_size + key_size + SL_ALIGN(skiplist->super.record.value_size);
+
+		if ((NULL == skiplist->arena) || (skiplist->arena->size - skiplist->arena->used < node_size)) {
+			size_t			arena_size	= SL_ALIGN(sizeof(ion_sl_arena_t)) + node_size;
+			ion_sl_arena_t	*arena;
+
+			if (arena_size < ION_SL_ARENA_SIZE) {
+				arena_size = ION_SL_ARENA_SIZE;
+			}
+
+			arena = malloc(arena_size);
+
+			if (NULL == arena) {
+				return NULL;
+			}
+
+			arena->next		= skiplist->arena;
+			arena->used		= SL_ALIGN(sizeof(ion_sl_arena_t));
+			arena->size		= arena_size;
+			skiplist->arena = arena;
+		}
+
+		node					= (ion_sl_node_t *) ((char *) skiplist->arena + skiplist->arena->used);
+		skiplist->arena->used	+= node_size;
+	}
+
+	node->height	= height;
+	node->next		= (ion_sl_node_t **) ((char *) node + SL_ALIGN(sizeof(ion_sl_node_t)));
+	node->key		= (char *) node->next + next_size;
+	node->value		= (char *) node->key + key_size;
+
+	return node;
+}
+
+/**
+@brief		Puts a node that is no longer linked on the free nodes of its
+			height.
+*/
+static void
+sl_free_node(
+	ion_skiplist_t	*skiplist,
+	ion_sl_node_t	*node
+) {
+	node->next[0]						= skiplist->free_nodes[node->height];
+	skiplist->free_nodes[node->height]	= node;
+}
+
 ion_err_t
 sl_initialize(
 	ion_skiplist_t	*skiplist,
@@ -40,21 +114,21 @@ sl_initialize(
 	printf("%s", "\n");
 #endif
 
-	skiplist->head = malloc(sizeof(ion_sl_node_t));
+	skiplist->arena			= NULL;
+	skiplist->free_nodes	= calloc(maxheight, sizeof(ion_sl_node_t *));
 
-	if (NULL == skiplist->head) {
+	if (NULL == skiplist->free_nodes) {
 		return err_out_of_memory;
 	}
 
-	skiplist->head->next = malloc(sizeof(ion_sl_node_t) * skiplist->maxheight);
+	skiplist->head = sl_allocate_node(skiplist, maxheight - 1);
 
-	if (NULL == skiplist->head->next) {
-		free(skiplist->head);
-		skiplist->head = NULL;
+	if (NULL == skiplist->head) {
+		free(skiplist->free_nodes);
+		skiplist->free_nodes = NULL;
 		return err_out_of_memory;
 	}
 
-	skiplist->head->height	= maxheight - 1;
 	skiplist->head->key		= NULL;
 	skiplist->head->value	= NULL;
 
@@ -69,18 +143,18 @@ ion_err_t
 sl_destroy(
 	ion_skiplist_t *skiplist
 ) {
-	ion_sl_node_t *cursor = skiplist->head, *tofree;
-
-	while (cursor != NULL) {
-		tofree	= cursor;
-		cursor	= cursor->next[0];
-		free(tofree->key);
-		free(tofree->value);
-		free(tofree->next);
+	ion_sl_arena_t *tofree;
+
+	/* Every node lives in an arena, so freeing the arenas frees them all. */
+	while (NULL != skiplist->arena) {
+		tofree			= skiplist->arena;
+		skiplist->arena = tofree->next;
 		free(tofree);
 	}
 
-	skiplist->head = NULL;
+	free(skiplist->free_nodes);
+	skiplist->free_nodes	= NULL;
+	skiplist->head			= NULL;
 
 	return err_ok;
 }
@@ -95,29 +169,7 @@ sl_insert(
 	int key_size			= skiplist->super.record.key_size;
 	int value_size			= skiplist->super.record.value_size;
 
-	ion_sl_node_t *newnode	= malloc(sizeof(ion_sl_node_t));
-
-	if (NULL == newnode) {
-		return ION_STATUS_ERROR(err_out_of_memory);
-	}
-
-	newnode->key = malloc(key_size);
-
-	if (NULL == newnode->key) {
-		free(newnode);
-		return ION_STATUS_ERROR(err_out_of_memory);
-	}
-
-	newnode->value = malloc(value_size);
-
-	if (NULL == newnode->value) {
-		free(newnode->key);
-		free(newnode);
-		return ION_STATUS_ERROR(err_out_of_memory);
-	}
-
-	memcpy(newnode->key, key, key_size);
-	memcpy(newnode->value, value, value_size);
+	ion_sl_node_t *newnode;
 
 	/* First we check if there's already a duplicate node. If there is, we're
 	 * going to do a modified insert instead. TODO write unit cpp_wrapper to check this
@@ -126,16 +178,15 @@ sl_insert(
 
 	if ((NULL != duplicate->key) && (skiplist->super.compare(duplicate->key, key, key_size) == 0)) {
 		/* Child duplicate nodes have no height (which is effectively 1). */
-		newnode->height = 0;
-		newnode->next	= malloc(sizeof(ion_sl_node_t *) * (newnode->height + 1));
+		newnode = sl_allocate_node(skiplist, 0);
 
-		if (NULL == newnode->next) {
-			free(newnode->value);
-			free(newnode->key);
-			free(newnode);
+		if (NULL == newnode) {
 			return ION_STATUS_ERROR(err_out_of_memory);
 		}
 
+		memcpy(newnode->key, key, key_size);
+		memcpy(newnode->value, value, value_size);
+
 		/* We want duplicate to be the last node in the block of duplicate
 		 * nodes, so we traverse along the bottom until we get there.
 		*/
@@ -149,16 +200,15 @@ sl_insert(
 	}
 	else {
 		/* If there's no duplicate node, we do a vanilla insert instead */
-		newnode->height = sl_gen_level(skiplist);
-		newnode->next	= malloc(sizeof(ion_sl_node_t *) * (newnode->height + 1));
+		newnode = sl_allocate_node(skiplist, sl_gen_level(skiplist));
 
-		if (NULL == newnode->next) {
-			free(newnode->value);
-			free(newnode->key);
-			free(newnode);
+		if (NULL == newnode) {
 			return ION_STATUS_ERROR(err_out_of_memory);
 		}
 
+		memcpy(newnode->key, key, key_size);
+		memcpy(newnode->value, value, value_size);
+
 		ion_sl_node_t	*cursor = skiplist->head;
 		ion_sl_level_t	h;
 
@@ -277,10 +327,7 @@ sl_delete(
 					link_h--;
 				}
 
-				free(tofree->key);
-				free(tofree->value);
-				free(tofree->next);
-				free(tofree);
+				sl_free_node(skiplist, tofree);
 
 				cursor = oldcursor;
 				status.count++;
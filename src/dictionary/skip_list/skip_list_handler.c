@@ -333,7 +333,11 @@ sldict_init(
 	handler->update				= sldict_update;
 	handler->find				= sldict_find;
 	handler->close_dictionary	= sldict_close_dictionary;
+	handler->multi_get			= NULL;
+	handler->insert_batch		= NULL;
 	handler->open_dictionary	= sldict_open_dictionary;
+	handler->flush_dictionary	= NULL;
+	handler->concurrency		= ion_concurrency_shared_get;
 }
 
 ion_status_t
@@ -20,8 +20,18 @@ extern "C" {
 
 typedef int ion_sl_level_t;	/**< Height of a skiplist */
 
+/**
+@brief		The number of bytes of node memory a skiplist takes from the
+			system at a time.
+*/
+#if !defined(ION_SL_ARENA_SIZE)
+#define ION_SL_ARENA_SIZE 1024
+#endif
+
 /**
 @brief  Struct of a node in the skiplist.
+@details	A node is allocated in one block, in which it is followed by its
+			@p next array, then its key, then its value.
 */
 typedef struct sl_node {
 	ion_key_t		key;		/**< Key of a skiplist node */
@@ -32,6 +42,16 @@ typedef struct sl_node {
 									 column in the skiplist */
 } ion_sl_node_t;
 
+/**
+@brief		A block of memory that skiplist nodes are carved from.
+*/
+typedef struct sl_arena {
+	struct sl_arena *next;	/**< The block taken before this one */
+	size_t			used;	/**< Bytes of the block handed out, counting
+								 this header */
+	size_t			size;	/**< Bytes in the block */
+} ion_sl_arena_t;
+
 /**
 @brief  Struct of the Skiplist, holds metadata and the entry point
 		into the skiplist.
@@ -46,6 +66,11 @@ typedef struct skiplist {
 										the number of nodes */
 	int						pnum;	/**< Probability NUMerator, used in height gen */
 	int						pden;	/**< Probability DENominator, used in height gen */
+	ion_sl_arena_t			*arena;	/**< The block nodes are being carved from,
+									linked to the blocks before it */
+	ion_sl_node_t			**free_nodes;	/**< Deleted nodes to reuse, one list
+											per height, linked through
+											next[0] */
 } ion_skiplist_t;
 
 typedef struct
@@ -1,5 +1,17 @@
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+/* mmap(), ftruncate() and friends are POSIX, and hidden by -std=c99 */
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "ion_file.h"
 
+#if !defined(ARDUINO)
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 ion_boolean_t
 ion_fexists(
 	char *name
@@ -30,16 +42,172 @@ ion_fopen(
 
 	ion_file_handle_t file;
 
-	file = fopen(name, "r+b");
+	file = malloc(sizeof(*file));
 
 	if (NULL == file) {
-		file = fopen(name, "w+b");
+		return ION_NOFILE;
+	}
+
+	file->file = fopen(name, "r+b");
+
+	if (NULL == file->file) {
+		file->file = fopen(name, "w+b");
+	}
+
+	if (NULL == file->file) {
+		free(file);
+		return ION_NOFILE;
 	}
 
 	return file;
 #endif
 }
 
+#if !defined(ARDUINO)
+
+/**
+@brief		Extends the mapping of a mapped file to hold at least
+			@p min_capacity bytes.
+@details	Only the mapping grows. The file is extended as data is written
+			to it, so that its size never counts unwritten bytes.
+*/
+static ion_err_t
+ion_fmap_grow(
+	ion_file_handle_t	file,
+	ion_file_offset_t	min_capacity
+) {
+	ion_file_offset_t	page_size;
+	ion_file_offset_t	capacity;
+	void				*map;
+
+	page_size	= sysconf(_SC_PAGESIZE);
+	capacity	= file->capacity;
+
+	if (capacity < ION_FILE_MAP_MIN_SIZE) {
+		capacity = ION_FILE_MAP_MIN_SIZE;
+	}
+
+	while (capacity < min_capacity) {
+		capacity *= 2;
+	}
+
+	capacity = (capacity + page_size - 1) / page_size * page_size;
+
+	map = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+
+	if (MAP_FAILED == map) {
+		return err_out_of_memory;
+	}
+
+	if (NULL != file->map) {
+		munmap(file->map, file->capacity);
+	}
+
+	file->map		= map;
+	file->capacity	= capacity;
+
+	return err_ok;
+}
+
+/**
+@brief		Sets the size of a mapped file, first extending its mapping if
+			the file no longer fits in it.
+*/
+static ion_err_t
+ion_fmap_resize(
+	ion_file_handle_t	file,
+	ion_file_offset_t	size
+) {
+	if (size > file->capacity) {
+		ion_err_t error = ion_fmap_grow(file, size);
+
+		if (err_ok != error) {
+			return error;
+		}
+	}
+
+	if (0 != ftruncate(file->fd, size)) {
+		return err_file_write_error;
+	}
+
+	file->size = size;
+
+	return err_ok;
+}
+
+/**
+@brief		Synchronizes the bytes of a mapped file written since the last
+			flush with the file.
+*/
+static ion_err_t
+ion_fmap_sync(
+	ion_file_handle_t file
+) {
+	ion_file_offset_t	page_size;
+	ion_file_offset_t	start;
+
+	if (file->dirty_end <= file->dirty_start) {
+		return err_ok;
+	}
+
+	/* msync() wants a page aligned address */
+	page_size	= sysconf(_SC_PAGESIZE);
+	start		= file->dirty_start / page_size * page_size;
+
+	if (0 != msync(file->map + start, file->dirty_end - start, MS_SYNC)) {
+		return err_file_write_error;
+	}
+
+	file->dirty_start	= 0;
+	file->dirty_end		= 0;
+
+	return err_ok;
+}
+
+#endif
+
+ion_file_handle_t
+ion_fopen_mapped(
+	char *name
+) {
+#if defined(ARDUINO)
+	return ion_fopen(name);
+#else
+
+	ion_file_handle_t	file;
+	struct stat			status;
+
+	file = malloc(sizeof(*file));
+
+	if (NULL == file) {
+		return ION_NOFILE;
+	}
+
+	file->file			= NULL;
+	file->map			= NULL;
+	file->capacity		= 0;
+	file->position		= 0;
+	file->dirty_start	= 0;
+	file->dirty_end		= 0;
+	file->fd			= open(name, O_RDWR | O_CREAT, 0644);
+
+	if (-1 == file->fd) {
+		free(file);
+		return ION_NOFILE;
+	}
+
+	if ((0 != fstat(file->fd, &status)) || (err_ok != ion_fmap_grow(file, status.st_size))) {
+		close(file->fd);
+		free(file);
+		return ION_NOFILE;
+	}
+
+	file->size = status.st_size;
+
+	return file;
+#endif
+}
+
 ion_err_t
 ion_fclose(
 	ion_file_handle_t file
@@ -48,11 +216,126 @@ ion_fclose(
 	fclose(file.file);
 	return err_ok;
 #else
-	fclose(file);
+
+	ion_err_t error = err_ok;
+
+	if (NULL != file->file) {
+		fclose(file->file);
+	}
+	else {
+		if (err_ok != ion_fmap_sync(file)) {
+			error = err_file_close_error;
+		}
+
+		munmap(file->map, file->capacity);
+
+		if (0 != close(file->fd)) {
+			error = err_file_close_error;
+		}
+	}
+
+	free(file);
+	return error;
+#endif
+}
+
+ion_err_t
+ion_fflush(
+	ion_file_handle_t file
+) {
+#if defined(ARDUINO)
+	fflush(file.file);
+	return err_ok;
+#else
+
+	if (NULL != file->file) {
+		if (0 != fflush(file->file)) {
+			return err_file_write_error;
+		}
+
+		return err_ok;
+	}
+
+	return ion_fmap_sync(file);
+#endif
+}
+
+ion_err_t
+ion_fsync(
+	ion_file_handle_t file
+) {
+#if defined(ARDUINO)
+	/* Flushing an SD file writes it to the card */
+	return ion_fflush(file);
+#else
+
+	ion_err_t error = ion_fflush(file);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	/* The mapping was synchronized by the flush */
+	if ((NULL != file->file) && (0 != fsync(fileno(file->file)))) {
+		return err_file_write_error;
+	}
+
 	return err_ok;
 #endif
 }
 
+ion_err_t
+ion_ftruncate(
+	ion_file_handle_t	file,
+	ion_file_offset_t	size
+) {
+#if defined(ARDUINO)
+
+	/* The SD library cannot cut a file short or leave a hole, so zeros are written out */
+	ion_byte_t			zeros[16]	= { 0 };
+	ion_file_offset_t	previous	= ion_ftell(file);
+	ion_file_offset_t	end			= ion_fend(file);
+	ion_err_t			error		= err_ok;
+
+	if (size < end) {
+		return err_file_write_error;
+	}
+
+	ion_fseek(file, end, ION_FILE_START);
+
+	while ((err_ok == error) && (end < size)) {
+		unsigned int num_bytes = (size - end < (ion_file_offset_t) sizeof(zeros)) ? (unsigned int) (size - end) : sizeof(zeros);
+
+		error	= ion_fwrite(file, num_bytes, zeros);
+		end		+= num_bytes;
+	}
+
+	ion_fseek(file, previous, ION_FILE_START);
+
+	return error;
+#else
+
+	if (NULL != file->file) {
+		if ((0 != fflush(file->file)) || (0 != ftruncate(fileno(file->file), size))) {
+			return err_file_write_error;
+		}
+
+		return err_ok;
+	}
+
+	if (size < file->size) {
+		/* The mapping past the data is kept zero, so that growing again reads as zeros */
+		memset(file->map + size, 0, file->size - size);
+
+		if (file->dirty_end > size) {
+			file->dirty_end = (file->dirty_start < size) ? size : file->dirty_start;
+		}
+	}
+
+	return ion_fmap_resize(file, size);
+#endif
+}
+
 ion_err_t
 ion_fremove(
 	char *name
@@ -84,10 +367,27 @@ ion_fseek(
 	return err_ok;
 #else
 
-	if (0 != fseek(file, seek_to, origin)) {
+	if (NULL != file->file) {
+		if (0 != fseek(file->file, seek_to, origin)) {
+			return err_file_bad_seek;
+		}
+
+		return err_ok;
+	}
+
+	if (ION_FILE_CURRENT == origin) {
+		seek_to += file->position;
+	}
+	else if (ION_FILE_END == origin) {
+		seek_to += file->size;
+	}
+
+	if (seek_to < 0) {
 		return err_file_bad_seek;
 	}
 
+	file->position = seek_to;
+
 	return err_ok;
 #endif
 }
@@ -99,7 +399,12 @@ ion_ftell(
 #if defined(ARDUINO)
 	return ftell(file.file);
 #else
-	return ftell(file);
+
+	if (NULL != file->file) {
+		return ftell(file->file);
+	}
+
+	return file->position;
 #endif
 }
 
@@ -132,7 +437,43 @@ ion_fwrite(
 
 	return err_ok;
 #else
-	fwrite(to_write, num_bytes, 1, file);
+
+	if (NULL != file->file) {
+		if ((num_bytes > 0) && (1 != fwrite(to_write, num_bytes, 1, file->file))) {
+			return err_file_incomplete_write;
+		}
+
+		return err_ok;
+	}
+
+	if (0 == num_bytes) {
+		return err_ok;
+	}
+
+	if (file->position + (ion_file_offset_t) num_bytes > file->size) {
+		ion_err_t error = ion_fmap_resize(file, file->position + num_bytes);
+
+		if (err_ok != error) {
+			return error;
+		}
+	}
+
+	memcpy(file->map + file->position, to_write, num_bytes);
+
+	if (file->dirty_end <= file->dirty_start) {
+		file->dirty_start	= file->position;
+		file->dirty_end		= file->position;
+	}
+	else if (file->position < file->dirty_start) {
+		file->dirty_start = file->position;
+	}
+
+	file->position += num_bytes;
+
+	if (file->position > file->dirty_end) {
+		file->dirty_end = file->position;
+	}
+
 	return err_ok;
 #endif
 }
@@ -189,10 +530,21 @@ ion_fread(
 	return err_ok;
 #else
 
-	if (1 != fread(write_to, num_bytes, 1, file)) {
+	if (NULL != file->file) {
+		if (1 != fread(write_to, num_bytes, 1, file->file)) {
+			return err_file_incomplete_read;
+		}
+
+		return err_ok;
+	}
+
+	if (file->position + (ion_file_offset_t) num_bytes > file->size) {
 		return err_file_incomplete_read;
 	}
 
+	memcpy(write_to, file->map + file->position, num_bytes);
+	file->position += num_bytes;
+
 	return err_ok;
 #endif
 }
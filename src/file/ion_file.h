@@ -19,6 +19,7 @@ extern "C" {
 typedef long ion_file_offset_t;
 
 #define ION_FILE_START	SEEK_SET
+#define ION_FILE_CURRENT	SEEK_CUR
 #define ION_FILE_END	SEEK_END
 
 #if defined(ARDUINO)
@@ -38,7 +39,29 @@ typedef struct file_handle {
 #include "stdio.h"
 #include "unistd.h"
 
-typedef FILE *ion_file_handle_t;
+/**
+@brief		The smallest mapping made for a file opened with
+			@ref ion_fopen_mapped. Mappings grow by doubling from here.
+*/
+#if !defined(ION_FILE_MAP_MIN_SIZE)
+#define ION_FILE_MAP_MIN_SIZE 4096
+#endif
+
+/**
+@brief		An open file. The file is accessed either through a stdio stream
+			or, if opened with @ref ion_fopen_mapped, through a shared memory
+			mapping of the whole file.
+*/
+typedef struct file_handle {
+	FILE				*file;		/**< The stdio stream, or NULL if the file is mapped. */
+	int					fd;			/**< Descriptor of a mapped file. */
+	ion_byte_t			*map;		/**< Start of the mapping of a mapped file. */
+	ion_file_offset_t	capacity;	/**< Bytes mapped. The file itself is only as long as its data. */
+	ion_file_offset_t	size;		/**< Bytes of the mapping holding data, which is the size of the file. */
+	ion_file_offset_t	position;	/**< Current position in a mapped file. */
+	ion_file_offset_t	dirty_start;	/**< Start of the bytes written since the last flush. */
+	ion_file_offset_t	dirty_end;	/**< End of the bytes written since the last flush, or @c dirty_start if none were. */
+} *ion_file_handle_t;
 
 #define ION_NOFILE ((ion_file_handle_t) (NULL))
 
@@ -56,11 +79,78 @@ ion_fopen(
 	char *name
 );
 
+/**
+@brief		Opens the file @p name, creating it if it does not exist, and maps
+			all of it into memory.
+@details	Reads and writes are copies to and from the mapping, and seeks
+			only move a position, so only writes past the end of the file
+			make a system call, to extend it. The file is always exactly as
+			long as its data, so it reads back the same even if it is never
+			closed. Writing past the end of the mapping also remaps it. The
+			bytes written since the last flush reach the file on
+			@ref ion_fflush and @ref ion_fclose. The file is left in the same
+			format as one written with @ref ion_fopen, so either may open it
+			later. Where memory mapping is not available, this is the same as
+			@ref ion_fopen.
+@param		name
+				The name of the file.
+@return		The open file, or @ref ION_NOFILE if it could not be opened.
+*/
+ion_file_handle_t
+ion_fopen_mapped(
+	char *name
+);
+
 ion_err_t
 ion_fclose(
 	ion_file_handle_t file
 );
 
+/**
+@brief		Writes anything buffered for @p file to the file.
+@details	For a mapped file, the part of the mapping written since the
+			last flush is synchronized with the file.
+@param		file
+				The file to flush.
+@return		The status of the flush.
+*/
+ion_err_t
+ion_fflush(
+	ion_file_handle_t file
+);
+
+/**
+@brief		Writes anything buffered for @p file to the file, and waits until
+			the file is on the storage device.
+@details	Unlike @ref ion_fflush, the data survives the system stopping
+			once this returns.
+@param		file
+				The file to synchronize.
+@return		The status of the synchronization.
+*/
+ion_err_t
+ion_fsync(
+	ion_file_handle_t file
+);
+
+/**
+@brief		Sets the size of @p file to @p size bytes.
+@details	Bytes added to the end read as zero. Where the file system
+			supports it they take no space until written, so a large file
+			of zeros is made without writing it. The position in the file is
+			left where it was.
+@param		file
+				The file to resize.
+@param		size
+				The size to give it.
+@return		The status of resizing the file.
+*/
+ion_err_t
+ion_ftruncate(
+	ion_file_handle_t	file,
+	ion_file_offset_t	size
+);
+
 ion_err_t
 ion_fremove(
 	char *name
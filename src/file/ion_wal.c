@@ -0,0 +1,445 @@
+/******************************************************************************/
+/**
+@file
+@brief		Implementation of the write-ahead log.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#include "ion_wal.h"
+
+#define ION_WAL_MAGIC 0x4C41574EU
+
+#if ION_THREAD_SAFE
+#define ion_wal_lock(wal)	pthread_mutex_lock(&(wal)->lock)
+#define ion_wal_unlock(wal) pthread_mutex_unlock(&(wal)->lock)
+#define ion_wal_wait(wal)	pthread_cond_wait(&(wal)->synced, &(wal)->lock)
+#define ion_wal_wake(wal)	pthread_cond_broadcast(&(wal)->synced)
+#else
+#define ion_wal_lock(wal)	UNUSED(wal)
+#define ion_wal_unlock(wal) UNUSED(wal)
+#define ion_wal_wait(wal)	UNUSED(wal)
+#define ion_wal_wake(wal)	UNUSED(wal)
+#endif
+
+/**
+@brief		The header at the start of a log file.
+*/
+typedef struct {
+	uint32_t		magic;			/**< Marks the file as a log. */
+	uint32_t		generation;		/**< Counts the checkpoints. */
+	ion_wal_lsn_t	checkpoint_lsn;	/**< The last LSN dropped by a checkpoint. */
+} ion_wal_header_t;
+
+/**
+@brief		The header of a record, which its payload follows.
+*/
+typedef struct {
+	ion_wal_lsn_t	lsn;			/**< The LSN of the record. */
+	uint32_t		generation;		/**< The generation of the log it was written in. */
+	uint32_t		checksum;		/**< Covers this header and the payload. */
+	uint16_t		size;			/**< The size of the payload. */
+	ion_byte_t		type;			/**< The type given when it was appended. */
+	ion_byte_t		reserved;		/**< Zero. */
+} ion_wal_record_t;
+
+/**
+@brief		Adds @p bytes to an FNV-1a checksum.
+*/
+static uint32_t
+ion_wal_checksum(
+	uint32_t		checksum,
+	ion_byte_t		*bytes,
+	unsigned int	size
+) {
+	unsigned int i;
+
+	for (i = 0; i < size; i++) {
+		checksum	^= bytes[i];
+		checksum	*= 16777619U;
+	}
+
+	return checksum;
+}
+
+/**
+@brief		Grows the buffer to hold at least @p size bytes.
+*/
+static ion_err_t
+ion_wal_reserve(
+	ion_wal_t		*wal,
+	unsigned int	size
+) {
+	unsigned int	capacity = wal->capacity;
+	ion_byte_t		*buffer;
+
+	if (size <= capacity) {
+		return err_ok;
+	}
+
+	while (capacity < size) {
+		capacity *= 2;
+	}
+
+	buffer = realloc(wal->buffer, capacity);
+
+	if (NULL == buffer) {
+		return err_out_of_memory;
+	}
+
+	wal->buffer		= buffer;
+	wal->capacity	= capacity;
+
+	return err_ok;
+}
+
+/**
+@brief		Writes the buffered records to the end of the log.
+*/
+static ion_err_t
+ion_wal_write(
+	ion_wal_t *wal
+) {
+	ion_err_t error;
+
+	if (0 == wal->buffered) {
+		return err_ok;
+	}
+
+	error = ion_fwrite_at(wal->file, wal->end, wal->buffered, wal->buffer);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	wal->end		+= wal->buffered;
+	wal->buffered	= 0;
+
+	return err_ok;
+}
+
+/**
+@brief		Writes and synchronizes the header of the log.
+*/
+static ion_err_t
+ion_wal_write_header(
+	ion_wal_t		*wal,
+	ion_wal_lsn_t	checkpoint_lsn
+) {
+	ion_wal_header_t	header = { ION_WAL_MAGIC, wal->generation, checkpoint_lsn };
+	ion_err_t			error;
+
+	error = ion_fwrite_at(wal->file, 0, sizeof(header), (ion_byte_t *) &header);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	return ion_fsync(wal->file);
+}
+
+/**
+@brief		Reads the record at @p offset into the buffer, if it is a whole
+			record of the current generation numbered @p lsn.
+@return		Whether the record is there.
+*/
+static ion_boolean_t
+ion_wal_read_record(
+	ion_wal_t			*wal,
+	ion_file_offset_t	offset,
+	ion_wal_lsn_t		lsn,
+	ion_wal_record_t	*record
+) {
+	uint32_t checksum;
+
+	if (err_ok != ion_fread_at(wal->file, offset, sizeof(*record), (ion_byte_t *) record)) {
+		return boolean_false;
+	}
+
+	if ((record->lsn != lsn) || (record->generation != wal->generation)) {
+		return boolean_false;
+	}
+
+	if ((err_ok != ion_wal_reserve(wal, record->size)) || ((record->size > 0) && (err_ok != ion_fread(wal->file, record->size, wal->buffer)))) {
+		return boolean_false;
+	}
+
+	checksum			= record->checksum;
+	record->checksum	= 0;
+
+	return checksum == ion_wal_checksum(ion_wal_checksum(2166136261U, (ion_byte_t *) record, sizeof(*record)), wal->buffer, record->size);
+}
+
+ion_err_t
+ion_wal_open(
+	ion_wal_t	*wal,
+	char		*name
+) {
+	ion_wal_header_t	header;
+	ion_wal_record_t	record;
+	ion_err_t			error;
+
+	wal->file = ion_fopen(name);
+
+#if defined(ARDUINO)
+
+	if (NULL == wal->file.file) {
+#else
+
+	if (ION_NOFILE == wal->file) {
+#endif
+		return err_file_open_error;
+	}
+
+	wal->buffer		= malloc(ION_WAL_BUFFER_SIZE);
+	wal->capacity	= ION_WAL_BUFFER_SIZE;
+	wal->buffered	= 0;
+	wal->end		= sizeof(header);
+
+	if (NULL == wal->buffer) {
+		ion_fclose(wal->file);
+		return err_out_of_memory;
+	}
+
+	if ((err_ok != ion_fread_at(wal->file, 0, sizeof(header), (ion_byte_t *) &header)) || (ION_WAL_MAGIC != header.magic)) {
+		/* A new log, or one whose header was never written whole */
+		wal->generation = 1;
+		wal->next_lsn	= 1;
+		error			= ion_wal_write_header(wal, 0);
+
+		if (err_ok != error) {
+			free(wal->buffer);
+			ion_fclose(wal->file);
+			return error;
+		}
+	}
+	else {
+		wal->generation = header.generation;
+		wal->next_lsn	= header.checkpoint_lsn + 1;
+
+		/* The log ends at the first record that was not written whole */
+		while (ion_wal_read_record(wal, wal->end, wal->next_lsn, &record)) {
+			wal->end += sizeof(record) + record.size;
+			wal->next_lsn++;
+		}
+	}
+
+	wal->durable_lsn	= wal->next_lsn - 1;
+	wal->syncing		= boolean_false;
+
+#if ION_THREAD_SAFE
+	pthread_mutex_init(&wal->lock, NULL);
+	pthread_cond_init(&wal->synced, NULL);
+#endif
+
+	return err_ok;
+}
+
+ion_err_t
+ion_wal_replay(
+	ion_wal_t		*wal,
+	ion_wal_apply_t apply,
+	void			*context
+) {
+	ion_wal_header_t	header;
+	ion_wal_record_t	record;
+	ion_file_offset_t	offset = sizeof(header);
+	ion_wal_lsn_t		lsn;
+	ion_err_t			error;
+
+	error = ion_fread_at(wal->file, 0, sizeof(header), (ion_byte_t *) &header);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	/* Nothing has been appended yet, so the buffer is free to read into */
+	for (lsn = header.checkpoint_lsn + 1; lsn < wal->next_lsn; lsn++) {
+		if (!ion_wal_read_record(wal, offset, lsn, &record)) {
+			return err_file_read_error;
+		}
+
+		error = apply(context, record.type, wal->buffer, record.size);
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		offset += sizeof(record) + record.size;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+ion_wal_append(
+	ion_wal_t		*wal,
+	ion_byte_t		type,
+	ion_byte_t		*first,
+	unsigned int	first_size,
+	ion_byte_t		*second,
+	unsigned int	second_size,
+	ion_wal_lsn_t	*lsn
+) {
+	ion_wal_record_t	record;
+	unsigned int		size = sizeof(record) + first_size + second_size;
+	ion_err_t			error;
+
+	if (first_size + second_size > UINT16_MAX) {
+		return err_out_of_bounds;
+	}
+
+	ion_wal_lock(wal);
+
+	if (wal->buffered + size > wal->capacity) {
+		error = ion_wal_write(wal);
+
+		if (err_ok == error) {
+			error = ion_wal_reserve(wal, size);
+		}
+
+		if (err_ok != error) {
+			ion_wal_unlock(wal);
+			return error;
+		}
+	}
+
+	record.lsn			= wal->next_lsn++;
+	record.generation	= wal->generation;
+	record.checksum		= 0;
+	record.size			= (uint16_t) (first_size + second_size);
+	record.type			= type;
+	record.reserved		= 0;
+
+	record.checksum		= ion_wal_checksum(ion_wal_checksum(ion_wal_checksum(2166136261U, (ion_byte_t *) &record, sizeof(record)), first, first_size), second, second_size);
+
+	memcpy(wal->buffer + wal->buffered, &record, sizeof(record));
+	memcpy(wal->buffer + wal->buffered + sizeof(record), first, first_size);
+
+	if (second_size > 0) {
+		memcpy(wal->buffer + wal->buffered + sizeof(record) + first_size, second, second_size);
+	}
+
+	wal->buffered	+= size;
+	*lsn			= record.lsn;
+
+	ion_wal_unlock(wal);
+
+	return err_ok;
+}
+
+ion_err_t
+ion_wal_commit(
+	ion_wal_t		*wal,
+	ion_wal_lsn_t	lsn
+) {
+	ion_wal_lsn_t	last;
+	ion_err_t		error = err_ok;
+
+	ion_wal_lock(wal);
+
+	/* Threads waiting here while another synchronizes usually find their records committed by it */
+	while (wal->syncing && (lsn > wal->durable_lsn)) {
+		ion_wal_wait(wal);
+	}
+
+	if (lsn > wal->durable_lsn) {
+		last	= wal->next_lsn - 1;
+		error	= ion_wal_write(wal);
+
+		if (err_ok == error) {
+			/* Appends carry on into the buffer while the file is synchronized */
+			wal->syncing = boolean_true;
+			ion_wal_unlock(wal);
+
+			error = ion_fsync(wal->file);
+
+			ion_wal_lock(wal);
+			wal->syncing = boolean_false;
+
+			if ((err_ok == error) && (last > wal->durable_lsn)) {
+				wal->durable_lsn = last;
+			}
+
+			ion_wal_wake(wal);
+		}
+	}
+
+	ion_wal_unlock(wal);
+
+	return error;
+}
+
+ion_err_t
+ion_wal_checkpoint(
+	ion_wal_t *wal
+) {
+	ion_err_t error;
+
+	ion_wal_lock(wal);
+
+	while (wal->syncing) {
+		ion_wal_wait(wal);
+	}
+
+	/* Records left in the file from before are of the old generation, and so are not read again */
+	wal->generation++;
+	wal->buffered	= 0;
+	wal->end		= sizeof(ion_wal_header_t);
+	error			= ion_wal_write_header(wal, wal->next_lsn - 1);
+
+	if (err_ok == error) {
+		wal->durable_lsn = wal->next_lsn - 1;
+	}
+
+	ion_wal_unlock(wal);
+
+	return error;
+}
+
+ion_file_offset_t
+ion_wal_size(
+	ion_wal_t *wal
+) {
+	ion_file_offset_t size;
+
+	ion_wal_lock(wal);
+	size = wal->end + wal->buffered - sizeof(ion_wal_header_t);
+	ion_wal_unlock(wal);
+
+	return size;
+}
+
+ion_err_t
+ion_wal_close(
+	ion_wal_t *wal
+) {
+	ion_err_t error = ion_wal_commit(wal, wal->next_lsn - 1);
+
+	if (err_ok != ion_fclose(wal->file)) {
+		error = err_file_close_error;
+	}
+
+	free(wal->buffer);
+
+#if ION_THREAD_SAFE
+	pthread_mutex_destroy(&wal->lock);
+	pthread_cond_destroy(&wal->synced);
+#endif
+
+	return error;
+}
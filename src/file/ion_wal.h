@@ -0,0 +1,250 @@
+/******************************************************************************/
+/**
+@file
+@brief		A write-ahead log, which makes writes durable by appending them to
+			a log file instead of synchronizing the files they change.
+@details	Records are appended to a buffer and given increasing log
+			sequence numbers (LSNs). Committing a record writes the buffer to
+			the log and synchronizes it, and a thread that commits while
+			another is synchronizing waits for it and is then usually done,
+			so that threads writing at once share a synchronization. Once the
+			owner of the log has made everything logged durable by other
+			means, a checkpoint drops the records, and the log starts over.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#if !defined(ION_WAL_H_)
+#define ION_WAL_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../key_value/kv_system.h"
+#include "ion_file.h"
+
+#if ION_THREAD_SAFE
+#include <pthread.h>
+#endif
+
+/**
+@brief		The bytes a log buffers before writing them out, unless a single
+			record needs more.
+*/
+#if !defined(ION_WAL_BUFFER_SIZE)
+#if defined(ARDUINO)
+#define ION_WAL_BUFFER_SIZE 64
+#else
+#define ION_WAL_BUFFER_SIZE 4096
+#endif
+#endif
+
+/**
+@brief		The size a log may reach before its owner should take a
+			checkpoint.
+*/
+#if !defined(ION_WAL_CHECKPOINT_SIZE)
+#if defined(ARDUINO)
+#define ION_WAL_CHECKPOINT_SIZE 4096
+#else
+#define ION_WAL_CHECKPOINT_SIZE (1024 * 1024)
+#endif
+#endif
+
+/**
+@brief		A log sequence number. Records are numbered from 1, and the
+			numbers keep counting up across checkpoints.
+*/
+typedef uint32_t ion_wal_lsn_t;
+
+/**
+@brief		Applies a record read back from a log.
+@param		context
+				What was passed to @ref ion_wal_replay.
+@param		type
+				The type the record was appended with.
+@param		payload
+				The record, which is only valid during the call.
+@param		size
+				The size of the record.
+@return		The status of applying the record. Replay stops at an error.
+*/
+typedef ion_err_t (*ion_wal_apply_t)(
+	void			*context,
+	ion_byte_t		type,
+	ion_byte_t		*payload,
+	unsigned int	size
+);
+
+/**
+@brief		An open write-ahead log.
+@details	The file starts with a header holding the generation of the log
+			and the LSN of the last checkpoint. Records follow, each with the
+			generation it was written in, so those left behind from before a
+			checkpoint are told apart from the current ones.
+*/
+typedef struct wal {
+	ion_file_handle_t	file;			/**< The log file. */
+	ion_byte_t			*buffer;		/**< Records not yet written to the file. */
+	unsigned int		capacity;		/**< Size of @p buffer. */
+	unsigned int		buffered;		/**< Bytes in @p buffer. */
+	ion_file_offset_t	end;			/**< Where @p buffer goes in the file. */
+	uint32_t			generation;		/**< Counts the checkpoints. */
+	ion_wal_lsn_t		next_lsn;		/**< The LSN of the next record appended. */
+	ion_wal_lsn_t		durable_lsn;	/**< The last LSN on the storage device. */
+	ion_boolean_t		syncing;		/**< Whether a commit is synchronizing the
+											 file, which it does without
+											 holding @p lock. */
+#if ION_THREAD_SAFE
+	pthread_mutex_t		lock;			/**< Guards everything above. */
+	pthread_cond_t		synced;			/**< Signalled when @p syncing is
+											 cleared. */
+#endif
+} ion_wal_t;
+
+/**
+@brief		Opens the log in the file @p name, creating it if it does not
+			exist.
+@details	The records of an existing log are kept, to be read with
+			@ref ion_wal_replay, and appending continues after them. Parts of
+			records that were being written when the system stopped may lie
+			past them, so a log that was replayed should be checkpointed
+			before more is appended.
+@param		wal
+				The log to open.
+@param		name
+				The name of the log file.
+@return		The status of opening the log.
+*/
+ion_err_t
+ion_wal_open(
+	ion_wal_t	*wal,
+	char		*name
+);
+
+/**
+@brief		Calls @p apply on each record logged since the last checkpoint,
+			in the order they were appended.
+@param		wal
+				The log to read.
+@param		apply
+				What to do with each record.
+@param		context
+				Passed through to @p apply.
+@return		The status of reading the log, or the first error @p apply gave.
+*/
+ion_err_t
+ion_wal_replay(
+	ion_wal_t		*wal,
+	ion_wal_apply_t apply,
+	void			*context
+);
+
+/**
+@brief		Appends a record, made of two parts written one after the other,
+			to the log.
+@details	The record is only buffered. It is durable once a commit of its
+			LSN, or of a later one, has returned.
+@param		wal
+				The log to append to.
+@param		type
+				A type for the record, given back by @ref ion_wal_replay.
+@param		first
+				The first part of the record.
+@param		first_size
+				The size of @p first.
+@param		second
+				The second part of the record, or @c NULL.
+@param		second_size
+				The size of @p second.
+@param[out]	lsn
+				The LSN the record was given.
+@return		The status of appending the record.
+*/
+ion_err_t
+ion_wal_append(
+	ion_wal_t		*wal,
+	ion_byte_t		type,
+	ion_byte_t		*first,
+	unsigned int	first_size,
+	ion_byte_t		*second,
+	unsigned int	second_size,
+	ion_wal_lsn_t	*lsn
+);
+
+/**
+@brief		Waits until the records up to and including @p lsn are on the
+			storage device.
+@details	If they are not yet, everything appended so far is written and
+			the log is synchronized, which also commits the records of any
+			thread that appended meanwhile. Records may still be appended
+			while the log is synchronized, and a commit made meanwhile waits
+			for that synchronization rather than starting another.
+@param		wal
+				The log to commit.
+@param		lsn
+				The LSN to make durable.
+@return		The status of the commit.
+*/
+ion_err_t
+ion_wal_commit(
+	ion_wal_t		*wal,
+	ion_wal_lsn_t	lsn
+);
+
+/**
+@brief		Drops every record logged so far.
+@details	The caller must first have made what was logged durable by
+			other means, and must keep records from being appended until this
+			returns.
+@param		wal
+				The log to start over.
+@return		The status of the checkpoint.
+*/
+ion_err_t
+ion_wal_checkpoint(
+	ion_wal_t *wal
+);
+
+/**
+@brief		Gives the bytes logged since the last checkpoint.
+@param		wal
+				The log to measure.
+@return		The size of the records in the log.
+*/
+ion_file_offset_t
+ion_wal_size(
+	ion_wal_t *wal
+);
+
+/**
+@brief		Commits everything appended, and closes the log.
+@param		wal
+				The log to close.
+@return		The status of closing the log.
+*/
+ion_err_t
+ion_wal_close(
+	ion_wal_t *wal
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ION_WAL_H_ */
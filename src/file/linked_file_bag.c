@@ -71,6 +71,43 @@ lfb_put(
 	return err_ok;
 }
 
+ion_err_t
+lfb_append(
+	ion_lfb_t			*bag,
+	ion_byte_t			*to_write,
+	unsigned int		num_bytes,
+	ion_file_offset_t	next,
+	ion_file_offset_t	*end
+) {
+	ion_err_t error;
+
+	if (ION_LFB_NULL == *end) {
+		error = ion_fseek(bag->file_handle, 0, ION_FILE_END);
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		*end = ion_ftell(bag->file_handle);
+	}
+
+	error = ion_fwrite(bag->file_handle, sizeof(ion_file_offset_t), (ion_byte_t *) &next);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	error = ion_fwrite(bag->file_handle, num_bytes, to_write);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	*end += sizeof(ion_file_offset_t) + num_bytes;
+
+	return err_ok;
+}
+
 ion_err_t
 lfb_get(
 	ion_lfb_t			*bag,
@@ -74,8 +74,36 @@ lfb_put(
 );
 
 /**
-@brief
+@brief		Add an item to the end of the linked file bag.
+@details	Unlike @ref lfb_put, deleted slots are not reused and the end
+			of the file is not looked up again for every item, so many
+			items can be written one after another without seeking.
+@param		bag
+				A pointer to the linked file bag handler object which
+				we wish to add this item to.
+@param		to_write
+				A pointer to the buffer of data to write.
+@param		num_bytes
+				The number of bytes to write from the start of @p to_write.
+@param		next
+				The offset of next item in this bag, if one exists (otherwise,
+				pass in @c -1).
+@param		end
+				A pointer to the offset of the end of the bag. Pass in
+				@c -1 on the first call to have it found. The item is written
+				there, and @p end is advanced past it. Nothing else may move
+				the file position between calls.
+@returns	An error code describing the result of the call.
 */
+ion_err_t
+lfb_append(
+	ion_lfb_t			*bag,
+	ion_byte_t			*to_write,
+	unsigned int		num_bytes,
+	ion_file_offset_t	next,
+	ion_file_offset_t	*end
+);
+
 /**
 @brief		Add an item to the linked file bag.
 @param		bag
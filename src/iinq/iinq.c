@@ -1,7 +1,271 @@
 #include <stdio.h>
+#include <string.h>
 #include "iinq.h"
 #include "../dictionary/bpp_tree/bpp_tree_handler.h"
 
+/**
+@brief		A source kept open by the source cache.
+*/
+typedef struct {
+	char						*schema_file_name;	/**< The schema file of the
+														 source, or NULL if the
+														 entry is free. */
+	ion_dictionary_handler_t	handler;		/**< Handler of @p dictionary. */
+	ion_dictionary_t			dictionary;		/**< The open dictionary. */
+	unsigned long				last_used;		/**< When the entry was last
+													 used, for eviction. */
+} ion_iinq_cached_source_t;
+
+/**
+@brief		The data modifying operations run through the source cache.
+*/
+typedef enum {
+	iinq_modify_insert, iinq_modify_update, iinq_modify_delete
+} ion_iinq_modify_t;
+
+static ion_iinq_cached_source_t iinq_source_cache[IINQ_SOURCE_CACHE_SIZE];
+static unsigned long			iinq_source_cache_clock = 0;
+static int						iinq_source_cache_count = 0;
+
+/**
+@brief		Closes the master table, unless cached sources still need it.
+*/
+static ion_err_t
+iinq_release_master_table(
+	void
+) {
+	if (0 != iinq_source_cache_count) {
+		return err_ok;
+	}
+
+	return ion_close_master_table();
+}
+
+/**
+@brief		Finds the cached entry of a source, or @c NULL if it is not
+			cached.
+*/
+static ion_iinq_cached_source_t *
+iinq_find_cached_source(
+	char *schema_file_name
+) {
+	int i;
+
+	for (i = 0; i < IINQ_SOURCE_CACHE_SIZE; i++) {
+		if ((NULL != iinq_source_cache[i].schema_file_name) && (0 == strcmp(iinq_source_cache[i].schema_file_name, schema_file_name))) {
+			return &iinq_source_cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Closes the dictionary of a cached entry and frees the entry.
+*/
+static ion_err_t
+iinq_evict_source(
+	ion_iinq_cached_source_t *entry
+) {
+	ion_err_t error = ion_close_dictionary(&entry->dictionary);
+
+	free(entry->schema_file_name);
+	entry->schema_file_name = NULL;
+	iinq_source_cache_count--;
+
+	return error;
+}
+
+/**
+@brief		Reads the schema file of a source and opens its dictionary,
+			leaving the master table open.
+*/
+static ion_err_t
+iinq_read_source(
+	char					*schema_file_name,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_handler_t	*handler
+) {
+	ion_err_t				error;
+	FILE				*schema_file;
+	ion_dictionary_id_t id;
+
+	error = ion_init_master_table();
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	/* Load the handler. */
+	bpptree_init(handler);
+
+	/* If the schema file already exists. */
+	if (NULL != (schema_file = fopen(schema_file_name, "rb"))) {
+		if (0 != fseek(schema_file, 0, SEEK_SET)) {
+			return err_file_bad_seek;
+		}
+
+		if (1 != fread(&id, sizeof(id), 1, schema_file)) {
+			return err_file_incomplete_read;
+		}
+
+		error = ion_open_dictionary(handler, dictionary, id);
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		if (0 != fclose(schema_file)) {
+			return err_file_close_error;
+		}
+
+		error = err_ok;
+	}
+	else {
+		error = err_file_open_error;
+	}
+
+	return error;
+}
+
+/**
+@brief		Returns the open dictionary of a source, opening it if it is not
+			cached yet.
+@details	When the cache is full, the least recently used source is closed
+			to make room for this one.
+*/
+static ion_err_t
+iinq_open_cached_source(
+	char				*schema_file_name,
+	ion_dictionary_t	**dictionary
+) {
+	ion_err_t					error;
+	ion_iinq_cached_source_t	*entry;
+	char						*name;
+	int							i;
+
+	entry = iinq_find_cached_source(schema_file_name);
+
+	if (NULL == entry) {
+		/* The name is copied first, so that running out of memory leaves the cache as it was */
+		name = malloc(strlen(schema_file_name) + 1);
+
+		if (NULL == name) {
+			return err_out_of_memory;
+		}
+
+		strcpy(name, schema_file_name);
+
+		entry = &iinq_source_cache[0];
+
+		for (i = 0; i < IINQ_SOURCE_CACHE_SIZE; i++) {
+			if (NULL == iinq_source_cache[i].schema_file_name) {
+				entry = &iinq_source_cache[i];
+				break;
+			}
+
+			if (iinq_source_cache[i].last_used < entry->last_used) {
+				entry = &iinq_source_cache[i];
+			}
+		}
+
+		if (NULL != entry->schema_file_name) {
+			error = iinq_evict_source(entry);
+
+			if (err_ok != error) {
+				free(name);
+				return error;
+			}
+		}
+
+		entry->dictionary.handler	= &entry->handler;
+
+		error						= iinq_read_source(schema_file_name, &entry->dictionary, &entry->handler);
+
+		if (err_ok != error) {
+			free(name);
+			iinq_release_master_table();
+			return error;
+		}
+
+		entry->schema_file_name = name;
+		iinq_source_cache_count++;
+	}
+
+	entry->last_used	= ++iinq_source_cache_clock;
+	*dictionary			= &entry->dictionary;
+
+	return err_ok;
+}
+
+/**
+@brief		Runs a data modifying operation against a source.
+@details	Sources are kept open in the source cache between calls.
+*/
+static ion_status_t
+iinq_modify(
+	char				*schema_file_name,
+	ion_iinq_modify_t	operation,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_err_t			error;
+	ion_status_t		status;
+	ion_dictionary_t	*dictionary;
+
+	error = iinq_open_cached_source(schema_file_name, &dictionary);
+
+	if (err_ok != error) {
+		return ION_STATUS_ERROR(error);
+	}
+
+	switch (operation) {
+		case iinq_modify_insert: {
+			status = dictionary_insert(dictionary, key, value);
+			break;
+		}
+
+		case iinq_modify_update: {
+			status = dictionary_update(dictionary, key, value);
+			break;
+		}
+
+		default: {
+			status = dictionary_delete(dictionary, key);
+			break;
+		}
+	}
+
+	return status;
+}
+
+ion_err_t
+iinq_close_sources(
+	void
+) {
+	ion_err_t	error = err_ok;
+	ion_err_t	close_error;
+	int			i;
+
+	for (i = 0; i < IINQ_SOURCE_CACHE_SIZE; i++) {
+		if (NULL != iinq_source_cache[i].schema_file_name) {
+			close_error = iinq_evict_source(&iinq_source_cache[i]);
+
+			if (err_ok == error) {
+				error = close_error;
+			}
+		}
+	}
+
+	close_error = ion_close_master_table();
+
+	if (err_ok == error) {
+		error = close_error;
+	}
+
+	return error;
+}
+
 ion_err_t
 iinq_create_source(
 	char					*schema_file_name,
@@ -60,7 +324,7 @@ iinq_create_source(
 		error = err_file_open_error;
 	}
 
-	ion_close_master_table();
+	iinq_release_master_table();
 
 	return error;
 }
@@ -71,46 +335,21 @@ iinq_open_source(
 	ion_dictionary_t			*dictionary,
 	ion_dictionary_handler_t	*handler
 ) {
-	ion_err_t				error;
-	FILE				*schema_file;
-	ion_dictionary_id_t id;
-
-	error = ion_init_master_table();
-
-	if (err_ok != error) {
-		return error;
-	}
-
-	/* Load the handler. */
-	bpptree_init(handler);
-
-	/* If the schema file already exists. */
-	if (NULL != (schema_file = fopen(schema_file_name, "rb"))) {
-		if (0 != fseek(schema_file, 0, SEEK_SET)) {
-			return err_file_bad_seek;
-		}
-
-		if (1 != fread(&id, sizeof(id), 1, schema_file)) {
-			return err_file_incomplete_read;
-		}
+	ion_err_t					error;
+	ion_iinq_cached_source_t	*entry;
 
-		error = ion_open_dictionary(handler, dictionary, id);
+	/* The caller gets its own instance, so the cached one must not hold unwritten changes. */
+	if (NULL != (entry = iinq_find_cached_source(schema_file_name))) {
+		error = iinq_evict_source(entry);
 
 		if (err_ok != error) {
 			return error;
 		}
-
-		if (0 != fclose(schema_file)) {
-			return err_file_close_error;
-		}
-
-		error = err_ok;
-	}
-	else {
-		error = err_file_open_error;
 	}
 
-	ion_close_master_table();
+	error = iinq_read_source(schema_file_name, dictionary, handler);
+
+	iinq_release_master_table();
 
 	return error;
 }
@@ -120,9 +359,32 @@ iinq_insert(
 	char 		*schema_file_name,
 	ion_key_t	key,
 	ion_value_t value
+) {
+	return iinq_modify(schema_file_name, iinq_modify_insert, key, value);
+}
+
+ion_status_t
+iinq_update(
+	char 		*schema_file_name,
+	ion_key_t	key,
+	ion_value_t value
+) {
+	return iinq_modify(schema_file_name, iinq_modify_update, key, value);
+}
+
+ion_status_t
+iinq_delete(
+	char 		*schema_file_name,
+	ion_key_t	key
+) {
+	return iinq_modify(schema_file_name, iinq_modify_delete, key, NULL);
+}
+
+ion_err_t
+iinq_drop(
+	char *schema_file_name
 ) {
 	ion_err_t					error;
-	ion_status_t			status		= ION_STATUS_INITIALIZE;
 	ion_dictionary_t			dictionary;
 	ion_dictionary_handler_t	handler;
 
@@ -130,95 +392,1118 @@ iinq_insert(
 
 	error					= iinq_open_source(schema_file_name, &dictionary, &handler);
 	if (err_ok != error) {
-		status				= ION_STATUS_ERROR(error);
-		goto RETURN;
+		return error;
 	}
 
-	status					= dictionary_insert(&dictionary, key, value);
-	error					= ion_close_dictionary(&dictionary);
-	if (err_ok == status.error && err_ok != error) {
-		status.error		= error;
-	}
+	error					= dictionary_delete_dictionary(&dictionary);
 
-	RETURN:
-	return status;
+	fremove(schema_file_name);
+
+	return error;
 }
 
-ion_status_t
-iinq_update(
-	char 		*schema_file_name,
-	ion_key_t	key,
-	ion_value_t value
+/**
+@brief		One record of the inner source of a hash join.
+@details	Followed in memory by the join key, the record key and the
+			record value.
+*/
+typedef struct {
+	int next;	/**< The next record in the same bucket, or -1. */
+} ion_iinq_hash_join_entry_t;
+
+/**
+@brief		Opens both sources of a join, and sizes the result for a record
+			of each.
+*/
+static ion_err_t
+iinq_open_join_sources(
+	char						*outer_schema_file_name,
+	char						*inner_schema_file_name,
+	ion_iinq_source_t			*outer,
+	ion_iinq_source_t			*inner,
+	ion_iinq_result_t			*result
 ) {
-	ion_err_t					error;
-	ion_status_t			status		= ION_STATUS_INITIALIZE;
-	ion_dictionary_t			dictionary;
-	ion_dictionary_handler_t	handler;
+	ion_err_t error;
 
-	dictionary.handler		= &handler;
+	outer->dictionary.handler	= &outer->handler;
+	inner->dictionary.handler	= &inner->handler;
+
+	error						= iinq_open_source(outer_schema_file_name, &outer->dictionary, &outer->handler);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	error = iinq_open_source(inner_schema_file_name, &inner->dictionary, &inner->handler);
 
-	error					= iinq_open_source(schema_file_name, &dictionary, &handler);
 	if (err_ok != error) {
-		status				= ION_STATUS_ERROR(error);
-		goto RETURN;
+		ion_close_dictionary(&outer->dictionary);
+		return error;
 	}
 
-	status					= dictionary_update(&dictionary, key, value);
-	error					= ion_close_dictionary(&dictionary);
-	if (err_ok == status.error && err_ok != error) {
-		status.error		= error;
+	result->num_bytes	= outer->dictionary.instance->record.key_size + outer->dictionary.instance->record.value_size + inner->dictionary.instance->record.key_size + inner->dictionary.instance->record.value_size;
+	result->data		= malloc(result->num_bytes);
+
+	if (NULL == result->data) {
+		ion_close_dictionary(&inner->dictionary);
+		ion_close_dictionary(&outer->dictionary);
+		return err_out_of_memory;
 	}
 
-	RETURN:
-	return status;
+	/* The records are read straight into the result, laid out as SELECT_ALL would. */
+	outer->ion_record.key	= result->data;
+	outer->ion_record.value = (ion_byte_t *) outer->ion_record.key + outer->dictionary.instance->record.key_size;
+	inner->ion_record.key	= (ion_byte_t *) outer->ion_record.value + outer->dictionary.instance->record.value_size;
+	inner->ion_record.value = (ion_byte_t *) inner->ion_record.key + inner->dictionary.instance->record.key_size;
+
+	return err_ok;
 }
 
-ion_status_t
-iinq_delete(
-	char 		*schema_file_name,
-	ion_key_t	key
+/**
+@brief		Closes both sources of a join, returning @p error unless closing
+			fails where it did not.
+*/
+static ion_err_t
+iinq_close_join_sources(
+	ion_iinq_source_t	*outer,
+	ion_iinq_source_t	*inner,
+	ion_iinq_result_t	*result,
+	ion_err_t			error
 ) {
-	ion_err_t					error;
-	ion_status_t			status		= ION_STATUS_INITIALIZE;
-	ion_dictionary_t			dictionary;
-	ion_dictionary_handler_t	handler;
+	ion_err_t close_error;
 
-	dictionary.handler		= &handler;
+	free(result->data);
 
-	error					= iinq_open_source(schema_file_name, &dictionary, &handler);
-	if (err_ok != error) {
-		status				= ION_STATUS_ERROR(error);
-		goto RETURN;
+	close_error = ion_close_dictionary(&inner->dictionary);
+
+	if (err_ok == error) {
+		error = close_error;
 	}
 
-	status					= dictionary_delete(&dictionary, key);
-	error					= ion_close_dictionary(&dictionary);
-	if (err_ok == status.error && err_ok != error) {
-		status.error		= error;
+	close_error = ion_close_dictionary(&outer->dictionary);
+
+	if (err_ok == error) {
+		error = close_error;
 	}
 
-	RETURN:
-	return status;
+	return error;
+}
+
+/**
+@brief		Returns whether a cursor has moved to another record.
+*/
+static ion_boolean_t
+iinq_next_record(
+	ion_iinq_source_t *source
+) {
+	source->cursor_status = source->cursor->next(source->cursor, &source->ion_record);
+
+	return cs_cursor_active == source->cursor_status || cs_cursor_initialized == source->cursor_status;
+}
+
+/**
+@brief		Writes the join key of the current record of a source, which is
+			its dictionary key when @p join_key_func is @c NULL.
+*/
+static void
+iinq_join_key(
+	ion_iinq_source_t			*source,
+	ion_iinq_join_key_func_t	join_key_func,
+	ion_key_size_t				join_key_size,
+	ion_key_t					join_key
+) {
+	if (NULL == join_key_func) {
+		memcpy(join_key, source->ion_record.key, join_key_size);
+	}
+	else {
+		join_key_func(source->ion_record.key, source->ion_record.value, join_key);
+	}
+}
+
+/**
+@brief		Returns whether a source gives join keys of @p join_key_size
+			bytes, which it does through @p join_key_func, or through its
+			dictionary key only if that is of the same size.
+*/
+static ion_boolean_t
+iinq_join_key_fits(
+	ion_iinq_source_t			*source,
+	ion_iinq_join_key_func_t	join_key_func,
+	ion_key_size_t				join_key_size
+) {
+	return NULL != join_key_func || source->dictionary.instance->record.key_size == join_key_size;
 }
 
 ion_err_t
-iinq_drop(
-	char *schema_file_name
+iinq_index_join(
+	char						*outer_schema_file_name,
+	char						*inner_schema_file_name,
+	ion_iinq_join_key_func_t	outer_key,
+	ion_key_size_t				join_key_size,
+	ion_iinq_query_processor_t	*processor
 ) {
-	ion_err_t					error;
-	ion_dictionary_t			dictionary;
-	ion_dictionary_handler_t	handler;
+	ion_err_t			error;
+	ion_iinq_source_t	outer;
+	ion_iinq_source_t	inner;
+	ion_iinq_result_t	result;
+	ion_key_t			join_key;
 
-	dictionary.handler		= &handler;
+	error = iinq_open_join_sources(outer_schema_file_name, inner_schema_file_name, &outer, &inner, &result);
 
-	error					= iinq_open_source(schema_file_name, &dictionary, &handler);
 	if (err_ok != error) {
 		return error;
 	}
 
-	error					= dictionary_delete_dictionary(&dictionary);
+	/* Outer keys are looked up as inner keys, so they must be alike unless a key function makes them so */
+	if ((join_key_size != inner.dictionary.instance->record.key_size) || !iinq_join_key_fits(&outer, outer_key, join_key_size) || ((NULL == outer_key) && (outer.dictionary.instance->key_type != inner.dictionary.instance->key_type))) {
+		return iinq_close_join_sources(&outer, &inner, &result, err_invalid_predicate);
+	}
 
-	fremove(schema_file_name);
+	join_key	= alloca(inner.dictionary.instance->record.key_size);
 
-	return error;
+	dictionary_build_predicate(&outer.predicate, predicate_all_records);
+	error		= dictionary_find(&outer.dictionary, &outer.predicate, &outer.cursor);
+
+	if (err_ok != error) {
+		return iinq_close_join_sources(&outer, &inner, &result, error);
+	}
+
+	while (iinq_next_record(&outer)) {
+		iinq_join_key(&outer, outer_key, inner.dictionary.instance->record.key_size, join_key);
+
+		/* The inner source is only read for the records that match. */
+		dictionary_build_predicate(&inner.predicate, predicate_equality, join_key);
+		error = dictionary_find(&inner.dictionary, &inner.predicate, &inner.cursor);
+
+		if (err_ok != error) {
+			break;
+		}
+
+		while (iinq_next_record(&inner)) {
+			processor->execute(&result, processor->state);
+		}
+
+		inner.cursor->destroy(&inner.cursor);
+	}
+
+	outer.cursor->destroy(&outer.cursor);
+
+	return iinq_close_join_sources(&outer, &inner, &result, error);
+}
+
+ion_err_t
+iinq_hash_join(
+	char						*outer_schema_file_name,
+	char						*inner_schema_file_name,
+	ion_iinq_join_key_func_t	outer_key,
+	ion_iinq_join_key_func_t	inner_key,
+	ion_key_size_t				join_key_size,
+	ion_iinq_query_processor_t	*processor
+) {
+	ion_err_t			error;
+	ion_iinq_source_t	outer;
+	ion_iinq_source_t	inner;
+	ion_iinq_result_t	result;
+	ion_byte_t			*entries	= NULL;
+	int					*buckets	= NULL;
+	int					count		= 0;
+	int					capacity	= 0;
+	int					num_buckets = 1;
+	int					inner_size;
+	int					entry_size;
+	int					i;
+	ion_key_t			join_key;
+
+	error = iinq_open_join_sources(outer_schema_file_name, inner_schema_file_name, &outer, &inner, &result);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	if (!iinq_join_key_fits(&outer, outer_key, join_key_size) || !iinq_join_key_fits(&inner, inner_key, join_key_size) || ((NULL == outer_key) && (NULL == inner_key) && (outer.dictionary.instance->key_type != inner.dictionary.instance->key_type))) {
+		return iinq_close_join_sources(&outer, &inner, &result, err_invalid_predicate);
+	}
+
+	/* Build: load the inner source into memory, behind its join keys. */
+	inner_size	= inner.dictionary.instance->record.key_size + inner.dictionary.instance->record.value_size;
+	entry_size	= sizeof(ion_iinq_hash_join_entry_t) + join_key_size + inner_size;
+
+	dictionary_build_predicate(&inner.predicate, predicate_all_records);
+	error		= dictionary_find(&inner.dictionary, &inner.predicate, &inner.cursor);
+
+	if (err_ok != error) {
+		return iinq_close_join_sources(&outer, &inner, &result, error);
+	}
+
+	while (iinq_next_record(&inner)) {
+		ion_byte_t *entry;
+
+		if (count == capacity) {
+			ion_byte_t *grown;
+
+			capacity	= (0 == capacity) ? 16 : capacity * 2;
+			grown		= realloc(entries, (size_t) capacity * entry_size);
+
+			if (NULL == grown) {
+				error = err_out_of_memory;
+				break;
+			}
+
+			entries = grown;
+		}
+
+		entry = entries + (size_t) count * entry_size;
+		iinq_join_key(&inner, inner_key, join_key_size, entry + sizeof(ion_iinq_hash_join_entry_t));
+		memcpy(entry + sizeof(ion_iinq_hash_join_entry_t) + join_key_size, inner.ion_record.key, inner_size);
+		count++;
+	}
+
+	inner.cursor->destroy(&inner.cursor);
+
+	while (num_buckets < count) {
+		num_buckets *= 2;
+	}
+
+	if ((err_ok == error) && (NULL == (buckets = malloc(num_buckets * sizeof(int))))) {
+		error = err_out_of_memory;
+	}
+
+	if (err_ok != error) {
+		free(entries);
+		return iinq_close_join_sources(&outer, &inner, &result, error);
+	}
+
+	for (i = 0; i < num_buckets; i++) {
+		buckets[i] = -1;
+	}
+
+	for (i = 0; i < count; i++) {
+		ion_byte_t	*entry	= entries + (size_t) i * entry_size;
+		uint32_t	bucket	= dictionary_hash_xxhash(entry + sizeof(ion_iinq_hash_join_entry_t), join_key_size) & (num_buckets - 1);
+
+		((ion_iinq_hash_join_entry_t *) entry)->next	= buckets[bucket];
+		buckets[bucket]									= i;
+	}
+
+	/* Probe: stream the outer source past the table. */
+	join_key	= alloca(join_key_size);
+
+	dictionary_build_predicate(&outer.predicate, predicate_all_records);
+	error		= dictionary_find(&outer.dictionary, &outer.predicate, &outer.cursor);
+
+	if (err_ok == error) {
+		while (iinq_next_record(&outer)) {
+			iinq_join_key(&outer, outer_key, join_key_size, join_key);
+
+			for (i = buckets[dictionary_hash_xxhash(join_key, join_key_size) & (num_buckets - 1)]; -1 != i; i = ((ion_iinq_hash_join_entry_t *) (entries + (size_t) i * entry_size))->next) {
+				ion_byte_t *entry = entries + (size_t) i * entry_size + sizeof(ion_iinq_hash_join_entry_t);
+
+				if (0 == memcmp(entry, join_key, join_key_size)) {
+					memcpy(inner.ion_record.key, entry + join_key_size, inner_size);
+					processor->execute(&result, processor->state);
+				}
+			}
+		}
+
+		outer.cursor->destroy(&outer.cursor);
+	}
+
+	free(buckets);
+	free(entries);
+
+	return iinq_close_join_sources(&outer, &inner, &result, error);
+}
+
+ion_err_t
+iinq_join(
+	char						*outer_schema_file_name,
+	char						*inner_schema_file_name,
+	ion_iinq_join_key_func_t	outer_key,
+	ion_iinq_join_key_func_t	inner_key,
+	ion_key_size_t				join_key_size,
+	ion_iinq_query_processor_t	*processor
+) {
+	/* Joining on the key of the inner source lets each outer record look up its matches. */
+	if (NULL == inner_key) {
+		return iinq_index_join(outer_schema_file_name, inner_schema_file_name, outer_key, join_key_size, processor);
+	}
+
+	return iinq_hash_join(outer_schema_file_name, inner_schema_file_name, outer_key, inner_key, join_key_size, processor);
+}
+
+/**
+@brief		A group of a query, chained in its hash bucket.
+@details	Followed in memory by the group key and the aggregate, which
+			together are the row passed on for the group.
+*/
+struct iinq_group {
+	struct iinq_group *next;	/**< The next group in the same bucket. */
+};
+
+/**
+@brief		How many times GROUPBY partitions rows before it stops writing
+			them out and lets the groups grow past their memory.
+*/
+#define IINQ_GROUP_MAX_LEVEL 8
+
+/**
+@brief		Numbers the files sorted runs and group partitions are written
+			to, so each has its own.
+*/
+static unsigned int iinq_sort_file_id = 0;
+
+void
+iinq_query_init(
+	ion_iinq_query_t			*query,
+	ion_iinq_query_processor_t	*processor
+) {
+	memset(query, 0, sizeof(ion_iinq_query_t));
+	query->processor	= processor;
+	query->order.runs	= ION_NOFILE;
+}
+
+void
+iinq_query_group_by(
+	ion_iinq_query_t			*query,
+	ion_iinq_result_size_t		offset,
+	ion_iinq_result_size_t		size,
+	ion_iinq_aggregate_func_t	aggregate,
+	ion_iinq_result_size_t		aggregate_size
+) {
+	query->group.grouped		= boolean_true;
+	query->group.offset			= offset;
+	query->group.size			= size;
+	query->group.aggregate		= aggregate;
+	query->group.aggregate_size = (NULL == aggregate) ? 0 : aggregate_size;
+}
+
+void
+iinq_query_order_by(
+	ion_iinq_query_t			*query,
+	ion_iinq_result_size_t		offset,
+	ion_iinq_result_size_t		size,
+	ion_dictionary_compare_t	compare,
+	signed char					direction
+) {
+	query->order.direction	= (direction < 0) ? iinq_order_descending : iinq_order_ascending;
+	query->order.offset		= offset;
+	query->order.size		= size;
+	query->order.compare	= compare;
+}
+
+void
+iinq_query_limit(
+	ion_iinq_query_t	*query,
+	unsigned long		limit
+) {
+	query->limited	= boolean_true;
+	query->limit	= limit;
+}
+
+/**
+@brief		Passes a row to the processor, unless the limit is reached.
+@return		Whether more rows are wanted.
+*/
+static ion_boolean_t
+iinq_query_emit(
+	ion_iinq_query_t	*query,
+	ion_iinq_result_t	*result
+) {
+	if (query->limited && (query->emitted >= query->limit)) {
+		return boolean_false;
+	}
+
+	query->processor->execute(result, query->processor->state);
+	query->emitted++;
+
+	return !query->limited || (query->emitted < query->limit);
+}
+
+/**
+@brief		Compares two rows on their sort keys, in the sort direction.
+*/
+static int
+iinq_sort_compare(
+	ion_iinq_query_t	*query,
+	unsigned char		*first,
+	unsigned char		*second
+) {
+	return query->order.direction * query->order.compare(first + query->order.offset, second + query->order.offset, query->order.size);
+}
+
+/**
+@brief		Moves a row of a heap down until neither of its children sorts
+			after it.
+*/
+static void
+iinq_sort_sift_down(
+	ion_iinq_query_t	*query,
+	unsigned char		*rows,
+	unsigned int		count,
+	unsigned int		i
+) {
+	ion_iinq_result_size_t	row_size	= query->order.row_size;
+	unsigned char			*swap		= query->order.rows + (size_t) query->order.capacity * row_size;
+	unsigned int			child;
+
+	while ((child = 2 * i + 1) < count) {
+		if ((child + 1 < count) && (iinq_sort_compare(query, rows + (size_t) (child + 1) * row_size, rows + (size_t) child * row_size) > 0)) {
+			child++;
+		}
+
+		if (iinq_sort_compare(query, rows + (size_t) child * row_size, rows + (size_t) i * row_size) <= 0) {
+			break;
+		}
+
+		memcpy(swap, rows + (size_t) i * row_size, row_size);
+		memcpy(rows + (size_t) i * row_size, rows + (size_t) child * row_size, row_size);
+		memcpy(rows + (size_t) child * row_size, swap, row_size);
+		i = child;
+	}
+}
+
+/**
+@brief		Arranges rows into a heap with the row that sorts last on top.
+*/
+static void
+iinq_sort_build_heap(
+	ion_iinq_query_t	*query,
+	unsigned char		*rows,
+	unsigned int		count
+) {
+	unsigned int i;
+
+	for (i = count / 2; i > 0; i--) {
+		iinq_sort_sift_down(query, rows, count, i - 1);
+	}
+}
+
+/**
+@brief		Sorts rows in place, with a heap sort so no more memory is
+			needed.
+*/
+static void
+iinq_sort_rows(
+	ion_iinq_query_t	*query,
+	unsigned char		*rows,
+	unsigned int		count
+) {
+	ion_iinq_result_size_t	row_size	= query->order.row_size;
+	unsigned char			*swap		= query->order.rows + (size_t) query->order.capacity * row_size;
+
+	iinq_sort_build_heap(query, rows, count);
+
+	while (count > 1) {
+		count--;
+		memcpy(swap, rows, row_size);
+		memcpy(rows, rows + (size_t) count * row_size, row_size);
+		memcpy(rows + (size_t) count * row_size, swap, row_size);
+		iinq_sort_sift_down(query, rows, count, 0);
+	}
+}
+
+/**
+@brief		Opens a new file for sorted runs, named into @p file_name.
+*/
+static ion_file_handle_t
+iinq_sort_open_runs(
+	char *file_name
+) {
+	sprintf(file_name, "%u.srt", iinq_sort_file_id);
+	iinq_sort_file_id = (iinq_sort_file_id + 1) % 10000;
+
+	ion_fremove(file_name);
+
+	return ion_fopen(file_name);
+}
+
+/**
+@brief		Writes the rows in memory out as a sorted run.
+*/
+static ion_err_t
+iinq_sort_spill(
+	ion_iinq_query_t *query
+) {
+	ion_err_t error;
+
+	if (ION_NOFILE == query->order.runs) {
+		query->order.runs = iinq_sort_open_runs(query->order.runs_file_name);
+
+		if (ION_NOFILE == query->order.runs) {
+			return err_file_open_error;
+		}
+	}
+
+	iinq_sort_rows(query, query->order.rows, query->order.count);
+
+	error = ion_fwrite_at(query->order.runs, (ion_file_offset_t) query->order.spilled * query->order.row_size, query->order.count * query->order.row_size, query->order.rows);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	query->order.spilled	+= query->order.count;
+	query->order.count		= 0;
+
+	return err_ok;
+}
+
+/**
+@brief		Adds a row to those being sorted, or passes it straight on if
+			there is no sort.
+*/
+static ion_boolean_t
+iinq_sort_push(
+	ion_iinq_query_t	*query,
+	ion_iinq_result_t	*result
+) {
+	ion_iinq_result_size_t row_size;
+
+	if (0 == query->order.direction) {
+		return iinq_query_emit(query, result);
+	}
+
+	if (NULL == query->order.rows) {
+		query->order.row_size	= result->num_bytes;
+		query->order.capacity	= IINQ_SORT_BUFFER_SIZE / result->num_bytes;
+
+		if (query->order.capacity < 2) {
+			query->order.capacity = 2;
+		}
+
+		/* When the limit fits, only the best rows so far are kept. */
+		if (query->limited && (query->limit <= query->order.capacity)) {
+			query->order.capacity	= query->limit;
+			query->order.top		= boolean_true;
+		}
+
+		query->order.rows = malloc((size_t) (query->order.capacity + 1) * query->order.row_size);
+
+		if (NULL == query->order.rows) {
+			query->error = err_out_of_memory;
+			return boolean_false;
+		}
+	}
+
+	row_size = query->order.row_size;
+
+	if (query->order.count == query->order.capacity) {
+		if (query->order.top) {
+			/* The top of the heap is the worst row kept, so it is replaced by any better one. */
+			if (iinq_sort_compare(query, result->data, query->order.rows) < 0) {
+				memcpy(query->order.rows, result->data, row_size);
+				iinq_sort_sift_down(query, query->order.rows, query->order.count, 0);
+			}
+
+			return boolean_true;
+		}
+
+		query->error = iinq_sort_spill(query);
+
+		if (err_ok != query->error) {
+			return boolean_false;
+		}
+	}
+
+	memcpy(query->order.rows + (size_t) query->order.count * row_size, result->data, row_size);
+	query->order.count++;
+
+	if (query->order.top && (query->order.count == query->order.capacity)) {
+		iinq_sort_build_heap(query, query->order.rows, query->order.count);
+	}
+
+	return boolean_true;
+}
+
+/**
+@brief		A sorted run being merged, read through its share of memory.
+*/
+typedef struct {
+	unsigned long	next;		/**< The next row of the file to read. */
+	unsigned long	end;		/**< The row of the file after the run. */
+	unsigned char	*rows;		/**< The rows read and not yet merged. */
+	unsigned int	buffered;	/**< The number of rows read. */
+	unsigned int	position;	/**< The number of those merged. */
+} ion_iinq_sort_run_t;
+
+/**
+@brief		Merges the sorted runs, a few at a time, until one pass merges
+			them all and passes the rows on.
+*/
+static ion_err_t
+iinq_sort_merge(
+	ion_iinq_query_t *query
+) {
+	ion_iinq_sort_run_t		runs[IINQ_SORT_MERGE_WAYS];
+	ion_iinq_result_t		result;
+	ion_iinq_result_size_t	row_size	= query->order.row_size;
+	unsigned long			total		= query->order.spilled;
+	unsigned long			run_length	= query->order.capacity;
+	unsigned int			ways		= IINQ_SORT_MERGE_WAYS;
+	unsigned int			chunk;
+	ion_file_handle_t		merged		= ION_NOFILE;
+	char					merged_file_name[ION_MAX_FILENAME_LENGTH];
+	ion_boolean_t			more		= boolean_true;
+	ion_err_t				error		= err_ok;
+
+	/* The runs share the memory that sorted them. */
+	if (ways > query->order.capacity) {
+		ways = query->order.capacity;
+	}
+
+	chunk				= query->order.capacity / ways;
+	result.num_bytes	= row_size;
+
+	while (more) {
+		ion_boolean_t	last_pass	= run_length * ways >= total;
+		unsigned long	start;
+
+		if (!last_pass) {
+			merged = iinq_sort_open_runs(merged_file_name);
+
+			if (ION_NOFILE == merged) {
+				return err_file_open_error;
+			}
+		}
+
+		for (start = 0; more && (start < total); start += run_length * ways) {
+			unsigned int	num_runs;
+			unsigned int	i;
+
+			for (num_runs = 0; (num_runs < ways) && (start + num_runs * run_length < total); num_runs++) {
+				runs[num_runs].next		= start + num_runs * run_length;
+				runs[num_runs].end		= runs[num_runs].next + run_length;
+				runs[num_runs].rows		= query->order.rows + (size_t) num_runs * chunk * row_size;
+				runs[num_runs].buffered = 0;
+				runs[num_runs].position = 0;
+
+				if (runs[num_runs].end > total) {
+					runs[num_runs].end = total;
+				}
+			}
+
+			while (more) {
+				int best = -1;
+
+				for (i = 0; i < num_runs; i++) {
+					if ((runs[i].position == runs[i].buffered) && (runs[i].next < runs[i].end)) {
+						runs[i].buffered = chunk;
+
+						if (runs[i].end - runs[i].next < chunk) {
+							runs[i].buffered = runs[i].end - runs[i].next;
+						}
+
+						error = ion_fread_at(query->order.runs, (ion_file_offset_t) runs[i].next * row_size, runs[i].buffered * row_size, runs[i].rows);
+
+						if (err_ok != error) {
+							more = boolean_false;
+							break;
+						}
+
+						runs[i].next		+= runs[i].buffered;
+						runs[i].position	= 0;
+					}
+
+					if ((runs[i].position < runs[i].buffered) && ((-1 == best) || (iinq_sort_compare(query, runs[i].rows + (size_t) runs[i].position * row_size, runs[best].rows + (size_t) runs[best].position * row_size) < 0))) {
+						best = i;
+					}
+				}
+
+				if (!more || (-1 == best)) {
+					break;
+				}
+
+				result.data = runs[best].rows + (size_t) runs[best].position * row_size;
+				runs[best].position++;
+
+				if (last_pass) {
+					more = iinq_query_emit(query, &result);
+				}
+				else if (err_ok != (error = ion_fwrite(merged, row_size, result.data))) {
+					more = boolean_false;
+				}
+			}
+		}
+
+		if (last_pass || (err_ok != error)) {
+			break;
+		}
+
+		/* The merged runs are the runs of the next pass. */
+		ion_fclose(query->order.runs);
+		ion_fremove(query->order.runs_file_name);
+		query->order.runs	= merged;
+		merged				= ION_NOFILE;
+		strcpy(query->order.runs_file_name, merged_file_name);
+		run_length			*= ways;
+	}
+
+	if (ION_NOFILE != merged) {
+		ion_fclose(merged);
+		ion_fremove(merged_file_name);
+	}
+
+	return error;
+}
+
+/**
+@brief		Finds the group of a key, or @c NULL if it has none yet.
+*/
+static ion_iinq_group_t *
+iinq_query_find_group(
+	ion_iinq_query_t	*query,
+	unsigned char		*key
+) {
+	ion_iinq_group_t *group;
+
+	if (0 == query->group.num_buckets) {
+		return NULL;
+	}
+
+	for (group = query->group.buckets[dictionary_hash_xxhash(key, query->group.size) & (query->group.num_buckets - 1)]; NULL != group; group = group->next) {
+		if (0 == memcmp(group + 1, key, query->group.size)) {
+			return group;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Doubles the buckets of the groups.
+*/
+static ion_err_t
+iinq_query_grow_groups(
+	ion_iinq_query_t *query
+) {
+	unsigned int		num_buckets = (0 == query->group.num_buckets) ? 16 : query->group.num_buckets * 2;
+	ion_iinq_group_t	**buckets	= calloc(num_buckets, sizeof(ion_iinq_group_t *));
+	unsigned int		i;
+
+	if (NULL == buckets) {
+		return err_out_of_memory;
+	}
+
+	for (i = 0; i < query->group.num_buckets; i++) {
+		while (NULL != query->group.buckets[i]) {
+			ion_iinq_group_t	*group	= query->group.buckets[i];
+			uint32_t			bucket	= dictionary_hash_xxhash(group + 1, query->group.size) & (num_buckets - 1);
+
+			query->group.buckets[i] = group->next;
+			group->next				= buckets[bucket];
+			buckets[bucket]			= group;
+		}
+	}
+
+	free(query->group.buckets);
+	query->group.buckets		= buckets;
+	query->group.num_buckets	= num_buckets;
+
+	return err_ok;
+}
+
+/**
+@brief		Frees the groups in memory, keeping their buckets.
+*/
+static void
+iinq_query_free_groups(
+	ion_iinq_query_t *query
+) {
+	unsigned int i;
+
+	for (i = 0; i < query->group.num_buckets; i++) {
+		while (NULL != query->group.buckets[i]) {
+			ion_iinq_group_t *group = query->group.buckets[i];
+
+			query->group.buckets[i] = group->next;
+			free(group);
+		}
+	}
+
+	query->group.count			= 0;
+	query->group.next_bucket	= 0;
+	query->group.next			= NULL;
+}
+
+/**
+@brief		Writes a row whose group does not fit in memory to the partition
+			of its group key.
+@details	The partition is picked from the key hash mixed with the level,
+			so that the rows of a partition are split anew if it does not
+			fit either when it is grouped.
+*/
+static ion_err_t
+iinq_query_spill_group_row(
+	ion_iinq_query_t	*query,
+	ion_iinq_result_t	*result
+) {
+	uint32_t					hash = dictionary_hash_xxhash(result->data + query->group.offset, query->group.size);
+	ion_iinq_group_partition_t	*partition;
+	unsigned int				i;
+	ion_err_t					error;
+
+	if (!query->group.spilling) {
+		if (query->group.num_partitions + IINQ_GROUP_PARTITIONS > query->group.max_partitions) {
+			unsigned int				max_partitions	= query->group.num_partitions + IINQ_GROUP_PARTITIONS * 4;
+			ion_iinq_group_partition_t	*partitions		= realloc(query->group.partitions, max_partitions * sizeof(ion_iinq_group_partition_t));
+
+			if (NULL == partitions) {
+				return err_out_of_memory;
+			}
+
+			query->group.partitions		= partitions;
+			query->group.max_partitions = max_partitions;
+		}
+
+		for (i = 0; i < IINQ_GROUP_PARTITIONS; i++) {
+			partition			= &query->group.partitions[query->group.num_partitions++];
+			partition->file		= ION_NOFILE;
+			partition->rows		= 0;
+			partition->level	= query->group.level;
+		}
+
+		query->group.spilling = boolean_true;
+	}
+
+	hash		^= (query->group.level + 1) * 0x9E3779B9U;
+	hash		^= hash >> 16;
+	hash		*= 0x85EBCA6BU;
+	hash		^= hash >> 13;
+	partition	= &query->group.partitions[query->group.num_partitions - IINQ_GROUP_PARTITIONS + hash % IINQ_GROUP_PARTITIONS];
+
+	if (ION_NOFILE == partition->file) {
+		partition->file = iinq_sort_open_runs(partition->file_name);
+
+		if (ION_NOFILE == partition->file) {
+			return err_file_open_error;
+		}
+	}
+
+	error = ion_fwrite_at(partition->file, (ion_file_offset_t) partition->rows * query->group.row_size, query->group.row_size, result->data);
+
+	if (err_ok == error) {
+		partition->rows++;
+	}
+
+	return error;
+}
+
+/**
+@brief		Adds a row to its group, making the group if it has none yet, or
+			writing the row out if there is no room for another group.
+@return		Whether more rows are wanted.
+*/
+static ion_boolean_t
+iinq_query_group_row(
+	ion_iinq_query_t	*query,
+	ion_iinq_result_t	*result
+) {
+	unsigned char		*key	= result->data + query->group.offset;
+	ion_iinq_group_t	*group;
+	uint32_t			bucket;
+
+	group = iinq_query_find_group(query, key);
+
+	if (NULL != group) {
+		if (NULL != query->group.aggregate) {
+			query->group.aggregate(result, (ion_byte_t *) (group + 1) + query->group.size, boolean_false);
+		}
+
+		return boolean_true;
+	}
+
+	if (0 == query->group.capacity) {
+		query->group.row_size	= result->num_bytes;
+		query->group.capacity	= IINQ_GROUP_BUFFER_SIZE / (sizeof(ion_iinq_group_t) + query->group.size + query->group.aggregate_size);
+
+		if (query->group.capacity < 1) {
+			query->group.capacity = 1;
+		}
+	}
+
+	/* Keys that still collide after being partitioned this often share their hash, so there cannot be many of them. */
+	if ((query->group.count >= query->group.capacity) && (query->group.level < IINQ_GROUP_MAX_LEVEL)) {
+		query->error = iinq_query_spill_group_row(query, result);
+		return err_ok == query->error;
+	}
+
+	if ((query->group.count >= query->group.num_buckets) && (err_ok != (query->error = iinq_query_grow_groups(query)))) {
+		return boolean_false;
+	}
+
+	group = malloc(sizeof(ion_iinq_group_t) + query->group.size + query->group.aggregate_size);
+
+	if (NULL == group) {
+		query->error = err_out_of_memory;
+		return boolean_false;
+	}
+
+	memcpy(group + 1, key, query->group.size);
+
+	if (NULL != query->group.aggregate) {
+		query->group.aggregate(result, (ion_byte_t *) (group + 1) + query->group.size, boolean_true);
+	}
+
+	bucket							= dictionary_hash_xxhash(key, query->group.size) & (query->group.num_buckets - 1);
+	group->next						= query->group.buckets[bucket];
+	query->group.buckets[bucket]	= group;
+	query->group.count++;
+
+	return boolean_true;
+}
+
+ion_boolean_t
+iinq_query_push(
+	ion_iinq_query_t	*query,
+	ion_iinq_result_t	*result
+) {
+	if (query->limited && (query->emitted >= query->limit)) {
+		return boolean_false;
+	}
+
+	if (!query->group.grouped) {
+		return iinq_sort_push(query, result);
+	}
+
+	return iinq_query_group_row(query, result);
+}
+
+/**
+@brief		Replaces the groups in memory, which have all been read, with the
+			groups of the partition written out last.
+@return		Whether there was a partition left to group.
+*/
+static ion_boolean_t
+iinq_query_regroup(
+	ion_iinq_query_t *query
+) {
+	ion_iinq_group_partition_t	partition;
+	ion_iinq_result_t			result;
+	unsigned long				i;
+
+	iinq_query_free_groups(query);
+	query->group.spilling = boolean_false;
+
+	do {
+		if (0 == query->group.num_partitions) {
+			return boolean_false;
+		}
+
+		partition = query->group.partitions[--query->group.num_partitions];
+	} while (ION_NOFILE == partition.file);
+
+	query->group.level	= partition.level + 1;
+	result.num_bytes	= query->group.row_size;
+	result.data			= malloc(query->group.row_size);
+
+	if (NULL == result.data) {
+		query->error = err_out_of_memory;
+	}
+	else {
+		for (i = 0; (err_ok == query->error) && (i < partition.rows); i++) {
+			query->error = ion_fread_at(partition.file, (ion_file_offset_t) i * query->group.row_size, query->group.row_size, result.data);
+
+			if (err_ok == query->error) {
+				iinq_query_group_row(query, &result);
+			}
+		}
+
+		free(result.data);
+	}
+
+	ion_fclose(partition.file);
+	ion_fremove(partition.file_name);
+
+	return err_ok == query->error;
+}
+
+ion_boolean_t
+iinq_query_next_group(
+	ion_iinq_query_t	*query,
+	ion_iinq_result_t	*result
+) {
+	ion_iinq_group_t *group;
+
+	if (!query->group.grouped || (err_ok != query->error)) {
+		return boolean_false;
+	}
+
+	while (NULL == query->group.next) {
+		if (query->group.next_bucket >= query->group.num_buckets) {
+			/* The groups in memory are done with, so the rows written out are grouped next. */
+			if (!iinq_query_regroup(query)) {
+				return boolean_false;
+			}
+
+			continue;
+		}
+
+		query->group.next = query->group.buckets[query->group.next_bucket++];
+	}
+
+	group				= query->group.next;
+	query->group.next	= group->next;
+	result->num_bytes	= query->group.size + query->group.aggregate_size;
+	result->data		= (unsigned char *) (group + 1);
+
+	return boolean_true;
+}
+
+ion_boolean_t
+iinq_query_push_group(
+	ion_iinq_query_t	*query,
+	ion_iinq_result_t	*result
+) {
+	if (query->limited && (query->emitted >= query->limit)) {
+		return boolean_false;
+	}
+
+	return iinq_sort_push(query, result);
+}
+
+ion_err_t
+iinq_query_finish(
+	ion_iinq_query_t *query
+) {
+	ion_iinq_result_t	result;
+	unsigned int		i;
+
+	if ((NULL != query->order.rows) && (err_ok == query->error)) {
+		if (0 == query->order.spilled) {
+			/* Everything fit in memory. */
+			iinq_sort_rows(query, query->order.rows, query->order.count);
+			result.num_bytes = query->order.row_size;
+
+			for (i = 0; i < query->order.count; i++) {
+				result.data = query->order.rows + (size_t) i * query->order.row_size;
+
+				if (!iinq_query_emit(query, &result)) {
+					break;
+				}
+			}
+		}
+		else if ((0 == query->order.count) || (err_ok == (query->error = iinq_sort_spill(query)))) {
+			query->error = iinq_sort_merge(query);
+		}
+	}
+
+	if (ION_NOFILE != query->order.runs) {
+		ion_fclose(query->order.runs);
+		ion_fremove(query->order.runs_file_name);
+	}
+
+	iinq_query_free_groups(query);
+
+	for (i = 0; i < query->group.num_partitions; i++) {
+		if (ION_NOFILE != query->group.partitions[i].file) {
+			ion_fclose(query->group.partitions[i].file);
+			ion_fremove(query->group.partitions[i].file_name);
+		}
+	}
+
+	free(query->group.partitions);
+	free(query->group.buckets);
+	free(query->order.rows);
+
+	return query->error;
 }
@@ -8,6 +8,57 @@ extern "C" {
 
 #include "../dictionary/dictionary_types.h"
 #include "../dictionary/ion_master_table.h"
+#include "../file/ion_file.h"
+
+/**
+@brief		The number of sources kept open between data modifying IINQ
+			calls.
+@details	INSERT, UPDATE and DELETE_FROM leave their source and the master
+			table open, so a run of calls against the same sources does not
+			pay for opening them each time. When more sources are used, the
+			least recently used one is closed. Call @ref iinq_close_sources
+			to close them all.
+*/
+#if !defined(IINQ_SOURCE_CACHE_SIZE)
+#define IINQ_SOURCE_CACHE_SIZE 4
+#endif
+
+/**
+@brief		The number of bytes of rows ORDERBY sorts in memory.
+@details	Larger sorts are written out in sorted runs of this size, which
+			are merged back through the same memory. An ORDERBY with a
+			LIMIT of no more rows than fit keeps only the best of them
+			instead.
+*/
+#if !defined(IINQ_SORT_BUFFER_SIZE)
+#define IINQ_SORT_BUFFER_SIZE 1024
+#endif
+
+/**
+@brief		The most sorted runs ORDERBY merges at once.
+*/
+#if !defined(IINQ_SORT_MERGE_WAYS)
+#define IINQ_SORT_MERGE_WAYS 4
+#endif
+
+/**
+@brief		The number of bytes of groups GROUPBY keeps in memory.
+@details	Once no more groups fit, the rows of groups not in memory are
+			written out to partition files by the hash of their group key.
+			Each partition is grouped in turn, through the same memory, once
+			the groups in memory are passed on.
+*/
+#if !defined(IINQ_GROUP_BUFFER_SIZE)
+#define IINQ_GROUP_BUFFER_SIZE 1024
+#endif
+
+/**
+@brief		The number of partitions GROUPBY splits the rows that do not fit
+			into at a time.
+*/
+#if !defined(IINQ_GROUP_PARTITIONS)
+#define IINQ_GROUP_PARTITIONS 4
+#endif
 
 typedef unsigned int ion_iinq_result_size_t;
 
@@ -32,6 +83,96 @@ typedef struct {
 
 #define IINQ_QUERY_PROCESSOR(execute, state)	((ion_iinq_query_processor_t){ execute, state })
 
+/**
+@brief		Function pointer type for computing the join key of a record.
+@details	Given the key and the value of a record, writes the key it is
+			joined on into the last argument. Join keys are matched byte
+			for byte.
+*/
+typedef void	(*ion_iinq_join_key_func_t)(ion_key_t, ion_value_t, ion_key_t);
+
+#define IINQ_NEW_JOIN_KEY_FUNC(name) \
+void name(ion_key_t key, ion_value_t value, ion_key_t join_key)
+
+/**
+@brief		Function pointer type for aggregating the rows of a group.
+@details	Called with each row of a group and the aggregate of the group,
+			and whether the row is the first of the group, in which case the
+			aggregate has yet to be set.
+*/
+typedef void	(*ion_iinq_aggregate_func_t)(ion_iinq_result_t*, void*, ion_boolean_t);
+
+#define IINQ_NEW_AGGREGATE_FUNC(name) \
+void name(ion_iinq_result_t *result, void *aggregate, ion_boolean_t first)
+
+/**
+@brief		The directions ORDERBY sorts in.
+*/
+enum IINQ_ORDER_DIRECTION {
+	iinq_order_ascending	= 1,
+	iinq_order_descending	= -1
+};
+
+typedef struct iinq_group ion_iinq_group_t;
+
+/**
+@brief		Rows of a query written out by GROUPBY to be grouped later.
+*/
+typedef struct {
+	ion_file_handle_t	file;		/**< The rows, or @ref ION_NOFILE if there are none. */
+	char				file_name[ION_MAX_FILENAME_LENGTH];	/**< The name of @p file. */
+	unsigned long		rows;		/**< The number of rows in @p file. */
+	unsigned int		level;		/**< How many times its rows were partitioned before. */
+} ion_iinq_group_partition_t;
+
+/**
+@brief		The GROUPBY, ORDERBY and LIMIT state of a query.
+@details	Rows passing WHERE are grouped, then those of the groups passing
+			HAVING are sorted, and the first rows up to the limit are passed
+			to the processor.
+*/
+typedef struct {
+	ion_iinq_query_processor_t	*processor;		/**< Where the rows go. */
+	ion_err_t					error;			/**< The first error met. */
+	ion_boolean_t				limited;		/**< Whether there is a limit. */
+	unsigned long				limit;			/**< The most rows to pass on. */
+	unsigned long				emitted;		/**< The rows passed on so far. */
+	struct {
+		ion_boolean_t				grouped;		/**< Whether rows are grouped. */
+		ion_iinq_result_size_t		offset;			/**< Where the group key is in a row. */
+		ion_iinq_result_size_t		size;			/**< The size of the group key. */
+		ion_iinq_aggregate_func_t	aggregate;		/**< Aggregates the rows of a group, or @c NULL. */
+		ion_iinq_result_size_t		aggregate_size;	/**< The size of the aggregate. */
+		ion_iinq_group_t			**buckets;		/**< The hash table of groups. */
+		unsigned int				num_buckets;	/**< The number of buckets, a power of two. */
+		unsigned int				count;			/**< The number of groups. */
+		unsigned int				next_bucket;	/**< The bucket groups are read from next. */
+		ion_iinq_group_t			*next;			/**< The group read next. */
+		unsigned int				capacity;		/**< The most groups kept in memory. */
+		ion_iinq_result_size_t		row_size;		/**< The size of the rows grouped. */
+		unsigned int				level;			/**< How many times the rows being grouped were partitioned. */
+		ion_iinq_group_partition_t	*partitions;	/**< Partitions not yet grouped, the last ones first. */
+		unsigned int				num_partitions;	/**< The number of @p partitions. */
+		unsigned int				max_partitions;	/**< The room in @p partitions. */
+		ion_boolean_t				spilling;		/**< Whether the last @ref IINQ_GROUP_PARTITIONS
+														 partitions take the rows that do not fit. */
+	} group;
+	struct {
+		signed char					direction;		/**< An @ref IINQ_ORDER_DIRECTION, or 0 if unsorted. */
+		ion_iinq_result_size_t		offset;			/**< Where the sort key is in a row. */
+		ion_iinq_result_size_t		size;			/**< The size of the sort key. */
+		ion_dictionary_compare_t	compare;		/**< Compares sort keys. */
+		ion_iinq_result_size_t		row_size;		/**< The size of the rows sorted. */
+		unsigned char				*rows;			/**< Rows in memory, then one more to swap through. */
+		unsigned int				capacity;		/**< The number of rows that fit in memory. */
+		unsigned int				count;			/**< The number of rows in memory. */
+		ion_boolean_t				top;			/**< Whether only the best rows are kept, in a heap. */
+		unsigned long				spilled;		/**< The number of rows written out in runs. */
+		ion_file_handle_t			runs;			/**< The file of sorted runs. */
+		char						runs_file_name[ION_MAX_FILENAME_LENGTH];	/**< The name of @p runs. */
+	} order;
+} ion_iinq_query_t;
+
 typedef struct iinq_source ion_iinq_source_t;
 
 typedef struct iinq_cleanup {
@@ -93,6 +234,186 @@ iinq_drop(
 	char *schema_file_name
 );
 
+/**
+@brief		Equi-joins two sources by looking up the matches of each outer
+			record in the inner source.
+@details	Each record of the outer source is joined on the key it is given
+			by @p outer_key, and the records of the inner source with that
+			dictionary key are found with an equality predicate, so only
+			they are read. Each matching pair is passed to @p processor,
+			laid out as SELECT_ALL lays out the records of two sources.
+@param		outer_key
+				Computes the join key, of the size of the inner dictionary
+				key, of an outer record. If @c NULL, outer records are
+				joined on their own key, which must then be of the same type
+				and size as the inner key.
+@param		join_key_size
+				The size of the join keys, which must be that of the inner
+				dictionary key.
+@return		The status of the join, which is @ref err_invalid_predicate
+			if the keys cannot be compared.
+*/
+ion_err_t
+iinq_index_join(
+	char						*outer_schema_file_name,
+	char						*inner_schema_file_name,
+	ion_iinq_join_key_func_t	outer_key,
+	ion_key_size_t				join_key_size,
+	ion_iinq_query_processor_t	*processor
+);
+
+/**
+@brief		Equi-joins two sources through an in memory hash table of the
+			inner source.
+@details	The inner source is read once into a table hashed on the keys
+			@p inner_key gives its records, and the outer source is then
+			streamed past it. The inner source must fit in memory. Each
+			matching pair is passed to @p processor, laid out as SELECT_ALL
+			lays out the records of two sources.
+@param		outer_key
+				Computes the join key of an outer record, or @c NULL to join
+				on its dictionary key.
+@param		inner_key
+				Computes the join key of an inner record, or @c NULL to join
+				on its dictionary key.
+@param		join_key_size
+				The size of the join keys. A source joined on its
+				dictionary key must have keys of this size.
+@return		The status of the join, which is @ref err_invalid_predicate
+			if the keys cannot be compared.
+*/
+ion_err_t
+iinq_hash_join(
+	char						*outer_schema_file_name,
+	char						*inner_schema_file_name,
+	ion_iinq_join_key_func_t	outer_key,
+	ion_iinq_join_key_func_t	inner_key,
+	ion_key_size_t				join_key_size,
+	ion_iinq_query_processor_t	*processor
+);
+
+/**
+@brief		Equi-joins two sources, picking how from the join condition.
+@details	When the inner source is joined on its own dictionary key, an
+			index nested loop join (@ref iinq_index_join) reads only the
+			inner records that match. Otherwise the inner source has to be
+			read in full anyway, and a hash join (@ref iinq_hash_join)
+			does so once instead of once per outer record.
+@param		join_key_size
+				The size of the join keys. A source joined on its
+				dictionary key must have keys of this size.
+@return		The status of the join, which is @ref err_invalid_predicate
+			if the keys cannot be compared.
+*/
+ion_err_t
+iinq_join(
+	char						*outer_schema_file_name,
+	char						*inner_schema_file_name,
+	ion_iinq_join_key_func_t	outer_key,
+	ion_iinq_join_key_func_t	inner_key,
+	ion_key_size_t				join_key_size,
+	ion_iinq_query_processor_t	*processor
+);
+
+/**
+@brief		Closes the sources kept open by data modifying IINQ calls, and
+			the master table.
+@details	Changes to a cached source are only known to be written once it
+			has been closed, so call this when done with IINQ.
+*/
+ion_err_t
+iinq_close_sources(
+	void
+);
+
+void
+iinq_query_init(
+	ion_iinq_query_t			*query,
+	ion_iinq_query_processor_t	*processor
+);
+
+/**
+@brief		Groups the rows of a query on the bytes of a key in them.
+@details	Each group is passed on once all rows are read, as a row of the
+			group key followed by the aggregate of the group. The groups that
+			fit in @ref IINQ_GROUP_BUFFER_SIZE are passed on first, and the
+			rest are grouped from partition files afterwards, so groups are
+			not passed on in any particular order.
+@param		aggregate
+				Aggregates the rows of a group into @p aggregate_size bytes,
+				or @c NULL to only find the distinct keys.
+*/
+void
+iinq_query_group_by(
+	ion_iinq_query_t			*query,
+	ion_iinq_result_size_t		offset,
+	ion_iinq_result_size_t		size,
+	ion_iinq_aggregate_func_t	aggregate,
+	ion_iinq_result_size_t		aggregate_size
+);
+
+/**
+@brief		Sorts the rows of a query on a key in them.
+@param		compare
+				Compares two sort keys, as a dictionary compares its keys.
+@param		direction
+				An @ref IINQ_ORDER_DIRECTION.
+*/
+void
+iinq_query_order_by(
+	ion_iinq_query_t			*query,
+	ion_iinq_result_size_t		offset,
+	ion_iinq_result_size_t		size,
+	ion_dictionary_compare_t	compare,
+	signed char					direction
+);
+
+void
+iinq_query_limit(
+	ion_iinq_query_t	*query,
+	unsigned long		limit
+);
+
+/**
+@brief		Passes a row that satisfies WHERE on to the rest of the query.
+@return		Whether more rows are wanted. Once the limit is reached without
+			sorting or grouping, no more are.
+*/
+ion_boolean_t
+iinq_query_push(
+	ion_iinq_query_t	*query,
+	ion_iinq_result_t	*result
+);
+
+/**
+@brief		Reads the next group into @p result.
+@return		Whether there was another group.
+*/
+ion_boolean_t
+iinq_query_next_group(
+	ion_iinq_query_t	*query,
+	ion_iinq_result_t	*result
+);
+
+/**
+@brief		Passes a group that satisfies HAVING on to the rest of the query.
+@return		Whether more groups are wanted.
+*/
+ion_boolean_t
+iinq_query_push_group(
+	ion_iinq_query_t	*query,
+	ion_iinq_result_t	*result
+);
+
+/**
+@brief		Passes on the sorted rows, and frees what the query held.
+@return		The first error the query met.
+*/
+ion_err_t
+iinq_query_finish(
+	ion_iinq_query_t *query
+);
+
 #define CREATE_DICTIONARY(schema_name, key_type, key_size, value_size) \
 iinq_create_source(#schema_name ".inq", key_type, key_size, value_size)
 
@@ -100,7 +421,7 @@ iinq_create_source(#schema_name ".inq", key_type, key_size, value_size)
 iinq_insert(#schema_name ".inq", key, value)
 
 #define UPDATE(schema_name, key, value) \
-iinq_insert(#schema_name ".inq", key, value)
+iinq_update(#schema_name ".inq", key, value)
 
 #define DELETE_FROM(schema_name, key) \
 iinq_delete(#schema_name ".inq", key)
@@ -108,6 +429,9 @@ iinq_delete(#schema_name ".inq", key)
 #define DROP(schema_name)\
 iinq_drop(#schema_name ".inq")
 
+#define JOIN(outer_schema_name, inner_schema_name, outer_key, inner_key, join_key_size, p) \
+iinq_join(#outer_schema_name ".inq", #inner_schema_name ".inq", outer_key, inner_key, join_key_size, p)
+
 #define SELECT_ALL \
 ion_iinq_result_size_t result_loc	= 0; \
 ion_iinq_cleanup_t *copyer			= first; \
@@ -119,7 +443,8 @@ while (NULL != copyer) { \
 	copyer						= copyer->next; \
 }
 
-#define _FROM_SOURCE_SINGLE(source) \
+/* Opens a source, with a cursor over the records matching the predicate built from the variable arguments. */
+#define _FROM_SOURCE_PREDICATE(source, ...) \
 	ion_iinq_source_t source; \
 	source.cleanup.next			= NULL; \
 	source.cleanup.last			= last; \
@@ -143,12 +468,14 @@ while (NULL != copyer) { \
 	source.ion_record.value		= source.value; \
 	result.num_bytes			+= source.dictionary.instance->record.key_size; \
 	result.num_bytes			+= source.dictionary.instance->record.value_size; \
-	error						= dictionary_build_predicate(&(source.predicate), predicate_all_records); \
+	error						= dictionary_build_predicate(&(source.predicate), __VA_ARGS__); \
 	if (err_ok != error) { \
 		break; \
 	} \
 	dictionary_find(&source.dictionary, &source.predicate, &source.cursor);
 
+#define _FROM_SOURCE_SINGLE(source) _FROM_SOURCE_PREDICATE(source, predicate_all_records)
+
 #define _FROM_CHECK_CURSOR_SINGLE(source) \
 	(cs_cursor_active == (source.cursor_status = source.cursor->next(source.cursor, &source.ion_record)) || cs_cursor_initialized == source.cursor_status)
 
@@ -197,7 +524,19 @@ while (NULL != copyer) { \
 #define _FROM_CHECK_CURSOR(sources) \
 	_FROM_CHECK_CURSOR_SINGLE(sources)
 
-#define FROM(...) \
+#define FROM(...) _FROM_WITH(_FROM_SOURCES(__VA_ARGS__))
+
+/*
+ * These read only the records of a source whose keys satisfy the condition, rather than all of them, so a condition
+ * on the key of a B+ tree source reads only the matching leaves. WHERE still applies to the records that are read.
+ */
+#define FROM_KEY_EQUAL(source, key) \
+	_FROM_WITH(_FROM_SOURCE_PREDICATE(source, predicate_equality, key))
+
+#define FROM_KEY_RANGE(source, lower_bound, upper_bound) \
+	_FROM_WITH(_FROM_SOURCE_PREDICATE(source, predicate_range, lower_bound, upper_bound))
+
+#define _FROM_WITH(sources) \
 	ion_iinq_cleanup_t	*first; \
 	ion_iinq_cleanup_t	*last; \
 	ion_iinq_cleanup_t	*ref_cursor; \
@@ -206,7 +545,7 @@ while (NULL != copyer) { \
 	last		= NULL; \
 	ref_cursor	= NULL; \
 	last_cursor	= NULL; \
-	_FROM_SOURCES(__VA_ARGS__) \
+	sources \
 	result.data	= alloca(result.num_bytes); \
 	ref_cursor	= first; \
 	/* Initialize all cursors except the last one. */ \
@@ -225,17 +564,35 @@ while (NULL != copyer) { \
 
 #define WHERE(condition) (condition)
 
+#define GROUPBY(offset, size, aggregate, aggregate_size) \
+	iinq_query_group_by(&iinq_query, offset, size, aggregate, aggregate_size);
+
+#define HAVING(condition) && (condition)
+
+#define ORDERBY(offset, size, compare, direction) \
+	iinq_query_order_by(&iinq_query, offset, size, compare, direction);
+
+#define LIMIT(count) \
+	iinq_query_limit(&iinq_query, count);
+
 #define QUERY(select, from, where, groupby, having, orderby, limit, when, p) \
 do { \
 	ion_err_t			error; \
 	ion_iinq_result_t	result; \
+	ion_iinq_query_t	iinq_query; \
 	result.num_bytes	= 0; \
+	iinq_query_init(&iinq_query, p); \
+	groupby \
+	orderby \
+	limit \
 	from/* This includes a loop declaration with some other stuff. */ \
 		if (!where) { \
 			continue; \
 		} \
 		select \
-		(p)->execute(&result, (p)->state); \
+		if (!iinq_query_push(&iinq_query, &result)) { \
+			break; \
+		} \
 	} \
 	IINQ_QUERY_CLEANUP: \
 	while (NULL != first) { \
@@ -243,6 +600,13 @@ do { \
 		ion_close_dictionary(&first->reference->dictionary); \
 		first			= first->next; \
 	}\
+	/* The groups are only complete once the sources are read. */ \
+	while (iinq_query_next_group(&iinq_query, &result)) { \
+		if ((1 having) && !iinq_query_push_group(&iinq_query, &result)) { \
+			break; \
+		} \
+	} \
+	iinq_query_finish(&iinq_query); \
 } while (0);
 
 #if defined(__cplusplus)
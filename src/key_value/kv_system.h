@@ -55,6 +55,19 @@ extern "C" {
 */
 #define ION_MAX_FILENAME_LENGTH 12
 
+/**
+@brief		Whether dictionaries and the master table latch themselves, so
+			that many threads may use them at once. Off on the Arduino, which
+			runs a single thread.
+*/
+#if !defined(ION_THREAD_SAFE)
+#if defined(ARDUINO)
+#define ION_THREAD_SAFE 0
+#else
+#define ION_THREAD_SAFE 1
+#endif
+#endif
+
 /* ==================== ARDUINO CONDITIONAL COMPILATION ================================ */
 #if !defined(ARDUINO)
 /* Only if we're on desktop do we want to flush. Otherwise we only do a printf. */
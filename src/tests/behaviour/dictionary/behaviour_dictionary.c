@@ -441,6 +441,47 @@ test_bhdct_insert_multiple(
 	bhdct_takedown(tc, &dict);
 }
 
+/**
+@brief	This function tests a batched insertion of records given out of
+		key order into a dictionary that already holds some records.
+*/
+void
+test_bhdct_insert_batch(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_low);
+
+	int				keys[100];
+	int				values[100];
+	ion_status_t	statuses[100];
+	int				i;
+
+	for (i = 0; i < 100; i++) {
+		keys[i]		= 1000 + (i * 37) % 100;
+		values[i]	= keys[i] * 7;
+	}
+
+	ion_status_t status = dictionary_insert_batch(&dict, keys, values, statuses, 100);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100, status.count);
+
+	for (i = 0; i < 100; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[i].error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, statuses[i].count);
+		bhdct_get(tc, &dict, IONIZE(keys[i], int), IONIZE(values[i], int), err_ok, 1);
+	}
+
+	ION_FILL_LOW_LOOP(i) {
+		bhdct_get(tc, &dict, IONIZE(i, int), ION_LOW_VALUE(i), err_ok, 1);
+	}
+
+	bhdct_takedown(tc, &dict);
+}
+
 /**
 @brief	This function tests multiple insertions into a string key dictionary.
 */
@@ -869,6 +910,57 @@ test_bhdct_get_all(
 	bhdct_takedown(tc, &dict);
 }
 
+/**
+@brief	This function tests a batched get of present, missing and repeated
+		keys, requested out of key order.
+*/
+void
+test_bhdct_multi_get(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_edge_cases);
+
+	int				keys[]		= { 905, 3, -98, 1000, 60, 3, -99, 0, 52 };
+	int				num_keys	= (int) (sizeof(keys) / sizeof(int));
+	int				values[sizeof(keys) / sizeof(int)];
+	ion_status_t	statuses[sizeof(keys) / sizeof(int)];
+	int				i;
+
+	for (i = 0; i < num_keys; i++) {
+		values[i] = 0x76767676;
+	}
+
+	ion_status_t status = dictionary_multi_get(&dict, keys, values, statuses, num_keys);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 7, status.count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[0].error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 905 * 10, values[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[1].error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 * 2, values[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[2].error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -98 * 3, values[2]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, statuses[3].error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, statuses[3].count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0x76767676, values[3]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[4].error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 60 * 5, values[4]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[5].error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 * 2, values[5]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, statuses[6].error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0x76767676, values[6]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[7].error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, values[7]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[8].error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 52 * 5, values[8]);
+
+	bhdct_takedown(tc, &dict);
+}
+
 /**
 @brief	This function tests a get of everything within a string key dictionary.
 */
@@ -1501,6 +1593,7 @@ bhdct_run_tests(
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_setup);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_insert_single);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_insert_multiple);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_insert_batch);
 
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_single);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_in_many);
@@ -1516,6 +1609,7 @@ bhdct_run_tests(
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_populated_multiple);
 
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_all);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_multi_get);
 
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_delete_empty);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_delete_nonexist_single);
@@ -31,4 +31,5 @@ runalltests_behaviour_bpp_tree(
 	void
 ) {
 	bhdct_run_tests(bpptree_init, -1, ION_BHDCT_ALL_TESTS & ~ION_BHDCT_STRING_INT);
+	bhdct_run_tests(bpptree_mapped_init, -1, ION_BHDCT_ALL_TESTS & ~ION_BHDCT_STRING_INT);
 }
@@ -0,0 +1,33 @@
+/******************************************************************************/
+/**
+@file
+@brief		Behaviour tests for the Concurrent Skip List implementation.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../behaviour_dictionary.h"
+#include "../../../../dictionary/concurrent_skip_list/concurrent_skip_list_handler.h"
+#include "test_behaviour_concurrent_skip_list.h"
+
+void
+runalltests_behaviour_concurrent_skip_list(
+	void
+) {
+	bhdct_run_tests(csldict_init, 7, ION_BHDCT_ALL_TESTS & ~ION_BHDCT_DUPLICATES);
+}
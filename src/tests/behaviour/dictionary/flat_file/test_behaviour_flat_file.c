@@ -31,4 +31,5 @@ runalltests_behaviour_flat_file(
 	void
 ) {
 	bhdct_run_tests(ffdict_init, 15, ION_BHDCT_ALL_TESTS);
+	bhdct_run_tests(ffdict_mapped_init, 15, ION_BHDCT_ALL_TESTS);
 }
@@ -31,4 +31,6 @@ runalltests_behaviour_open_address_file_hash(
 	void
 ) {
 	bhdct_run_tests(oafdict_init, 200, ION_BHDCT_ALL_TESTS & ~ION_BHDCT_DUPLICATES);
+	bhdct_run_tests(oafdict_mapped_init, 200, ION_BHDCT_ALL_TESTS & ~ION_BHDCT_DUPLICATES);
+	bhdct_run_tests(oafdict_paged_init, 200, ION_BHDCT_ALL_TESTS & ~ION_BHDCT_DUPLICATES);
 }
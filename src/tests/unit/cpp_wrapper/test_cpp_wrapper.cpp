@@ -1099,7 +1099,7 @@ test_cpp_wrapper_open_close(
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
 
 	ion_dictionary_config_info_t config = {
-		gdict_id, 0, key_type, key_size, val_size, dict_size
+		gdict_id, 0, key_type, key_size, val_size, dict_size, hash_function_default
 	};
 
 	error = dict->open(config);
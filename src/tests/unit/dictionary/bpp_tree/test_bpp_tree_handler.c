@@ -117,12 +117,431 @@ run_bpptreehandler_generic_test_set_1(
 	cleanup_generic_dictionary_test(&test);
 }
 
+/**
+@brief		Inserts and reads back keys through trees opened with the smallest
+			buffer pool and with a pool large enough to hold every node, and
+			checks that the hit and miss counters reflect the pool size.
+*/
+void
+test_bpptree_buffer_pool(
+	planck_unit_test_t *tc
+) {
+	int					bufCts[] = { ION_BPP_MIN_BUFFERS, 256 };
+	long				hits[2];
+	long				misses[2];
+	int					i;
+	int					j;
+	ion_bpp_open_t		info;
+	ion_bpp_handle_t	tree;
+	ion_bpp_err_t		bErr;
+
+	for (i = 0; i < 2; i++) {
+		ion_fremove("pool.bpt");
+
+		info.iName		= "pool.bpt";
+		info.keySize	= sizeof(int);
+		info.dupKeys	= boolean_false;
+		info.sectorSize = 256;
+		info.comp		= dictionary_compare_signed_value;
+		info.bufCt		= bufCts[i];
+		info.valueSize	= 0;
+		info.mapped		= boolean_false;
+
+		bErr			= bOpen(info, &tree);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bErr);
+
+		/* scattered insertion order touches many different leaves */
+		for (j = 0; j < 2000; j++) {
+			int key = (j * 7919) % 2000;
+
+			bErr = bInsertKey(tree, &key, key * 2, NULL);
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bErr);
+		}
+
+		for (j = 0; j < 2000; j++) {
+			ion_bpp_external_address_t rec;
+
+			bErr = bFindKey(tree, &j, &rec);
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bErr);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, j * 2, rec);
+		}
+
+		bCacheStats(tree, &hits[i], &misses[i]);
+		PLANCK_UNIT_ASSERT_TRUE(tc, hits[i] > 0);
+
+		bErr = bClose(tree);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bErr);
+
+		/* everything must have made it to disk through eviction or close */
+		bErr = bOpen(info, &tree);
+		PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bErr);
+
+		for (j = 0; j < 2000; j++) {
+			ion_bpp_external_address_t rec;
+
+			bErr = bFindKey(tree, &j, &rec);
+			PLANCK_UNIT_ASSERT_TRUE(tc, bErrOk == bErr);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, j * 2, rec);
+		}
+
+		bClose(tree);
+	}
+
+	ion_fremove("pool.bpt");
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, misses[1] < misses[0]);
+}
+
+/**
+@brief		Reads the hit and miss counters of a B+ tree dictionary, and
+			resizes its buffer pool from them while it holds records.
+*/
+void
+test_bpptree_dictionary_buffer_count(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	long						hits;
+	long						misses;
+	long						small_misses;
+	int							round;
+	int							i;
+	int							key;
+	int							value;
+
+	bpptree_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 71, key_type_numeric_signed, sizeof(int), sizeof(int), -1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_set_buffer_count(&dictionary, ION_BPP_MIN_BUFFERS));
+
+	/* Scattered keys, with nodes left modified in the buffers when the pool is resized */
+	for (i = 0; i < 2000; i++) {
+		key = (i * 7919) % 2000;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &key).error);
+	}
+
+	for (round = 0; round < 2; round++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_set_buffer_count(&dictionary, (0 == round) ? ION_BPP_MIN_BUFFERS : 512));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_cache_stats(&dictionary, &hits, &misses));
+
+		/* Opening the tree only reads its root */
+		PLANCK_UNIT_ASSERT_TRUE(tc, hits + misses <= 1);
+
+		for (i = 0; i < 2 * 2000; i++) {
+			key = (i * 7919) % 2000;
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, &key, &value).error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key, value);
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_cache_stats(&dictionary, &hits, &misses));
+		PLANCK_UNIT_ASSERT_TRUE(tc, hits > 0);
+
+		if (0 == round) {
+			small_misses = misses;
+		}
+	}
+
+	/* Once every node fits, only the first read of each goes to the file */
+	PLANCK_UNIT_ASSERT_TRUE(tc, misses < small_misses);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Bulk loads sorted records with duplicate keys, then checks them
+			through lookups, a full scan, further updates and a reopen.
+*/
+void
+test_bpptree_bulk_load(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_status_t				status;
+	ion_err_t					error;
+	int							num_records = 3000;
+	int							keys[3000];
+	int							values[3000];
+	int							i;
+	int							value;
+
+	/* every key appears twice */
+	for (i = 0; i < num_records; i++) {
+		keys[i]		= i / 2;
+		values[i]	= i;
+	}
+
+	bpptree_init(&handler);
+
+	error = dictionary_create(&handler, &dictionary, 2, key_type_numeric_signed, sizeof(int), sizeof(int), -1);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+
+	/* out of order input is rejected before anything is written */
+	keys[10]	= 5000;
+	status		= bpptree_bulk_load(&dictionary, (ion_byte_t *) keys, (ion_byte_t *) values, num_records, 100);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_sorted_order_violation == status.error);
+	keys[10]	= 5;
+
+	status		= bpptree_bulk_load(&dictionary, (ion_byte_t *) keys, (ion_byte_t *) values, num_records, 100);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, num_records, status.count);
+
+	/* a tree can only be bulk loaded while empty */
+	status		= bpptree_bulk_load(&dictionary, (ion_byte_t *) keys, (ion_byte_t *) values, num_records, 100);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_illegal_state == status.error);
+
+	/* the last value loaded under a key is the one found first */
+	for (i = 0; i < num_records / 2; i++) {
+		status = dictionary_get(&dictionary, &i, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 2 + 1, value);
+	}
+
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_predicate_t		predicate;
+	ion_record_t		record;
+	int					count	= 0;
+	int					last	= -1;
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	error			= dictionary_find(&dictionary, &predicate, &cursor);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+
+	record.key		= malloc(sizeof(int));
+	record.value	= malloc(sizeof(int));
+
+	while (cs_end_of_results != cursor->next(cursor, &record)) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, *(int *) record.key >= last);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, *(int *) record.key, *(int *) record.value / 2);
+		last = *(int *) record.key;
+		count++;
+	}
+
+	free(record.key);
+	free(record.value);
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, num_records, count);
+
+	/* the packed leaves still split and merge normally */
+	for (i = 0; i < 500; i++) {
+		int key = (i * 2) + 1;
+
+		status = dictionary_delete(&dictionary, &key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, status.count);
+
+		key		= -i;
+		status	= dictionary_insert(&dictionary, &key, &i);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	}
+
+	ion_dictionary_config_info_t config = {
+		2, 0, key_type_numeric_signed, sizeof(int), sizeof(int), -1
+	};
+
+	error	= dictionary_close(&dictionary);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+	error	= dictionary_open(&handler, &dictionary, &config);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+
+	status	= dictionary_get(&dictionary, IONIZE(1499, int), &value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2999, value);
+
+	status	= dictionary_get(&dictionary, IONIZE(-499, int), &value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 499, value);
+
+	status	= dictionary_get(&dictionary, IONIZE(999, int), &value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_item_not_found == status.error);
+
+	dictionary_delete_dictionary(&dictionary);
+}
+
+/**
+@brief		Tests that @p dictionary_size picks the node size of a new tree,
+			and that the size stored in the file wins when it is reopened.
+*/
+void
+test_bpptree_sector_size(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_status_t				status;
+	ion_err_t					error;
+	char						filename[ION_MAX_FILENAME_LENGTH];
+	ion_file_handle_t			file;
+	ion_file_offset_t			size;
+	int							i;
+	int							value;
+
+	bpptree_init(&handler);
+
+	error = dictionary_create(&handler, &dictionary, 4, key_type_numeric_signed, sizeof(int), sizeof(int), 4096);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+
+	for (i = 0; i < 2000; i++) {
+		status = dictionary_insert(&dictionary, &i, &i);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	}
+
+	error = dictionary_close(&dictionary);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+
+	/* header, 3 sector root, then whole nodes */
+	dictionary_get_filename(4, "bpt", filename);
+	file	= ion_fopen(filename);
+	ion_fseek(file, 0, ION_FILE_END);
+	size	= ion_ftell(file);
+	ion_fclose(file);
+	PLANCK_UNIT_ASSERT_TRUE(tc, size > 4 * 4096);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, size % 4096);
+
+	/* a different size on open is ignored for an existing tree */
+	ion_dictionary_config_info_t config = {
+		4, 0, key_type_numeric_signed, sizeof(int), sizeof(int), 512
+	};
+
+	error = dictionary_open(&handler, &dictionary, &config);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+
+	for (i = 0; i < 2000; i++) {
+		status = dictionary_get(&dictionary, &i, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	dictionary_delete_dictionary(&dictionary);
+}
+
+/**
+@brief		Checks that small values live in the tree, and that a key's
+			values move to the value file once it has more than one.
+*/
+void
+test_bpptree_inline_values(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_status_t				status;
+	ion_err_t					error;
+	char						filename[ION_MAX_FILENAME_LENGTH];
+	ion_file_handle_t			file;
+	ion_file_offset_t			size;
+	int							keys[600];
+	int							values[600];
+	int							i;
+	int							value;
+
+	bpptree_init(&handler);
+
+	error = dictionary_create(&handler, &dictionary, 5, key_type_numeric_signed, sizeof(int), sizeof(int), -1);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ((ion_bpptree_t *) dictionary.instance)->inline_values);
+
+	for (i = 0; i < 1000; i++) {
+		value	= i * 3;
+		status	= dictionary_insert(&dictionary, &i, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	}
+
+	/* nothing has been written to the value file */
+	dictionary_get_filename(5, "val", filename);
+	file	= ion_fopen(filename);
+	ion_fseek(file, 0, ION_FILE_END);
+	size	= ion_ftell(file);
+	ion_fclose(file);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, size);
+
+	/* a duplicate spills the first value, the newest is found first */
+	status = dictionary_insert(&dictionary, IONIZE(7, int), IONIZE(100, int));
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	status = dictionary_get(&dictionary, IONIZE(7, int), &value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100, value);
+
+	status = dictionary_update(&dictionary, IONIZE(8, int), IONIZE(5, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+
+	status = dictionary_delete(&dictionary, IONIZE(9, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+	status = dictionary_delete(&dictionary, IONIZE(7, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, status.count);
+
+	ion_dictionary_config_info_t config = {
+		5, 0, key_type_numeric_signed, sizeof(int), sizeof(int), -1
+	};
+
+	error	= dictionary_close(&dictionary);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+	error	= dictionary_open(&handler, &dictionary, &config);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_predicate_t		predicate;
+	ion_record_t		record;
+	int					count	= 0;
+
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	error			= dictionary_find(&dictionary, &predicate, &cursor);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+
+	record.key		= malloc(sizeof(int));
+	record.value	= malloc(sizeof(int));
+
+	while (cs_end_of_results != cursor->next(cursor, &record)) {
+		i = *(int *) record.key;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (8 == i) ? 5 : i * 3, *(int *) record.value);
+		count++;
+	}
+
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 998, count);
+
+	dictionary_delete_dictionary(&dictionary);
+
+	/* bulk loaded keys keep single values inline too, every third key is doubled */
+	for (i = 0; i < 600; i++) {
+		keys[i]		= i - i / 3;
+		values[i]	= i;
+	}
+
+	error	= dictionary_create(&handler, &dictionary, 6, key_type_numeric_signed, sizeof(int), sizeof(int), -1);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+	status	= bpptree_bulk_load(&dictionary, (ion_byte_t *) keys, (ion_byte_t *) values, 600, 100);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+
+	count	= 0;
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	error	= dictionary_find(&dictionary, &predicate, &cursor);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == error);
+
+	while (cs_end_of_results != cursor->next(cursor, &record)) {
+		i = *(int *) record.value;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, keys[i], *(int *) record.key);
+		count++;
+	}
+
+	free(record.key);
+	free(record.value);
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 600, count);
+
+	dictionary_delete_dictionary(&dictionary);
+}
+
 planck_unit_suite_t *
 bpptreehandler_get_suite(
 ) {
 	planck_unit_suite_t *suite = planck_unit_new_suite();
 
 	PLANCK_UNIT_ADD_TO_SUITE(suite, run_bpptreehandler_generic_test_set_1);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_buffer_pool);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_dictionary_buffer_count);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_bulk_load);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_sector_size);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptree_inline_values);
 
 	return suite;
 }
@@ -0,0 +1,9 @@
+#include "test_concurrent_skip_list.h"
+
+int
+main(
+	void
+) {
+	runalltests_concurrent_skip_list();
+	return 0;
+}
@@ -0,0 +1,343 @@
+/******************************************************************************/
+/**
+@file
+@brief		Unit tests for the concurrent skiplist.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#include "test_concurrent_skip_list.h"
+
+#if !defined(ARDUINO)
+#include <pthread.h>
+#endif
+
+#define ION_CSL_TEST_RECORDS	1000
+#define ION_CSL_TEST_THREADS	4
+#define ION_CSL_TEST_SHARED		64
+
+/**
+@brief		Initializes a skiplist of int keys and int values.
+*/
+void
+csl_test_initialize(
+	planck_unit_test_t			*tc,
+	ion_concurrent_skiplist_t	*skiplist
+) {
+	skiplist->super.compare = dictionary_compare_signed_value;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, csl_initialize(skiplist, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+}
+
+/**
+@brief		Counts the retired nodes and values still waiting to be freed.
+*/
+int
+csl_test_count_retired(
+	ion_concurrent_skiplist_t *skiplist
+) {
+	ion_csl_retired_t	*retired;
+	int					count = 0;
+
+	for (retired = skiplist->retired; NULL != retired; retired = retired->next) {
+		count++;
+	}
+
+	return count;
+}
+
+/**
+@brief		Tests inserts, queries, updates and deletes from one thread, and
+			that the nodes stay in key order.
+
+@param		tc
+				Test case.
+*/
+void
+test_concurrent_skip_list_single_thread(
+	planck_unit_test_t *tc
+) {
+	ion_concurrent_skiplist_t	skiplist;
+	ion_status_t				status;
+	ion_csl_node_t				*node;
+	int							slot;
+	int							i;
+	int							value;
+	int							last;
+
+	csl_test_initialize(tc, &skiplist);
+
+	/* inserted out of order, to be found in order */
+	for (i = 0; i < ION_CSL_TEST_RECORDS; i++) {
+		int key = (i * 7) % ION_CSL_TEST_RECORDS;
+
+		value	= key * 2;
+		status	= csl_insert(&skiplist, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+	}
+
+	for (i = 0; i < ION_CSL_TEST_RECORDS; i++) {
+		status = csl_query(&skiplist, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 2, value);
+
+		status = csl_insert(&skiplist, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_duplicate_key, status.error);
+	}
+
+	for (i = 0; i < ION_CSL_TEST_RECORDS; i += 2) {
+		status = csl_delete(&skiplist, &i);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+
+		status = csl_delete(&skiplist, &i);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+	}
+
+	for (i = 0; i < ION_CSL_TEST_RECORDS; i++) {
+		value	= -i;
+		status	= csl_update(&skiplist, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+	}
+
+	slot	= csl_enter(&skiplist);
+	last	= -1;
+	i		= 0;
+
+	for (node = csl_find_node(&skiplist, NULL); NULL != node; node = csl_next_node(node)) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, csl_read_value(&skiplist, node, &value));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, last + 1, *(int *) CSL_NODE_KEY(node));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -(last + 1), value);
+		last = *(int *) CSL_NODE_KEY(node);
+		i++;
+	}
+
+	csl_leave(&skiplist, slot);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_CSL_TEST_RECORDS, i);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, csl_destroy(&skiplist));
+}
+
+/**
+@brief		Tests that memory retired by deletes and updates is freed as
+			the epoch moves on, but not while a thread could still read it.
+
+@param		tc
+				Test case.
+*/
+void
+test_concurrent_skip_list_reclaim(
+	planck_unit_test_t *tc
+) {
+	ion_concurrent_skiplist_t	skiplist;
+	ion_csl_node_t				*node;
+	int							slot;
+	int							key = 0;
+	int							value;
+	int							i;
+
+	csl_test_initialize(tc, &skiplist);
+
+	value = 42;
+	csl_insert(&skiplist, &key, &value);
+
+	/* A reader holding the node keeps it, and everything retired after, from being freed. */
+	slot	= csl_enter(&skiplist);
+	node	= csl_find_node(&skiplist, &key);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != node);
+
+	csl_delete(&skiplist, &key);
+
+	for (i = 1; i <= ION_CSL_RECLAIM_INTERVAL * 4; i++) {
+		csl_update(&skiplist, &i, &i);
+		csl_delete(&skiplist, &i);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, csl_test_count_retired(&skiplist) >= ION_CSL_RECLAIM_INTERVAL * 8);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, *(int *) CSL_NODE_KEY(node));
+	PLANCK_UNIT_ASSERT_FALSE(tc, csl_read_value(&skiplist, node, &value));
+
+	csl_leave(&skiplist, slot);
+
+	for (i = 1; i <= ION_CSL_RECLAIM_INTERVAL * 4; i++) {
+		csl_update(&skiplist, &i, &i);
+		csl_delete(&skiplist, &i);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, csl_test_count_retired(&skiplist) < ION_CSL_RECLAIM_INTERVAL * 4);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, csl_destroy(&skiplist));
+}
+
+#if !defined(ARDUINO)
+
+/**
+@brief		What a thread of @ref test_concurrent_skip_list_threads works on,
+			and what it found.
+*/
+typedef struct {
+	ion_concurrent_skiplist_t	*skiplist;
+	int							thread;
+	int							inserted[ION_CSL_TEST_SHARED];
+	int							deleted[ION_CSL_TEST_SHARED];
+	int							errors;
+} csl_test_thread_t;
+
+/**
+@brief		Works on keys of its own, which it checks as it goes, and fights
+			the other threads over a few shared keys, counting its wins.
+*/
+void *
+csl_test_thread(
+	void *argument
+) {
+	csl_test_thread_t	*work = argument;
+	ion_status_t		status;
+	int					i;
+	int					key;
+	int					value;
+
+	for (i = 0; i < ION_CSL_TEST_RECORDS; i++) {
+		key		= ION_CSL_TEST_SHARED + i * ION_CSL_TEST_THREADS + work->thread;
+		value	= key;
+
+		if (err_ok != csl_insert(work->skiplist, &key, &value).error) {
+			work->errors++;
+		}
+
+		if ((err_ok != csl_query(work->skiplist, &key, &value).error) || (key != value)) {
+			work->errors++;
+		}
+
+		if (0 == i % 2) {
+			value = -key;
+
+			if (err_ok != csl_update(work->skiplist, &key, &value).error) {
+				work->errors++;
+			}
+		}
+		else if (err_ok != csl_delete(work->skiplist, &key).error) {
+			work->errors++;
+		}
+
+		key		= (i * 13 + work->thread) % ION_CSL_TEST_SHARED;
+		value	= work->thread;
+		status	= (0 == i % 3) ? csl_delete(work->skiplist, &key) : csl_insert(work->skiplist, &key, &value);
+
+		if (err_ok == status.error) {
+			if (0 == i % 3) {
+				work->deleted[key]++;
+			}
+			else {
+				work->inserted[key]++;
+			}
+		}
+
+		/* Whatever a shared key holds was put there whole by one thread. */
+		if ((err_ok == csl_query(work->skiplist, &key, &value).error) && ((value < 0) || (value >= ION_CSL_TEST_THREADS))) {
+			work->errors++;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Tests threads inserting, updating and deleting at once, some of
+			them over the same keys.
+
+@param		tc
+				Test case.
+*/
+void
+test_concurrent_skip_list_threads(
+	planck_unit_test_t *tc
+) {
+	ion_concurrent_skiplist_t	skiplist;
+	csl_test_thread_t			work[ION_CSL_TEST_THREADS];
+	pthread_t					threads[ION_CSL_TEST_THREADS];
+	int							i;
+	int							t;
+	int							key;
+	int							value;
+	int							present;
+
+	csl_test_initialize(tc, &skiplist);
+	memset(work, 0, sizeof(work));
+
+	for (t = 0; t < ION_CSL_TEST_THREADS; t++) {
+		work[t].skiplist	= &skiplist;
+		work[t].thread		= t;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, pthread_create(&threads[t], NULL, csl_test_thread, &work[t]));
+	}
+
+	for (t = 0; t < ION_CSL_TEST_THREADS; t++) {
+		pthread_join(threads[t], NULL);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, work[t].errors);
+	}
+
+	/* Every shared key was inserted one more time than it was deleted if, and only if, it is there now. */
+	for (key = 0; key < ION_CSL_TEST_SHARED; key++) {
+		present = 0;
+
+		for (t = 0; t < ION_CSL_TEST_THREADS; t++) {
+			present += work[t].inserted[key] - work[t].deleted[key];
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (err_ok == csl_query(&skiplist, &key, &value).error) ? 1 : 0, present);
+	}
+
+	for (i = 0; i < ION_CSL_TEST_RECORDS * ION_CSL_TEST_THREADS; i++) {
+		key = ION_CSL_TEST_SHARED + i;
+
+		if (0 == (i / ION_CSL_TEST_THREADS) % 2) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, csl_query(&skiplist, &key, &value).error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -key, value);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, csl_query(&skiplist, &key, &value).error);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, csl_destroy(&skiplist));
+}
+
+#endif
+
+planck_unit_suite_t *
+concurrent_skip_list_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_concurrent_skip_list_single_thread);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_concurrent_skip_list_reclaim);
+#if !defined(ARDUINO)
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_concurrent_skip_list_threads);
+#endif
+
+	return suite;
+}
+
+void
+runalltests_concurrent_skip_list(
+) {
+	planck_unit_suite_t *suite = concurrent_skip_list_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
@@ -0,0 +1,19 @@
+#ifndef TEST_CONCURRENT_SKIP_LIST_H_
+#define TEST_CONCURRENT_SKIP_LIST_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/concurrent_skip_list/concurrent_skip_list.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+void
+runalltests_concurrent_skip_list(
+);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
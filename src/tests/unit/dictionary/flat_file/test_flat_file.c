@@ -39,7 +39,7 @@ ftest_create(
 	ion_value_size_t		value_size,
 	ion_dictionary_size_t	dictionary_size
 ) {
-	ion_err_t err = flat_file_initialize(flat_file, 0, key_type, key_size, value_size, dictionary_size);
+	ion_err_t err = flat_file_initialize(flat_file, 0, key_type, key_size, value_size, dictionary_size, boolean_false);
 
 	flat_file->super.compare	= dictionary_compare_signed_value;
 	flat_file->super.id			= 0;
@@ -128,12 +128,12 @@ ftest_insert(
 
 		ion_byte_t read_buffer[flat_file->row_size];
 
-		fseek(flat_file->data_file, flat_file->start_of_data, SEEK_SET);
+		ion_fseek(flat_file->data_file, flat_file->start_of_data, ION_FILE_START);
 
 		ion_fpos_t cur_index = 0;
 
 		while (boolean_true) {
-			if (1 != fread(read_buffer, flat_file->row_size, 1, flat_file->data_file)) {
+			if (err_ok != ion_fread(flat_file->data_file, flat_file->row_size, read_buffer)) {
 				break;
 			}
 
@@ -763,6 +763,231 @@ test_flat_file_sort_update_many_exist_duplicates(
 	ftest_takedown(tc, &flat_file);
 }
 
+/**
+@brief		Asserts that the fence index holds the key of the first row of every
+			block in the data file.
+*/
+void
+ftest_check_fences(
+	planck_unit_test_t	*tc,
+	ion_flat_file_t		*flat_file
+) {
+	ion_fpos_t			num_rows = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_fpos_t			block;
+	ion_flat_file_row_t row;
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != flat_file->fences);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (num_rows + flat_file->num_buffered - 1) / flat_file->num_buffered, flat_file->num_fences);
+
+	for (block = 0; block < flat_file->num_fences; block++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_read_row(flat_file, block * flat_file->num_buffered, &row));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, flat_file->super.compare(row.key, flat_file->fences + block * flat_file->super.record.key_size, flat_file->super.record.key_size));
+	}
+}
+
+/**
+@brief		Tests binary searches that go through the fence index, with
+			duplicates running across the blocks, before and after the flat
+			file is reopened.
+*/
+void
+test_flat_file_sort_fence_search(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t flat_file;
+	int				keys[]		= { 3, 3, 5, 8, 8, 9 };
+	int				values[]	= { 4, 5, 6, 7, 8, 9 };
+	ion_status_t	statuses[6];
+	int				pass;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 3);
+	flat_file.sorted_mode = boolean_true;
+
+	/* Blocks of 3 rows: | 1 3 3 | 3 3 5 | 8 8 9 | 12 | */
+	ftest_insert(tc, &flat_file, IONIZE(1, int), IONIZE(1, int), err_ok, 1, boolean_true);
+	ftest_insert(tc, &flat_file, IONIZE(3, int), IONIZE(2, int), err_ok, 1, boolean_true);
+	ftest_insert(tc, &flat_file, IONIZE(3, int), IONIZE(3, int), err_ok, 1, boolean_true);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_insert_batch(&flat_file, keys, values, statuses, 6).error);
+	ftest_insert(tc, &flat_file, IONIZE(12, int), IONIZE(10, int), err_ok, 1, boolean_true);
+
+	for (pass = 0; pass < 2; pass++) {
+		ftest_check_fences(tc, &flat_file);
+
+		ftest_file_binary_search(tc, &flat_file, IONIZE(3, int), err_ok, 1);
+		ftest_file_binary_search(tc, &flat_file, IONIZE(5, int), err_ok, 5);
+		ftest_file_binary_search(tc, &flat_file, IONIZE(8, int), err_ok, 6);
+		ftest_file_binary_search(tc, &flat_file, IONIZE(12, int), err_ok, 9);
+		ftest_file_binary_search(tc, &flat_file, IONIZE(4, int), err_ok, 4);
+		ftest_file_binary_search(tc, &flat_file, IONIZE(10, int), err_ok, 8);
+		ftest_file_binary_search(tc, &flat_file, IONIZE(130, int), err_ok, 9);
+		ftest_file_binary_search(tc, &flat_file, IONIZE(0, int), err_item_not_found, -1);
+
+		ftest_get(tc, &flat_file, IONIZE(3, int), err_ok, IONIZE(2, int));
+		ftest_get(tc, &flat_file, IONIZE(8, int), err_ok, IONIZE(7, int));
+		ftest_get(tc, &flat_file, IONIZE(12, int), err_ok, IONIZE(10, int));
+		ftest_get(tc, &flat_file, IONIZE(6, int), err_item_not_found, NULL);
+
+		/* The index is built again from the data file */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_close(&flat_file));
+		ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 3);
+		flat_file.sorted_mode = boolean_true;
+	}
+
+	ftest_takedown(tc, &flat_file);
+}
+
+/**
+@brief		Tests that deletes, which move the last row into the hole left,
+			keep the fence index in step with the data file.
+*/
+void
+test_flat_file_delete_fences(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t flat_file;
+	int				i;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 3);
+
+	for (i = 0; i < 7; i++) {
+		ftest_insert(tc, &flat_file, IONIZE(i * 10, int), IONIZE(i, int), err_ok, 1, boolean_false);
+	}
+
+	ftest_check_fences(tc, &flat_file);
+
+	/* Starts the second block, and is replaced by the row starting the last */
+	ftest_delete(tc, &flat_file, IONIZE(30, int), err_ok, 1, boolean_true);
+	ftest_check_fences(tc, &flat_file);
+
+	ftest_delete(tc, &flat_file, IONIZE(0, int), err_ok, 1, boolean_true);
+	ftest_check_fences(tc, &flat_file);
+
+	ftest_insert(tc, &flat_file, IONIZE(70, int), IONIZE(7, int), err_ok, 1, boolean_true);
+	ftest_check_fences(tc, &flat_file);
+
+	ftest_takedown(tc, &flat_file);
+}
+
+/**
+@brief		Asserts what a get on a flat file in tiered mode gives. Unlike @ref ftest_get, this
+			does not look for the row in the data file, as it may still be in the memtable.
+*/
+void
+ftest_tiered_get(
+	planck_unit_test_t	*tc,
+	ion_flat_file_t		*flat_file,
+	int					key,
+	ion_err_t			expected_status,
+	int					expected_value
+) {
+	int				value	= -1;
+	ion_status_t	status	= flat_file_get(flat_file, &key, &value);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected_status, status.error);
+
+	if (err_ok == expected_status) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected_value, value);
+	}
+}
+
+/**
+@brief		Tests out of order inserts, deletes and updates in tiered mode, across flushes,
+			merges, compaction and reopening the flat file.
+*/
+void
+test_flat_file_tiered(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t		flat_file;
+	ion_status_t		status;
+	ion_flat_file_row_t row;
+	ion_fpos_t			loc;
+	int					i;
+	int					key;
+	int					pass;
+
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 4);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_enable_tiered_mode(&flat_file));
+
+	/* 40 keys in a scattered order, flushed as 10 runs that are merged as they build up */
+	for (i = 0; i < 40; i++) {
+		key = (i * 7) % 40;
+		ftest_insert(tc, &flat_file, &key, &key, err_ok, 1, boolean_false);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, flat_file.num_runs < ION_FLAT_FILE_TIER_FANOUT);
+
+	for (key = 0; key < 40; key++) {
+		ftest_tiered_get(tc, &flat_file, key, err_ok, key);
+	}
+
+	ftest_tiered_get(tc, &flat_file, 40, err_item_not_found, 0);
+
+	/* A duplicate is deleted along with the row it duplicates */
+	key = 5;
+	ftest_insert(tc, &flat_file, &key, IONIZE(55, int), err_ok, 1, boolean_false);
+	ftest_tiered_get(tc, &flat_file, 5, err_ok, 55);
+	status = flat_file_update(&flat_file, &key, IONIZE(-5, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, status.count);
+	ftest_tiered_get(tc, &flat_file, 5, err_ok, -5);
+
+	for (key = 0; key < 40; key += 3) {
+		status = flat_file_delete(&flat_file, &key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+	}
+
+	status = flat_file_delete(&flat_file, IONIZE(3, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+
+	/* An upsert of a deleted key */
+	status = flat_file_update(&flat_file, IONIZE(9, int), IONIZE(99, int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+
+	for (pass = 0; pass < 2; pass++) {
+		for (key = 0; key < 40; key++) {
+			if (9 == key) {
+				ftest_tiered_get(tc, &flat_file, key, err_ok, 99);
+			}
+			else if (0 == key % 3) {
+				ftest_tiered_get(tc, &flat_file, key, err_item_not_found, 0);
+			}
+			else {
+				ftest_tiered_get(tc, &flat_file, key, err_ok, 5 == key ? -5 : key);
+			}
+		}
+
+		/* The runs are found again from the data file */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_close(&flat_file));
+		ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 4);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_enable_tiered_mode(&flat_file));
+	}
+
+	/* Compaction leaves one sorted run, of the rows that were not deleted, two of them for key 5 */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_compact(&flat_file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, flat_file.num_runs);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 28, (flat_file.eof_position - flat_file.start_of_data) / flat_file.row_size);
+
+	for (loc = 1; loc < 28; loc++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_read_row(&flat_file, loc - 1, &row));
+		memcpy(&key, row.key, sizeof(key));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_read_row(&flat_file, loc, &row));
+		PLANCK_UNIT_ASSERT_TRUE(tc, flat_file.super.compare(&key, row.key, sizeof(key)) <= 0);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_FLAT_FILE_STATUS_OCCUPIED, row.row_status);
+	}
+
+	ftest_check_fences(tc, &flat_file);
+
+	/* The rows cleared past the run are not found when it is opened again */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, flat_file_close(&flat_file));
+	ftest_create(tc, &flat_file, key_type_numeric_signed, sizeof(int), sizeof(int), 4);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 28, (flat_file.eof_position - flat_file.start_of_data) / flat_file.row_size);
+
+	ftest_takedown(tc, &flat_file);
+}
+
 planck_unit_suite_t *
 flat_file_getsuite(
 ) {
@@ -793,6 +1018,11 @@ flat_file_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_update_many_exist);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_update_many_exist_duplicates);
 
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_fence_search);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_delete_fences);
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_tiered);
+
 	return suite;
 }
 
@@ -0,0 +1,9 @@
+#include "test_group_hash.h"
+
+int
+main(
+	void
+) {
+	runalltests_group_hash();
+	return 0;
+}
@@ -0,0 +1,331 @@
+/******************************************************************************/
+/**
+@file
+@brief		Unit tests for the group hash.
+@copyright	Copyright 2016
+				The University of British Columbia,
+				IonDB Project Contributors (see AUTHORS.md)
+@par
+			Licensed under the Apache License, Version 2.0 (the "License");
+			you may not use this file except in compliance with the License.
+			You may obtain a copy of the License at
+					http://www.apache.org/licenses/LICENSE-2.0
+@par
+			Unless required by applicable law or agreed to in writing,
+			software distributed under the License is distributed on an
+			"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+			either express or implied. See the License for the specific
+			language governing permissions and limitations under the
+			License.
+*/
+/******************************************************************************/
+
+#include "test_group_hash.h"
+
+#define ION_GH_TEST_RECORDS 1000
+
+/**
+@brief		Initializes a table of int keys and int values.
+*/
+void
+gh_test_initialize(
+	planck_unit_test_t	*tc,
+	ion_group_hash_t	*table,
+	int					size
+) {
+	table->super.compare = dictionary_compare_signed_value;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, gh_initialize(table, key_type_numeric_signed, sizeof(int), sizeof(int), size));
+}
+
+/**
+@brief		Tests that the table is sized to hold the requested number of
+			records in a power of two number of slots.
+
+@param		tc
+				Test case.
+*/
+void
+test_group_hash_initialize(
+	planck_unit_test_t *tc
+) {
+	ion_group_hash_t table;
+
+	gh_test_initialize(tc, &table, 100);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, table.capacity >= 100);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, table.capacity % ION_GH_GROUP_SIZE);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, table.capacity & (table.capacity - 1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, table.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, gh_next_slot(&table, 0));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, gh_destroy(&table));
+}
+
+/**
+@brief		Tests that a table started at its smallest size grows to take
+			many records, all of which stay reachable.
+
+@param		tc
+				Test case.
+*/
+void
+test_group_hash_insert_grow(
+	planck_unit_test_t *tc
+) {
+	ion_group_hash_t	table;
+	ion_status_t		status;
+	int					i;
+	int					value;
+
+	gh_test_initialize(tc, &table, 0);
+
+	for (i = 0; i < ION_GH_TEST_RECORDS; i++) {
+		value	= i * 3;
+		status	= gh_insert(&table, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_GH_TEST_RECORDS, table.count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, table.capacity * ION_GH_MAX_LOAD_PERCENT >= table.used * 100);
+
+	for (i = 0; i < ION_GH_TEST_RECORDS; i++) {
+		status = gh_query(&table, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 3, value);
+
+		/* duplicates are refused and leave the record as it was */
+		value	= -1;
+		status	= gh_insert(&table, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_duplicate_key, status.error);
+	}
+
+	i		= ION_GH_TEST_RECORDS;
+	status	= gh_query(&table, &i, &value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+
+	i		= 0;
+	status	= gh_query(&table, &i, &value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, value);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, gh_destroy(&table));
+}
+
+/**
+@brief		Tests that updates replace existing values and insert missing
+			keys.
+
+@param		tc
+				Test case.
+*/
+void
+test_group_hash_update(
+	planck_unit_test_t *tc
+) {
+	ion_group_hash_t	table;
+	ion_status_t		status;
+	int					i;
+	int					value;
+
+	gh_test_initialize(tc, &table, 10);
+
+	for (i = 0; i < ION_GH_TEST_RECORDS; i += 2) {
+		value = i;
+		gh_insert(&table, &i, &value);
+	}
+
+	for (i = 0; i < ION_GH_TEST_RECORDS; i++) {
+		value	= -i;
+		status	= gh_update(&table, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_GH_TEST_RECORDS, table.count);
+
+	for (i = 0; i < ION_GH_TEST_RECORDS; i++) {
+		status = gh_query(&table, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -i, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, gh_destroy(&table));
+}
+
+/**
+@brief		Tests deletes, and that replacing the records many times over
+			does not keep growing the table.
+
+@param		tc
+				Test case.
+*/
+void
+test_group_hash_delete(
+	planck_unit_test_t *tc
+) {
+	ion_group_hash_t	table;
+	ion_status_t		status;
+	int					i;
+	int					j;
+	int					value;
+	int					capacity;
+
+	gh_test_initialize(tc, &table, ION_GH_TEST_RECORDS);
+	capacity = table.capacity;
+
+	for (j = 0; j < 20; j++) {
+		for (i = 0; i < ION_GH_TEST_RECORDS; i++) {
+			int key = i + j * ION_GH_TEST_RECORDS;
+
+			value	= key;
+			status	= gh_insert(&table, &key, &value);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		}
+
+		for (i = 0; i < ION_GH_TEST_RECORDS; i++) {
+			int key = i + j * ION_GH_TEST_RECORDS;
+
+			if (0 == i % 2) {
+				status = gh_delete(&table, &key);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+
+				status = gh_delete(&table, &key);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+			}
+		}
+
+		for (i = 0; i < ION_GH_TEST_RECORDS; i++) {
+			int key = i + j * ION_GH_TEST_RECORDS;
+
+			status = gh_query(&table, &key, &value);
+
+			if (0 == i % 2) {
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+			}
+			else {
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key, value);
+			}
+		}
+
+		/* keep only the odd records of the latest round */
+		for (i = 1; i < ION_GH_TEST_RECORDS; i += 2) {
+			int key = i + j * ION_GH_TEST_RECORDS;
+
+			gh_delete(&table, &key);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, table.count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, table.capacity <= capacity * 2);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, gh_destroy(&table));
+}
+
+/**
+@brief		Compares string keys up to their terminator.
+*/
+char
+gh_test_compare_string(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	return strncmp((char *) first_key, (char *) second_key, key_size);
+}
+
+/**
+@brief		Tests that string keys are matched up to their terminator, as
+			they are compared, whatever follows it.
+
+@param		tc
+				Test case.
+*/
+void
+test_group_hash_string_keys(
+	planck_unit_test_t *tc
+) {
+	ion_group_hash_t	table;
+	ion_status_t		status;
+	char				key[8];
+	int					value;
+	int					i;
+
+	table.super.compare = gh_test_compare_string;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, gh_initialize(&table, key_type_char_array, sizeof(key), sizeof(int), 10));
+
+	for (i = 0; i < 100; i++) {
+		memset(key, 'x', sizeof(key));
+		sprintf(key, "k%d", i);
+		status = gh_insert(&table, key, &i);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	for (i = 0; i < 100; i++) {
+		memset(key, 'y', sizeof(key));
+		sprintf(key, "k%d", i);
+		status = gh_query(&table, key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, gh_destroy(&table));
+}
+
+/**
+@brief		Tests that walking the slots visits every record once.
+
+@param		tc
+				Test case.
+*/
+void
+test_group_hash_next_slot(
+	planck_unit_test_t *tc
+) {
+	ion_group_hash_t	table;
+	int					i;
+	int					slot;
+	int					sum		= 0;
+	int					count	= 0;
+
+	gh_test_initialize(tc, &table, 10);
+
+	for (i = 1; i <= 100; i++) {
+		gh_insert(&table, &i, &i);
+	}
+
+	for (slot = gh_next_slot(&table, 0); -1 != slot; slot = gh_next_slot(&table, slot + 1)) {
+		sum += *(int *) GH_SLOT_KEY(&table, slot);
+		count++;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 100, count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5050, sum);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, gh_destroy(&table));
+}
+
+planck_unit_suite_t *
+group_hash_getsuite(
+) {
+	planck_unit_suite_t *suite = planck_unit_new_suite();
+
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_group_hash_initialize);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_group_hash_insert_grow);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_group_hash_update);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_group_hash_delete);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_group_hash_string_keys);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_group_hash_next_slot);
+
+	return suite;
+}
+
+void
+runalltests_group_hash(
+) {
+	planck_unit_suite_t *suite = group_hash_getsuite();
+
+	planck_unit_run_suite(suite);
+	planck_unit_destroy_suite(suite);
+}
@@ -0,0 +1,19 @@
+#ifndef TEST_GROUP_HASH_H_
+#define TEST_GROUP_HASH_H_
+
+#include "../../../planckunit/src/planck_unit.h"
+#include "../../../../dictionary/group_hash/group_hash.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+void
+runalltests_group_hash(
+);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
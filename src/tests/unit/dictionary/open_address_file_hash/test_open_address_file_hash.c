@@ -25,7 +25,7 @@ check_file_map(
 	int i;
 	int bucket_size = map->super.record.key_size + map->super.record.value_size + sizeof(char);
 
-	frewind(map->file);
+	ion_fseek(map->file, 0, ION_FILE_START);
 
 	ion_hash_bucket_t *record;
 
@@ -37,7 +37,7 @@ check_file_map(
 
 		int j;
 
-		DUMP((int) fread(record, bucket_size, 1, map->file), "%d");
+		DUMP((int) ion_fread(map->file, bucket_size, (ion_byte_t *) record), "%d");
 		printf("reading\n");
 		fflush(stdout);
 
@@ -60,7 +60,7 @@ initialize_file_hash_map(
 ) {
 	map->super.compare	= dictionary_compare_signed_value;
 	map->super.id		= 0;
-	oafh_initialize(map, oafh_compute_simple_hash, /*dictionary_compare_signed_value,*/ map->super.key_type, record->key_size, record->value_size, size, 0);
+	oafh_initialize(map, oafh_compute_simple_hash, /*dictionary_compare_signed_value,*/ map->super.key_type, record->key_size, record->value_size, size, 0, boolean_false, boolean_false);
 }
 
 void
@@ -187,7 +187,7 @@ test_open_address_file_hashmap_find_item_location(
 	int bucket_size = sizeof(char) + record.key_size + record.value_size;
 
 	/* rewind */
-	frewind(map.file);
+	ion_fseek(map.file, 0, ION_FILE_START);
 
 	for (offset = 0; offset < map.map_size; offset++) {
 		/* apply continual offsets */
@@ -199,7 +199,7 @@ test_open_address_file_hashmap_find_item_location(
 
 		/* printf("writing to %i\n",(offset*bucket_size)%(map.map_size*bucket_size)); */
 
-		fseek(map.file, (offset * bucket_size) % (map.map_size * bucket_size), SEEK_SET);
+		ion_fseek(map.file, (offset * bucket_size) % (map.map_size * bucket_size), ION_FILE_START);
 
 		for (i = 0; i < map.map_size; i++) {
 			item_ptr->status = ION_IN_USE;
@@ -214,10 +214,10 @@ test_open_address_file_hashmap_find_item_location(
 
 			/* memcpy(pos_ptr, item_ptr, bucket_size); */
 
-			fwrite(item_ptr, bucket_size, 1, map.file);
+			ion_fwrite(map.file, bucket_size, (ion_byte_t *) item_ptr);
 			/* printf("Moving to position %i\n", ((((i+1+offset)%map.map_size)*bucket_size )%(map.map_size*bucket_size))); */
 			/* pos_ptr = map.entry + ((((i+1+offset)%map.map_size)*bucket_size )%(map.map_size*bucket_size)); */
-			fseek(map.file, ((((i + 1 + offset) % map.map_size) * bucket_size) % (map.map_size * bucket_size)), SEEK_SET);
+			ion_fseek(map.file, ((((i + 1 + offset) % map.map_size) * bucket_size) % (map.map_size * bucket_size)), ION_FILE_START);
 			/* printf("current file pos: %i\n",(int)	ftell(map.file)); */
 		}
 
@@ -260,7 +260,7 @@ test_open_address_file_hashmap_simple_insert(
 	int bucket_size				= sizeof(char) + record.key_size + record.value_size;
 
 	/* rewind */
-	frewind(map.file);
+	ion_fseek(map.file, 0, ION_FILE_START);
 
 	for (offset = 0; offset < map.map_size; offset++) {
 		for (i = 0; i < map.map_size; i++) {
@@ -278,15 +278,15 @@ test_open_address_file_hashmap_simple_insert(
 
 		for (i = 0; i < map.map_size; i++) {
 			/* set the position in the file */
-			fseek(map.file, ((((i + offset) % map.map_size) * bucket_size) % (map.map_size * bucket_size)), SEEK_SET);
+			ion_fseek(map.file, ((((i + offset) % map.map_size) * bucket_size) % (map.map_size * bucket_size)), ION_FILE_START);
 
 			ion_record_status_t record_status;	/* = ((ion_hash_bucket_t *)(map.entry + ((((i+offset)%map.map_size)*bucket_size )%(map.map_size*bucket_size))))->status; */
 			int					key;	/* = *(int *)(((ion_hash_bucket_t *)(map.entry + ((((i+offset)%map.map_size)*bucket_size )%(map.map_size*bucket_size))))->data ); */
 			ion_byte_t			value[10];		/* = (((ion_hash_bucket_t *)(map.entry + ((((i+offset)%map.map_size)*bucket_size )%(map.map_size*bucket_size))))->data + sizeof(int)); */
 
-			fread(&record_status, SIZEOF(STATUS), 1, map.file);
-			fread(&key, map.super.record.key_size, 1, map.file);
-			fread(value, map.super.record.value_size, 1, map.file);
+			ion_fread(map.file, SIZEOF(STATUS), (ion_byte_t *) &record_status);
+			ion_fread(map.file, map.super.record.key_size, (ion_byte_t *) &key);
+			ion_fread(map.file, map.super.record.value_size, value);
 
 			/* build up expected value */
 			char str[10];
@@ -979,6 +979,474 @@ test_open_address_file_hashmap_capacity(
 	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
 }
 
+/**
+@brief		Tests that a batch of inserts wraps around the end of the map,
+			refuses duplicates within the batch, and stops at capacity.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_insert_batch(
+	planck_unit_test_t *tc
+) {
+	ion_file_hashmap_t	map;
+	ion_status_t		status;
+	ion_status_t		statuses[7];
+	char				values[7][10];
+	char				value[10];
+	int					i;
+
+	initialize_file_hash_map_std_conditions(&map);
+
+	/* 19 and 29 collide with 9 and wrap to the start of the map */
+	int first[] = { 9, 3, 19, 3, 29 };
+
+	for (i = 0; i < 5; i++) {
+		sprintf(values[i], "%02i is key", first[i]);
+	}
+
+	status = oafh_insert_batch(&map, first, values, statuses, 5);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_duplicate_key == status.error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 4 == status.count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == statuses[0].error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == statuses[1].error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == statuses[2].error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_duplicate_key == statuses[3].error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == statuses[3].count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == statuses[4].error);
+
+	/* only six buckets are left for these seven */
+	int second[] = { 40, 41, 42, 43, 44, 45, 46 };
+
+	for (i = 0; i < 7; i++) {
+		sprintf(values[i], "%02i is key", second[i]);
+	}
+
+	status = oafh_insert_batch(&map, second, values, statuses, 7);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_max_capacity == status.error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 6 == status.count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_max_capacity == statuses[6].error);
+
+	for (i = 0; i < 6; i++) {
+		status = oafh_query(&map, &second[i], value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		PLANCK_UNIT_ASSERT_STR_ARE_EQUAL(tc, value, values[i]);
+	}
+
+	for (i = 0; i < 5; i++) {
+		char expected[10];
+
+		sprintf(expected, "%02i is key", first[i]);
+		status = oafh_query(&map, &first[i], value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		PLANCK_UNIT_ASSERT_STR_ARE_EQUAL(tc, value, expected);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
+}
+
+/**
+@brief		Tests that deleting a record moves back the records after it
+			whose probe sequences ran through its bucket, including ones
+			that wrapped around, and leaves the bucket freed empty.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_delete_shift(
+	planck_unit_test_t *tc
+) {
+	ion_file_hashmap_t	map;
+	ion_status_t		status;
+	char				value[10];
+	int					location;
+	int					i;
+
+	initialize_file_hash_map_std_conditions(&map);
+
+	/* 18, 9 and 28 are pushed on past 8, wrapping around to the start, while 2 is at home */
+	int keys[]		= { 8, 18, 9, 28, 2 };
+	int moved[]		= { -1, 8, 9, 0, 2 };
+
+	for (i = 0; i < 5; i++) {
+		sprintf(value, "%02i is key", keys[i]);
+		status = oafh_insert(&map, &keys[i], value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	}
+
+	status = oafh_delete(&map, &keys[0]);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 1 == status.count);
+
+	for (i = 1; i < 5; i++) {
+		char expected[10];
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_find_item_loc(&map, &keys[i], &location));
+		PLANCK_UNIT_ASSERT_TRUE(tc, moved[i] == location);
+
+		sprintf(expected, "%02i is key", keys[i]);
+		status = oafh_query(&map, &keys[i], value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		PLANCK_UNIT_ASSERT_STR_ARE_EQUAL(tc, value, expected);
+	}
+
+	/* The last record moved left its slot empty rather than marked deleted */
+	ion_hash_bucket_t *item = malloc(SIZEOF(STATUS) + sizeof(int) + 10);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == ion_fread_at(map.file, SIZEOF(STATUS) + sizeof(int) + 10, SIZEOF(STATUS) + sizeof(int) + 10, (ion_byte_t *) item));
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_EMPTY == item->status);
+	free(item);
+
+	/* A key whose probe would have run into the cleared bucket is still known to be missing */
+	i		= 38;
+	status	= oafh_query(&map, &i, value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_item_not_found == status.error);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
+}
+
+/**
+@brief		Tests that a new map file is made its full size without its
+			slots being written, and that its slots of zeros read as empty,
+			through both a stream and a mapping.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_create_large(
+	planck_unit_test_t *tc
+) {
+	ion_file_hashmap_t	map;
+	ion_status_t		status;
+	int					size = 1 << 18;
+	int					mapped;
+	int					location;
+	int					key;
+	int					value;
+
+	for (mapped = 0; mapped < 2; mapped++) {
+		map.super.compare	= dictionary_compare_signed_value;
+		map.super.key_type	= key_type_numeric_signed;
+		map.super.id		= 0;
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_initialize(&map, oafh_compute_simple_hash, key_type_numeric_signed, sizeof(int), sizeof(int), size, 0, (ion_boolean_t) mapped, boolean_false));
+		PLANCK_UNIT_ASSERT_TRUE(tc, (ion_file_offset_t) size * (ion_file_offset_t) (SIZEOF(STATUS) + 2 * sizeof(int)) + (ion_file_offset_t) sizeof(int32_t) == ion_fend(map.file));
+
+		key		= size - 1;
+		status	= oafh_query(&map, &key, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_item_not_found == status.error);
+
+		value	= 5;
+		status	= oafh_insert(&map, &key, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+
+		/* Wraps around from the last slot, past the record just written */
+		key		= 2 * size - 1;
+		value	= 6;
+		status	= oafh_insert(&map, &key, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_find_item_loc(&map, &key, &location));
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == location);
+
+		status	= oafh_query(&map, &key, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		PLANCK_UNIT_ASSERT_TRUE(tc, 6 == value);
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
+	}
+}
+
+/**
+@brief		Writes the map file with id 0 as a map of 10 slots of the given
+			status would be, followed by @p trailer_size bytes of @p trailer.
+*/
+static void
+write_slot_file(
+	char		status,
+	void		*trailer,
+	size_t		trailer_size
+) {
+	FILE	*file = fopen("0.oaf", "wb");
+	char	item[SIZEOF(STATUS) + 2 * sizeof(int)];
+	int		i;
+
+	memset(item, 0, sizeof(item));
+	item[0] = status;
+
+	for (i = 0; i < 10; i++) {
+		fwrite(item, sizeof(item), 1, file);
+	}
+
+	if (0 < trailer_size) {
+		fwrite(trailer, 1, trailer_size, file);
+	}
+
+	fclose(file);
+}
+
+/**
+@brief		Writes a record into slot @p loc of the map file with id 0.
+*/
+static void
+write_slot(
+	int		loc,
+	char	status,
+	int		key,
+	int		value
+) {
+	FILE	*file = fopen("0.oaf", "r+b");
+	char	item[SIZEOF(STATUS) + 2 * sizeof(int)];
+
+	item[0] = status;
+	memcpy(item + SIZEOF(STATUS), &key, sizeof(int));
+	memcpy(item + SIZEOF(STATUS) + sizeof(int), &value, sizeof(int));
+	fseek(file, loc * (long) sizeof(item), SEEK_SET);
+	fwrite(item, sizeof(item), 1, file);
+	fclose(file);
+}
+
+/**
+@brief		Tests that a slot layout map file from before its format was
+			recorded, whose empty slots are marked with -1, is converted when
+			opened, and that files of other formats are refused.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_legacy_slots(
+	planck_unit_test_t *tc
+) {
+	ion_file_hashmap_t	map;
+	ion_status_t		status;
+	int32_t				format;
+	int					mapped;
+	int					key;
+	int					value;
+
+	map.super.compare	= dictionary_compare_signed_value;
+	map.super.key_type	= key_type_numeric_signed;
+	map.super.id		= 0;
+
+	for (mapped = 0; mapped < 2; mapped++) {
+		/* 13 collides with 3, past a deleted slot left by an older delete */
+		write_slot_file(ION_OAFH_LEGACY_EMPTY, NULL, 0);
+		write_slot(3, ION_IN_USE, 3, 30);
+		write_slot(4, ION_DELETED, 23, 230);
+		write_slot(5, ION_IN_USE, 13, 130);
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_initialize(&map, oafh_compute_simple_hash, key_type_numeric_signed, sizeof(int), sizeof(int), 10, 0, (ion_boolean_t) mapped, boolean_false));
+		PLANCK_UNIT_ASSERT_TRUE(tc, 10 * (ion_file_offset_t) (SIZEOF(STATUS) + 2 * sizeof(int)) + (ion_file_offset_t) sizeof(int32_t) == ion_fend(map.file));
+
+		key		= 13;
+		status	= oafh_query(&map, &key, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		PLANCK_UNIT_ASSERT_TRUE(tc, 130 == value);
+
+		/* The probe for a key that is not there stops at the converted empty slot */
+		key		= 23;
+		status	= oafh_query(&map, &key, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_item_not_found == status.error);
+
+		key		= 7;
+		value	= 70;
+		status	= oafh_insert(&map, &key, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		status	= oafh_query(&map, &key, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		PLANCK_UNIT_ASSERT_TRUE(tc, 70 == value);
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(&map));
+	}
+
+	/* An unknown format, and a file cut short, are not read at all */
+	format = ION_OAFH_SLOT_FORMAT + 1;
+	write_slot_file(ION_EMPTY, &format, sizeof(format));
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_dictionary_initialization_failed == oafh_initialize(&map, oafh_compute_simple_hash, key_type_numeric_signed, sizeof(int), sizeof(int), 10, 0, boolean_false, boolean_false));
+
+	format = ION_OAFH_SLOT_FORMAT;
+	write_slot_file(ION_EMPTY, &format, sizeof(format) - 1);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_dictionary_initialization_failed == oafh_initialize(&map, oafh_compute_simple_hash, key_type_numeric_signed, sizeof(int), sizeof(int), 10, 0, boolean_false, boolean_false));
+
+	fremove("0.oaf");
+}
+
+/**
+@brief		Opens the paged map with id 0, creating it if need be.
+
+@param		size
+				The number of records the map is expected to hold at first.
+@return		The map, which is closed with @ref oafh_close.
+*/
+ion_file_hashmap_t *
+open_paged_file_hash_map(
+	int size
+) {
+	ion_file_hashmap_t *map = malloc(sizeof(ion_file_hashmap_t));
+
+	map->super.compare	= dictionary_compare_signed_value;
+	map->super.key_type = key_type_numeric_signed;
+	map->super.id		= 0;
+
+	if (err_ok != oafh_initialize(map, oafh_compute_simple_hash, key_type_numeric_signed, sizeof(int), sizeof(int), size, 0, boolean_false, boolean_true)) {
+		free(map);
+		return NULL;
+	}
+
+	return map;
+}
+
+/**
+@brief		Tests the paged layout, where a bucket that outgrows its page
+			continues in overflow pages, and the page headers are read back
+			when the map is opened again.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_paged(
+	planck_unit_test_t *tc
+) {
+	ion_file_hashmap_t	*map = malloc(sizeof(ion_file_hashmap_t));
+	ion_status_t		status;
+	int					slots;
+	int					value;
+	int					i;
+
+	map->super.compare	= dictionary_compare_signed_value;
+	map->super.key_type = key_type_numeric_signed;
+	map->super.id		= 0;
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_initialize(map, oafh_compute_simple_hash, key_type_numeric_signed, sizeof(int), sizeof(int), 10, 0, boolean_false, boolean_true));
+
+	slots = map->slots_per_page;
+	PLANCK_UNIT_ASSERT_TRUE(tc, 1 == map->num_buckets);
+	PLANCK_UNIT_ASSERT_TRUE(tc, (ION_OAFH_PAGE_SIZE - (int) sizeof(ion_oafh_page_header_t)) / 9 == slots);
+
+	/* Two and a half pages of records, in one bucket */
+	for (i = 0; i < slots * 5 / 2; i++) {
+		value	= i * 2;
+		status	= oafh_insert(map, &i, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, 2 == map->num_overflow);
+	PLANCK_UNIT_ASSERT_TRUE(tc, slots == map->buckets[0].count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, slots / 2 == map->overflow[1].count);
+
+	i		= slots + 1;
+	status	= oafh_insert(map, &i, &value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_duplicate_key == status.error);
+
+	/* A freed slot is taken by the next record of the bucket */
+	i		= 3;
+	status	= oafh_delete(map, &i);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, slots - 1 == map->buckets[0].count);
+	status	= oafh_query(map, &i, &value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_item_not_found == status.error);
+
+	i		= -1;
+	value	= -1;
+	status	= oafh_insert(map, &i, &value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, slots == map->buckets[0].count);
+
+	i		= slots * 2;
+	value	= 7;
+	status	= oafh_update(map, &i, &value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_close(map));
+
+	map					= malloc(sizeof(ion_file_hashmap_t));
+	map->super.compare	= dictionary_compare_signed_value;
+	map->super.key_type = key_type_numeric_signed;
+	map->super.id		= 0;
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_initialize(map, oafh_compute_simple_hash, key_type_numeric_signed, sizeof(int), sizeof(int), 10, 0, boolean_false, boolean_true));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 2 == map->num_overflow);
+	PLANCK_UNIT_ASSERT_TRUE(tc, slots == map->buckets[0].count);
+
+	for (i = -1; i < slots * 5 / 2; i++) {
+		status = oafh_query(map, &i, &value);
+
+		if (3 == i) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_item_not_found == status.error);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+			PLANCK_UNIT_ASSERT_TRUE(tc, ((-1 == i) ? -1 : (slots * 2 == i) ? 7 : i * 2) == value);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(map));
+	free(map);
+}
+
+/**
+@brief		Tests that a map with the paged layout grows a bucket at a time
+			as it fills, keeping every record, and is opened again at the
+			size it grew to.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_file_hashmap_paged_grow(
+	planck_unit_test_t *tc
+) {
+	ion_file_hashmap_t	*map = open_paged_file_hash_map(10);
+	ion_status_t		status;
+	int					num_buckets;
+	int					value;
+	int					i;
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != map);
+	map->max_load = ION_OAFH_MAX_LOAD_PERCENT;
+
+	for (i = 0; i < map->slots_per_page * 12; i++) {
+		value	= -i;
+		status	= oafh_insert(map, &i, &value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	}
+
+	/* The splits keep the map below its load limit */
+	num_buckets = map->num_buckets;
+	PLANCK_UNIT_ASSERT_TRUE(tc, num_buckets >= 15);
+	PLANCK_UNIT_ASSERT_TRUE(tc, map->slots_per_page * 12 == map->count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, map->count * 100 <= num_buckets * map->slots_per_page * map->max_load);
+
+	for (i = 0; i < map->slots_per_page * 12; i += 2) {
+		status = oafh_delete(map, &i);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_close(map));
+
+	map = open_paged_file_hash_map(10);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != map);
+	PLANCK_UNIT_ASSERT_TRUE(tc, num_buckets == map->num_buckets);
+	PLANCK_UNIT_ASSERT_TRUE(tc, map->slots_per_page * 6 == map->count);
+
+	for (i = 0; i < map->slots_per_page * 12; i++) {
+		status = oafh_query(map, &i, &value);
+
+		if (i % 2) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+			PLANCK_UNIT_ASSERT_TRUE(tc, -i == value);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_item_not_found == status.error);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oafh_destroy(map));
+	free(map);
+}
+
 planck_unit_suite_t *
 open_address_file_hashmap_getsuite(
 ) {
@@ -998,6 +1466,12 @@ open_address_file_hashmap_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_delete_1);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_delete_2);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_capacity);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_delete_shift);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_insert_batch);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_create_large);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_legacy_slots);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_paged);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_file_hashmap_paged_grow);
 
 	return suite;
 }
@@ -973,6 +973,144 @@ test_open_address_hashmap_capacity(
 	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_destroy(&map));
 }
 
+/**
+@brief		Tests that deleting a record moves back the records after it
+			whose probe sequences ran through its bucket, including ones
+			that wrapped around, and leaves the bucket freed empty.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_hashmap_delete_shift(
+	planck_unit_test_t *tc
+) {
+	ion_hashmap_t	map;
+	ion_status_t	status;
+	char			value[10];
+	int				location;
+	int				i;
+
+	initialize_hash_map_std_conditions(&map);
+
+	/* 18, 9 and 28 are pushed on past 8, wrapping around to the start, while 2 is at home */
+	int keys[]		= { 8, 18, 9, 28, 2 };
+	int moved[]		= { -1, 8, 9, 0, 2 };
+
+	for (i = 0; i < 5; i++) {
+		sprintf(value, "%02i is key", keys[i]);
+		status = oah_insert(&map, &keys[i], value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	}
+
+	status = oah_delete(&map, &keys[0]);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 1 == status.count);
+
+	for (i = 1; i < 5; i++) {
+		char expected[10];
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_find_item_loc(&map, &keys[i], &location));
+		PLANCK_UNIT_ASSERT_TRUE(tc, moved[i] == location);
+
+		sprintf(expected, "%02i is key", keys[i]);
+		status = oah_query(&map, &keys[i], value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		PLANCK_UNIT_ASSERT_STR_ARE_EQUAL(tc, value, expected);
+	}
+
+	/* The last record moved left its bucket empty rather than marked deleted */
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_EMPTY == ((ion_hash_bucket_t *) (map.entry + (SIZEOF(STATUS) + sizeof(int) + 10) * 1))->status);
+
+	/* A key whose probe would have run into the cleared bucket is still known to be missing */
+	i		= 38;
+	status	= oah_query(&map, &i, value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_item_not_found == status.error);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_destroy(&map));
+}
+
+/**
+@brief		Tests that a map allowed to grow takes more records than its
+			initial size, and that every record stays reachable while the
+			records are moved into the larger bucket array.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_hashmap_grow(
+	planck_unit_test_t *tc
+) {
+	ion_hashmap_t	map;
+	int				i;
+	int				j;
+	ion_status_t	status;
+	char			str[16];
+	char			value[10];
+
+	initialize_hash_map_std_conditions(&map);
+	map.max_load = ION_OAH_MAX_LOAD_PERCENT;
+
+	for (i = 0; i < ION_MAX_HASH_TEST; i++) {
+		sprintf(str, "%02i is key", i % 100);
+		status = oah_insert(&map, &i, str);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		PLANCK_UNIT_ASSERT_TRUE(tc, 1 == status.count);
+
+		/* earlier records are found whether or not they have been moved yet */
+		for (j = 0; j <= i; j++) {
+			status = oah_query(&map, &j, value);
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+			sprintf(str, "%02i is key", j % 100);
+			PLANCK_UNIT_ASSERT_STR_ARE_EQUAL(tc, str, value);
+		}
+
+		/* and are still detected as duplicates */
+		j		= i / 2;
+		status	= oah_insert(&map, &j, str);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_duplicate_key == status.error);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, map.map_size > ION_MAX_HASH_TEST);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_MAX_HASH_TEST == map.count);
+
+	/* remove and replace the records many times over, which must not keep growing the map */
+	int size = map.map_size;
+
+	for (j = 0; j < 10; j++) {
+		for (i = 0; i < ION_MAX_HASH_TEST; i++) {
+			status = oah_delete(&map, &i);
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		}
+
+		for (i = 0; i < ION_MAX_HASH_TEST; i++) {
+			int key = i + (j + 1) * ION_MAX_HASH_TEST;
+
+			status = oah_query(&map, &key, value);
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_item_not_found == status.error);
+
+			sprintf(str, "%02i is key", i);
+			status = oah_insert(&map, &i, str);
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, map.map_size <= size * 2);
+
+	oah_complete_rehash(&map);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == map.old_entry);
+
+	for (i = 0; i < ION_MAX_HASH_TEST; i++) {
+		status = oah_query(&map, &i, value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		sprintf(str, "%02i is key", i);
+		PLANCK_UNIT_ASSERT_STR_ARE_EQUAL(tc, str, value);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == oah_destroy(&map));
+}
+
 planck_unit_suite_t *
 open_address_hashmap_getsuite(
 ) {
@@ -992,6 +1130,8 @@ open_address_hashmap_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_delete_1);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_delete_2);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_capacity);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_delete_shift);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_grow);
 
 	return suite;
 }
@@ -109,6 +109,64 @@ test_open_address_hashmap_handler_create_destroy(
 	/* todo fix free value status */
 }
 
+/**
+@brief		Tests that a dictionary created without asking for a hash
+			function places keys with the legacy hash, and that the other
+			families are used only when asked for.
+
+@param	  tc
+				Test case.
+*/
+void
+test_open_address_hashmap_handler_create_hashed(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	map_handler;
+	ion_dictionary_t			test_dictionary;
+	ion_hashmap_t			*map;
+	int							i;
+	int							value;
+
+	oadict_init(&map_handler);
+	dictionary_create(&map_handler, &test_dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 200);
+
+	map = (ion_hashmap_t *) test_dictionary.instance;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, hash_function_modulo, test_dictionary.hash_function);
+	PLANCK_UNIT_ASSERT_TRUE(tc, map->compute_hash == &oah_compute_simple_hash);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == map->hash);
+
+	for (i = -50; i < 50; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&test_dictionary, &i, &i).error);
+	}
+
+	for (i = -50; i < 50; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&test_dictionary, &i, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&test_dictionary));
+
+	dictionary_create_hashed(&map_handler, &test_dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 200, hash_function_xxhash);
+
+	map = (ion_hashmap_t *) test_dictionary.instance;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, hash_function_xxhash, test_dictionary.hash_function);
+	PLANCK_UNIT_ASSERT_TRUE(tc, map->compute_hash == &oah_compute_dictionary_hash);
+	PLANCK_UNIT_ASSERT_TRUE(tc, map->hash == dictionary_switch_hash(key_type_numeric_signed, sizeof(int), hash_function_xxhash));
+
+	for (i = -50; i < 50; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&test_dictionary, &i, &i).error);
+	}
+
+	for (i = -50; i < 50; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&test_dictionary, &i, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&test_dictionary));
+}
+
 void
 test_open_address_dictionary_cursor_equality(
 	planck_unit_test_t *tc
@@ -149,6 +207,91 @@ test_open_address_dictionary_cursor_equality(
 	dictionary_delete_dictionary(&test_dictionary);
 }
 
+/**
+@brief		Tests that an equality cursor follows the probe sequence of its
+			key, past collisions, deleted buckets and the end of the map, and
+			ends at the first empty bucket.
+
+@param	  tc
+				Test case.
+*/
+/**
+@brief		Writes a record straight into bucket @p loc of an in memory hash
+			dictionary, wherever its key would be probed for.
+*/
+static void
+test_open_address_dictionary_plant(
+	ion_dictionary_t	*dictionary,
+	int					loc,
+	int					key,
+	int					value
+) {
+	ion_hashmap_t		*hash_map	= (ion_hashmap_t *) dictionary->instance;
+	ion_hash_bucket_t	*item		= (ion_hash_bucket_t *) (hash_map->entry + (SIZEOF(STATUS) + sizeof(int) + sizeof(int)) * loc);
+
+	item->status = ION_IN_USE;
+	memcpy(item->data, &key, sizeof(int));
+	memcpy(item->data + sizeof(int), &value, sizeof(int));
+}
+
+void
+test_open_address_dictionary_cursor_equality_probe(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	map_handler;
+	ion_dictionary_t			test_dictionary;
+	ion_dict_cursor_t			*cursor;
+	ion_predicate_t				predicate;
+	ion_record_t				record;
+	int							keys[] = { 3, 23, 43, 19, 39 };
+	int							key;
+	int							value;
+	int							i;
+
+	oadict_init(&map_handler);
+	dictionary_create_hashed(&map_handler, &test_dictionary, 1, key_type_numeric_signed, sizeof(int), sizeof(int), 20, hash_function_modulo);
+
+	/* 23 and 43 collide with 3, and 39 wraps around from 19 into the first bucket */
+	for (i = 0; i < (int) (sizeof(keys) / sizeof(keys[0])); i++) {
+		value = keys[i] * 10;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&test_dictionary, &keys[i], &value).error);
+	}
+
+	key = 23;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&test_dictionary, &key).error);
+
+	/* Copies of the probed keys past the empty buckets that end their probe sequences, which only a scan of the whole map would reach */
+	for (i = 2; i < (int) (sizeof(keys) / sizeof(keys[0])); i++) {
+		test_open_address_dictionary_plant(&test_dictionary, 8 + i, keys[i], -1);
+	}
+
+	test_open_address_dictionary_plant(&test_dictionary, 14, 23, -1);
+	test_open_address_dictionary_plant(&test_dictionary, 15, 63, -1);
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+
+	for (i = 2; i < (int) (sizeof(keys) / sizeof(keys[0])); i++) {
+		dictionary_build_predicate(&predicate, predicate_equality, &keys[i]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&test_dictionary, &predicate, &cursor));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_cursor_active, cursor->next(cursor, &record));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, keys[i], key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, keys[i] * 10, value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->next(cursor, &record));
+		cursor->destroy(&cursor);
+	}
+
+	/* Keys that were deleted or never inserted have no results */
+	for (key = 23; key <= 63; key += 40) {
+		dictionary_build_predicate(&predicate, predicate_equality, &key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&test_dictionary, &predicate, &cursor));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->next(cursor, &record));
+		cursor->destroy(&cursor);
+	}
+
+	dictionary_delete_dictionary(&test_dictionary);
+}
+
 void
 test_open_address_dictionary_handler_query_with_results(
 	planck_unit_test_t *tc
@@ -517,10 +660,12 @@ open_address_hashmap_handler_getsuite(
 
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_handler_function_registration);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_handler_create_destroy);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_hashmap_handler_create_hashed);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_dictionary_predicate_equality);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_dictionary_predicate_range_signed);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_dictionary_predicate_range_unsigned);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_dictionary_cursor_equality);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_dictionary_cursor_equality_probe);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_dictionary_handler_query_with_results);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_dictionary_handler_query_no_results);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_open_address_dictionary_cursor_range);
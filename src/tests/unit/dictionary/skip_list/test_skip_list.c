@@ -1922,6 +1922,89 @@ test_skiplist_big_keys(
 	sl_destroy(&skiplist);
 }
 
+/**
+@brief	  Counts the arenas a skiplist has taken from the system.
+
+@param	  skiplist
+				Skiplist to count the arenas of
+*/
+int
+skiplist_count_arenas(
+	ion_skiplist_t *skiplist
+) {
+	ion_sl_arena_t	*arena	= skiplist->arena;
+	int				count	= 0;
+
+	while (NULL != arena) {
+		count++;
+		arena = arena->next;
+	}
+
+	return count;
+}
+
+/**
+@brief	  Tests that nodes hold their key and value in the same block, and
+			that deleted nodes are reused rather than taking more memory.
+
+@param	  tc
+				Test case.
+*/
+void
+test_skiplist_arena_reuse(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_skiplist_t skiplist;
+
+	/* A probability of 0 gives every node the same height, so each deleted node fits a new one. */
+	initialize_skiplist(&skiplist, key_type_numeric_signed, dictionary_compare_signed_value, 7, sizeof(int), 10, 0, 4);
+
+	ion_byte_t	value[10];
+	int			i;
+	int			round;
+	int			arenas = 0;
+
+	strcpy((char *) value, "Reuse me");
+
+	for (round = 0; round < 3; round++) {
+		for (i = 0; i < 200; i++) {
+			ion_status_t status = sl_insert(&skiplist, (ion_key_t) &i, value);
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		}
+
+		if (0 == round) {
+			arenas = skiplist_count_arenas(&skiplist);
+			PLANCK_UNIT_ASSERT_TRUE(tc, arenas > 1);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, arenas, skiplist_count_arenas(&skiplist));
+		}
+
+		for (i = 0; i < 200; i++) {
+			ion_sl_node_t *node = sl_find_node(&skiplist, (ion_key_t) &i);
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, *((int *) node->key) == i);
+			PLANCK_UNIT_ASSERT_STR_ARE_EQUAL(tc, (char *) node->value, "Reuse me");
+			PLANCK_UNIT_ASSERT_TRUE(tc, (ion_byte_t *) node->next > (ion_byte_t *) node);
+			PLANCK_UNIT_ASSERT_TRUE(tc, (ion_byte_t *) node->key > (ion_byte_t *) node->next);
+			PLANCK_UNIT_ASSERT_TRUE(tc, (ion_byte_t *) node->value > (ion_byte_t *) node->key);
+		}
+
+		for (i = 0; i < 200; i++) {
+			ion_status_t status = sl_delete(&skiplist, (ion_key_t) &i);
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status.error);
+		}
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, skiplist.head->next[0] == NULL);
+	}
+
+	sl_destroy(&skiplist);
+}
+
 /**
 @brief	  Creates the suite to test using PlanckUnit test cases.
 @return	 Pointer to a PlanckUnit test suite.
@@ -2026,6 +2109,7 @@ skiplist_getsuite_3(
 	/* Variation Tests */
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_skiplist_different_size);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_skiplist_big_keys);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_skiplist_arena_reuse);
 
 	return suite;
 }
@@ -6,6 +6,18 @@
 */
 
 #include "test_dictionary.h"
+#include "../../../file/ion_wal.h"
+
+#if !defined(ARDUINO)
+#include <pthread.h>
+#endif
+
+#define ION_TEST_DICTIONARY_THREADS			4
+#define ION_TEST_DICTIONARY_PER_THREAD		8
+#define ION_TEST_DICTIONARY_THREAD_RECORDS	500
+#define ION_TEST_DICTIONARY_WAL_RECORDS		50
+#define ION_TEST_DICTIONARY_WAL_FILENAME	"test.wal"
+#define ION_TEST_DICTIONARY_MAP_FILENAME	"test.map"
 
 void
 test_dictionary_compare_numerics(
@@ -148,6 +160,72 @@ test_dictionary_compare_numerics(
 	}
 }
 
+void
+test_dictionary_hash_functions(
+	planck_unit_test_t *tc
+) {
+	/* Reference values of xxHash32 with a seed of zero */
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0x02CC5D05UL == dictionary_hash_xxhash("", 0));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0x550D7456UL == dictionary_hash_xxhash("a", 1));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0x32D153FFUL == dictionary_hash_xxhash("abc", 3));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0xE2293B2FUL == dictionary_hash_xxhash("Nobody inspects the spammish repetition", 39));
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == dictionary_switch_hash(key_type_numeric_signed, sizeof(int), hash_function_modulo));
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == dictionary_switch_hash(key_type_numeric_signed, sizeof(int), hash_function_default));
+
+	/* The versions specialized for a key size agree with the general ones */
+	{
+		ion_dictionary_hash_t	xxhash_32bit	= dictionary_switch_hash(key_type_numeric_unsigned, 4, hash_function_xxhash);
+		ion_dictionary_hash_t	wyhash_64bit	= dictionary_switch_hash(key_type_numeric_unsigned, 8, hash_function_wyhash);
+		ion_byte_t				key[8];
+		int						i;
+		int						j;
+
+		for (i = 0; i < 100; i++) {
+			for (j = 0; j < 8; j++) {
+				key[j] = (ion_byte_t) (i * 31 + j * 7);
+			}
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_hash_xxhash(key, 4) == xxhash_32bit(key, 4));
+			PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_hash_wyhash(key, 8) == wyhash_64bit(key, 8));
+		}
+	}
+
+	/* String keys compare equal up to their terminator, so they must hash that way too */
+	{
+		char	first[10]	= "key";
+		char	second[10]	= "key";
+		int		family;
+
+		memset(first + 4, 'x', sizeof(first) - 4);
+		memset(second + 4, 'y', sizeof(second) - 4);
+
+		for (family = hash_function_xxhash; family <= hash_function_wyhash; family++) {
+			ion_dictionary_hash_t hash = dictionary_switch_hash(key_type_char_array, sizeof(first), (ion_hash_function_t) family);
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, hash(first, sizeof(first)) == hash(second, sizeof(second)));
+
+			second[2] = 'z';
+			PLANCK_UNIT_ASSERT_TRUE(tc, hash(first, sizeof(first)) != hash(second, sizeof(second)));
+			second[2] = 'y';
+		}
+	}
+
+	/* Sequential keys spread over the low bits a table uses */
+	{
+		int buckets[16] = { 0 };
+		int i;
+
+		for (i = 0; i < 1600; i++) {
+			buckets[dictionary_hash_wyhash(&i, sizeof(i)) % 16]++;
+		}
+
+		for (i = 0; i < 16; i++) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, buckets[i] > 50);
+		}
+	}
+}
+
 void
 test_dictionary_master_table(
 	planck_unit_test_t *tc
@@ -255,13 +333,774 @@ test_dictionary_master_table(
 	/**************/
 }
 
+/**
+@brief		Writes a master table record in the layout used before records
+			held a hash function family.
+*/
+static void
+test_dictionary_write_legacy_record(
+	FILE							*file,
+	ion_dictionary_config_info_t	*config
+) {
+	fwrite(&(config->id), sizeof(config->id), 1, file);
+	fwrite(&(config->use_type), sizeof(config->use_type), 1, file);
+	fwrite(&(config->type), sizeof(config->type), 1, file);
+	fwrite(&(config->key_size), sizeof(config->key_size), 1, file);
+	fwrite(&(config->value_size), sizeof(config->value_size), 1, file);
+	fwrite(&(config->dictionary_size), sizeof(config->dictionary_size), 1, file);
+}
+
+/**
+@brief		Tests that the master table keeps the hash function family of
+			each dictionary, and still reads tables written before it did.
+*/
+void
+test_dictionary_master_table_hashed(
+	planck_unit_test_t *tc
+) {
+	ion_err_t						err;
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_t				dictionary2;
+	ion_dictionary_config_info_t	config;
+	FILE							*file;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+
+	/* A new table records the family it was asked for, and the legacy one for the default */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+
+	ffdict_init(&handler);
+	err = ion_master_table_create_hashed_dictionary(&handler, &dictionary, key_type_numeric_signed, sizeof(short), 7, 14, hash_function_wyhash);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, err);
+	err = ion_master_table_create_dictionary(&handler, &dictionary2, key_type_numeric_signed, sizeof(int), 10, 20);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, err);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(1, &config));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 14 == config.dictionary_size);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, hash_function_wyhash, config.hash_function);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(2, &config));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 20 == config.dictionary_size);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, hash_function_modulo, config.hash_function);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_delete_from_master_table(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_delete_from_master_table(&dictionary2));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+
+	/* A table written before records held a family, with a master row and two dictionaries */
+	file = fopen(ION_MASTER_TABLE_FILENAME, "w+b");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != file);
+
+	memset(&config, 0, sizeof(config));
+	config.id = 3;
+	test_dictionary_write_legacy_record(file, &config);
+
+	config.id				= 1;
+	config.type				= key_type_numeric_signed;
+	config.key_size			= sizeof(int);
+	config.value_size		= 10;
+	config.dictionary_size	= 20;
+	test_dictionary_write_legacy_record(file, &config);
+
+	config.id				= 2;
+	config.type				= key_type_numeric_unsigned;
+	config.key_size			= sizeof(short);
+	config.value_size		= 7;
+	config.dictionary_size	= 14;
+	test_dictionary_write_legacy_record(file, &config);
+
+	fclose(file);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, ion_master_table_next_id);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(2, &config));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 2 == config.id);
+	PLANCK_UNIT_ASSERT_TRUE(tc, key_type_numeric_unsigned == config.type);
+	PLANCK_UNIT_ASSERT_TRUE(tc, sizeof(short) == config.key_size);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 7 == config.value_size);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 14 == config.dictionary_size);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, hash_function_default, config.hash_function);
+
+	/* Only the legacy hash can be recorded in it, and new records keep its layout */
+	err = ion_master_table_create_hashed_dictionary(&handler, &dictionary, key_type_numeric_signed, sizeof(int), 10, 20, hash_function_xxhash);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_dictionary_initialization_failed, err);
+	err = ion_master_table_create_dictionary(&handler, &dictionary, key_type_numeric_signed, sizeof(int), 10, 20);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, err);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, ion_master_table_next_id);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(3, &config));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 3 == config.id);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 20 == config.dictionary_size);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_lookup_in_master_table(1, &config));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 1 == config.id);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 20 == config.dictionary_size);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_delete_from_master_table(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_close_master_table());
+	fremove(ION_MASTER_TABLE_FILENAME);
+}
+
+/**
+@brief		Tests that a latch counts its readers and keeps a writer alone.
+*/
+void
+test_dictionary_latch(
+	planck_unit_test_t *tc
+) {
+	ion_latch_t latch;
+
+	dictionary_latch_init(&latch);
+
+	dictionary_latch_acquire_shared(&latch);
+	dictionary_latch_acquire_shared(&latch);
+#if ION_THREAD_SAFE
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, latch.state);
+#endif
+	dictionary_latch_release_shared(&latch);
+	dictionary_latch_release_shared(&latch);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, latch.state);
+
+	dictionary_latch_acquire_exclusive(&latch);
+#if ION_THREAD_SAFE
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, latch.state);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, latch.writers);
+#endif
+	dictionary_latch_release_exclusive(&latch);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, latch.state);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, latch.writers);
+}
+
+/**
+@brief		Checks each record replayed from the log written by
+			@ref test_dictionary_wal, and counts them.
+*/
+static ion_err_t
+test_dictionary_wal_apply(
+	void			*context,
+	ion_byte_t		type,
+	ion_byte_t		*payload,
+	unsigned int	size
+) {
+	int *count = context;
+	int key;
+
+	memcpy(&key, payload, sizeof(key));
+
+	if ((type != *count + 1) || (key != *count * 10) || (size != ((1 == type) ? sizeof(int) : 2 * sizeof(int)))) {
+		return err_file_read_error;
+	}
+
+	(*count)++;
+
+	return err_ok;
+}
+
+/**
+@brief		Tests that records committed to a log are read back after it is
+			reopened, and that a checkpoint drops them.
+*/
+void
+test_dictionary_wal(
+	planck_unit_test_t *tc
+) {
+	ion_wal_t		wal;
+	ion_wal_lsn_t	lsn;
+	int				key;
+	int				count;
+
+	fremove(ION_TEST_DICTIONARY_WAL_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open(&wal, ION_TEST_DICTIONARY_WAL_FILENAME));
+
+	for (key = 0; key < 30; key += 10) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_append(&wal, key / 10 + 1, (ion_byte_t *) &key, sizeof(key), (0 == key) ? NULL : (ion_byte_t *) &key, (0 == key) ? 0 : sizeof(key), &lsn));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key / 10 + 1, lsn);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_commit(&wal, lsn));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(&wal));
+
+	count = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open(&wal, ION_TEST_DICTIONARY_WAL_FILENAME));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_replay(&wal, test_dictionary_wal_apply, &count));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_wal_size(&wal) > 0);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_checkpoint(&wal));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, ion_wal_size(&wal));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(&wal));
+
+	/* The records of the old generation are still in the file, but are not read */
+	count = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open(&wal, ION_TEST_DICTIONARY_WAL_FILENAME));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_replay(&wal, test_dictionary_wal_apply, &count));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, count);
+
+	key = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_append(&wal, 1, (ion_byte_t *) &key, sizeof(key), NULL, 0, &lsn));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, lsn);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(&wal));
+
+	fremove(ION_TEST_DICTIONARY_WAL_FILENAME);
+}
+
+/**
+@brief		Stops using a durable dictionary the way a crash would, leaving
+			its log without a checkpoint, and its data file as it was in
+			@p snapshot if one is given.
+*/
+static void
+test_dictionary_crash(
+	ion_dictionary_t	*dictionary,
+	char				*data_filename,
+	ion_byte_t			*snapshot,
+	size_t				snapshot_size
+) {
+	ion_wal_t	*wal = dictionary->instance->wal;
+	FILE		*file;
+
+	dictionary->handler->close_dictionary(dictionary);
+
+	if (NULL != snapshot) {
+		file = fopen(data_filename, "wb");
+		fwrite(snapshot, 1, snapshot_size, file);
+		fclose(file);
+	}
+
+	ion_wal_close(wal);
+	free(wal);
+}
+
+/**
+@brief		Counts the records in a dictionary with a key.
+*/
+static int
+test_dictionary_count(
+	ion_dictionary_t	*dictionary,
+	int					key
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_record_t		record;
+	int					value;
+	int					count	= 0;
+
+	dictionary_build_predicate(&predicate, predicate_equality, &key);
+	dictionary_find(dictionary, &predicate, &cursor);
+
+	record.key		= &key;
+	record.value	= &value;
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		count++;
+	}
+
+	cursor->destroy(&cursor);
+
+	return count;
+}
+
+/**
+@brief		Tests that the writes to a durable dictionary which had not
+			reached its data file when it stopped are redone when it is
+			opened, and that those which had are not done twice.
+*/
+void
+test_dictionary_durable(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_config_info_t	config = { 0 };
+	char							data_filename[ION_MAX_FILENAME_LENGTH];
+	char							wal_filename[ION_MAX_FILENAME_LENGTH];
+	ion_byte_t						snapshot[64];
+	size_t							snapshot_size;
+	FILE							*file;
+	int								i;
+	int								value;
+
+	ffdict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 77, key_type_numeric_signed, sizeof(int), sizeof(int), 10));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_make_durable(&dictionary));
+
+	dictionary_get_filename(77, "ffs", data_filename);
+	dictionary_get_filename(77, "wal", wal_filename);
+
+	file			= fopen(data_filename, "rb");
+	snapshot_size	= fread(snapshot, 1, sizeof(snapshot), file);
+	fclose(file);
+	PLANCK_UNIT_ASSERT_TRUE(tc, snapshot_size < sizeof(snapshot));
+
+	for (i = 0; i < ION_TEST_DICTIONARY_WAL_RECORDS; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &i, &i).error);
+	}
+
+	value = -1;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, &value, &value).error);
+	value = 3;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&dictionary, &value).error);
+
+	/* None of the writes reached the data file */
+	test_dictionary_crash(&dictionary, data_filename, snapshot, snapshot_size);
+
+	config.id				= 77;
+	config.type				= key_type_numeric_signed;
+	config.key_size			= sizeof(int);
+	config.value_size		= sizeof(int);
+	config.dictionary_size	= 10;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open(&handler, &dictionary, &config));
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != dictionary.instance->wal);
+
+	for (i = -1; i < ION_TEST_DICTIONARY_WAL_RECORDS; i++) {
+		ion_err_t expected = (3 == i) ? err_item_not_found : err_ok;
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, dictionary_get(&dictionary, &i, &value).error);
+
+		if (err_ok == expected) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+		}
+	}
+
+	i = ION_TEST_DICTIONARY_WAL_RECORDS;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &i, &i).error);
+
+	/* All of the writes reached the data file */
+	test_dictionary_crash(&dictionary, data_filename, NULL, 0);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open(&handler, &dictionary, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, test_dictionary_count(&dictionary, ION_TEST_DICTIONARY_WAL_RECORDS));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, test_dictionary_count(&dictionary, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+
+	/* Closing takes a checkpoint, so there is nothing to redo */
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_fexists(wal_filename));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open(&handler, &dictionary, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, test_dictionary_count(&dictionary, 0));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	PLANCK_UNIT_ASSERT_FALSE(tc, ion_fexists(wal_filename));
+}
+
+/**
+@brief		Tests that redoing the log of a durable dictionary with duplicate
+			keys leaves an inserted and then updated key with as many records
+			as it had, that one whose writes never reached the data file
+			is still updated, and that a record inserted more than once is
+			redone as many times as it was inserted.
+*/
+void
+test_dictionary_durable_duplicates(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_config_info_t	config = { 0 };
+	char							data_filename[ION_MAX_FILENAME_LENGTH];
+	ion_byte_t						snapshot[64];
+	size_t							snapshot_size;
+	FILE							*file;
+	int								key;
+	int								value;
+	int								snapshotted;
+
+	config.id				= 78;
+	config.type				= key_type_numeric_signed;
+	config.key_size			= sizeof(int);
+	config.value_size		= sizeof(int);
+	config.dictionary_size	= 10;
+
+	dictionary_get_filename(78, "ffs", data_filename);
+	ffdict_init(&handler);
+
+	for (snapshotted = 0; snapshotted < 2; snapshotted++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 78, key_type_numeric_signed, sizeof(int), sizeof(int), 10));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_make_durable(&dictionary));
+
+		file			= fopen(data_filename, "rb");
+		snapshot_size	= fread(snapshot, 1, sizeof(snapshot), file);
+		fclose(file);
+
+		/* Key 5 once, key 6 twice, each inserted and then updated */
+		key		= 5;
+		value	= 5;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &value).error);
+		value	= 9;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, &key, &value).error);
+
+		key		= 6;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &key).error);
+		value	= 7;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &value).error);
+		value	= 9;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, &key, &value).error);
+
+		/* The same record twice as key 4, and twice more as key 3 after it was deleted */
+		key = 4;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &key).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &key).error);
+
+		key = 3;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &key).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&dictionary, &key).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &key).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &key).error);
+
+		test_dictionary_crash(&dictionary, data_filename, snapshotted ? snapshot : NULL, snapshot_size);
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open(&handler, &dictionary, &config));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, test_dictionary_count(&dictionary, 5));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, test_dictionary_count(&dictionary, 4));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, test_dictionary_count(&dictionary, 3));
+
+		key = 5;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, &key, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 9, value);
+
+		/* Without the data file, redoing the update of key 6 can only make one record */
+		if (!snapshotted) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, test_dictionary_count(&dictionary, 6));
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	}
+}
+
+#if !defined(ARDUINO)
+
+/**
+@brief		Returns the size of a file as another process would see it.
+*/
+static long
+test_dictionary_file_size(
+	char *name
+) {
+	FILE	*file = fopen(name, "rb");
+	long	size;
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fclose(file);
+
+	return size;
+}
+
+/**
+@brief		Tests that a mapped file is always exactly as long as its data,
+			so that stopping without closing it leaves no padding behind, and
+			that flushed writes can be read through another handle.
+*/
+void
+test_dictionary_mapped_file(
+	planck_unit_test_t *tc
+) {
+	ion_file_handle_t	file;
+	ion_byte_t			buffer[100];
+	ion_byte_t			read[100];
+	FILE				*other;
+	int					i;
+
+	for (i = 0; i < (int) sizeof(buffer); i++) {
+		buffer[i] = (ion_byte_t) (i + 1);
+	}
+
+	fremove(ION_TEST_DICTIONARY_MAP_FILENAME);
+	file = ion_fopen_mapped(ION_TEST_DICTIONARY_MAP_FILENAME);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_NOFILE != file);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite(file, 10, buffer));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, test_dictionary_file_size(ION_TEST_DICTIONARY_MAP_FILENAME));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fflush(file));
+
+	/* A write in place, then one past the end of the mapping */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, 2, 3, buffer + 50));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, 3 * ION_FILE_MAP_MIN_SIZE, sizeof(buffer), buffer));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3 * ION_FILE_MAP_MIN_SIZE + sizeof(buffer), test_dictionary_file_size(ION_TEST_DICTIONARY_MAP_FILENAME));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fflush(file));
+
+	other = fopen(ION_TEST_DICTIONARY_MAP_FILENAME, "rb");
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, fread(read, 1, 10, other));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, read[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 51, read[2]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 53, read[4]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 6, read[5]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, fseek(other, 3 * ION_FILE_MAP_MIN_SIZE, SEEK_SET));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, sizeof(read), fread(read, 1, sizeof(read), other));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, memcmp(buffer, read, sizeof(read)));
+	fclose(other);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_ftruncate(file, 5));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, ion_fend(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, test_dictionary_file_size(ION_TEST_DICTIONARY_MAP_FILENAME));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, test_dictionary_file_size(ION_TEST_DICTIONARY_MAP_FILENAME));
+	fremove(ION_TEST_DICTIONARY_MAP_FILENAME);
+}
+
+/**
+@brief		What a thread of @ref test_dictionary_wal_threads works on.
+*/
+typedef struct {
+	ion_wal_t	*wal;
+	ion_err_t	error;
+	int			thread;
+} test_dictionary_wal_thread_t;
+
+/**
+@brief		Appends records numbered in order to a log shared with other
+			threads, committing each one.
+*/
+void *
+test_dictionary_wal_thread(
+	void *argument
+) {
+	test_dictionary_wal_thread_t	*work = argument;
+	ion_wal_lsn_t					lsn;
+	ion_err_t						error;
+	int								i;
+
+	for (i = 0; i < ION_TEST_DICTIONARY_THREAD_RECORDS; i++) {
+		error = ion_wal_append(work->wal, 1, (ion_byte_t *) &work->thread, sizeof(int), (ion_byte_t *) &i, sizeof(int), &lsn);
+
+		if (err_ok == error) {
+			error = ion_wal_commit(work->wal, lsn);
+		}
+
+		if (err_ok != error) {
+			work->error = error;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Checks that the records of each thread of
+			@ref test_dictionary_wal_threads are replayed in order, and counts
+			them.
+*/
+static ion_err_t
+test_dictionary_wal_thread_apply(
+	void			*context,
+	ion_byte_t		type,
+	ion_byte_t		*payload,
+	unsigned int	size
+) {
+	int *counts = context;
+	int thread;
+	int i;
+
+	memcpy(&thread, payload, sizeof(int));
+	memcpy(&i, payload + sizeof(int), sizeof(int));
+
+	if ((1 != type) || (2 * sizeof(int) != size) || (thread < 0) || (thread >= ION_TEST_DICTIONARY_THREADS) || (i != counts[thread])) {
+		return err_file_read_error;
+	}
+
+	counts[thread]++;
+
+	return err_ok;
+}
+
+/**
+@brief		Tests that records appended and committed by many threads at once,
+			with appends carrying on while commits synchronize the log, are
+			all read back in the order each thread appended them.
+*/
+void
+test_dictionary_wal_threads(
+	planck_unit_test_t *tc
+) {
+	test_dictionary_wal_thread_t	work[ION_TEST_DICTIONARY_THREADS];
+	pthread_t						threads[ION_TEST_DICTIONARY_THREADS];
+	ion_wal_t						wal;
+	int								counts[ION_TEST_DICTIONARY_THREADS] = { 0 };
+	int								t;
+
+	fremove(ION_TEST_DICTIONARY_WAL_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open(&wal, ION_TEST_DICTIONARY_WAL_FILENAME));
+
+	for (t = 0; t < ION_TEST_DICTIONARY_THREADS; t++) {
+		work[t].wal		= &wal;
+		work[t].error	= err_ok;
+		work[t].thread	= t;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, pthread_create(&threads[t], NULL, test_dictionary_wal_thread, &work[t]));
+	}
+
+	for (t = 0; t < ION_TEST_DICTIONARY_THREADS; t++) {
+		pthread_join(threads[t], NULL);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, work[t].error);
+	}
+
+	/* Every commit has returned, so everything appended is durable */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, wal.next_lsn - 1, wal.durable_lsn);
+	PLANCK_UNIT_ASSERT_FALSE(tc, wal.syncing);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(&wal));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open(&wal, ION_TEST_DICTIONARY_WAL_FILENAME));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_replay(&wal, test_dictionary_wal_thread_apply, counts));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(&wal));
+
+	for (t = 0; t < ION_TEST_DICTIONARY_THREADS; t++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_TEST_DICTIONARY_THREAD_RECORDS, counts[t]);
+	}
+
+	fremove(ION_TEST_DICTIONARY_WAL_FILENAME);
+}
+
+/**
+@brief		What a thread of @ref test_dictionary_threads works on.
+*/
+typedef struct {
+	ion_dictionary_handler_t	*handler;
+	ion_dictionary_t			*shared;
+	ion_dictionary_t			created[ION_TEST_DICTIONARY_PER_THREAD];
+	ion_err_t					error;
+	int							thread;
+	int							mismatches;
+} test_dictionary_thread_t;
+
+/**
+@brief		Creates dictionaries through the master table while reading a
+			dictionary that one of the threads also writes to.
+*/
+void *
+test_dictionary_thread(
+	void *argument
+) {
+	test_dictionary_thread_t	*work = argument;
+	ion_status_t				status;
+	int							i;
+	int							key;
+	int							value;
+
+	for (i = 0; i < ION_TEST_DICTIONARY_PER_THREAD; i++) {
+		ion_err_t error = ion_master_table_create_dictionary(work->handler, &work->created[i], key_type_numeric_signed, sizeof(int), sizeof(int), 7);
+
+		if (err_ok != error) {
+			work->error = error;
+		}
+	}
+
+	for (i = 0; i < ION_TEST_DICTIONARY_THREAD_RECORDS; i++) {
+		if (0 == work->thread) {
+			/* the writer adds odd keys among the even ones there from the start */
+			key		= i * 2 + 1;
+			value	= key;
+			dictionary_insert(work->shared, &key, &value);
+		}
+		else {
+			key		= i * 2;
+			status	= dictionary_get(work->shared, &key, &value);
+
+			if ((err_ok != status.error) || (key != value)) {
+				work->mismatches++;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Tests that threads creating dictionaries are each given their
+			own IDs, and that a dictionary can be read by many threads while
+			another writes to it.
+*/
+void
+test_dictionary_threads(
+	planck_unit_test_t *tc
+) {
+	test_dictionary_thread_t	work[ION_TEST_DICTIONARY_THREADS];
+	pthread_t					threads[ION_TEST_DICTIONARY_THREADS];
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			shared;
+	ion_boolean_t				seen[ION_TEST_DICTIONARY_THREADS * ION_TEST_DICTIONARY_PER_THREAD] = { 0 };
+	ion_dictionary_id_t			first;
+	int							i;
+	int							t;
+	int							value;
+
+	ion_close_master_table();
+	fremove(ION_MASTER_TABLE_FILENAME);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_init_master_table());
+	first = ion_master_table_next_id;
+
+	sldict_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &shared, 0, key_type_numeric_signed, sizeof(int), sizeof(int), 7));
+
+	for (i = 0; i < ION_TEST_DICTIONARY_THREAD_RECORDS * 2; i += 2) {
+		dictionary_insert(&shared, &i, &i);
+	}
+
+	for (t = 0; t < ION_TEST_DICTIONARY_THREADS; t++) {
+		work[t].handler		= &handler;
+		work[t].shared		= &shared;
+		work[t].error		= err_ok;
+		work[t].thread		= t;
+		work[t].mismatches	= 0;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, pthread_create(&threads[t], NULL, test_dictionary_thread, &work[t]));
+	}
+
+	for (t = 0; t < ION_TEST_DICTIONARY_THREADS; t++) {
+		pthread_join(threads[t], NULL);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, work[t].error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, work[t].mismatches);
+	}
+
+	/* Every ID is handed out once */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, first + ION_TEST_DICTIONARY_THREADS * ION_TEST_DICTIONARY_PER_THREAD, ion_master_table_next_id);
+
+	for (t = 0; t < ION_TEST_DICTIONARY_THREADS; t++) {
+		for (i = 0; i < ION_TEST_DICTIONARY_PER_THREAD; i++) {
+			ion_dictionary_id_t id = work[t].created[i].instance->id - first;
+
+			PLANCK_UNIT_ASSERT_TRUE(tc, id < ION_TEST_DICTIONARY_THREADS * ION_TEST_DICTIONARY_PER_THREAD);
+			PLANCK_UNIT_ASSERT_FALSE(tc, seen[id]);
+			seen[id] = boolean_true;
+			dictionary_delete_dictionary(&work[t].created[i]);
+		}
+	}
+
+	for (i = 0; i < ION_TEST_DICTIONARY_THREAD_RECORDS * 2; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&shared, &i, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	dictionary_delete_dictionary(&shared);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_delete_master_table());
+	ion_close_master_table();
+}
+
+#endif
+
 planck_unit_suite_t *
 dictionary_getsuite(
 ) {
 	planck_unit_suite_t *suite = planck_unit_new_suite();
 
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_compare_numerics);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_hash_functions);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_master_table);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_master_table_hashed);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_latch);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_wal);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_durable);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_durable_duplicates);
+#if !defined(ARDUINO)
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_mapped_file);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_threads);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_wal_threads);
+#endif
 
 	return suite;
 }
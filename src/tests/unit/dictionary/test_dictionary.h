@@ -9,6 +9,7 @@
 #include "./../../../dictionary/dictionary.h"
 #include "./../../../dictionary/ion_master_table.h"
 #include "../../../dictionary/flat_file/flat_file_dictionary_handler.h"
+#include "../../../dictionary/skip_list/skip_list_handler.h"
 
 #ifdef  __cplusplus
 extern "C" {
@@ -246,6 +246,564 @@ iinq_test_create_query_select_all_from_where_two_dictionaries(
 	DROP(test2);
 }
 
+void
+iinq_test_source_cache(
+	planck_unit_test_t	*tc
+) {
+	/* More sources than the cache holds, and one with a name longer than a dictionary file name. */
+	char						names[IINQ_SOURCE_CACHE_SIZE + 3][24];
+	int							num_sources	= IINQ_SOURCE_CACHE_SIZE + 3;
+	ion_err_t					error;
+	ion_status_t			status;
+	ion_dictionary_t			dictionary;
+	ion_dictionary_handler_t	handler;
+	int							i;
+	int							key;
+	int							value;
+
+	for (i = 0; i < num_sources - 1; i++) {
+		sprintf(names[i], "cache%d.inq", i);
+	}
+
+	sprintf(names[num_sources - 1], "long_source_name.inq");
+
+	for (i = 0; i < num_sources; i++) {
+		error	= iinq_create_source(names[i], key_type_numeric_signed, sizeof(int), sizeof(int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+	}
+
+	for (key = 0; key < 20; key++) {
+		for (i = 0; i < num_sources; i++) {
+			value	= key * 100 + i;
+			status	= iinq_insert(names[i], &key, &value);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		}
+	}
+
+	/* The cached sources keep the master table open between calls. */
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != ion_master_table_file);
+
+	key		= 3;
+	value	= -1;
+	status	= iinq_update(names[0], &key, &value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	status	= iinq_delete(names[1], &key);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+
+	error	= iinq_close_sources();
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ion_master_table_file);
+
+	for (i = 0; i < num_sources; i++) {
+		dictionary.handler	= &handler;
+		error				= iinq_open_source(names[i], &dictionary, &handler);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+
+		for (key = 0; key < 20; key++) {
+			status = dictionary_get(&dictionary, &key, &value);
+
+			if ((3 == key) && (1 == i)) {
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+			}
+			else if ((3 == key) && (0 == i)) {
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, value);
+			}
+			else {
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 100 + i, value);
+			}
+		}
+
+		ion_close_dictionary(&dictionary);
+	}
+
+	for (i = 0; i < num_sources; i++) {
+		error	= iinq_drop(names[i]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+	}
+}
+
+void
+iinq_test_source_cache_long_name(
+	planck_unit_test_t	*tc
+) {
+	ion_err_t		error;
+	ion_status_t	status;
+	int				key;
+	int				value;
+
+	error	= CREATE_DICTIONARY(customer_accounts, key_type_numeric_signed, sizeof(int), sizeof(int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+
+	for (key = 0; key < 20; key++) {
+		value	= key * 2;
+		status	= INSERT(customer_accounts, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+
+		/* The source stays cached, and with it the master table open. */
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL != ion_master_table_file);
+	}
+
+	key		= 7;
+	value	= -7;
+	status	= UPDATE(customer_accounts, &key, &value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	status	= DELETE_FROM(customer_accounts, &key);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+
+	error	= iinq_close_sources();
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ion_master_table_file);
+
+	error	= DROP(customer_accounts);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+}
+
+/* Counts joined records, and those whose join columns do not match. */
+typedef struct {
+	int count;
+	int mismatched;
+	int outer_column;
+	int inner_column;
+} iinq_test_join_state_t;
+
+IINQ_NEW_PROCESSOR_FUNC(iinq_test_count_join) {
+	iinq_test_join_state_t	*join	= state;
+	int						*row	= (int *) result->data;
+
+	join->count++;
+
+	if (row[join->outer_column] != row[2 + join->inner_column]) {
+		join->mismatched++;
+	}
+}
+
+/* The customer an order is for. */
+IINQ_NEW_JOIN_KEY_FUNC(iinq_test_order_customer) {
+	UNUSED(key);
+	memcpy(join_key, value, sizeof(int));
+}
+
+void
+iinq_test_join(
+	planck_unit_test_t	*tc
+) {
+	ion_err_t					error;
+	ion_status_t			status;
+	ion_iinq_query_processor_t	processor;
+	iinq_test_join_state_t		state;
+	int							key;
+	int							value;
+
+	processor	= IINQ_QUERY_PROCESSOR(iinq_test_count_join, &state);
+
+	error		= CREATE_DICTIONARY(customers, key_type_numeric_signed, sizeof(int), sizeof(int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+	error		= CREATE_DICTIONARY(orders, key_type_numeric_signed, sizeof(int), sizeof(int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+
+	/* 20 customers; 100 orders, of which those for customers 20 to 24 have no customer. */
+	for (key = 0; key < 20; key++) {
+		value	= key * 10;
+		status	= INSERT(customers, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	for (key = 0; key < 100; key++) {
+		value	= key % 25;
+		status	= INSERT(orders, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	/* Joined on the customer key, so each order looks its customer up. */
+	memset(&state, 0, sizeof(state));
+	state.outer_column	= 1;
+	state.inner_column	= 0;
+	error				= JOIN(orders, customers, iinq_test_order_customer, NULL, sizeof(int), &processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 80, state.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state.mismatched);
+
+	/* Joined on an order column, so the orders are hashed instead. */
+	memset(&state, 0, sizeof(state));
+	state.outer_column	= 0;
+	state.inner_column	= 1;
+	error				= JOIN(customers, orders, NULL, iinq_test_order_customer, sizeof(int), &processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 80, state.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state.mismatched);
+
+	/* Both ways give the same pairs as each other. */
+	memset(&state, 0, sizeof(state));
+	state.outer_column	= 1;
+	state.inner_column	= 0;
+	error				= iinq_hash_join("orders.inq", "customers.inq", iinq_test_order_customer, NULL, sizeof(int), &processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 80, state.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state.mismatched);
+
+	/* Keys of different sizes are not joined on without a key function to make them alike. */
+	error	= CREATE_DICTIONARY(regions, key_type_numeric_signed, sizeof(short), sizeof(int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+
+	memset(&state, 0, sizeof(state));
+	error	= JOIN(regions, customers, NULL, NULL, sizeof(int), &processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, error);
+	error	= JOIN(regions, orders, NULL, iinq_test_order_customer, sizeof(int), &processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, error);
+	error	= JOIN(customers, orders, NULL, iinq_test_order_customer, sizeof(short), &processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, error);
+	error	= JOIN(orders, customers, iinq_test_order_customer, NULL, sizeof(long long), &processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_invalid_predicate, error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state.count);
+
+	DROP(regions);
+	DROP(customers);
+	DROP(orders);
+}
+
+/* Counts the rows, and those whose key is outside the bounds in the state. */
+IINQ_NEW_PROCESSOR_FUNC(iinq_test_count_range) {
+	int *bounds = state;
+	int *row	= (int *) result->data;
+
+	bounds[2]++;
+
+	if ((row[0] < bounds[0]) || (row[0] > bounds[1])) {
+		bounds[3]++;
+	}
+}
+
+/* Each QUERY has its own cleanup label, so only one fits in a function. */
+void
+iinq_test_query_key_range(
+	int							lower,
+	int							upper,
+	ion_iinq_query_processor_t	*processor
+) {
+	QUERY(
+		SELECT_ALL,
+		FROM_KEY_RANGE(test, IONIZE(lower, int), IONIZE(upper, int)),
+		WHERE(1),
+		,
+		,
+		,
+		,
+		,
+		processor
+	);
+}
+
+void
+iinq_test_query_key_range_even(
+	int							lower,
+	int							upper,
+	ion_iinq_query_processor_t	*processor
+) {
+	QUERY(
+		SELECT_ALL,
+		FROM_KEY_RANGE(test, IONIZE(lower, int), IONIZE(upper, int)),
+		WHERE(NEUTRALIZE(test.key, int) % 2 == 0),
+		,
+		,
+		,
+		,
+		,
+		processor
+	);
+}
+
+void
+iinq_test_query_key_equal(
+	int							key,
+	ion_iinq_query_processor_t	*processor
+) {
+	QUERY(
+		SELECT_ALL,
+		FROM_KEY_EQUAL(test, IONIZE(key, int)),
+		WHERE(1),
+		,
+		,
+		,
+		,
+		,
+		processor
+	);
+}
+
+void
+iinq_test_key_predicate_pushdown(
+	planck_unit_test_t	*tc
+) {
+	ion_err_t					error;
+	ion_status_t			status;
+	ion_iinq_query_processor_t	processor;
+	int							state[4];
+	int							key;
+	int							value;
+
+	processor	= IINQ_QUERY_PROCESSOR(iinq_test_count_range, state);
+
+	error		= CREATE_DICTIONARY(test, key_type_numeric_signed, sizeof(int), sizeof(int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+
+	for (key = 0; key < 100; key++) {
+		value	= key * 2;
+		status	= INSERT(test, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	/* Only the keys in the range are read. */
+	state[0]	= 10;
+	state[1]	= 19;
+	state[2]	= 0;
+	state[3]	= 0;
+	iinq_test_query_key_range(10, 19, &processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10, state[2]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state[3]);
+
+	/* WHERE still filters the records read. */
+	state[2]	= 0;
+	iinq_test_query_key_range_even(10, 19, &processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, state[2]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state[3]);
+
+	state[0]	= 42;
+	state[1]	= 42;
+	state[2]	= 0;
+	iinq_test_query_key_equal(42, &processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, state[2]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state[3]);
+
+	/* A key that is not there gives no rows. */
+	state[2]	= 0;
+	iinq_test_query_key_equal(500, &processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state[2]);
+
+	DROP(test);
+}
+
+#define IINQ_TEST_OPERATOR_RECORDS 1000
+
+typedef struct {
+	int count;
+	int column;
+	int descending;
+	int out_of_order;
+	int first[2];
+	int last[2];
+} iinq_test_operator_state_t;
+
+/* Tracks the rows passed on, and how many are out of order with the last on the column checked. */
+IINQ_NEW_PROCESSOR_FUNC(iinq_test_collect) {
+	iinq_test_operator_state_t	*collected	= state;
+	int							*row		= (int *) result->data;
+
+	if ((collected->count > 0) && (collected->descending ? row[collected->column] > collected->last[collected->column] : row[collected->column] <= collected->last[collected->column])) {
+		collected->out_of_order++;
+	}
+
+	if (0 == collected->count) {
+		memcpy(collected->first, row, sizeof(collected->first));
+	}
+
+	memcpy(collected->last, row, sizeof(collected->last));
+	collected->count++;
+}
+
+/* Counts the rows of a group, and sums their keys. */
+IINQ_NEW_AGGREGATE_FUNC(iinq_test_count_sum) {
+	int *totals = aggregate;
+
+	if (first) {
+		totals[0]	= 0;
+		totals[1]	= 0;
+	}
+
+	totals[0]++;
+	totals[1] += NEUTRALIZE(result->data, int);
+}
+
+void
+iinq_test_query_limit(
+	ion_iinq_query_processor_t *processor
+) {
+	QUERY(
+		SELECT_ALL,
+		FROM(test),
+		WHERE(1),
+		,
+		,
+		,
+		LIMIT(5),
+		,
+		processor
+	);
+}
+
+void
+iinq_test_query_order_by_limit(
+	ion_iinq_query_processor_t *processor
+) {
+	QUERY(
+		SELECT_ALL,
+		FROM(test),
+		WHERE(1),
+		,
+		,
+		ORDERBY(0, sizeof(int), dictionary_compare_signed_value, iinq_order_descending),
+		LIMIT(3),
+		,
+		processor
+	);
+}
+
+void
+iinq_test_query_order_by(
+	ion_iinq_query_processor_t *processor
+) {
+	QUERY(
+		SELECT_ALL,
+		FROM(test),
+		WHERE(1),
+		,
+		,
+		ORDERBY(sizeof(int), sizeof(int), dictionary_compare_signed_value, iinq_order_descending),
+		,
+		,
+		processor
+	);
+}
+
+void
+iinq_test_query_group_by(
+	ion_iinq_query_processor_t *processor
+) {
+	QUERY(
+		SELECT_ALL,
+		FROM(test),
+		WHERE(1),
+		GROUPBY(sizeof(int), sizeof(int), iinq_test_count_sum, 2 * sizeof(int)),
+		HAVING(NEUTRALIZE(result.data + sizeof(int), int) > 142),
+		ORDERBY(0, sizeof(int), dictionary_compare_signed_value, iinq_order_ascending),
+		,
+		,
+		processor
+	);
+}
+
+void
+iinq_test_order_group_limit(
+	planck_unit_test_t	*tc
+) {
+	ion_err_t					error;
+	ion_status_t			status;
+	ion_iinq_query_processor_t	processor;
+	iinq_test_operator_state_t	state;
+	int							key;
+	int							value;
+
+	processor	= IINQ_QUERY_PROCESSOR(iinq_test_collect, &state);
+
+	error		= CREATE_DICTIONARY(test, key_type_numeric_signed, sizeof(int), sizeof(int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+
+	for (key = 0; key < IINQ_TEST_OPERATOR_RECORDS; key++) {
+		value	= key % 7;
+		status	= INSERT(test, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	/* Reading stops at the limit. */
+	memset(&state, 0, sizeof(state));
+	iinq_test_query_limit(&processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, state.count);
+
+	/* Only the best rows are kept, and passed on in order. */
+	memset(&state, 0, sizeof(state));
+	state.descending	= 1;
+	iinq_test_query_order_by_limit(&processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, state.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state.out_of_order);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, IINQ_TEST_OPERATOR_RECORDS - 1, state.first[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, IINQ_TEST_OPERATOR_RECORDS - 3, state.last[0]);
+
+	/* Too many rows to sort in memory, so runs are written out and merged over more than one pass. */
+	memset(&state, 0, sizeof(state));
+	state.column		= 1;
+	state.descending	= 1;
+	iinq_test_query_order_by(&processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, IINQ_TEST_OPERATOR_RECORDS, state.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state.out_of_order);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 6, state.first[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state.last[1]);
+
+	/* 1000 rows in 7 groups leaves the last group with one row fewer. */
+	memset(&state, 0, sizeof(state));
+	iinq_test_query_group_by(&processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 6, state.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state.out_of_order);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state.first[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 143, state.first[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, state.last[0]);
+
+	DROP(test);
+}
+
+void
+iinq_test_query_group_by_value(
+	ion_iinq_query_processor_t *processor
+) {
+	QUERY(
+		SELECT_ALL,
+		FROM(groups),
+		WHERE(1),
+		GROUPBY(sizeof(int), sizeof(int), iinq_test_count_sum, 2 * sizeof(int)),
+		,
+		ORDERBY(0, sizeof(int), dictionary_compare_signed_value, iinq_order_ascending),
+		,
+		,
+		processor
+	);
+}
+
+void
+iinq_test_group_by_spill(
+	planck_unit_test_t	*tc
+) {
+	ion_err_t					error;
+	ion_status_t			status;
+	ion_iinq_query_processor_t	processor;
+	iinq_test_operator_state_t	state;
+	int							key;
+	int							value;
+
+	processor	= IINQ_QUERY_PROCESSOR(iinq_test_collect, &state);
+
+	error		= CREATE_DICTIONARY(groups, key_type_numeric_signed, sizeof(int), sizeof(int));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, error);
+
+	for (key = 0; key < IINQ_TEST_OPERATOR_RECORDS; key++) {
+		value	= key % 400;
+		status	= INSERT(groups, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	/* Far more groups than fit in memory, so most are grouped from partitions written out, each group once. */
+	memset(&state, 0, sizeof(state));
+	iinq_test_query_group_by_value(&processor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 400, state.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state.out_of_order);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, state.first[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 3, state.first[1]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 399, state.last[0]);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, state.last[1]);
+
+	DROP(groups);
+}
+
 planck_unit_suite_t *
 iinq_get_suite(
 ) {
@@ -256,6 +814,12 @@ iinq_get_suite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_create_insert_update_delete_drop_dictionary_intint);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_create_query_select_all_from_where_single_dictionary);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_create_query_select_all_from_where_two_dictionaries);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_source_cache);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_source_cache_long_name);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_join);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_key_predicate_pushdown);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_order_group_limit);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, iinq_test_group_by_spill);
 
 	return suite;
 }